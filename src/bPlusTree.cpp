@@ -0,0 +1,163 @@
+#include "global.h"
+
+/**
+ * @brief Construct a new BPlusTree object. The tree is empty until build is
+ * called.
+ *
+ * @param indexName name of the relation holding the nodes
+ * @param columnIndex indexed column
+ */
+BPlusTree::BPlusTree(const string &indexName, int columnIndex) {
+    LOG_TRACE("BPlusTree::BPlusTree");
+    this->indexName = indexName;
+    this->columnIndex = columnIndex;
+}
+
+/**
+ * @brief Bulk loads the tree. The (key, pageIndex, slot) rows of the table are
+ * written out and sorted into the leaves, then the inner levels are built
+ * bottom up from the first key of every page of the level below. The index
+ * must already be known to the catalogue.
+ *
+ * @param table
+ * @return true if the tree has been built
+ * @return false if the table has no rows
+ */
+bool BPlusTree::build(Table *table) {
+    LOG_TRACE("BPlusTree::build");
+    Table *run = new Table(this->indexName, vector<string>{"key", "pageIndex", "slot"});
+    TableBuilder builder(run, false);
+    vector<int> entry(3);
+    Cursor cursor(table->tableName, 0, TABLE);
+    cursor.readAhead();
+    for (int pageCounter = 0; pageCounter < table->blockCount; pageCounter++) {
+        if (pageCounter)
+            cursor.nextPage(pageCounter);
+        ColumnView keys = cursor.page->getColumnView(this->columnIndex);
+        for (int slot = 0; slot < keys.size(); slot++) {
+            entry[0] = keys[slot], entry[1] = pageCounter, entry[2] = slot;
+            builder.addRow(entry);
+        }
+    }
+    tableCatalogue.insertTable(run);
+    if (!builder.finish()) {
+        tableCatalogue.deleteTable(this->indexName);
+        return false;
+    }
+    run->sort("key", ASC, this->indexName);
+    this->leafCount = this->blockCount = run->blockCount;
+    for (uint leaf = 0; leaf < this->leafCount; leaf++)
+        this->dimsPerBlock.emplace_back(run->rowsPerBlockCount[leaf], 3);
+    // The leaves now belong to the index
+    tableCatalogue.eraseTable(this->indexName);
+
+    vector<int> firstKeys(this->leafCount);
+    for (uint leaf = 0; leaf < this->leafCount; leaf++)
+        firstKeys[leaf] = Cursor(this->indexName, leaf, INDEX_NODE).page->getCell(0, 0);
+    const uint fanout = (uint) ((BLOCK_SIZE * 1000) / (sizeof(int) * 2));
+    vector<vector<int>> node(fanout, vector<int>(2));
+    uint levelStart = 0;
+    while (firstKeys.size() > 1) {
+        vector<int> nextFirstKeys;
+        uint nextLevelStart = this->blockCount;
+        for (uint child = 0; child < firstKeys.size();) {
+            int rowCount = 0;
+            for (; rowCount < fanout && child < firstKeys.size(); rowCount++, child++) {
+                node[rowCount][0] = firstKeys[child];
+                node[rowCount][1] = levelStart + child;
+            }
+            nextFirstKeys.push_back(node[0][0]);
+            this->dimsPerBlock.emplace_back(rowCount, 2);
+            bufferManager.writePage(this->indexName, this->blockCount++, node, rowCount, 2);
+        }
+        firstKeys.swap(nextFirstKeys);
+        levelStart = nextLevelStart;
+        this->height++;
+    }
+    this->rootPageIndex = this->blockCount - 1;
+    return true;
+}
+
+bool BPlusTree::supportsRanges() const {
+    return true;
+}
+
+/**
+ * @brief Descends from the root to the first leaf that can hold key. That is
+ * the child before the first one starting with a key of at least key, since
+ * the child before may still end with copies of key.
+ *
+ * @param key
+ * @return uint page index of the leaf
+ */
+uint BPlusTree::findLeaf(int key) {
+    LOG_TRACE("BPlusTree::findLeaf");
+    uint pageIndex = this->rootPageIndex;
+    for (uint level = 0; level < this->height; level++) {
+        Cursor cursor(this->indexName, pageIndex, INDEX_NODE);
+        Page *node = cursor.page;
+        ColumnView keys = node->getColumnView(0);
+        int low = 0, high = keys.size();
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (keys[middle] < key)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        pageIndex = node->getCell(max(low - 1, 0), 1);
+    }
+    return pageIndex;
+}
+
+/**
+ * @brief Appends the row ids of all rows whose key lies in [low, high] to
+ * rowIds, in key order
+ *
+ * @param low
+ * @param high
+ * @param rowIds
+ */
+void BPlusTree::lookup(int low, int high, vector<RowId> &rowIds) {
+    LOG_TRACE("BPlusTree::lookup");
+    if (low > high || !this->leafCount)
+        return;
+    uint leaf = this->findLeaf(low);
+    Cursor cursor(this->indexName, leaf, INDEX_NODE);
+    while (true) {
+        ColumnView keys = cursor.page->getColumnView(0);
+        for (int slot = 0; slot < keys.size(); slot++) {
+            if (keys[slot] > high)
+                return;
+            if (keys[slot] >= low)
+                rowIds.push_back({cursor.page->getCell(slot, 1), cursor.page->getCell(slot, 2)});
+        }
+        if (++leaf == this->leafCount)
+            return;
+        cursor.nextPage(leaf);
+    }
+}
+
+/**
+ * @brief A lookup descends through the inner levels and then reads the
+ * leaves holding the matching entries
+ *
+ * @param matchingRows
+ * @return long long
+ */
+long long BPlusTree::lookupCost(long long matchingRows) const {
+    const long long entriesPerLeaf = (long long) ((BLOCK_SIZE * 1000) / (sizeof(int) * 3));
+    return this->height + max(1LL, (matchingRows + entriesPerLeaf - 1) / entriesPerLeaf);
+}
+
+void BPlusTree::save(CatalogWriter &writer) const {
+    TableIndex::save(writer);
+    writer.write(this->leafCount);
+    writer.write(this->height);
+    writer.write(this->rootPageIndex);
+}
+
+bool BPlusTree::restore(CatalogReader &reader) {
+    return TableIndex::restore(reader) && reader.read(this->leafCount) && reader.read(this->height) &&
+           reader.read(this->rootPageIndex);
+}
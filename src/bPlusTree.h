@@ -0,0 +1,35 @@
+#ifndef B_PLUS_TREE_H
+#define B_PLUS_TREE_H
+#include"tableIndex.h"
+
+/**
+ * @brief The BPlusTree is a bulk loaded B+-tree over one column of a table.
+ *
+ * The leaves are the first leafCount pages of the index relation and hold
+ * (key, pageIndex, slot) rows in key order; they are produced by sorting the
+ * (key, row id) pairs of the table with Table::sort, so the leaf after leaf
+ * N is simply page N + 1. Every inner level follows the one below it and
+ * holds one (first key, child page) row per child. The root is the last page.
+ *
+ * Lookups descend from the root to the first leaf that can hold the lower end
+ * of the range and walk the leaves from there.
+ */
+class BPlusTree : public TableIndex{
+
+    uint leafCount = 0;
+    uint height = 0;
+    uint rootPageIndex = 0;
+
+    uint findLeaf(int key);
+
+    public:
+
+    BPlusTree(const string &indexName, int columnIndex);
+    bool build(Table *table) override;
+    bool supportsRanges() const override;
+    void lookup(int low, int high, vector<RowId> &rowIds) override;
+    long long lookupCost(long long matchingRows) const override;
+    void save(CatalogWriter &writer) const override;
+    bool restore(CatalogReader &reader) override;
+};
+#endif //B_PLUS_TREE_H
@@ -0,0 +1,237 @@
+#include <bits/stdc++.h>
+
+using namespace std;
+
+/**
+ * @brief Runs the benchmark suite and writes its results as CSV.
+ *
+ * SYNTAX: driver [--rows n,n,...] [--blocks n,n,...] [--columns n]
+ *                [--cardinality n] [--skew x] [--density x] [--output path]
+ *
+ * For every number of rows the relations BENCH_R (rows rows), BENCH_S
+ * (rows / 10) and BENCH_T (rows / 1000, at least 10) and the matrix BENCH_M
+ * (sqrt(rows) square, the given density) are generated with bench/generate.
+ * Then for every BLOCK_COUNT a fresh server_bench runs the statements below,
+ * recording the statistics of each in a stats file (see Profiler). One CSV
+ * line per statement gives its wall and CPU time, its throughput (rows read,
+ * or written if it reads none, per second) and its block I/O. The first
+ * column is the commit the binary was built from, so results of several
+ * commits can be put side by side.
+ */
+
+struct Benchmark
+{
+    string name;
+    string statement;
+};
+
+vector<Benchmark> benchmarks(long long cardinality)
+{
+    return {
+        {"load", "LOAD BENCH_R"},
+        {"load", "LOAD BENCH_S"},
+        {"load", "LOAD BENCH_T"},
+        {"load_matrix", "LOAD MATRIX BENCH_M"},
+        {"select", "BENCH_SEL <- SELECT BENCH_R_1 < " + to_string(cardinality / 2) + " FROM BENCH_R"},
+        {"join_equi", "BENCH_EJ <- JOIN BENCH_R, BENCH_S ON BENCH_R_0 == BENCH_S_0"},
+        {"join_non_equi", "BENCH_NEJ <- JOIN BENCH_T, BENCH_S ON BENCH_T_0 < BENCH_S_0"},
+        {"group_by", "BENCH_GB <- GROUP BY BENCH_R_0 FROM BENCH_R HAVING COUNT(BENCH_R_1) > 0 RETURN SUM(BENCH_R_1)"},
+        {"cross", "BENCH_X <- CROSS BENCH_T BENCH_S"},
+        {"sort", "SORT BENCH_R BY BENCH_R_1 IN ASC"},
+        {"sort_multi_column", "SORT BENCH_R BY BENCH_R_2, BENCH_R_1 IN DESC, ASC"},
+        {"transpose", "TRANSPOSE MATRIX BENCH_M"},
+        {"compute", "COMPUTE BENCH_M"},
+    };
+}
+
+const vector<string> benchRelations = {"BENCH_R", "BENCH_S", "BENCH_T", "BENCH_M", "BENCH_M_RESULT", "BENCH_SEL",
+                                       "BENCH_EJ", "BENCH_NEJ", "BENCH_GB", "BENCH_X"};
+
+/**
+ * @brief The statement as the server reports it: its tokens (split at
+ * white space and commas) joined by single spaces
+ */
+string normalize(const string &statement)
+{
+    string normalized, token;
+    for (char character: statement + " ")
+    {
+        if (!isspace((unsigned char) character) && character != ',')
+        {
+            token += character;
+            continue;
+        }
+        if (!token.empty())
+            normalized += (normalized.empty() ? "" : " ") + token;
+        token.clear();
+    }
+    return normalized;
+}
+
+vector<long long> parseList(const string &list)
+{
+    vector<long long> values;
+    stringstream stream(list);
+    for (string value; getline(stream, value, ',');)
+        values.push_back(stoll(value));
+    return values;
+}
+
+string run(const string &command)
+{
+    string output;
+    FILE *pipe = popen(command.c_str(), "r");
+    if (!pipe)
+        return output;
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe))
+        output += buffer;
+    pclose(pipe);
+    while (!output.empty() && isspace((unsigned char) output.back()))
+        output.pop_back();
+    return output;
+}
+
+/**
+ * @brief Value of a field of the first operator (the statement itself) in a
+ * line of the stats file
+ */
+double field(const string &line, const string &name)
+{
+    size_t operators = line.find("\"operators\":[");
+    size_t position = line.find("\"" + name + "\":", operators);
+    if (operators == string::npos || position == string::npos)
+        return 0;
+    return atof(line.c_str() + position + name.size() + 3);
+}
+
+string statementOf(const string &line)
+{
+    const string key = "{\"statement\":\"";
+    if (line.compare(0, key.size(), key))
+        return "";
+    string statement;
+    for (size_t position = key.size(); position < line.size() && line[position] != '"'; position++)
+    {
+        if (line[position] == '\\')
+            position++;
+        statement += line[position];
+    }
+    return statement;
+}
+
+bool generate(long long rows, int columns, long long cardinality, double skew, double density)
+{
+    string table = " " + to_string(columns) + " " + to_string(cardinality) + " " + to_string(skew);
+    long long dimension = max(2LL, (long long) sqrt((double) rows));
+    return !system(("./bench/generate table BENCH_R " + to_string(rows) + table).c_str()) &&
+           !system(("./bench/generate table BENCH_S " + to_string(rows / 10) + table).c_str()) &&
+           !system(("./bench/generate table BENCH_T " + to_string(max(10LL, rows / 1000)) + table).c_str()) &&
+           !system(("./bench/generate matrix BENCH_M " + to_string(dimension) + " " + to_string(density)).c_str());
+}
+
+/**
+ * @brief Runs the benchmarks on a server with blockCount blocks and appends
+ * their results to fout
+ */
+bool runBenchmarks(const string &commit, long long rows, long long cardinality, long long blockCount, ofstream &fout)
+{
+    const string statsFile = "../data/temp/bench_stats.json";
+    remove(statsFile.c_str());
+    FILE *server = popen(("./server_bench --block-count " + to_string(blockCount) + " --stats-file " + statsFile +
+                          " > /dev/null").c_str(), "w");
+    if (!server)
+        return false;
+    // Relations left behind by an earlier run that stopped half way are
+    // cleared before and after
+    for (const string &relation: benchRelations)
+        fprintf(server, "CLEAR %s\n", relation.c_str());
+    map<string, string> names;
+    for (const Benchmark &benchmark: benchmarks(cardinality))
+    {
+        fprintf(server, "%s\n", benchmark.statement.c_str());
+        names[normalize(benchmark.statement)] = benchmark.name;
+    }
+    for (const string &relation: benchRelations)
+        fprintf(server, "CLEAR %s\n", relation.c_str());
+    fprintf(server, "QUIT\n");
+    if (pclose(server))
+        return false;
+
+    ifstream stats(statsFile);
+    for (string line; getline(stats, line);)
+    {
+        auto name = names.find(statementOf(line));
+        if (name == names.end())
+            continue;
+        double wallMs = field(line, "wallMs");
+        double rowsProcessed = max(field(line, "rowsIn"), field(line, "rowsOut"));
+        fout << commit << "," << rows << "," << blockCount << "," << name->second << "," << (long long) field(line, "rowsIn")
+             << "," << (long long) field(line, "rowsOut") << "," << wallMs << "," << field(line, "cpuMs") << ","
+             << (long long) (wallMs > 0 ? rowsProcessed * 1000 / wallMs : 0) << "," << (long long) field(line, "blocksRead")
+             << "," << (long long) field(line, "blocksWritten") << "," << (long long) field(line, "poolHits") << ","
+             << (long long) field(line, "poolMisses") << "," << (long long) field(line, "bytesSpilled") << ","
+             << (long long) field(line, "passes") << endl;
+    }
+    remove(statsFile.c_str());
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<long long> rowCounts{10000, 100000}, blockCounts{10, 100};
+    int columns = 4;
+    long long cardinality = 1000;
+    double skew = 0, density = 0.1;
+    string output = "bench.csv";
+    for (int argument = 1; argument + 1 < argc; argument += 2)
+    {
+        string option = argv[argument], value = argv[argument + 1];
+        if (option == "--rows")
+            rowCounts = parseList(value);
+        else if (option == "--blocks")
+            blockCounts = parseList(value);
+        else if (option == "--columns")
+            columns = max(3, stoi(value));
+        else if (option == "--cardinality")
+            cardinality = max(1LL, stoll(value));
+        else if (option == "--skew")
+            skew = stod(value);
+        else if (option == "--density")
+            density = stod(value);
+        else if (option == "--output")
+            output = value;
+        else
+        {
+            cerr << "Unknown option " << option << endl;
+            return 1;
+        }
+    }
+
+    string commit = run("git rev-parse --short HEAD 2> /dev/null");
+    ofstream fout(output);
+    fout << "commit,rows,block_count,benchmark,rows_in,rows_out,wall_ms,cpu_ms,rows_per_second,blocks_read,"
+            "blocks_written,pool_hits,pool_misses,bytes_spilled,passes" << endl;
+    for (long long rows: rowCounts)
+    {
+        cerr << "Generating " << rows << " rows" << endl;
+        if (!generate(rows, columns, cardinality, skew, density))
+        {
+            cerr << "Generating the data failed" << endl;
+            return 1;
+        }
+        for (long long blockCount: blockCounts)
+        {
+            cerr << "Running " << rows << " rows with " << blockCount << " blocks" << endl;
+            if (!runBenchmarks(commit.empty() ? "unknown" : commit, rows, cardinality, blockCount, fout))
+            {
+                cerr << "The server failed" << endl;
+                return 1;
+            }
+        }
+    }
+    for (const string &relation: {"BENCH_R", "BENCH_S", "BENCH_T", "BENCH_M"})
+        remove(("../data/" + string(relation) + ".csv").c_str());
+    cerr << "Results written to " << output << endl;
+    return 0;
+}
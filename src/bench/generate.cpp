@@ -0,0 +1,115 @@
+#include <bits/stdc++.h>
+
+using namespace std;
+
+/**
+ * @brief Generates synthetic relations and matrices for the benchmarks.
+ *
+ * SYNTAX: generate table <name> <rows> <columns> <cardinality> <skew> [seed]
+ *         generate matrix <name> <dimension> <density> [seed]
+ *
+ * Tables are written to ../data/<name>.csv with the columns <name>_0,
+ * <name>_1, ... Every value is drawn from 0 .. cardinality - 1 following a
+ * Zipf distribution with the given skew (0 is uniform), each column ranking
+ * the values in its own random order.
+ *
+ * Matrices are written to ../data/<name>.csv as dimension x dimension cells.
+ * A cell is non zero (between -1000 and 1000) with probability density.
+ */
+
+/**
+ * @brief Draws values 0 .. cardinality - 1, the value of rank k with a
+ * probability proportional to 1 / (k + 1)^skew
+ */
+class ZipfGenerator
+{
+    vector<double> cumulative;
+    vector<int> valueOfRank;
+    uniform_real_distribution<double> uniform;
+
+public:
+    ZipfGenerator(int cardinality, double skew, mt19937_64 &random) : cumulative(cardinality), valueOfRank(cardinality)
+    {
+        double total = 0;
+        for (int rank = 0; rank < cardinality; rank++)
+            this->cumulative[rank] = total += pow(rank + 1.0, -skew);
+        this->uniform = uniform_real_distribution<double>(0, total);
+        iota(this->valueOfRank.begin(), this->valueOfRank.end(), 0);
+        shuffle(this->valueOfRank.begin(), this->valueOfRank.end(), random);
+    }
+
+    int operator()(mt19937_64 &random)
+    {
+        size_t rank = lower_bound(this->cumulative.begin(), this->cumulative.end(), this->uniform(random)) - this->cumulative.begin();
+        return this->valueOfRank[min(rank, this->valueOfRank.size() - 1)];
+    }
+};
+
+bool generateTable(const string &name, long long rows, int columns, int cardinality, double skew, mt19937_64 &random)
+{
+    ofstream fout("../data/" + name + ".csv");
+    if (!fout || rows < 0 || columns < 1 || cardinality < 1 || skew < 0)
+        return false;
+    vector<ZipfGenerator> generators;
+    for (int column = 0; column < columns; column++)
+        generators.emplace_back(cardinality, skew, random);
+    string line;
+    for (int column = 0; column < columns; column++)
+        line += (column ? ", " : "") + name + "_" + to_string(column);
+    fout << line << '\n';
+    for (long long row = 0; row < rows; row++)
+    {
+        line.clear();
+        for (int column = 0; column < columns; column++)
+            line += (column ? ", " : "") + to_string(generators[column](random));
+        fout << line << '\n';
+    }
+    return (bool) fout;
+}
+
+bool generateMatrix(const string &name, long long dimension, double density, mt19937_64 &random)
+{
+    ofstream fout("../data/" + name + ".csv");
+    if (!fout || dimension < 1 || density < 0 || density > 1)
+        return false;
+    bernoulli_distribution nonZero(density);
+    uniform_int_distribution<int> value(-1000, 1000);
+    string line;
+    for (long long row = 0; row < dimension; row++)
+    {
+        line.clear();
+        for (long long column = 0; column < dimension; column++)
+            line += (column ? ", " : "") + to_string(nonZero(random) ? value(random) : 0);
+        fout << line << '\n';
+    }
+    return (bool) fout;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> arguments(argv + 1, argv + argc);
+    bool generated = false;
+    if (arguments.size() >= 6 && arguments[0] == "table")
+    {
+        mt19937_64 random(arguments.size() > 6 ? stoull(arguments[6]) : 42);
+        generated = generateTable(arguments[1], stoll(arguments[2]), stoi(arguments[3]), stoi(arguments[4]),
+                                  stod(arguments[5]), random);
+    }
+    else if (arguments.size() >= 4 && arguments[0] == "matrix")
+    {
+        mt19937_64 random(arguments.size() > 4 ? stoull(arguments[4]) : 42);
+        generated = generateMatrix(arguments[1], stoll(arguments[2]), stod(arguments[3]), random);
+    }
+    else
+    {
+        cerr << "Usage: " << argv[0] << " table <name> <rows> <columns> <cardinality> <skew> [seed]" << endl;
+        cerr << "       " << argv[0] << " matrix <name> <dimension> <density> [seed]" << endl;
+        return 1;
+    }
+    if (!generated)
+    {
+        cerr << "Could not generate " << arguments[1] << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,16 +1,23 @@
 #include "global.h"
 
 void BlockStats::ReadBlock() { this->blocksRead++; }
-void BlockStats::WriteBlock() { this->blocksWritten++; }
+void BlockStats::WriteBlock(long long bytes) {
+    this->blocksWritten++;
+    this->bytesWritten += bytes;
+}
+void BlockStats::PoolHit() { this->poolHits++; }
+void BlockStats::PoolMiss() { this->poolMisses++; }
 
 /**
  * @brief Logs the stats of the number of blocks read, written and accessed. Doesn't
  * count reads from memory as a read.
  */
 void BlockStats::log() {
-    cout << "\nNumber of blocks read: " << this->blocksRead << endl;
-    cout << "Number of blocks written: " << this->blocksWritten << endl;
-    cout << "Number of blocks accessed: " << this->blocksRead + this->blocksWritten << endl;
+    long long blocksRead = this->blocksRead - this->blocksReadBefore;
+    long long blocksWritten = this->blocksWritten - this->blocksWrittenBefore;
+    cout << "\nNumber of blocks read: " << blocksRead << endl;
+    cout << "Number of blocks written: " << blocksWritten << endl;
+    cout << "Number of blocks accessed: " << blocksRead + blocksWritten << endl;
     clearStats();
 }
 
@@ -18,6 +25,6 @@ void BlockStats::log() {
  * @brief Sets the block statistics to 0
  */
 void BlockStats::clearStats() {
-    this->blocksRead = 0;
-    this->blocksWritten = 0;
-}
+    this->blocksReadBefore = this->blocksRead;
+    this->blocksWrittenBefore = this->blocksWritten;
+}
\ No newline at end of file
@@ -1,9 +1,15 @@
 class BlockStats {
 public:
-    int blocksWritten, blocksRead;
-    BlockStats(): blocksWritten(0), blocksRead(0) {}
+    // Pages are also read and written off the main thread. The counters only
+    // grow, so the profiler can take differences while statements log and
+    // clear theirs; log reports the counts since the last clearStats.
+    atomic<long long> blocksWritten, blocksRead, bytesWritten, poolHits, poolMisses;
+    long long blocksWrittenBefore = 0, blocksReadBefore = 0;
+    BlockStats(): blocksWritten(0), blocksRead(0), bytesWritten(0), poolHits(0), poolMisses(0) {}
     void ReadBlock();
-    void WriteBlock();
+    void WriteBlock(long long bytes = 0);
+    void PoolHit();
+    void PoolMiss();
     void log();
     void clearStats();
 };
\ No newline at end of file
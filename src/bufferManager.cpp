@@ -1,102 +1,286 @@
 #include "global.h"
 
 BufferManager::BufferManager() {
-    logger.log("BufferManager::BufferManager");
-    this->blocksWritten = this->blocksRead = 0;
+    LOG_TRACE("BufferManager::BufferManager");
+    this->replacementPolicy = ReplacementPolicy::create(REPLACEMENT_STRATEGY);
+}
+
+BufferManager::~BufferManager() {
+    delete this->replacementPolicy;
 }
 
 /**
- * @brief Function called to read a page from the buffer manager. If the page is
- * not present in the pool, the page is read and then inserted into the pool.
+ * @brief Partition of the page table the page belongs to
  *
- * @param tableName 
- * @param pageIndex 
- * @return Page*
+ * @param pageName
+ * @return PageTablePartition&
+ */
+PageTablePartition &BufferManager::partitionOf(const string &pageName) {
+    return this->pageTable[hash<string>()(pageName) % PAGE_TABLE_PARTITIONS];
+}
+
+/**
+ * @brief Looks the page up in the page table, adding a pin to its frame if
+ * pin is set.
+ *
+ * @param pageName
+ * @param pin
+ * @return Frame* nullptr if the page isn't in the pool
  */
-Page *BufferManager::getPage(string tableName, int pageIndex, datatype d) {
-    logger.log("BufferManager::getPage");
+Frame *BufferManager::findFrame(const string &pageName, bool pin) {
+    PageTablePartition &partition = this->partitionOf(pageName);
+    lock_guard<mutex> guard(partition.latch);
+    auto it = partition.pages.find(pageName);
+    if (it == partition.pages.end())
+        return nullptr;
+    if (pin)
+        it->second->pinCount++;
+    return it->second;
+}
+
+/**
+ * @brief Enters an empty frame into the page table under pageName. The pool
+ * latch and the latch of the page's partition have to be held.
+ *
+ * @param frame
+ * @param pageName
+ * @param tableName
+ */
+void BufferManager::registerFrame(Frame &frame, const string &pageName, const string &tableName) {
+    frame.pageName = pageName;
+    frame.tableName = tableName;
+    this->partitionOf(pageName).pages[pageName] = &frame;
+}
+
+/**
+ * @brief Pins the page in the pool, reading it in if required. The frame
+ * won't be replaced until every pin on it has been released through unpin.
+ * The page is read with no pool or partition latch held, so other sessions
+ * go on using the pool meanwhile; if two sessions miss on the same page only
+ * one of them reads it.
+ *
+ * @param tableName
+ * @param pageIndex
+ * @return PageHandle
+ */
+PageHandle BufferManager::pin(string tableName, int pageIndex, datatype d) {
+    LOG_TRACE("BufferManager::pin");
     string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
-    if (this->inPool(pageName))
-        return this->getFromPool(pageName);
+    Frame *frame = this->findFrame(pageName, true);
+    bool reading = false;
+    if (frame)
+        blockStats.PoolHit();
+    else {
+        blockStats.PoolMiss();
+        lock_guard<mutex> guard(this->poolLatch);
+        Frame &freeFrame = this->getFreeFrame();
+        PageTablePartition &partition = this->partitionOf(pageName);
+        lock_guard<mutex> partitionGuard(partition.latch);
+        auto it = partition.pages.find(pageName);
+        if (it != partition.pages.end()) {
+            // Another session brought the page in meanwhile
+            this->freeFrames.push_back(freeFrame.id);
+            frame = it->second;
+            frame->pinCount++;
+        } else {
+            frame = &freeFrame;
+            frame->pinCount = 1;
+            frame->latch.lock();
+            this->registerFrame(*frame, pageName, tableName);
+            reading = true;
+        }
+    }
+    if (!reading) {
+        // Waits for the page if it is still being read in
+        shared_lock<shared_mutex> latch(frame->latch);
+        return {frame, &frame->page};
+    }
+    if (this->prefetcher.take(pageName, frame->page))
+        for (int block = 0; block < frame->page.getBlockSpan(); block++)
+            blockStats.ReadBlock();
     else
-        return this->insertIntoPool(tableName, pageIndex, d);
+        frame->page = Page(tableName, pageIndex, d);
+    frame->latch.unlock();
+    return {frame, &frame->page};
 }
 
 /**
- * @brief Checks to see if a page exists in the pool
+ * @brief Adds one more pin to an already pinned frame (used when a handle is
+ * copied).
  *
- * @param pageName 
- * @return true 
- * @return false 
+ * @param handle
  */
-bool BufferManager::inPool(string pageName) {
-    logger.log("BufferManager::inPool");
-    for (auto page: this->pages) {
-        if (pageName == page.pageName and !page.isDeleted())
-            return true;
-    }
-    return false;
+void BufferManager::pin(const PageHandle &handle) {
+    if (handle.valid())
+        handle.frame->pinCount++;
 }
 
 /**
- * @brief If the page is present in the pool, then this function returns the
- * page. Note that this function will fail if the page is not present in the
- * pool.
+ * @brief Releases a pin. Once a frame has no pins left it becomes a
+ * replacement candidate again, or is freed if its page was detached meanwhile.
  *
- * @param pageName 
- * @return Page*
+ * @param handle
  */
-Page *BufferManager::getFromPool(string pageName) {
-    logger.log("BufferManager::getFromPool");
-    for (auto &page: this->pages)
-        if (pageName == page.pageName)
-            return &page;
+void BufferManager::unpin(PageHandle &handle) {
+    if (!handle.valid())
+        return;
+    Frame *frame = handle.frame;
+    handle = PageHandle();
+    lock_guard<mutex> guard(this->poolLatch);
+    assert(frame->pinCount > 0); //Should never occur. Sanity check
+    if (--frame->pinCount)
+        return;
+    if (frame->detached)
+        this->releaseFrame(*frame);
+    else
+        this->replacementPolicy->recordAccess(frame->id);
 }
 
 /**
- * @brief Inserts page indicated by tableName and pageIndex into pool. If the
- * pool is full, the pool ejects the oldest inserted page from the pool and adds
- * the current page at the end. It naturally follows a queue data structure. 
+ * @brief Asks for a page to be read in the background so that a later pin
+ * doesn't have to wait for the disk. Pages already in the pool or in the
+ * prefetch reserve are left alone.
  *
- * @param tableName 
- * @param pageIndex 
- * @return Page*
- */
-Page *BufferManager::insertIntoPool(string tableName, int pageIndex, datatype d) {
-    logger.log("BufferManager::insertIntoPool");
-    this->blocksRead++;
-    Page page(tableName, pageIndex, d);
-    if (this->pages.size() >= BLOCK_COUNT) {
-        if (!pages.front().isDeleted() and pages.front().isDirty()) {
-            pages.front().writePage();
-            this->blocksWritten++;
+ * @param tableName
+ * @param pageIndex
+ */
+void BufferManager::prefetch(string tableName, int pageIndex, datatype d) {
+    LOG_TRACE("BufferManager::prefetch");
+    string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
+    if (!PREFETCH_COUNT || this->findFrame(pageName, false) || this->prefetcher.contains(pageName))
+        return;
+    this->prefetcher.request(Page(tableName, pageIndex, d, true));
+}
+
+/**
+ * @brief Returns an empty frame. If BLOCK_COUNT frames are in use, the
+ * replacement policy picks the frame whose page gets ejected (written back
+ * first if it is dirty). Frames pinned since they were last unpinned are
+ * passed over. If every frame is pinned the pool temporarily grows past
+ * BLOCK_COUNT. The pool latch has to be held.
+ *
+ * @return Frame&
+ */
+Frame &BufferManager::getFreeFrame() {
+    while (this->frames.size() - this->freeFrames.size() >= BLOCK_COUNT) {
+        int victim = this->replacementPolicy->pickVictim();
+        if (victim == -1) {
+            LOG_WARNING("BufferManager::getFreeFrame: every frame is pinned");
+            break;
         }
-        pages.pop_front();
+        if (this->evictFrame(this->frames[victim], true, false))
+            break;
+        this->replacementPolicy->remove(victim);
     }
-    pages.push_back(page);
-    return &pages.back();
+    if (this->freeFrames.empty()) {
+        this->frames.emplace_back();
+        this->frames.back().id = this->frames.size() - 1;
+        return this->frames.back();
+    }
+    Frame &frame = this->frames[this->freeFrames.back()];
+    this->freeFrames.pop_back();
+    return frame;
+}
+
+/**
+ * @brief Removes the page held in the frame from the pool. If writeBack is
+ * set and the page is dirty, it is written to disk before the frame is
+ * released. A pinned frame is left alone unless detachPinned is set; then it
+ * is only detached from the page table and freed when the last pin goes
+ * away. The pool latch has to be held.
+ *
+ * @param frame
+ * @param writeBack
+ * @param detachPinned
+ * @return false if the frame is pinned and was left alone
+ */
+bool BufferManager::evictFrame(Frame &frame, bool writeBack, bool detachPinned) {
+    LOG_TRACE("BufferManager::evictFrame");
+    {
+        PageTablePartition &partition = this->partitionOf(frame.pageName);
+        lock_guard<mutex> guard(partition.latch);
+        if (frame.pinCount && !detachPinned)
+            return false;
+        partition.pages.erase(frame.pageName);
+    }
+    // Nobody can pin the frame anymore and unpins wait for the pool latch
+    if (writeBack and frame.page.isDirty())
+        frame.page.writePage();
+    this->replacementPolicy->remove(frame.id);
+    if (frame.pinCount) {
+        frame.detached = true;
+        frame.pageName.clear();
+        return true;
+    }
+    this->releaseFrame(frame);
+    return true;
+}
+
+/**
+ * @brief Clears a frame that is no longer part of the page table and puts it
+ * back on the free list.
+ *
+ * @param frame
+ */
+void BufferManager::releaseFrame(Frame &frame) {
+    frame.page = Page();
+    frame.pageName.clear();
+    frame.tableName.clear();
+    frame.detached = false;
+    this->freeFrames.push_back(frame.id);
 }
 
 /**
  * @brief The buffer manager is also responsible for writing pages. This is
- * called when new tables are created using assignment statements.
+ * called when new tables are created using assignment statements. With
+ * write-behind (WRITE_BEHIND_PAGES non zero) new pages are put into the pool
+ * as dirty frames instead of being written out (except for DSM pages).
  *
  * @param tableName 
  * @param pageIndex 
  * @param rows 
  * @param rowCount 
+ * @param layout layout of the table the page belongs to
+ * @param compressed whether the table stores its pages compressed
  */
-void BufferManager::writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount) {
-    logger.log("BufferManager::writePage");
+void BufferManager::writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount, PageLayout layout,
+                              bool compressed) {
+    LOG_TRACE("BufferManager::writePage");
 
     string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
-    if (!inPool(pageName)) {
-        this->blocksWritten++;
-        Page page(tableName, pageIndex, rows, rowCount, colCount);
-        page.writePage();
+    this->prefetcher.discard(pageName);
+    if (layout == DSM) {
+        // Columns of DSM tables are also read straight from their chains
+        // (see Page::readColumns), so their pages are written through and
+        // the pool never holds a dirty one
+        {
+            lock_guard<mutex> guard(this->poolLatch);
+            if (Frame *frame = this->findFrame(pageName, false))
+                this->evictFrame(*frame, false, true);
+        }
+        Page(tableName, pageIndex, rows, rowCount, colCount, layout, compressed).writePage();
+    } else if (Frame *frame = this->findFrame(pageName, true)) {
+        {
+            unique_lock<shared_mutex> latch(frame->latch);
+            frame->page.modifyPage(rows, rowCount, colCount);
+        }
+        PageHandle handle{frame, &frame->page};
+        this->unpin(handle);
+    } else if (WRITE_BEHIND_PAGES) {
+        // The page only reaches the disk if it is evicted before its table is
+        // deleted
+        Page page(tableName, pageIndex, rows, rowCount, colCount, layout, compressed);
+        page.setDirty();
+        lock_guard<mutex> guard(this->poolLatch);
+        Frame &frame = this->getFreeFrame();
+        frame.page = std::move(page);
+        {
+            lock_guard<mutex> partitionGuard(this->partitionOf(pageName).latch);
+            this->registerFrame(frame, pageName, tableName);
+        }
+        this->replacementPolicy->recordAccess(frame.id);
     } else {
-        auto page = getFromPool(pageName);
-        page->modifyPage(rows, rowCount, colCount);
+        Page(tableName, pageIndex, rows, rowCount, colCount, layout, compressed).writePage();
     }
 }
 
@@ -108,64 +292,114 @@ void BufferManager::writePage(string tableName, int pageIndex, vector<vector<int
 void BufferManager::deleteFile(string fileName) {
 
     if (remove(fileName.c_str()))
-        logger.log("BufferManager::deleteFile: Err");
-    else logger.log("BufferManager::deleteFile: Success");
+        LOG_WARNING("BufferManager::deleteFile: Err");
+    else LOG_DEBUG("BufferManager::deleteFile: Success");
 }
 
 /**
- * @brief Renames file from oldName to newName
+ * @brief Writes the dirty pages of the relation held in the pool to disk.
+ * They stay in the pool, now clean. Afterwards the disk holds every page of
+ * the relation, for code that reads pages without the pool.
  *
- * @param oldName
- * @param newName
+ * @param relationName all relations if empty
  */
-void BufferManager::renameFile(string oldName, string newName) {
+void BufferManager::flushPages(const string &relationName) {
+    LOG_TRACE("BufferManager::flushPages");
+    lock_guard<mutex> guard(this->poolLatch);
+    for (Frame &frame: this->frames) {
+        // A frame whose page is still being read in is clean
+        if (frame.pageName.empty() || (!relationName.empty() && frame.tableName != relationName) ||
+            !frame.latch.try_lock_shared())
+            continue;
+        if (frame.page.isDirty())
+            frame.page.writePage();
+        frame.latch.unlock_shared();
+    }
+}
 
-    if (rename(oldName.c_str(), newName.c_str()))
-        logger.log("BufferManager::renameFile: Err");
-    else logger.log("BufferManager::renameFile: Success");
+/**
+ * @brief Ejects pages, as chosen by the replacement policy, until no more
+ * than BLOCK_COUNT frames are in use, e.g. after SET BUFFER_BLOCKS lowered
+ * it. Pinned frames stay, so the pool may remain larger until they are
+ * unpinned.
+ */
+void BufferManager::shrink() {
+    LOG_TRACE("BufferManager::shrink");
+    lock_guard<mutex> guard(this->poolLatch);
+    while (this->frames.size() - this->freeFrames.size() > BLOCK_COUNT) {
+        int victim = this->replacementPolicy->pickVictim();
+        if (victim == -1)
+            break;
+        if (!this->evictFrame(this->frames[victim], true, false))
+            this->replacementPolicy->remove(victim);
+    }
 }
 
 /**
- * @brief Goes through pages in the deque and renames pages from oldName to newName
+ * @brief Drops every page of the relation from the pool and the prefetch
+ * reserve without writing it back.
+ *
+ * @param relationName
+ */
+void BufferManager::dropPagesInMemory(const string &relationName) {
+    this->prefetcher.discardTable(relationName);
+    lock_guard<mutex> guard(this->poolLatch);
+    for (Frame &frame: this->frames)
+        if (!frame.pageName.empty() && frame.tableName == relationName)
+            this->evictFrame(frame, false, true);
+}
+
+/**
+ * @brief Goes through the pages in the pool and renames pages from oldName to
+ * newName. Pages already present under newName are about to be overwritten on
+ * disk, so they are dropped from the pool without being written back.
  *
  * @param oldName
  * @param newName
  */
-
 void BufferManager::renamePagesInMemory(string oldName, string newName) {
     assert(oldName != newName); //Should never occur. Sanity check
-    for (auto &page: this->pages) {
-        if (page.getTableName() == newName)
-            page.setDeleted();
-        else if (page.getTableName() == oldName)
-            page.setPageName(newName);
+    this->prefetcher.discardTable(oldName);
+    this->dropPagesInMemory(newName);
+    lock_guard<mutex> guard(this->poolLatch);
+    for (Frame &frame: this->frames) {
+        if (frame.pageName.empty() || frame.tableName != oldName)
+            continue;
+        // Waits for the page if it is still being read in
+        unique_lock<shared_mutex> latch(frame.latch);
+        {
+            PageTablePartition &partition = this->partitionOf(frame.pageName);
+            lock_guard<mutex> partitionGuard(partition.latch);
+            partition.pages.erase(frame.pageName);
+        }
+        frame.page.setPageName(newName);
+        lock_guard<mutex> partitionGuard(this->partitionOf(frame.page.pageName).latch);
+        this->registerFrame(frame, frame.page.pageName, newName);
     }
 }
 
 /**
- * @brief Overloaded function that calls deleteFile(fileName) by constructing
- * the fileName from the tableName and pageIndex.
+ * @brief Deletes the pages of a relation, on disk and in memory, so a later
+ * relation with the same name never sees stale rows.
  *
- * @param tableName 
- * @param pageIndex 
+ * @param relationName
+ * @param pageCount
  */
-void BufferManager::deleteFile(string tableName, int pageIndex) {
-    logger.log("BufferManager::deleteFile");
-    string fileName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
-    this->deleteFile(fileName);
+void BufferManager::deleteRelation(string relationName, uint pageCount) {
+    LOG_TRACE("BufferManager::deleteRelation");
+    this->dropPagesInMemory(relationName);
+    diskManager.deleteRelation(relationName, pageCount);
 }
 
 /**
- * @brief Overloaded function that calls renameFile(oldName, newName) by constructing
- * the fileName from the file names and pageIndex.
+ * @brief Renames the pages of a relation, on disk and in memory.
  *
  * @param oldName
  * @param newName
- * @param pageIndex
+ * @param pageCount
  */
-void BufferManager::renameFile(string oldName, string newName, int pageIndex) {
-    logger.log("BufferManager::deleteFile");
-    string oldFileName = "../data/temp/" + oldName + "_Page" + to_string(pageIndex);
-    string newFileName = "../data/temp/" + newName + "_Page" + to_string(pageIndex);
-    this->renameFile(oldFileName, newFileName);
-}
\ No newline at end of file
+void BufferManager::renameRelation(string oldName, string newName, uint pageCount) {
+    LOG_TRACE("BufferManager::renameRelation");
+    this->renamePagesInMemory(oldName, newName);
+    diskManager.renameRelation(oldName, newName, pageCount);
+}
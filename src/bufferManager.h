@@ -1,4 +1,6 @@
-#include"page.h"
+#include"diskManager.h"
+#include"prefetcher.h"
+#include"replacementPolicy.h"
 
 /**
  * @brief The BufferManager is responsible for reading pages to the main memory.
@@ -8,34 +10,108 @@
  * splitting and storing the file as multiple files each of one BLOCK_SIZE,
  * although this isn't traditionally how it's done. You can alternatively just
  * random access to the point where a block begins within the same
- * file. In this system we assume that the the sizes of blocks and pages are the
+ * file, which is what the DiskManager does when STORAGE_MODE is SEGMENT_FILES.
+ * In this system we assume that the the sizes of blocks and pages are the
  * same. 
  * 
  * <p>
- * The buffer can hold multiple pages quantified by BLOCK_COUNT. The
- * buffer manager follows the FIFO replacement policy i.e. the first block to be
- * read in is replaced by the new incoming block. This replacement policy should
- * be transparent to the executors i.e. the executor should not know if a block
- * was previously present in the buffer or was read in from the disk. 
+ * The buffer can hold multiple pages quantified by BLOCK_COUNT. Each page
+ * lives in a frame and the page table maps page names to frames so lookups
+ * don't have to scan the pool. When the pool is full the frame to replace is
+ * chosen by the ReplacementPolicy selected through REPLACEMENT_STRATEGY (FIFO,
+ * LRU, CLOCK or LRU-K). This replacement policy should be transparent to the
+ * executors i.e. the executor should not know if a block was previously
+ * present in the buffer or was read in from the disk. 
+ * </p>
+ *
+ * <p>
+ * Frames can be pinned through pin/unpin. A pinned frame is never chosen for
+ * replacement, which lets cursors read rows straight out of the pool instead
+ * of copying pages. A pinned page that gets deleted or overwritten is detached
+ * from the page table and its frame is reused once the last pin is released.
+ * </p>
+ *
+ * <p>
+ * Cursors that scan sequentially ask for the next PREFETCH_COUNT pages through
+ * prefetch; those are read in the background by the Prefetcher and handed
+ * over to the pool when the cursor reaches them.
+ * </p>
+ *
+ * <p>
+ * The pool is shared by the sessions of the server, which run statements at
+ * the same time. The page table is split into PAGE_TABLE_PARTITIONS
+ * partitions, each with a latch of its own, so that lookups of pages already
+ * in the pool only contend when they hash to the same partition. The pool
+ * latch guards the free list, the replacement policy and the growth of the
+ * pool; it is always taken before a partition latch, never after one. A page
+ * is read from the disk holding neither, with the latch of its frame held
+ * exclusively, and whoever finds the frame meanwhile waits on that latch.
+ * Pins are counted under the partition latch, so a frame can only be chosen
+ * for eviction once nobody can pin it anymore. Page contents themselves are
+ * not latched while being read: the locks statements take on relations (see
+ * LockManager) keep a relation from being written while it is read.
  * </p>
  *
  */
+const uint PAGE_TABLE_PARTITIONS = 16;
+
+/**
+ * @brief A frame of the pool. pageName is the name the frame is registered
+ * under in the page table (empty for a free frame). Frames are never moved,
+ * so pointers to them stay valid for the life of the pool.
+ */
+struct Frame {
+    int id = -1;
+    string pageName;
+    string tableName;
+    Page page;
+    atomic<int> pinCount{0};
+    bool detached = false;
+    shared_mutex latch;
+};
+
+struct PageHandle {
+    Frame *frame = nullptr;
+    Page *page = nullptr;
+
+    bool valid() const { return frame != nullptr; }
+};
+
+struct PageTablePartition {
+    mutex latch;
+    unordered_map<string, Frame*> pages;
+};
+
 class BufferManager{
 
-    deque<Page> pages;
-    uint blocksWritten, blocksRead;
-    bool inPool(string pageName);
-    Page* getFromPool(string pageName);
-    Page* insertIntoPool(string tableName, int pageIndex, datatype d);
+    deque<Frame> frames;
+    vector<int> freeFrames;
+    PageTablePartition pageTable[PAGE_TABLE_PARTITIONS];
+    mutex poolLatch;
+    ReplacementPolicy* replacementPolicy;
+    Prefetcher prefetcher;
+    PageTablePartition &partitionOf(const string &pageName);
+    Frame* findFrame(const string &pageName, bool pin);
+    void registerFrame(Frame &frame, const string &pageName, const string &tableName);
+    Frame& getFreeFrame();
+    bool evictFrame(Frame &frame, bool writeBack, bool detachPinned);
+    void releaseFrame(Frame &frame);
+    void renamePagesInMemory(string oldName, string newName);
 
     public:
     
     BufferManager();
-    Page* getPage(string tableName, int pageIndex, datatype d);
-    void deleteFile(string tableName, int pageIndex);
+    ~BufferManager();
+    PageHandle pin(string tableName, int pageIndex, datatype d);
+    void pin(const PageHandle &handle);
+    void unpin(PageHandle &handle);
+    void prefetch(string tableName, int pageIndex, datatype d);
+    void flushPages(const string &relationName = "");
+    void shrink();
+    void dropPagesInMemory(const string &relationName);
     void deleteFile(string fileName);
-    void renameFile(string oldName, string newName, int pageIndex);
-    void renameFile(string oldName, string newName);
-    void writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount);
-    void renamePagesInMemory(string oldName, string newName);
+    void deleteRelation(string relationName, uint pageCount);
+    void renameRelation(string oldName, string newName, uint pageCount);
+    void writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount, PageLayout layout = NSM,
+                   bool compressed = false);
 };
\ No newline at end of file
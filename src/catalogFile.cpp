@@ -0,0 +1,69 @@
+#include "global.h"
+
+/**
+ * @brief FNV-1a hash of a run of bytes, continuing from hash
+ */
+static uint64_t checksumOf(const char *data, size_t length, uint64_t hash)
+{
+    for (size_t byte = 0; byte < length; byte++)
+        hash = (hash ^ (unsigned char) data[byte]) * 1099511628211ull;
+    return hash;
+}
+
+CatalogWriter::CatalogWriter(const string &fileName) : out(fileName, ios::out | ios::binary | ios::trunc)
+{
+    LOG_TRACE("CatalogWriter::CatalogWriter");
+}
+
+void CatalogWriter::writeBytes(const void *data, size_t length)
+{
+    this->checksum = checksumOf((const char *) data, length, this->checksum);
+    this->out.write((const char *) data, length);
+}
+
+/**
+ * @brief Appends the checksum and closes the file
+ *
+ * @return true if everything has been written
+ */
+bool CatalogWriter::finish()
+{
+    LOG_TRACE("CatalogWriter::finish");
+    uint64_t sum = this->checksum;
+    this->out.write((const char *) &sum, sizeof(sum));
+    this->out.close();
+    return !this->out.fail();
+}
+
+/**
+ * @brief Reads the file and checks its checksum. A missing file fails the
+ * reader like a corrupt one.
+ *
+ * @param fileName
+ */
+CatalogReader::CatalogReader(const string &fileName)
+{
+    LOG_TRACE("CatalogReader::CatalogReader");
+    ifstream fin(fileName, ios::in | ios::binary);
+    this->contents.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+    uint64_t sum;
+    if (!fin.is_open() || this->contents.size() < sizeof(sum)) {
+        this->failed = true;
+        return;
+    }
+    memcpy(&sum, this->contents.data() + this->contents.size() - sizeof(sum), sizeof(sum));
+    this->contents.resize(this->contents.size() - sizeof(sum));
+    if (checksumOf(this->contents.data(), this->contents.size(), CATALOG_CHECKSUM_SEED) != sum) {
+        LOG_WARNING("CatalogReader::CatalogReader: checksum mismatch");
+        this->failed = true;
+    }
+}
+
+bool CatalogReader::readBytes(void *data, size_t length)
+{
+    if (this->failed || length > this->contents.size() - this->position)
+        return this->failed = true, false;
+    memcpy(data, this->contents.data() + this->position, length);
+    this->position += length;
+    return true;
+}
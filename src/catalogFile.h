@@ -0,0 +1,108 @@
+#ifndef CATALOG_FILE_H
+#define CATALOG_FILE_H
+#include"logger.h"
+
+const uint64_t CATALOG_CHECKSUM_SEED = 14695981039346656037ull; // FNV-1a offset basis
+
+/**
+ * @brief Writes the binary file the catalogue is persisted in (see
+ * TableCatalogue::save). Values are written in the host's byte order, strings
+ * and vectors preceded by their length, and finish appends a checksum of
+ * everything written so that a torn or foreign file is never trusted.
+ */
+class CatalogWriter {
+    ofstream out;
+    uint64_t checksum = CATALOG_CHECKSUM_SEED;
+
+    void writeBytes(const void *data, size_t length);
+
+public:
+    CatalogWriter(const string &fileName);
+
+    template <typename T>
+    void write(const T &value)
+    {
+        static_assert(is_trivially_copyable<T>::value, "only plain values are written as bytes");
+        this->writeBytes(&value, sizeof(T));
+    }
+
+    void write(const string &value)
+    {
+        this->write((uint64_t) value.size());
+        this->writeBytes(value.data(), value.size());
+    }
+
+    template <typename A, typename B>
+    void write(const pair<A, B> &value)
+    {
+        this->write(value.first);
+        this->write(value.second);
+    }
+
+    template <typename T>
+    void write(const vector<T> &values)
+    {
+        this->write((uint64_t) values.size());
+        for (const T &value: values)
+            this->write(value);
+    }
+
+    bool finish();
+};
+
+/**
+ * @brief Reads a file written by a CatalogWriter. The whole file is read and
+ * its checksum verified up front; reads past the end or of lengths the file
+ * can't hold fail the reader instead of reading garbage, and every read after
+ * a failure is ignored.
+ */
+class CatalogReader {
+    vector<char> contents;
+    size_t position = 0;
+    bool failed = false;
+
+    bool readBytes(void *data, size_t length);
+
+public:
+    CatalogReader(const string &fileName);
+    bool good() const { return !this->failed; }
+    bool atEnd() const { return this->position == this->contents.size(); }
+
+    template <typename T>
+    bool read(T &value)
+    {
+        static_assert(is_trivially_copyable<T>::value, "only plain values are read as bytes");
+        return this->readBytes(&value, sizeof(T));
+    }
+
+    bool read(string &value)
+    {
+        uint64_t length = 0;
+        if (!this->read(length) || length > this->contents.size() - this->position)
+            return this->failed = true, false;
+        value.assign(this->contents.data() + this->position, length);
+        this->position += length;
+        return true;
+    }
+
+    template <typename A, typename B>
+    bool read(pair<A, B> &value)
+    {
+        return this->read(value.first) && this->read(value.second);
+    }
+
+    template <typename T>
+    bool read(vector<T> &values)
+    {
+        uint64_t length = 0;
+        if (!this->read(length) || length > this->contents.size() - this->position)
+            return this->failed = true, false;
+        values.assign(length, T());
+        for (T &value: values)
+            if (!this->read(value))
+                return false;
+        return true;
+    }
+};
+
+#endif //CATALOG_FILE_H
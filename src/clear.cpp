@@ -3,11 +3,14 @@
 /**
  * @brief 
  * SYNTAX: CLEAR <relation_name> 
+ *
+ * The relation can be a table or a matrix. A table holding a result that can
+ * be reused is handed to the ResultCache instead of being deleted.
  */
 
 bool syntacticParseCLEAR()
 {
-    logger.log("syntacticParseCLEAR");
+    LOG_TRACE("syntacticParseCLEAR");
     if (tokenizedQuery.size() != 2)
     {
         cout << "SYNTAX ERROR" << endl;
@@ -20,9 +23,9 @@ bool syntacticParseCLEAR()
 
 bool semanticParseCLEAR()
 {
-    logger.log("semanticParseCLEAR");
-    //Table should exist
-    if (tableCatalogue.isTable(parsedQuery.clearRelationName))
+    LOG_TRACE("semanticParseCLEAR");
+    //Table or matrix should exist
+    if (tableCatalogue.isTable(parsedQuery.clearRelationName) || tableCatalogue.isMatrix(parsedQuery.clearRelationName))
         return true;
     cout << "SEMANTIC ERROR: No such relation exists" << endl;
     return false;
@@ -30,8 +33,11 @@ bool semanticParseCLEAR()
 
 void executeCLEAR()
 {
-    logger.log("executeCLEAR");
+    LOG_TRACE("executeCLEAR");
     //Deleting table from the catalogue deletes all temporary files
-    tableCatalogue.deleteTable(parsedQuery.clearRelationName);
+    if (tableCatalogue.isMatrix(parsedQuery.clearRelationName))
+        tableCatalogue.deleteMatrix(parsedQuery.clearRelationName);
+    else if (!resultCache.release(parsedQuery.clearRelationName))
+        tableCatalogue.deleteTable(parsedQuery.clearRelationName);
     return;
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "global.h"
+#include <sys/mman.h>
+
+const size_t COLUMNAR_HEADER_BYTES = 24;
+
+string ColumnarFile::fileName(const string &relationName) {
+    return "../data/" + relationName + ".col";
+}
+
+bool ColumnarFile::exists(const string &relationName) {
+    struct stat buffer;
+    return stat(fileName(relationName).c_str(), &buffer) == 0;
+}
+
+/**
+ * @brief Writes the table to its columnar file. The pages are read a chunk
+ * at a time; the columns of a chunk are gathered and written to their places
+ * in the file in parallel.
+ *
+ * @param table
+ * @return false if the file can't be written
+ */
+bool ColumnarFile::write(Table *table) {
+    LOG_TRACE("ColumnarFile::write");
+    int fd = open(fileName(table->tableName).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("ColumnarFile::write: Err");
+        return false;
+    }
+    uint32_t fields[] = {MAGIC, VERSION, table->columnCount, 0};
+    uint64_t rowCount = table->rowCount;
+    string header((const char *) fields, sizeof(fields));
+    header.append((const char *) &rowCount, sizeof(rowCount));
+    for (const string &columnName: table->columns) {
+        uint32_t length = columnName.size();
+        header.append((const char *) &length, sizeof(length));
+        header += columnName;
+    }
+    header.resize((header.size() + 7) / 8 * 8, '\0');
+    bool written = pwrite(fd, header.data(), header.size(), 0) == (ssize_t) header.size();
+
+    uint chunkPages = max(1u, (uint) (CsvWriter::CHUNK_BYTES / (BLOCK_SIZE * 1000)));
+    vector<int> values;
+    vector<vector<int>> columnValues(table->columnCount);
+    vector<char> columnWritten(table->columnCount);
+    uint64_t firstRow = 0;
+    for (uint firstPage = 0; written && firstPage < table->blockCount; firstPage += chunkPages) {
+        values.clear();
+        long long chunkRows = table->readPages(firstPage, chunkPages, values);
+        threadPool.run(table->columnCount, [&](uint columnCounter) {
+            vector<int> &column = columnValues[columnCounter];
+            column.resize(chunkRows);
+            for (long long rowCounter = 0; rowCounter < chunkRows; rowCounter++)
+                column[rowCounter] = values[rowCounter * table->columnCount + columnCounter];
+            off_t offset = header.size() + (columnCounter * rowCount + firstRow) * sizeof(int);
+            ssize_t bytes = chunkRows * sizeof(int);
+            columnWritten[columnCounter] = pwrite(fd, column.data(), bytes, offset) == bytes;
+        });
+        written = all_of(columnWritten.begin(), columnWritten.end(), [](char columnWritten) { return columnWritten; });
+        firstRow += chunkRows;
+    }
+    written = close(fd) == 0 && written && firstRow == rowCount;
+    if (!written)
+        LOG_ERROR("ColumnarFile::write: Err");
+    return written;
+}
+
+/**
+ * @brief Construct a new ColumnarFile object that maps the columnar file of
+ * the relation and checks its layout
+ *
+ * @param relationName
+ */
+ColumnarFile::ColumnarFile(const string &relationName) {
+    LOG_TRACE("ColumnarFile::ColumnarFile");
+    int fd = open(fileName(relationName).c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && (size_t) fileStat.st_size >= COLUMNAR_HEADER_BYTES) {
+        void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            this->data = (const char *) mapping;
+            this->size = fileStat.st_size;
+            madvise(mapping, this->size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    if (!this->data)
+        return;
+
+    uint32_t fields[4];
+    memcpy(fields, this->data, sizeof(fields));
+    memcpy(&this->rowCount, this->data + sizeof(fields), sizeof(this->rowCount));
+    if (fields[0] != MAGIC || fields[1] != VERSION || fields[2] == 0)
+        return;
+    size_t position = COLUMNAR_HEADER_BYTES;
+    for (uint32_t columnCounter = 0; columnCounter < fields[2]; columnCounter++) {
+        uint32_t length;
+        if (position + sizeof(length) > this->size)
+            return;
+        memcpy(&length, this->data + position, sizeof(length));
+        position += sizeof(length);
+        if (length > this->size - position)
+            return;
+        this->columnNames.emplace_back(this->data + position, length);
+        position += length;
+    }
+    position = (position + 7) / 8 * 8;
+    if (position > this->size || this->rowCount > (this->size - position) / sizeof(int) / fields[2]) {
+        this->columnNames.clear();
+        return;
+    }
+    this->values = (const int *) (this->data + position);
+}
+
+ColumnarFile::~ColumnarFile() {
+    if (this->data)
+        munmap((void *) this->data, this->size);
+}
+
+bool ColumnarFile::isValid() const {
+    return this->values != nullptr;
+}
+
+const vector<string> &ColumnarFile::columns() const {
+    return this->columnNames;
+}
+
+uint64_t ColumnarFile::rows() const {
+    return this->rowCount;
+}
+
+/**
+ * @param columnIndex
+ * @return const int* the rows() values of the column
+ */
+const int *ColumnarFile::column(uint columnIndex) const {
+    return this->values + columnIndex * this->rowCount;
+}
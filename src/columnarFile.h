@@ -0,0 +1,44 @@
+#ifndef COLUMNAR_FILE_H
+#define COLUMNAR_FILE_H
+#include"logger.h"
+
+class Table;
+
+/**
+ * @brief Binary columnar files ("<relation>.col" in the data directory), the
+ * format of EXPORT ... BINARY and LOAD ... BINARY. A file holds
+ *
+ * - a header: magic, format version, column count (uint32 each), 4 bytes of
+ *   padding and the row count (uint64),
+ * - the column names, each a uint32 length followed by its characters,
+ *   padded with zeros to a multiple of 8 bytes,
+ * - the columns one after the other, each rowCount native int32 values.
+ *
+ * Reading maps the file and hands out the columns in place, so loading needs
+ * no parsing at all.
+ */
+class ColumnarFile{
+
+    const char *data = nullptr;
+    size_t size = 0;
+    vector<string> columnNames;
+    uint64_t rowCount = 0;
+    const int *values = nullptr;
+
+    public:
+
+    static const uint32_t MAGIC = 0x4c4f4352; // "RCOL"
+    static const uint32_t VERSION = 1;
+
+    static string fileName(const string &relationName);
+    static bool exists(const string &relationName);
+    static bool write(Table *table);
+
+    explicit ColumnarFile(const string &relationName);
+    ~ColumnarFile();
+    bool isValid() const;
+    const vector<string> &columns() const;
+    uint64_t rows() const;
+    const int *column(uint columnIndex) const;
+};
+#endif //COLUMNAR_FILE_H
@@ -0,0 +1,202 @@
+#include "global.h"
+
+/**
+ * @brief Number of bits required to represent value (0 for 0)
+ */
+int PageCodec::bitsNeeded(uint32_t value) {
+    return value ? 32 - __builtin_clz(value) : 0;
+}
+
+/**
+ * @brief Bytes taken by count codes of bitWidth bits, rounded up to whole
+ * 64 bit words.
+ */
+size_t PageCodec::packedBytes(int count, int bitWidth) {
+    return (((size_t) count * bitWidth + 63) / 64) * sizeof(uint64_t);
+}
+
+/**
+ * @brief Size of a column in the compressed page, descriptor included
+ *
+ * @param encoding
+ * @param rowCount
+ * @return size_t
+ */
+size_t PageCodec::encodedSize(const ColumnEncoding &encoding, int rowCount) {
+    return sizeof(ColumnEncodingHeader) + encoding.dictionary.size() * sizeof(int)
+           + packedBytes(rowCount, encoding.bitWidth);
+}
+
+/**
+ * @brief Picks the smallest encoding for count values read with the given
+ * stride.
+ *
+ * @param values
+ * @param count
+ * @param stride
+ * @return ColumnEncoding
+ */
+ColumnEncoding PageCodec::chooseEncoding(const int *values, int count, int stride) {
+    ColumnEncoding best;
+    if (count == 0)
+        return best;
+    int minimum = values[0], maximum = values[0];
+    bool sorted = true;
+    uint32_t largestDelta = 0;
+    for (int i = 1; i < count; i++) {
+        int value = values[i * stride], previous = values[(i - 1) * stride];
+        minimum = min(minimum, value), maximum = max(maximum, value);
+        if (value < previous)
+            sorted = false;
+        else
+            largestDelta = max(largestDelta, (uint32_t) ((int64_t) value - previous));
+    }
+
+    ColumnEncoding frameOfReference;
+    frameOfReference.type = FOR_ENCODING;
+    frameOfReference.base = minimum;
+    frameOfReference.bitWidth = bitsNeeded((uint32_t) ((int64_t) maximum - minimum));
+    if (encodedSize(frameOfReference, count) < encodedSize(best, count))
+        best = frameOfReference;
+
+    if (sorted) {
+        ColumnEncoding delta;
+        delta.type = DELTA_ENCODING;
+        delta.base = values[0];
+        delta.bitWidth = bitsNeeded(largestDelta);
+        if (encodedSize(delta, count) < encodedSize(best, count))
+            best = delta;
+    }
+
+    // A dictionary only pays off if its codes are narrower than the frame of
+    // reference codes
+    if (best.bitWidth == 0)
+        return best;
+    ColumnEncoding dictionary;
+    dictionary.type = DICTIONARY_ENCODING;
+    for (int i = 0; i < count; i++)
+        dictionary.dictionary.push_back(values[i * stride]);
+    std::sort(dictionary.dictionary.begin(), dictionary.dictionary.end());
+    dictionary.dictionary.erase(unique(dictionary.dictionary.begin(), dictionary.dictionary.end()),
+                                dictionary.dictionary.end());
+    dictionary.bitWidth = bitsNeeded(dictionary.dictionary.size() - 1);
+    if (dictionary.bitWidth < best.bitWidth && encodedSize(dictionary, count) < encodedSize(best, count))
+        best = dictionary;
+    return best;
+}
+
+/**
+ * @brief Appends the descriptor, the dictionary and the packed codes of a
+ * column to out.
+ *
+ * @param values
+ * @param count
+ * @param stride
+ * @param encoding
+ * @param out
+ */
+void PageCodec::encode(const int *values, int count, int stride, const ColumnEncoding &encoding, vector<char> &out) {
+    ColumnEncodingHeader header{encoding.type, encoding.bitWidth, encoding.base, (int32_t) encoding.dictionary.size()};
+    out.insert(out.end(), (const char *) &header, (const char *) (&header + 1));
+    out.insert(out.end(), (const char *) encoding.dictionary.data(),
+               (const char *) (encoding.dictionary.data() + encoding.dictionary.size()));
+
+    vector<uint64_t> words(packedBytes(count, encoding.bitWidth) / sizeof(uint64_t), 0);
+    size_t bit = 0;
+    for (int i = 0; i < count && encoding.bitWidth; i++, bit += encoding.bitWidth) {
+        int value = values[i * stride];
+        uint64_t code;
+        switch (encoding.type) {
+            case FOR_ENCODING: code = (uint32_t) ((int64_t) value - encoding.base); break;
+            case DELTA_ENCODING: code = i ? (uint32_t) ((int64_t) value - values[(i - 1) * stride]) : 0; break;
+            case DICTIONARY_ENCODING:
+                code = lower_bound(encoding.dictionary.begin(), encoding.dictionary.end(), value) - encoding.dictionary.begin();
+                break;
+            default: code = (uint32_t) value;
+        }
+        words[bit / 64] |= code << (bit % 64);
+        if (bit % 64 + encoding.bitWidth > 64)
+            words[bit / 64 + 1] |= code >> (64 - bit % 64);
+    }
+    out.insert(out.end(), (const char *) words.data(), (const char *) (words.data() + words.size()));
+}
+
+/**
+ * @brief Decodes one column written by encode, storing the values with the
+ * given stride and the column's encoding in encoding.
+ *
+ * @return const char* position right after the column, nullptr if the input
+ * is truncated
+ */
+const char* PageCodec::decode(const char *in, const char *end, int count, ColumnEncoding &encoding, int *values, int stride) {
+    ColumnEncodingHeader header;
+    if (end - in < (ptrdiff_t) sizeof(header))
+        return nullptr;
+    memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
+    encoding.type = (ColumnEncodingType) header.type;
+    encoding.bitWidth = header.bitWidth;
+    encoding.base = header.base;
+    size_t wordBytes = packedBytes(count, encoding.bitWidth);
+    if (end - in < (ptrdiff_t) (header.dictionarySize * sizeof(int) + wordBytes))
+        return nullptr;
+    // The payload isn't aligned, copy it out instead of casting
+    encoding.dictionary.resize(header.dictionarySize);
+    if (header.dictionarySize)
+        memcpy(encoding.dictionary.data(), in, header.dictionarySize * sizeof(int));
+    in += header.dictionarySize * sizeof(int);
+    vector<uint64_t> words(wordBytes / sizeof(uint64_t));
+    if (wordBytes)
+        memcpy(words.data(), in, wordBytes);
+    in += wordBytes;
+
+    uint64_t mask = encoding.bitWidth == 64 ? ~0ULL : (1ULL << encoding.bitWidth) - 1;
+    size_t bit = 0;
+    int previous = encoding.base;
+    for (int i = 0; i < count; i++, bit += encoding.bitWidth) {
+        uint64_t code = 0;
+        if (encoding.bitWidth) {
+            code = words[bit / 64] >> (bit % 64);
+            if (bit % 64 + encoding.bitWidth > 64)
+                code |= words[bit / 64 + 1] << (64 - bit % 64);
+            code &= mask;
+        }
+        int value;
+        switch (encoding.type) {
+            case FOR_ENCODING: value = (int) ((int64_t) encoding.base + code); break;
+            case DELTA_ENCODING: value = (int) ((int64_t) previous + code); break;
+            case DICTIONARY_ENCODING: value = encoding.dictionary[code]; break;
+            default: value = (int) (uint32_t) code;
+        }
+        values[i * stride] = previous = value;
+    }
+    return in;
+}
+
+/**
+ * @brief Largest number of rows per page for which every page of a table with
+ * the given column ranges fits into one block once compressed. The frame of
+ * reference codes of a page are never wider than the range of the whole
+ * column and the codec never picks anything larger, so the bound holds for
+ * any subset or permutation of the rows (as written by sorting).
+ *
+ * @param columnRanges minimum and maximum of every column
+ * @return uint 0 if not even one row fits
+ */
+uint PageCodec::maxRowsPerBlock(const vector<pair<int, int>> &columnRanges) {
+    size_t budget = BLOCK_SIZE * 1000;
+    size_t descriptorBytes = columnRanges.size() * sizeof(ColumnEncodingHeader);
+    if (descriptorBytes >= budget)
+        return 0;
+    size_t rowBits = 0;
+    for (auto &[minimum, maximum]: columnRanges)
+        rowBits += bitsNeeded((uint32_t) ((int64_t) maximum - minimum));
+    // Every column may lose up to one word to rounding
+    size_t available = budget - descriptorBytes - columnRanges.size() * sizeof(uint64_t);
+    uint plainRows = (uint) (budget / (sizeof(int) * columnRanges.size()));
+    // Decoded pages are kept in memory, so don't let them grow without bound
+    uint limit = 32 * plainRows;
+    if (rowBits == 0)
+        return limit;
+    return (uint) min((size_t) limit, available * 8 / rowBits);
+}
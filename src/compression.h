@@ -0,0 +1,52 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+#include"logger.h"
+
+/**
+ * @brief Encodings a column can have inside a compressed page. Every encoding
+ * turns the values into fixed width codes that are bit packed:
+ * <ul>
+ * <li>PLAIN: the value itself (32 bit codes)</li>
+ * <li>FOR: frame of reference, the value minus the smallest value of the page</li>
+ * <li>DELTA: difference to the previous value, for columns sorted in the page</li>
+ * <li>DICTIONARY: position of the value in the sorted list of distinct values</li>
+ * </ul>
+ */
+enum ColumnEncodingType {PLAIN_ENCODING, FOR_ENCODING, DELTA_ENCODING, DICTIONARY_ENCODING};
+
+struct ColumnEncoding {
+    ColumnEncodingType type = PLAIN_ENCODING;
+    int bitWidth = 32;
+    int base = 0;
+    vector<int> dictionary;
+};
+
+/**
+ * @brief Per column descriptor stored in front of the packed codes.
+ */
+struct ColumnEncodingHeader {
+    int32_t type;
+    int32_t bitWidth;
+    int32_t base;
+    int32_t dictionarySize;
+};
+
+/**
+ * @brief The PageCodec converts the columns of a page to and from their
+ * compressed form. The encoding of every column is picked per page, whichever
+ * takes the fewest bytes.
+ */
+class PageCodec{
+
+    static int bitsNeeded(uint32_t value);
+    static size_t packedBytes(int rowCount, int bitWidth);
+
+    public:
+
+    static ColumnEncoding chooseEncoding(const int *values, int count, int stride);
+    static size_t encodedSize(const ColumnEncoding &encoding, int rowCount);
+    static void encode(const int *values, int count, int stride, const ColumnEncoding &encoding, vector<char> &out);
+    static const char* decode(const char *in, const char *end, int count, ColumnEncoding &encoding, int *values, int stride);
+    static uint maxRowsPerBlock(const vector<pair<int, int>> &columnRanges);
+};
+#endif //COMPRESSION_H
@@ -0,0 +1,357 @@
+#include "global.h"
+
+const char *physicalOperatorNames[] = {"TABLE SCAN", "INDEX SCAN", "INDEX NESTED LOOP JOIN", "HASH JOIN",
+                                       "SORT MERGE JOIN", "NESTED LOOP JOIN", "HASH AGGREGATE", "SORT AGGREGATE",
+                                       "HASH DISTINCT", "SORT DISTINCT", "EXTERNAL SORT",
+                                       "TOP-K HEAP", "BLOCK NESTED LOOP PRODUCT"};
+
+/**
+ * @brief Expresses "column bin_op literal" as the range of matching values
+ * [low, high], which is empty when low > high.
+ *
+ * @return true if the predicate is a single range
+ * @return false otherwise (!=)
+ */
+bool literalRange(int literal, BinaryOperator binaryOperator, int &low, int &high)
+{
+    low = INT_MIN, high = INT_MAX;
+    switch (binaryOperator)
+    {
+    case LESS_THAN:
+        if (literal == INT_MIN)
+            low = 1, high = 0;
+        else
+            high = literal - 1;
+        return true;
+    case GREATER_THAN:
+        if (literal == INT_MAX)
+            low = 1, high = 0;
+        else
+            low = literal + 1;
+        return true;
+    case LEQ:
+        high = literal;
+        return true;
+    case GEQ:
+        low = literal;
+        return true;
+    case EQUAL:
+        low = high = literal;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Number of block accesses an external sort of the relation takes:
+ * the sorting phase plus every merging pass reads and writes each block once.
+ *
+ * @param blockCount
+ * @return long long
+ */
+long long sortCost(long long blockCount)
+{
+    // The frames Table::sort is granted
+    const long long nb = max((long long) MIN_GRANT_FRAMES, min((long long) memoryManager.availableFrames(), blockCount + 1)) - 1;
+    long long runs = (blockCount + nb - 1) / nb, passes = 0;
+    for (; runs > 1; runs = (runs + nb - 1) / nb)
+        passes++;
+    return 2 * blockCount * (1 + passes);
+}
+
+/**
+ * @brief Number of block accesses it takes to have the relation in the given
+ * order: none if its rows already are (see Table::isSortedOn)
+ */
+long long sortCost(Table *table, const vector<int> &columns, const vector<int> &multipliers)
+{
+    return table->isSortedOn(columns, multipliers) ? 0 : sortCost(table->blockCount);
+}
+
+/**
+ * @brief Block accesses of a hash join: one pass over both relations if the
+ * smaller one fits into the work frames of a grant, otherwise both are also
+ * read and written once per level of partitioning.
+ *
+ * @param buildBlocks blocks of the smaller relation
+ * @param probeBlocks blocks of the larger relation
+ * @return long long
+ */
+long long hashJoinCost(long long buildBlocks, long long probeBlocks)
+{
+    const long long frames = memoryManager.availableFrames(), memoryBlocks = frames - 2, partitionCount = frames - 1;
+    long long levels = 0;
+    for (long long partitionBlocks = buildBlocks; partitionBlocks > memoryBlocks; partitionBlocks = (partitionBlocks + partitionCount - 1) / partitionCount)
+        levels++;
+    return (2 * levels + 1) * (buildBlocks + probeBlocks);
+}
+
+/**
+ * @brief Estimates the number of distinct rows of a table from the distinct
+ * counts of its columns: at most their product, and at most the row count.
+ */
+long long estimateDistinctRows(Table *table)
+{
+    long long estimate = 1;
+    for (uint columnCounter = 0; columnCounter < table->columnCount && estimate < table->rowCount; columnCounter++) {
+        if (columnCounter >= table->distinctValuesPerColumnCount.size())
+            return table->rowCount;
+        estimate *= table->distinctValuesPerColumnCount[columnCounter];
+    }
+    return min(estimate, table->rowCount);
+}
+
+/**
+ * @brief Distinct values of a column, the row count if the table has no
+ * statistics
+ */
+static long long distinctValues(Table *table, int column)
+{
+    if (column < 0 || column >= table->distinctValuesPerColumnCount.size())
+        return max(1LL, table->rowCount);
+    return max(1u, table->distinctValuesPerColumnCount[column]);
+}
+
+/**
+ * @brief Expected number of pages holding rows of a table when rows rows
+ * are picked at random (Cardenas' formula)
+ */
+static long long pagesHolding(Table *table, double rows)
+{
+    if (!table->blockCount || rows <= 0)
+        return 0;
+    double blocks = table->blockCount;
+    return llround(ceil(blocks * (1 - pow(1 - 1 / blocks, rows))));
+}
+
+/**
+ * @brief Estimated share of the rows of a table for which "column bin_op
+ * literal" holds, from the histogram of the column. Without statistics a
+ * third of the rows match, or one distinct value's share for equality.
+ *
+ * @return double between 0 and 1
+ */
+double estimateSelectivity(Table *table, int column, BinaryOperator binaryOperator, int literal)
+{
+    if (column < 0 || column >= table->columnStatistics.size() || !table->columnStatistics[column].valueCount) {
+        if (binaryOperator == EQUAL)
+            return 1.0 / distinctValues(table, column);
+        if (binaryOperator == NOT_EQUAL)
+            return 1 - 1.0 / distinctValues(table, column);
+        return 1.0 / 3;
+    }
+    const ColumnStatistics &statistics = table->columnStatistics[column];
+    int low, high;
+    if (binaryOperator == EQUAL)
+        return statistics.equalitySelectivity(literal);
+    if (!literalRange(literal, binaryOperator, low, high))
+        return 1 - statistics.equalitySelectivity(literal);
+    return statistics.rangeSelectivity(low, high);
+}
+
+/**
+ * @brief Blocks a selection scan reads when it has to look at scannedPages
+ * pages of the table. Of a DSM table only the compared columns of these
+ * pages are read, and the other columns of the pages holding matches.
+ */
+static long long scanCost(Table *table, long long scannedPages, int comparedColumns, double matchingRows)
+{
+    if (table->layout != DSM)
+        return scannedPages;
+    long long matchingPages = min(scannedPages, pagesHolding(table, matchingRows));
+    return scannedPages * comparedColumns + matchingPages * (table->columnCount - comparedColumns);
+}
+
+/**
+ * @brief Chooses between scanning the table and fetching the matching rows
+ * through its index for a SELECTION query. A scan reads the pages whose zone
+ * maps don't rule the predicate out (see scanCost); the index costs its
+ * lookup plus the pages that hold the matching rows, each read once.
+ * Comparisons of two columns always scan; a third of the rows is taken to
+ * match them, or for equality one distinct value's share.
+ */
+QueryPlan planSelection(Table *table, const ParsedQuery &query)
+{
+    LOG_TRACE("planSelection");
+    QueryPlan plan;
+    int column = table->getColumnIndex(query.selectionFirstColumnName);
+    long long scannedPages = 0;
+    for (uint pageCounter = 0; pageCounter < table->blockCount; pageCounter++)
+        scannedPages += evaluateOnZoneMap(*table, pageCounter, query) != 0;
+    if (query.selectType == COLUMN) {
+        int secondColumn = table->getColumnIndex(query.selectionSecondColumnName);
+        double selectivity = 1.0 / 3;
+        if (query.selectionBinaryOperator == EQUAL)
+            selectivity = 1.0 / max(distinctValues(table, column), distinctValues(table, secondColumn));
+        plan.estimatedRows = llround(table->rowCount * selectivity);
+        plan.cost = scanCost(table, scannedPages, column == secondColumn ? 1 : 2, table->rowCount * selectivity);
+        return plan;
+    }
+    const int literal = query.selectionIntLiteral;
+    double matchingRows = table->rowCount * estimateSelectivity(table, column, query.selectionBinaryOperator, literal);
+    plan.estimatedRows = llround(matchingRows);
+    plan.cost = scanCost(table, scannedPages, 1, matchingRows);
+    int low, high;
+    if (table->index && table->index->columnIndex == column && literalRange(literal, query.selectionBinaryOperator, low, high)
+        && (table->index->supportsRanges() || low == high)) {
+        int pageBlocks = table->layout == DSM ? table->columnCount : 1;
+        long long indexCost = table->index->lookupCost(llround(matchingRows))
+                              + min(scannedPages, pagesHolding(table, matchingRows)) * pageBlocks;
+        if (indexCost < plan.cost) {
+            plan.algorithm = INDEX_SCAN;
+            plan.cost = indexCost;
+        }
+    }
+    return plan;
+}
+
+/**
+ * @brief Index nested loop join cost: the outer relation is read once and
+ * every outer row looks its matches up in the index of the inner relation,
+ * reading the pages that hold them
+ */
+static long long indexJoinCost(Table *outer, Table *inner, int innerColumn)
+{
+    double matchesPerKey = (double) inner->rowCount / distinctValues(inner, innerColumn);
+    long long perLookup = inner->index->lookupCost(llround(matchesPerKey)) + pagesHolding(inner, matchesPerKey);
+    return outer->blockCount + outer->rowCount * perLookup;
+}
+
+/**
+ * @brief Chooses the join algorithm. Equi joins go through the index of
+ * either relation if it is on the join column, by hashing with the smaller
+ * relation as the build side, or by sorting both relations, whichever is
+ * cheapest. Other joins have a single algorithm: <, >, <= and >= stream the
+ * second relation, sorted, past chunks of the first (a nested loop that
+ * stops early), != merges both sorted relations. Relations that already are
+ * in the order a join needs aren't sorted again.
+ */
+QueryPlan planJoin(Table *table1, int column1, Table *table2, int column2, BinaryOperator binaryOperator)
+{
+    LOG_TRACE("planJoin");
+    QueryPlan plan;
+    const long long blocks1 = table1->blockCount, blocks2 = table2->blockCount;
+    const double pairs = (double) table1->rowCount * table2->rowCount;
+    const long long largerDistinct = max(distinctValues(table1, column1), distinctValues(table2, column2));
+    if (binaryOperator == EQUAL) {
+        plan.estimatedRows = llround(pairs / largerDistinct);
+        plan.algorithm = SORT_MERGE_JOIN;
+        plan.cost = sortCost(table1, {column1}, {ASC}) + sortCost(table2, {column2}, {ASC}) + blocks1 + blocks2;
+        plan.firstIsBuild = blocks1 <= blocks2;
+        long long hashCost = hashJoinCost(min(blocks1, blocks2), max(blocks1, blocks2));
+        // Merging relations that are sorted already needs no memory
+        if (hashCost < plan.cost) {
+            plan.algorithm = HASH_JOIN;
+            plan.cost = hashCost;
+            plan.memoryFrames = min((long long) memoryManager.availableFrames(), min(blocks1, blocks2) + 2);
+        }
+        if (table2->index && table2->index->columnIndex == column2 && indexJoinCost(table1, table2, column2) <= plan.cost) {
+            plan.algorithm = INDEX_NESTED_LOOP_JOIN;
+            plan.firstIsBuild = false;
+            plan.cost = indexJoinCost(table1, table2, column2);
+        }
+        if (table1->index && table1->index->columnIndex == column1 && indexJoinCost(table2, table1, column1) < plan.cost) {
+            plan.algorithm = INDEX_NESTED_LOOP_JOIN;
+            plan.firstIsBuild = true;
+            plan.cost = indexJoinCost(table2, table1, column1);
+        }
+        return plan;
+    }
+    if (binaryOperator == NOT_EQUAL) {
+        plan.estimatedRows = llround(pairs * (1 - 1.0 / largerDistinct));
+        plan.algorithm = SORT_MERGE_JOIN;
+        plan.cost = sortCost(table1, {column1}, {ASC}) + sortCost(table2, {column2}, {ASC}) + blocks1 +
+                    table1->rowCount * blocks2;
+        return plan;
+    }
+    const long long chunkPages = memoryManager.availableFrames() - 2, chunks = (blocks1 + chunkPages - 1) / chunkPages;
+    plan.estimatedRows = llround(pairs / 3);
+    plan.algorithm = NESTED_LOOP_JOIN;
+    plan.cost = sortCost(table2, {column2}, {binaryOperator % 2 ? ASC : DESC}) + blocks1 + chunks * blocks2;
+    return plan;
+}
+
+/**
+ * @brief Chooses between hash aggregation, which partitions the table once
+ * per level while its groups don't fit into the work frames of a grant, and
+ * aggregating the table sorted on the grouping column in one scan. A table
+ * that already is in that order is always aggregated in the one scan.
+ *
+ * @param table
+ * @param groupingColumn
+ * @param groupBytes memory a group takes in the hash table
+ */
+QueryPlan planGroupBy(Table *table, int groupingColumn, size_t groupBytes)
+{
+    LOG_TRACE("planGroupBy");
+    const size_t frames = memoryManager.availableFrames(), blockBytes = BLOCK_SIZE * 1000;
+    const size_t memoryBytes = (frames - 2) * blockBytes, maxDepth = 4;
+    QueryPlan plan;
+    plan.estimatedRows = min(table->rowCount, distinctValues(table, groupingColumn));
+    size_t groupsBytes = plan.estimatedRows * groupBytes, levels = 0;
+    for (; groupsBytes > memoryBytes && levels < maxDepth; levels++)
+        groupsBytes /= min(frames - 1, max((size_t) 2, (groupsBytes * 5 / 4 + memoryBytes - 1) / memoryBytes));
+    plan.algorithm = HASH_AGGREGATE;
+    plan.memoryFrames = min(frames, (size_t) (plan.estimatedRows * groupBytes + blockBytes - 1) / blockBytes + 2);
+    plan.cost = (2 * levels + 1) * table->blockCount;
+    bool sorted = table->isSortedOn({groupingColumn}, {ASC});
+    long long sortedCost = sortCost(table, {groupingColumn}, {ASC}) + table->blockCount;
+    if (sortedCost < plan.cost || sorted) {
+        plan.algorithm = SORT_AGGREGATE;
+        plan.cost = sortedCost;
+        plan.memoryFrames = 0;
+    }
+    return plan;
+}
+
+/**
+ * @brief DISTINCT hashes in a single scan when the estimated distinct rows
+ * fit into the work frames of a grant and sorts otherwise. The two differ in
+ * the order of their results, so memory and not cost decides.
+ */
+QueryPlan planDistinct(Table *table)
+{
+    LOG_TRACE("planDistinct");
+    const size_t blockBytes = BLOCK_SIZE * 1000, memoryBytes = (memoryManager.availableFrames() - 2) * blockBytes;
+    const size_t rowBytes = table->columnCount * sizeof(int) + 3 * sizeof(size_t);
+    QueryPlan plan;
+    plan.estimatedRows = estimateDistinctRows(table);
+    plan.algorithm = plan.estimatedRows * rowBytes <= memoryBytes ? HASH_DISTINCT : SORT_DISTINCT;
+    plan.cost = plan.algorithm == HASH_DISTINCT ? table->blockCount : sortCost(table->blockCount);
+    if (plan.algorithm == HASH_DISTINCT)
+        plan.memoryFrames = (plan.estimatedRows * rowBytes + blockBytes - 1) / blockBytes + 2;
+    return plan;
+}
+
+/**
+ * @brief ORDER BY sorts the relation, unless it has a LIMIT (limit >= 0)
+ * whose rows, with their heap entries, fit into the work frames of a grant: then
+ * they are kept in a heap during one scan. A larger limit sorts and reads
+ * back the pages holding the first rows. A relation that already is in the
+ * order is just read, up to the pages holding the first rows.
+ */
+QueryPlan planOrderBy(Table *table, int column, int multiplier, long long limit)
+{
+    LOG_TRACE("planOrderBy");
+    const size_t blockBytes = BLOCK_SIZE * 1000, memoryBytes = (memoryManager.availableFrames() - 2) * blockBytes;
+    const size_t entryBytes = table->columnCount * sizeof(int) + sizeof(int) + sizeof(long long) + sizeof(size_t);
+    QueryPlan plan;
+    plan.estimatedRows = limit < 0 ? table->rowCount : min(limit, table->rowCount);
+    if (table->isSortedOn({column}, {multiplier})) {
+        plan.algorithm = TABLE_SCAN;
+        plan.cost = (plan.estimatedRows + table->maxRowsPerBlock - 1) / max(1u, table->maxRowsPerBlock);
+        return plan;
+    }
+    if (limit >= 0 && limit * entryBytes <= memoryBytes) {
+        plan.algorithm = TOP_K_HEAP;
+        plan.cost = table->blockCount;
+        plan.memoryFrames = (plan.estimatedRows * entryBytes + blockBytes - 1) / blockBytes + 2;
+        return plan;
+    }
+    plan.algorithm = EXTERNAL_SORT;
+    plan.cost = sortCost(table->blockCount);
+    if (limit >= 0)
+        plan.cost += (plan.estimatedRows + table->maxRowsPerBlock - 1) / table->maxRowsPerBlock;
+    return plan;
+}
@@ -0,0 +1,59 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+/**
+ * @brief The cost model picks the algorithm of a statement from the
+ * statistics of its relations (row and block counts, distinct counts and
+ * histograms) and the frames a memory grant would get (see MemoryManager).
+ * Costs are block accesses - pages read and written up to the result,
+ * leaving out writing the result itself since every alternative shares it.
+ * Operators are taken to hold the frames of their grant less two, one block
+ * being left for input and one for output.
+ */
+enum PhysicalOperator
+{
+    TABLE_SCAN,
+    INDEX_SCAN,
+    INDEX_NESTED_LOOP_JOIN,
+    HASH_JOIN,
+    SORT_MERGE_JOIN,
+    NESTED_LOOP_JOIN,
+    HASH_AGGREGATE,
+    SORT_AGGREGATE,
+    HASH_DISTINCT,
+    SORT_DISTINCT,
+    EXTERNAL_SORT,
+    TOP_K_HEAP,
+    BLOCK_NESTED_LOOP_PRODUCT
+};
+
+extern const char *physicalOperatorNames[];
+
+/**
+ * @brief The chosen algorithm of a statement. For joins firstIsBuild tells
+ * whether the first relation is the build (hash join) or inner (index nested
+ * loop join) side. memoryFrames is the grant an in-memory hash table or heap
+ * of the plan asks for (0 for the other algorithms, which size themselves).
+ */
+struct QueryPlan
+{
+    PhysicalOperator algorithm = TABLE_SCAN;
+    bool firstIsBuild = false;
+    uint memoryFrames = 0;
+    long long cost = 0;
+    long long estimatedRows = 0;
+};
+
+bool literalRange(int literal, BinaryOperator binaryOperator, int &low, int &high);
+long long sortCost(long long blockCount);
+long long sortCost(Table *table, const vector<int> &columns, const vector<int> &multipliers);
+long long hashJoinCost(long long buildBlocks, long long probeBlocks);
+long long estimateDistinctRows(Table *table);
+double estimateSelectivity(Table *table, int column, BinaryOperator binaryOperator, int literal);
+QueryPlan planSelection(Table *table, const ParsedQuery &query);
+QueryPlan planJoin(Table *table1, int column1, Table *table2, int column2, BinaryOperator binaryOperator);
+QueryPlan planGroupBy(Table *table, int groupingColumn, size_t groupBytes);
+QueryPlan planDistinct(Table *table);
+QueryPlan planOrderBy(Table *table, int column, int multiplier, long long limit);
+
+#endif //COST_MODEL_H
@@ -0,0 +1,154 @@
+#include "global.h"
+#include <sys/mman.h>
+
+/**
+ * @brief Construct a new CsvReader object that maps the given file
+ *
+ * @param fileName
+ */
+CsvReader::CsvReader(const string &fileName) {
+    LOG_TRACE("CsvReader::CsvReader");
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0) {
+        this->size = fileStat.st_size;
+        this->opened = true;
+        if (this->size) {
+            void *mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                LOG_ERROR("CsvReader::CsvReader: Err");
+                this->opened = false;
+            } else {
+                this->data = (const char *) mapping;
+                madvise(mapping, this->size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+    // The mapping stays valid without the descriptor
+    close(fd);
+}
+
+CsvReader::~CsvReader() {
+    if (this->data)
+        munmap((void *) this->data, this->size);
+}
+
+bool CsvReader::isOpen() const {
+    return this->opened;
+}
+
+/**
+ * @return uint number of chunks parsed together, which is also the number of
+ * slots the parallel consumer sees
+ */
+uint CsvReader::windowSize() const {
+    return 2 * threadPool.size();
+}
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Parses the rows of one chunk, appending their values to values
+ *
+ * @param begin
+ * @param end
+ * @param columnCount
+ * @param values
+ * @return true if every line holds at least columnCount integers
+ * @return false otherwise
+ */
+bool CsvReader::parseChunk(const char *begin, const char *end, uint columnCount, vector<int> &values) const {
+    const char *position = begin;
+    while (position < end) {
+        const char *lineEnd = (const char *) memchr(position, '\n', end - position);
+        if (!lineEnd)
+            lineEnd = end;
+        while (position < lineEnd && isBlank(*position))
+            position++;
+        if (position == lineEnd) {
+            position = lineEnd + 1;
+            continue;
+        }
+        for (uint columnCounter = 0; columnCounter < columnCount; columnCounter++) {
+            while (position < lineEnd && isBlank(*position))
+                position++;
+            bool negative = false;
+            if (position < lineEnd && (*position == '-' || *position == '+'))
+                negative = *position++ == '-';
+            if (position == lineEnd || (unsigned) (*position - '0') > 9)
+                return false;
+            long long value = 0;
+            while (position < lineEnd && (unsigned) (*position - '0') <= 9) {
+                value = value * 10 + (*position++ - '0');
+                if (value > (long long) INT_MAX + 1)
+                    return false;
+            }
+            value = negative ? -value : value;
+            if (value > INT_MAX)
+                return false;
+            values.push_back((int) value);
+            while (position < lineEnd && isBlank(*position))
+                position++;
+            if (columnCounter + 1 < columnCount) {
+                if (position == lineEnd || *position != ',')
+                    return false;
+                position++;
+            }
+        }
+        position = lineEnd + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses the whole file, skipping its first line if asked to
+ *
+ * @param columnCount
+ * @param skipHeader
+ * @param parallel may be empty
+ * @param ordered may be empty
+ * @return true if every row was parsed
+ * @return false otherwise
+ */
+bool CsvReader::read(uint columnCount, bool skipHeader, const ParallelConsumer &parallel, const OrderedConsumer &ordered) {
+    LOG_TRACE("CsvReader::read");
+    if (!this->opened)
+        return false;
+    const char *position = this->data, *end = this->data + this->size;
+    if (skipHeader && position < end) {
+        const char *headerEnd = (const char *) memchr(position, '\n', end - position);
+        position = headerEnd ? headerEnd + 1 : end;
+    }
+    vector<pair<const char *, const char *>> chunks;
+    vector<vector<int>> chunkValues(this->windowSize());
+    vector<char> chunkParsed(this->windowSize());
+    while (position < end) {
+        chunks.clear();
+        while (position < end && chunks.size() < this->windowSize()) {
+            const char *chunkEnd = end;
+            if ((size_t) (end - position) > CHUNK_BYTES) {
+                chunkEnd = (const char *) memchr(position + CHUNK_BYTES, '\n', end - position - CHUNK_BYTES);
+                chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+            }
+            chunks.emplace_back(position, chunkEnd);
+            position = chunkEnd;
+        }
+        threadPool.run(chunks.size(), [&](uint slot) {
+            chunkValues[slot].clear();
+            chunkParsed[slot] = this->parseChunk(chunks[slot].first, chunks[slot].second, columnCount, chunkValues[slot]);
+            if (chunkParsed[slot] && parallel)
+                parallel(slot, chunkValues[slot]);
+        });
+        for (uint slot = 0; slot < chunks.size(); slot++) {
+            if (!chunkParsed[slot])
+                return false;
+            if (ordered)
+                ordered(chunkValues[slot]);
+        }
+    }
+    return true;
+}
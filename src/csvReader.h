@@ -0,0 +1,41 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+#include"threadPool.h"
+
+/**
+ * @brief The CsvReader parses the integer rows of a csv file in parallel. The
+ * file is memory mapped and cut into chunks of about CHUNK_BYTES that end on
+ * line boundaries. Chunks are parsed windowSize() at a time on the thread
+ * pool, and every parsed chunk is handed to two consumers:
+ *
+ * - the parallel consumer runs on the thread that parsed the chunk and gets
+ *   the chunk's position in the window (its slot), so that callers can keep
+ *   per slot state such as partial statistics and merge it at the end;
+ * - the ordered consumer runs on the calling thread and sees the chunks in
+ *   file order, which is where pages get written.
+ *
+ * Rows are passed on as one flat vector, row after row. Values may be
+ * surrounded by blanks, lines holding nothing but blanks are skipped and
+ * values beyond the expected column count are ignored.
+ */
+class CsvReader{
+
+    const char *data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+
+    bool parseChunk(const char *begin, const char *end, uint columnCount, vector<int> &values) const;
+
+    public:
+
+    typedef function<void(uint slot, const vector<int> &values)> ParallelConsumer;
+    typedef function<void(const vector<int> &values)> OrderedConsumer;
+    static const size_t CHUNK_BYTES = 1 << 22;
+
+    explicit CsvReader(const string &fileName);
+    ~CsvReader();
+    bool isOpen() const;
+    uint windowSize() const;
+    bool read(uint columnCount, bool skipHeader, const ParallelConsumer &parallel, const OrderedConsumer &ordered);
+};
+#endif //CSV_READER_H
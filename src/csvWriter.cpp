@@ -0,0 +1,113 @@
+#include "global.h"
+#include <charconv>
+#include <sys/uio.h>
+
+/**
+ * @brief Construct a new CsvWriter object that creates (or truncates) the
+ * given file
+ *
+ * @param fileName
+ */
+CsvWriter::CsvWriter(const string &fileName) {
+    LOG_TRACE("CsvWriter::CsvWriter");
+    this->fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0)
+        LOG_ERROR("CsvWriter::CsvWriter: Err");
+}
+
+CsvWriter::~CsvWriter() {
+    this->close();
+}
+
+bool CsvWriter::isOpen() const {
+    return this->fd >= 0;
+}
+
+/**
+ * @brief Appends a line of names to text
+ *
+ * @param row
+ * @param text
+ */
+void CsvWriter::appendRow(const vector<string> &row, string &text) {
+    for (int columnCounter = 0; columnCounter < row.size(); columnCounter++) {
+        if (columnCounter != 0)
+            text += ", ";
+        text += row[columnCounter];
+    }
+    text += '\n';
+}
+
+/**
+ * @brief Appends rowCount rows, given one after the other in values, to text
+ *
+ * @param values
+ * @param rowCount
+ * @param columnCount
+ * @param text
+ */
+void CsvWriter::appendRows(const int *values, size_t rowCount, uint columnCount, string &text) {
+    // An int takes at most 11 characters, 13 with the separator
+    size_t used = text.size();
+    text.resize(used + rowCount * columnCount * 13 + rowCount);
+    char *position = text.data() + used;
+    for (size_t rowCounter = 0; rowCounter < rowCount; rowCounter++) {
+        for (uint columnCounter = 0; columnCounter < columnCount; columnCounter++) {
+            if (columnCounter != 0) {
+                *position++ = ',';
+                *position++ = ' ';
+            }
+            position = to_chars(position, position + 11, *values++).ptr;
+        }
+        *position++ = '\n';
+    }
+    text.resize(position - text.data());
+}
+
+bool CsvWriter::write(const string &text) {
+    return this->write({text}, 1);
+}
+
+/**
+ * @brief Appends the first textCount texts to the file, in order
+ *
+ * @param texts
+ * @param textCount
+ * @return false if the file can't be written
+ */
+bool CsvWriter::write(const vector<string> &texts, uint textCount) {
+    LOG_TRACE("CsvWriter::write");
+    vector<struct iovec> parts;
+    for (uint textCounter = 0; textCounter < textCount; textCounter++)
+        if (!texts[textCounter].empty())
+            parts.push_back({(void *) texts[textCounter].data(), texts[textCounter].size()});
+    for (size_t first = 0; first < parts.size() && !this->failed;) {
+        int partCount = (int) min(parts.size() - first, (size_t) IOV_MAX);
+        ssize_t written = this->fd < 0 ? -1 : writev(this->fd, parts.data() + first, partCount);
+        if (written < 0) {
+            this->failed = true;
+            break;
+        }
+        // Skip what was written, which may end within a part
+        while (first < parts.size() && (size_t) written >= parts[first].iov_len)
+            written -= parts[first++].iov_len;
+        if (first < parts.size()) {
+            parts[first].iov_base = (char *) parts[first].iov_base + written;
+            parts[first].iov_len -= written;
+        }
+    }
+    return this->fd >= 0 && !this->failed;
+}
+
+/**
+ * @brief Closes the file
+ *
+ * @return false if any write failed
+ */
+bool CsvWriter::close() {
+    if (this->fd >= 0 && ::close(this->fd))
+        this->failed = true;
+    bool written = this->fd >= 0 && !this->failed;
+    this->fd = -1;
+    return written;
+}
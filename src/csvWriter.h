@@ -0,0 +1,31 @@
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+#include"threadPool.h"
+
+/**
+ * @brief The CsvWriter writes csv files in large pieces. Callers format whole
+ * pages of rows into text, several pages at a time on the thread pool, and
+ * hand the texts over in file order; each batch goes to the file with a
+ * single system call instead of a flush per row. Numbers are formatted with
+ * to_chars, into the same "1, 2, 3" lines as Table::writeRow.
+ */
+class CsvWriter{
+
+    int fd = -1;
+    bool failed = false;
+
+    public:
+
+    // Rows read from a relation before they are formatted and written
+    static const size_t CHUNK_BYTES = 1 << 22;
+
+    explicit CsvWriter(const string &fileName);
+    ~CsvWriter();
+    bool isOpen() const;
+    static void appendRow(const vector<string> &row, string &text);
+    static void appendRows(const int *values, size_t rowCount, uint columnCount, string &text);
+    bool write(const string &text);
+    bool write(const vector<string> &texts, uint textCount);
+    bool close();
+};
+#endif //CSV_WRITER_H
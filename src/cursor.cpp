@@ -5,14 +5,66 @@ Cursor::Cursor() = default;
 
 Cursor::Cursor(string tableName, int pageIndex, datatype d)
 {
-    logger.log("Cursor::Cursor");
-    this->page = *bufferManager.getPage(tableName, pageIndex, d);
+    LOG_TRACE("Cursor::Cursor");
+    this->handle = bufferManager.pin(tableName, pageIndex, d);
+    this->page = this->handle.page;
     this->pagePointer = 0;
     this->d = d;
     this->tableName = tableName;
     this->pageIndex = pageIndex;
 }
 
+Cursor::Cursor(const Cursor &other)
+    : handle(other.handle), page(other.page), pageIndex(other.pageIndex), tableName(other.tableName),
+      d(other.d), pagePointer(other.pagePointer)
+{
+    bufferManager.pin(this->handle);
+}
+
+Cursor::Cursor(Cursor &&other) noexcept
+    : handle(other.handle), page(other.page), pageIndex(other.pageIndex), tableName(std::move(other.tableName)),
+      d(other.d), pagePointer(other.pagePointer)
+{
+    other.handle = PageHandle();
+    other.page = nullptr;
+}
+
+Cursor& Cursor::operator=(const Cursor &other)
+{
+    if (this == &other)
+        return *this;
+    bufferManager.pin(other.handle);
+    bufferManager.unpin(this->handle);
+    this->handle = other.handle;
+    this->page = other.page;
+    this->pageIndex = other.pageIndex;
+    this->tableName = other.tableName;
+    this->d = other.d;
+    this->pagePointer = other.pagePointer;
+    return *this;
+}
+
+Cursor& Cursor::operator=(Cursor &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+    bufferManager.unpin(this->handle);
+    this->handle = other.handle;
+    this->page = other.page;
+    this->pageIndex = other.pageIndex;
+    this->tableName = std::move(other.tableName);
+    this->d = other.d;
+    this->pagePointer = other.pagePointer;
+    other.handle = PageHandle();
+    other.page = nullptr;
+    return *this;
+}
+
+Cursor::~Cursor()
+{
+    bufferManager.unpin(this->handle);
+}
+
 /**
  * @brief This function reads the next row from the page. The index of the
  * current row read from the page is indicated by the pagePointer(points to row
@@ -22,13 +74,27 @@ Cursor::Cursor(string tableName, int pageIndex, datatype d)
  */
 vector<int> Cursor::getNext()
 {
-    logger.log("Cursor::geNext");
-    vector<int> result = this->page.getRow(this->pagePointer);
+    LOG_TRACE("Cursor::geNext");
+    RowView row = this->getNextView();
+    return vector<int>(row.begin(), row.end());
+}
+
+/**
+ * @brief Same as getNext, but returns a view into the pinned page instead of
+ * a copy of the row. The view is invalidated once the cursor moves on to the
+ * next page.
+ *
+ * @return RowView
+ */
+RowView Cursor::getNextView()
+{
+    LOG_TRACE("Cursor::getNextView");
+    RowView result = this->page->getRowView(this->pagePointer);
     this->pagePointer++;
     if(result.empty()){
         tableCatalogue.getTable(this->tableName)->getNextPage(this);
         if(!this->pagePointer){
-            result = this->page.getRow(this->pagePointer);
+            result = this->page->getRowView(this->pagePointer);
             this->pagePointer++;
         }
     }
@@ -43,21 +109,44 @@ vector<int> Cursor::getNext()
  * @return value at cell specified
  */
 int Cursor::getCell(int row, int col) {
-    logger.log("Cursor::getCell");
-    return this->page.getCell(row, col);
+    LOG_TRACE("Cursor::getCell");
+    return this->page->getCell(row, col);
 }
 
 /**
  * @brief Function that loads Page indicated by pageIndex. Now the cursor starts
- * reading from the new page.
+ * reading from the new page. The previous page is unpinned.
  *
  * @param pageIndex 
  */
 void Cursor::nextPage(int pageIndex)
 {
-    logger.log("Cursor::nextPage");
-    this->page = *bufferManager.getPage(this->tableName, pageIndex, this->d);
+    LOG_TRACE("Cursor::nextPage");
+    PageHandle next = bufferManager.pin(this->tableName, pageIndex, this->d);
+    bufferManager.unpin(this->handle);
+    bool sequential = (pageIndex == this->pageIndex + 1);
+    this->handle = next;
+    this->page = next.page;
     this->pageIndex = pageIndex;
     this->pagePointer = 0;
+    if (sequential)
+        this->readAhead();
 }
 
+/**
+ * @brief Prefetches the PREFETCH_COUNT pages following the current one (as
+ * far as the table or matrix goes).
+ */
+void Cursor::readAhead()
+{
+    LOG_TRACE("Cursor::readAhead");
+    uint blockCount;
+    if (this->d == TABLE)
+        blockCount = tableCatalogue.getTable(this->tableName)->blockCount;
+    else if (this->d == INDEX_NODE)
+        blockCount = tableCatalogue.getIndex(this->tableName)->blockCount;
+    else
+        blockCount = tableCatalogue.getMatrix(this->tableName)->blockCount;
+    for (uint offset = 1; offset <= PREFETCH_COUNT && this->pageIndex + offset < blockCount; offset++)
+        bufferManager.prefetch(this->tableName, this->pageIndex + offset, this->d);
+}
@@ -6,20 +6,35 @@
  * table, you need to initialize a cursor. The cursor reads rows from a page one
  * at a time.
  *
+ * The cursor keeps the page it is reading pinned in the buffer pool and reads
+ * rows directly out of the pool frame. Copying a cursor adds a pin on the same
+ * frame, so copies can be advanced independently.
+ *
+ * Once a cursor moves from a page to the one right after it, the scan is
+ * taken to be sequential and the following PREFETCH_COUNT pages are
+ * prefetched. readAhead gives the same hint up front for known full scans.
  */
 class Cursor{
     public:
-    Page page;
+    PageHandle handle;
+    Page *page = nullptr;
     int pageIndex{};
     string tableName;
-    datatype d;
+    datatype d = TABLE;
     int pagePointer{};
 
     public:
     Cursor();
     Cursor(string tableName, int pageIndex, datatype d);
+    Cursor(const Cursor &other);
+    Cursor(Cursor &&other) noexcept;
+    Cursor& operator=(const Cursor &other);
+    Cursor& operator=(Cursor &&other) noexcept;
+    ~Cursor();
     vector<int> getNext();
+    RowView getNextView();
     void nextPage(int pageIndex);
+    void readAhead();
     int getCell(int row, int col);
 };
 #endif //CURSOR_H
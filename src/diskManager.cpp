@@ -0,0 +1,573 @@
+#include "global.h"
+
+namespace {
+
+// Pages read ahead for this thread (see DiskManager::readAhead)
+thread_local map<pair<string, int>, vector<char>> readAheadPages;
+
+/**
+ * @brief Copies bytes into the buffers of a read, as far as they reach
+ *
+ * @return ssize_t number of bytes copied
+ */
+ssize_t copyToParts(const char *bytes, size_t size, const struct iovec *parts, int partCount) {
+    size_t copied = 0;
+    for (int part = 0; part < partCount && copied < size; part++) {
+        size_t length = min(parts[part].iov_len, size - copied);
+        memcpy(parts[part].iov_base, bytes + copied, length);
+        copied += length;
+    }
+    return copied;
+}
+
+}
+
+/**
+ * @brief Waits for the queued writes to be flushed and closes the segment
+ * files.
+ */
+DiskManager::~DiskManager() {
+    {
+        lock_guard<mutex> guard(this->queueLock);
+        this->stopping = true;
+    }
+    this->queueChanged.notify_all();
+    if (this->flusher.joinable())
+        this->flusher.join();
+    for (auto &[relationName, segment]: this->segments)
+        close(segment.fd);
+    delete this->io;
+}
+
+string DiskManager::pageFileName(const string &relationName, int pageIndex) {
+    return "../data/temp/" + relationName + "_Page" + to_string(pageIndex);
+}
+
+string DiskManager::segmentFileName(const string &relationName) {
+    return "../data/temp/" + relationName + "_Segment";
+}
+
+/**
+ * @brief Largest page: the page header and one block of cells.
+ *
+ * @return size_t
+ */
+size_t DiskManager::pageBytes() {
+    return sizeof(PageHeader) + (size_t) (BLOCK_SIZE * 1000);
+}
+
+/**
+ * @brief Space reserved for every page in a segment file: pageBytes(),
+ * rounded up to DIRECT_IO_ALIGNMENT with DIRECT_IO so that every page starts
+ * on an aligned offset and its rounded up transfers stay within its slot.
+ *
+ * @return size_t
+ */
+size_t DiskManager::slotBytes() {
+    if (!DIRECT_IO)
+        return pageBytes();
+    return (pageBytes() + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+}
+
+/**
+ * @brief The I/O backend, created from IO_BACKEND on first use
+ */
+IoBackend &DiskManager::backend() {
+    call_once(this->ioCreated, [this] { this->io = IoBackend::create(IO_BACKEND); });
+    return *this->io;
+}
+
+/**
+ * @return IoBackendType the backend in use, which is POSIX_IO if IO_BACKEND
+ * asked for one the kernel doesn't provide
+ */
+IoBackendType DiskManager::ioBackendType() {
+    return this->backend().type();
+}
+
+/**
+ * @brief Returns the segment file of the relation, opening (and creating) the
+ * file on first use. With DIRECT_IO the file is opened with O_DIRECT, unless
+ * its file system doesn't support it.
+ *
+ * @param relationName
+ * @return Segment whose fd is -1 if the file can't be opened
+ */
+DiskManager::Segment DiskManager::getSegment(const string &relationName) {
+    lock_guard<mutex> guard(this->lock);
+    auto it = this->segments.find(relationName);
+    if (it != this->segments.end())
+        return it->second;
+    Segment segment;
+    string fileName = segmentFileName(relationName);
+    if (DIRECT_IO) {
+        segment.fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+        segment.direct = segment.fd >= 0;
+        if (!segment.direct)
+            LOG_WARNING("DiskManager::getSegment: no direct I/O");
+    }
+    if (segment.fd < 0)
+        segment.fd = open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (segment.fd < 0) {
+        LOG_ERROR("DiskManager::getSegment: Err");
+        return segment;
+    }
+    this->segments[relationName] = segment;
+    return segment;
+}
+
+void DiskManager::closeSegment(const string &relationName) {
+    lock_guard<mutex> guard(this->lock);
+    auto it = this->segments.find(relationName);
+    if (it == this->segments.end())
+        return;
+    close(it->second.fd);
+    this->segments.erase(it);
+}
+
+/**
+ * @brief Runs a batch of requests on the I/O backend, calling completed with
+ * the position of every request once it has completed. Requests marked in
+ * direct are on descriptors opened with O_DIRECT, which only move whole
+ * aligned blocks from and to aligned memory: they transfer their length
+ * rounded up to DIRECT_IO_ALIGNMENT through a bounce buffer. Their offsets
+ * are slot boundaries, so the rounded transfers stay within their slots.
+ *
+ * @param requests
+ * @param direct
+ * @param completed
+ */
+void DiskManager::perform(vector<IoRequest> &requests, const vector<char> &direct,
+                          const function<void(size_t)> &completed) {
+    struct Bounce {
+        char *data = nullptr;
+        size_t length = 0;
+        struct iovec part;
+        const struct iovec *parts;
+        int partCount;
+    };
+    vector<Bounce> bounces(requests.size());
+    for (size_t requestCounter = 0; requestCounter < requests.size(); requestCounter++) {
+        if (!direct[requestCounter])
+            continue;
+        IoRequest &request = requests[requestCounter];
+        Bounce &bounce = bounces[requestCounter];
+        for (int part = 0; part < request.partCount; part++)
+            bounce.length += request.parts[part].iov_len;
+        size_t alignedLength = max((size_t) 1, (bounce.length + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT)
+                               * DIRECT_IO_ALIGNMENT;
+        bounce.data = (char *) aligned_alloc(DIRECT_IO_ALIGNMENT, alignedLength);
+        if (request.write) {
+            char *position = bounce.data;
+            for (int part = 0; part < request.partCount; part++)
+                position = (char *) mempcpy(position, request.parts[part].iov_base, request.parts[part].iov_len);
+            memset(position, 0, bounce.data + alignedLength - position);
+        }
+        bounce.part = {bounce.data, alignedLength};
+        bounce.parts = request.parts;
+        bounce.partCount = request.partCount;
+        request.parts = &bounce.part;
+        request.partCount = 1;
+    }
+    this->backend().perform(requests.data(), requests.size(), [&](IoRequest &request) {
+        size_t requestCounter = &request - requests.data();
+        Bounce &bounce = bounces[requestCounter];
+        if (bounce.data) {
+            if (request.result > (ssize_t) bounce.length)
+                request.result = bounce.length;
+            request.parts = bounce.parts;
+            request.partCount = bounce.partCount;
+            if (!request.write && request.result > 0)
+                copyToParts(bounce.data, request.result, request.parts, request.partCount);
+        }
+        if (completed)
+            completed(requestCounter);
+    });
+    for (Bounce &bounce: bounces)
+        free(bounce.data);
+}
+
+/**
+ * @brief Reads a page into the given buffers with a single system call, or
+ * from the write queue if the page is waiting to be written.
+ *
+ * @param relationName
+ * @param pageIndex
+ * @param parts
+ * @param partCount
+ * @return ssize_t number of bytes read, -1 on failure
+ */
+ssize_t DiskManager::readPage(const string &relationName, int pageIndex, struct iovec *parts, int partCount) {
+    LOG_TRACE("DiskManager::readPage");
+    {
+        lock_guard<mutex> guard(this->queueLock);
+        const vector<char> *bytes = nullptr;
+        for (WriteQueue *writes: {&this->pendingWrites, &this->inFlightWrites}) {
+            auto it = writes->find({relationName, pageIndex});
+            if (it != writes->end()) {
+                bytes = &it->second;
+                break;
+            }
+        }
+        if (bytes)
+            return copyToParts(bytes->data(), bytes->size(), parts, partCount);
+    }
+    auto readAhead = readAheadPages.find({relationName, pageIndex});
+    if (readAhead != readAheadPages.end()) {
+        ssize_t bytesRead = copyToParts(readAhead->second.data(), readAhead->second.size(), parts, partCount);
+        readAheadPages.erase(readAhead);
+        return bytesRead;
+    }
+    if (STORAGE_MODE == SEGMENT_FILES) {
+        Segment segment = this->getSegment(relationName);
+        if (segment.fd < 0)
+            return -1;
+        vector<IoRequest> requests{{false, segment.fd, parts, partCount, (off_t) (pageIndex * slotBytes())}};
+        this->perform(requests, {segment.direct});
+        return requests[0].result;
+    }
+    int fd = open(pageFileName(relationName, pageIndex).c_str(), O_RDONLY);
+    if (fd < 0)
+        return -1;
+    ssize_t bytesRead = this->backend().read(fd, parts, partCount, 0);
+    close(fd);
+    return bytesRead;
+}
+
+/**
+ * @brief Reads the given pages with one batch of requests and keeps them for
+ * the calling thread: its next readPage of one of them is served from
+ * memory. completed is called with the position of every page in pages as
+ * soon as the page has been read, in the order the reads complete, or right
+ * away for a page that isn't read. Pages in the write queue are not read,
+ * they are newer than their copies on disk. The caller has to keep the pages
+ * from being written until it has read them (the Prefetcher does, writers
+ * discard its slots first) and drop the rest with endReadAhead.
+ *
+ * @param pages
+ * @param completed
+ */
+void DiskManager::readAhead(const vector<pair<string, int>> &pages, const function<void(size_t)> &completed) {
+    LOG_TRACE("DiskManager::readAhead");
+    vector<char> queued(pages.size(), false);
+    {
+        lock_guard<mutex> guard(this->queueLock);
+        for (size_t position = 0; position < pages.size(); position++)
+            queued[position] = this->pendingWrites.count(pages[position]) || this->inFlightWrites.count(pages[position]);
+    }
+    vector<IoRequest> requests;
+    vector<char> direct;
+    vector<size_t> positions;
+    vector<int> pageFiles;
+    vector<vector<char>> buffers(pages.size());
+    vector<struct iovec> parts(pages.size());
+    for (size_t position = 0; position < pages.size(); position++) {
+        const auto &[relationName, pageIndex] = pages[position];
+        Segment segment;
+        off_t offset = 0;
+        if (!queued[position] && STORAGE_MODE == SEGMENT_FILES) {
+            segment = this->getSegment(relationName);
+            offset = (off_t) pageIndex * slotBytes();
+        } else if (!queued[position]) {
+            segment.fd = open(pageFileName(relationName, pageIndex).c_str(), O_RDONLY);
+            if (segment.fd >= 0)
+                pageFiles.push_back(segment.fd);
+        }
+        if (segment.fd < 0) {
+            completed(position);
+            continue;
+        }
+        buffers[position].resize(pageBytes());
+        parts[position] = {buffers[position].data(), buffers[position].size()};
+        requests.push_back({false, segment.fd, &parts[position], 1, offset});
+        direct.push_back(segment.direct);
+        positions.push_back(position);
+    }
+    this->perform(requests, direct, [&](size_t requestCounter) {
+        size_t position = positions[requestCounter];
+        if (requests[requestCounter].result >= 0) {
+            buffers[position].resize(requests[requestCounter].result);
+            readAheadPages[pages[position]] = std::move(buffers[position]);
+        }
+        completed(position);
+    });
+    for (int fd: pageFiles)
+        close(fd);
+}
+
+/**
+ * @brief Drops the pages read ahead for the calling thread that it hasn't
+ * read
+ */
+void DiskManager::endReadAhead() {
+    readAheadPages.clear();
+}
+
+/**
+ * @brief Writes a page from the given buffers. With write-behind the buffers
+ * are copied into the write queue, otherwise the page is written right away.
+ *
+ * @param relationName
+ * @param pageIndex
+ * @param parts
+ * @param partCount
+ * @return true if every byte was written (or queued)
+ */
+bool DiskManager::writePage(const string &relationName, int pageIndex, struct iovec *parts, int partCount) {
+    LOG_TRACE("DiskManager::writePage");
+    if (!WRITE_BEHIND_PAGES)
+        return this->writePageNow(relationName, pageIndex, parts, partCount);
+    vector<char> bytes;
+    for (int part = 0; part < partCount; part++)
+        bytes.insert(bytes.end(), (char *) parts[part].iov_base, (char *) parts[part].iov_base + parts[part].iov_len);
+    assert(STORAGE_MODE == PAGE_FILES || bytes.size() <= pageBytes()); //Should never occur. Sanity check
+
+    unique_lock<mutex> guard(this->queueLock);
+    this->queueChanged.wait(guard, [this] { return this->pendingWrites.size() < WRITE_BEHIND_PAGES; });
+    this->pendingWrites[{relationName, pageIndex}] = std::move(bytes);
+    if (!this->flusher.joinable())
+        this->flusher = thread(&DiskManager::runFlusher, this);
+    guard.unlock();
+    this->queueChanged.notify_all();
+    return true;
+}
+
+/**
+ * @brief Writes a page from the given buffers with a single system call.
+ * Per page files are truncated first.
+ *
+ * @return true if every byte was written
+ */
+bool DiskManager::writePageNow(const string &relationName, int pageIndex, struct iovec *parts, int partCount) {
+    ssize_t expected = 0;
+    for (int part = 0; part < partCount; part++)
+        expected += parts[part].iov_len;
+    if (STORAGE_MODE == SEGMENT_FILES) {
+        assert(expected <= (ssize_t) pageBytes()); //Should never occur. Sanity check
+        Segment segment = this->getSegment(relationName);
+        if (segment.fd < 0)
+            return false;
+        vector<IoRequest> requests{{true, segment.fd, parts, partCount, (off_t) (pageIndex * slotBytes())}};
+        this->perform(requests, {segment.direct});
+        return requests[0].result == expected;
+    }
+    int fd = open(pageFileName(relationName, pageIndex).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    bool written = this->backend().write(fd, parts, partCount, 0) == expected;
+    close(fd);
+    return written;
+}
+
+/**
+ * @brief Body of the flusher thread. Takes whatever is queued as one batch
+ * and writes it out.
+ */
+void DiskManager::runFlusher() {
+    unique_lock<mutex> guard(this->queueLock);
+    while (true) {
+        this->queueChanged.wait(guard, [this] { return this->stopping || !this->pendingWrites.empty(); });
+        // Give the queue a moment to fill up so that consecutive pages can be
+        // written together, unless someone is waiting for the writes
+        this->queueChanged.wait_for(guard, chrono::milliseconds(2), [this] {
+            return this->stopping || this->flushRequested || this->pendingWrites.size() >= WRITE_BEHIND_PAGES / 2;
+        });
+        this->flushRequested = false;
+        if (this->pendingWrites.empty()) {
+            if (this->stopping)
+                return;
+            continue;
+        }
+        this->inFlightWrites.swap(this->pendingWrites);
+        guard.unlock();
+        this->queueChanged.notify_all();
+        this->flush(this->inFlightWrites);
+        guard.lock();
+        this->inFlightWrites.clear();
+        this->queueChanged.notify_all();
+    }
+}
+
+/**
+ * @brief Writes a batch of pages, submitted to the I/O backend together. The
+ * batch is ordered by relation and page index, so in segment files every run
+ * of consecutive pages is written with one request, each page padded to the
+ * size of its slot.
+ *
+ * @param writes
+ */
+void DiskManager::flush(const WriteQueue &writes) {
+    LOG_DEBUG("DiskManager::flush " + to_string(writes.size()));
+    vector<IoRequest> requests;
+    vector<char> direct;
+    vector<ssize_t> expected;
+    // The buffers of every request; a deque doesn't move them as it grows
+    deque<vector<struct iovec>> parts;
+    vector<int> pageFiles;
+    if (STORAGE_MODE == PAGE_FILES) {
+        for (auto &[page, bytes]: writes) {
+            int fd = open(pageFileName(page.first, page.second).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                LOG_ERROR("DiskManager::flush: Err");
+                continue;
+            }
+            pageFiles.push_back(fd);
+            parts.push_back({{(void *) bytes.data(), bytes.size()}});
+            requests.push_back({true, fd, parts.back().data(), 1, 0});
+            direct.push_back(false);
+            expected.push_back(bytes.size());
+        }
+    }
+    const vector<char> padding(STORAGE_MODE == SEGMENT_FILES ? slotBytes() : 0, 0);
+    const int maxRunLength = IOV_MAX / 2;
+    for (auto run = writes.begin(); STORAGE_MODE == SEGMENT_FILES && run != writes.end();) {
+        const string &relationName = run->first.first;
+        int firstPage = run->first.second, runLength = 0;
+        vector<struct iovec> runParts;
+        ssize_t runBytes = 0;
+        auto it = run;
+        while (it != writes.end() && it->first.first == relationName && it->first.second == firstPage + runLength
+               && runLength < maxRunLength) {
+            const vector<char> &bytes = it->second;
+            runParts.push_back({(void *) bytes.data(), bytes.size()});
+            runBytes += bytes.size();
+            // The last page of a run needs no padding
+            auto next = std::next(it);
+            if (next != writes.end() && next->first.first == relationName && next->first.second == firstPage + runLength + 1
+                && runLength + 1 < maxRunLength) {
+                runParts.push_back({(void *) padding.data(), slotBytes() - bytes.size()});
+                runBytes += slotBytes() - bytes.size();
+            }
+            runLength++;
+            it = next;
+        }
+        run = it;
+        Segment segment = this->getSegment(relationName);
+        if (segment.fd < 0) {
+            LOG_ERROR("DiskManager::flush: Err");
+            continue;
+        }
+        parts.push_back(std::move(runParts));
+        requests.push_back({true, segment.fd, parts.back().data(), (int) parts.back().size(),
+                            (off_t) firstPage * (off_t) slotBytes()});
+        direct.push_back(segment.direct);
+        expected.push_back(runBytes);
+    }
+    this->perform(requests, direct);
+    for (size_t requestCounter = 0; requestCounter < requests.size(); requestCounter++)
+        if (requests[requestCounter].result != expected[requestCounter])
+            LOG_ERROR("DiskManager::flush: Err");
+    for (int fd: pageFiles)
+        close(fd);
+}
+
+/**
+ * @param writes
+ * @param relationName
+ * @return true if writes holds a page of the relation
+ */
+bool DiskManager::hasWrites(const WriteQueue &writes, const string &relationName) {
+    auto it = writes.lower_bound({relationName, INT_MIN});
+    return it != writes.end() && it->first.first == relationName;
+}
+
+/**
+ * @brief Deletes the files holding the pages of a relation
+ *
+ * @param relationName
+ * @param pageCount
+ */
+void DiskManager::deleteRelation(const string &relationName, uint pageCount) {
+    LOG_TRACE("DiskManager::deleteRelation");
+    {
+        // Queued pages of the relation never reach the disk; wait for the
+        // ones being written
+        unique_lock<mutex> guard(this->queueLock);
+        auto first = this->pendingWrites.lower_bound({relationName, INT_MIN});
+        auto last = this->pendingWrites.lower_bound({relationName, INT_MAX});
+        this->pendingWrites.erase(first, last);
+        this->queueChanged.wait(guard, [&] { return !this->hasWrites(this->inFlightWrites, relationName); });
+    }
+    this->queueChanged.notify_all();
+    if (STORAGE_MODE == SEGMENT_FILES) {
+        this->closeSegment(relationName);
+        if (remove(segmentFileName(relationName).c_str()))
+            LOG_WARNING("DiskManager::deleteRelation: Err");
+        return;
+    }
+    for (int pageIndex = 0; pageIndex < pageCount; pageIndex++)
+        if (remove(pageFileName(relationName, pageIndex).c_str()))
+            LOG_WARNING("DiskManager::deleteRelation: Err");
+}
+
+/**
+ * @brief Moves the pages of relation oldName to newName, replacing whatever
+ * newName held before. For segment files the open descriptor is kept.
+ *
+ * @param oldName
+ * @param newName
+ * @param pageCount
+ */
+void DiskManager::renameRelation(const string &oldName, const string &newName, uint pageCount) {
+    LOG_TRACE("DiskManager::renameRelation");
+    {
+        // Queued pages are written under their old names first
+        unique_lock<mutex> guard(this->queueLock);
+        this->flushRequested = true;
+        this->queueChanged.notify_all();
+        this->queueChanged.wait(guard, [&] {
+            return !this->hasWrites(this->pendingWrites, oldName) && !this->hasWrites(this->inFlightWrites, oldName)
+                   && !this->hasWrites(this->pendingWrites, newName) && !this->hasWrites(this->inFlightWrites, newName);
+        });
+    }
+    if (STORAGE_MODE == SEGMENT_FILES) {
+        this->closeSegment(newName);
+        // If no page of oldName has reached the disk yet there is no segment
+        // to move, but whatever newName held is still replaced
+        if (rename(segmentFileName(oldName).c_str(), segmentFileName(newName).c_str())) {
+            LOG_WARNING("DiskManager::renameRelation: Err");
+            if (errno == ENOENT)
+                remove(segmentFileName(newName).c_str());
+        }
+        lock_guard<mutex> guard(this->lock);
+        auto it = this->segments.find(oldName);
+        if (it != this->segments.end()) {
+            Segment segment = it->second;
+            this->segments.erase(it);
+            this->segments[newName] = segment;
+        }
+        return;
+    }
+    for (int pageIndex = 0; pageIndex < pageCount; pageIndex++)
+        if (rename(pageFileName(oldName, pageIndex).c_str(), pageFileName(newName, pageIndex).c_str()))
+            LOG_WARNING("DiskManager::renameRelation: Err");
+}
+
+/**
+ * @brief Waits until every queued write has reached the disk
+ */
+void DiskManager::flushWrites() {
+    LOG_TRACE("DiskManager::flushWrites");
+    unique_lock<mutex> guard(this->queueLock);
+    this->flushRequested = true;
+    this->queueChanged.notify_all();
+    this->queueChanged.wait(guard, [this] { return this->pendingWrites.empty() && this->inFlightWrites.empty(); });
+}
+
+/**
+ * @brief Tells whether a page of the relation is on disk. Queued writes
+ * don't count.
+ *
+ * @param relationName
+ * @param pageIndex
+ * @return true if the page file exists, or the segment file reaches the
+ * page's slot
+ */
+bool DiskManager::hasPage(const string &relationName, int pageIndex) {
+    LOG_TRACE("DiskManager::hasPage");
+    struct stat status;
+    if (STORAGE_MODE == SEGMENT_FILES)
+        return stat(segmentFileName(relationName).c_str(), &status) == 0 &&
+               status.st_size > (off_t) pageIndex * (off_t) slotBytes();
+    return stat(pageFileName(relationName, pageIndex).c_str(), &status) == 0;
+}
@@ -0,0 +1,89 @@
+#ifndef DISK_MANAGER_H
+#define DISK_MANAGER_H
+#include"ioBackend.h"
+
+enum StorageMode {PAGE_FILES, SEGMENT_FILES};
+
+/**
+ * @brief The DiskManager maps pages to the files they are stored in. With
+ * PAGE_FILES every page is a file of its own ("<relation>_Page<pageIndex>").
+ * With SEGMENT_FILES all pages of a relation live in one segment file
+ * ("<relation>_Segment"), page N at offset N * slotBytes(), and are accessed
+ * with positioned reads and writes on a descriptor that stays open until the
+ * relation is deleted. Renaming a relation is then a single rename of its
+ * segment file.
+ *
+ * Segment files always hold binary pages; the text page format is only
+ * available with PAGE_FILES.
+ *
+ * <p>
+ * Reads and writes go through the IoBackend selected by IO_BACKEND. With
+ * DIRECT_IO set, segment files are opened with O_DIRECT so that pages bypass
+ * the kernel's page cache instead of being cached twice; slots are then
+ * rounded up to DIRECT_IO_ALIGNMENT and every transfer goes through an
+ * aligned bounce buffer. Both are fixed when the server starts.
+ * </p>
+ *
+ * <p>
+ * readAhead reads a batch of pages with a single submission, for the
+ * Prefetcher: the pages are kept for the calling thread, whose next readPage
+ * of each is served from memory.
+ * </p>
+ *
+ * <p>
+ * When WRITE_BEHIND_PAGES is non zero, writes are queued instead of being
+ * performed right away and a flusher thread writes the queue out in batches;
+ * in a segment file, runs of consecutive pages go out with one pwritev. Up to
+ * WRITE_BEHIND_PAGES pages can be waiting, after that writers block. Reads
+ * of a queued page are served from the queue, and the queued pages of a
+ * deleted relation are dropped without ever reaching the disk.
+ * </p>
+ */
+class DiskManager{
+
+    typedef map<pair<string, int>, vector<char>> WriteQueue;
+
+    struct Segment {
+        int fd = -1;
+        bool direct = false;
+    };
+
+    IoBackend *io = nullptr;
+    once_flag ioCreated;
+    unordered_map<string, Segment> segments;
+    mutex lock;
+    WriteQueue pendingWrites, inFlightWrites;
+    mutex queueLock;
+    condition_variable queueChanged;
+    thread flusher;
+    bool stopping = false;
+    bool flushRequested = false;
+
+    IoBackend &backend();
+    Segment getSegment(const string &relationName);
+    void closeSegment(const string &relationName);
+    void perform(vector<IoRequest> &requests, const vector<char> &direct,
+                 const function<void(size_t)> &completed = nullptr);
+    bool writePageNow(const string &relationName, int pageIndex, struct iovec *parts, int partCount);
+    void runFlusher();
+    void flush(const WriteQueue &writes);
+    bool hasWrites(const WriteQueue &writes, const string &relationName);
+
+    public:
+
+    ~DiskManager();
+    static string pageFileName(const string &relationName, int pageIndex);
+    static string segmentFileName(const string &relationName);
+    static size_t pageBytes();
+    static size_t slotBytes();
+    IoBackendType ioBackendType();
+    ssize_t readPage(const string &relationName, int pageIndex, struct iovec *parts, int partCount);
+    void readAhead(const vector<pair<string, int>> &pages, const function<void(size_t)> &completed);
+    void endReadAhead();
+    bool writePage(const string &relationName, int pageIndex, struct iovec *parts, int partCount);
+    void deleteRelation(const string &relationName, uint pageCount);
+    void renameRelation(const string &oldName, const string &newName, uint pageCount);
+    void flushWrites();
+    bool hasPage(const string &relationName, int pageIndex);
+};
+#endif //DISK_MANAGER_H
@@ -1,28 +1,156 @@
 #include"global.h"
 
-void executeCommand(){
+const char *queryTypeNames[] = {"CLEAR", "COMPUTE", "CROSS", "DISTINCT", "EXPORT", "GROUP BY", "INDEX", "JOIN", "LIST",
+                                "LOAD", "MULTIPLY", "PRINT", "PROJECT", "RENAME", "SELECT", "SET", "SORT", "SOURCE",
+                                "CHECKSYMMETRY", "TRANSPOSE", "ORDER BY", "UNDETERMINED"};
+
+/**
+ * @brief Names of the tables the parsed statement reads and of the table it
+ * writes (empty if it writes none)
+ */
+void statementRelations(vector<string> &inputs, string &result){
+    switch(parsedQuery.queryType){
+        case CROSS:
+            inputs = {parsedQuery.crossFirstRelationName, parsedQuery.crossSecondRelationName};
+            result = parsedQuery.crossResultRelationName;
+            break;
+        case DISTINCT:
+            inputs = {parsedQuery.distinctRelationName};
+            result = parsedQuery.distinctResultRelationName;
+            break;
+        case EXPORT: inputs = {parsedQuery.exportRelationName}; break;
+        case GROUPBY:
+            inputs = {parsedQuery.groupByRelationName};
+            result = parsedQuery.groupByResultantRelationName;
+            break;
+        case INDEX: inputs = {parsedQuery.indexRelationName}; break;
+        case JOIN:
+            inputs = {parsedQuery.joinFirstRelationName, parsedQuery.joinSecondRelationName};
+            result = parsedQuery.joinResultRelationName;
+            break;
+        case LOAD: result = parsedQuery.loadRelationName; break;
+        case PRINT: inputs = {parsedQuery.printRelationName}; break;
+        case PROJECTION:
+            inputs = {parsedQuery.projectionRelationName};
+            result = parsedQuery.projectionResultRelationName;
+            break;
+        case SELECTION:
+            inputs = {parsedQuery.selectionRelationName};
+            result = parsedQuery.selectionResultRelationName;
+            break;
+        case SORT:
+            inputs = {parsedQuery.sortRelationName};
+            result = parsedQuery.sortRelationName;
+            break;
+        case ORDERBY:
+            inputs = {parsedQuery.orderByRelationName};
+            result = parsedQuery.orderByResultantRelationName;
+            break;
+        default: break;
+    }
+}
 
+/**
+ * @brief Takes the locks the parsed statement needs (see LockManager):
+ * statements with known relations lock those, the rest the whole catalogue
+ */
+StatementLock lockStatement(){
+    vector<string> inputs;
+    string result;
+    statementRelations(inputs, result);
+    bool known = !inputs.empty() || !result.empty();
+    for (const string &input: inputs)
+        known &= !input.empty();
     switch(parsedQuery.queryType){
-        case CLEAR: executeCLEAR(); break;
-        case COMPUTE: executeCOMPUTE(); break;
-        case CROSS: executeCROSS(); break;
-        case DISTINCT: executeDISTINCT(); break;
-        case EXPORT: executeEXPORT(); break;
-        case GROUPBY: executeGROUPBY(); break;
-        case INDEX: executeINDEX(); break;
-        case JOIN: executeJOIN(); break;
-        case LIST: executeLIST(); break;
-        case LOAD: executeLOAD(); break;
-        case PRINT: executePRINT(); break;
-        case PROJECTION: executePROJECTION(); break;
-        case RENAME: executeRENAME(); break;
-        case SELECTION: executeSELECTION(); break;
-        case SORT: executeSORT(); break;
-        case SOURCE: executeSOURCE(); break;
-        case SYMMETRY: executeSYMMETRY(); break;
-        case TRANSPOSE: executeTRANSPOSE(); break;
-        case ORDERBY: executeORDERBY(); break;
-        default: cout<<"PARSING ERROR"<<endl;
+        case CROSS: case DISTINCT: case EXPORT: case GROUPBY: case JOIN: case LOAD: case PRINT: case PROJECTION:
+        case SELECTION: case SORT: case ORDERBY: break;
+        default: known = false;
+    }
+    if (!known)
+        return lockManager.lockCatalogue();
+    vector<string> reads, writes;
+    for (const string &input: inputs)
+        if (input != result)
+            reads.push_back(input);
+    if (!result.empty())
+        writes.push_back(result);
+    return lockManager.lockRelations(reads, writes);
+}
+
+long long relationRows(const string &relationName){
+    return !relationName.empty() && tableCatalogue.isTable(relationName) ? tableCatalogue.getTable(relationName)->rowCount : 0;
+}
+
+void executeCommand(){
+
+    if (parsedQuery.explain) {
+        executeEXPLAIN();
+        if (!parsedQuery.analyze)
+            return;
+    }
+    // SOURCE is left out: the statements it runs are profiled one by one
+    bool profile = parsedQuery.queryType != SOURCE && (parsedQuery.analyze || !STATS_FILE.empty());
+    vector<string> inputs;
+    string result;
+    long long rowsIn = 0;
+    statementRelations(inputs, result);
+    if (profile) {
+        for (const string &input: inputs)
+            rowsIn += relationRows(input);
+        profiler.start(queryTypeNames[parsedQuery.queryType]);
+    }
+    // A result computed before from the same inputs is taken over instead
+    string cacheKey = resultCache.keyFor(tokenizedQuery, inputs);
+    bool reused = !cacheKey.empty() && resultCache.reuse(cacheKey, result);
+    if (!reused) {
+        switch(parsedQuery.queryType){
+            case CLEAR: executeCLEAR(); break;
+            case COMPUTE: executeCOMPUTE(); break;
+            case CROSS: executeCROSS(); break;
+            case DISTINCT: executeDISTINCT(); break;
+            case EXPORT: executeEXPORT(); break;
+            case GROUPBY: executeGROUPBY(); break;
+            case INDEX: executeINDEX(); break;
+            case JOIN: executeJOIN(); break;
+            case LIST: executeLIST(); break;
+            case LOAD: executeLOAD(); break;
+            case MULTIPLY: executeMULTIPLY(); break;
+            case PRINT: executePRINT(); break;
+            case PROJECTION: executePROJECTION(); break;
+            case RENAME: executeRENAME(); break;
+            case SELECTION: executeSELECTION(); break;
+            case SET: executeSET(); break;
+            case SORT: executeSORT(); break;
+            case SOURCE: executeSOURCE(); break;
+            case SYMMETRY: executeSYMMETRY(); break;
+            case TRANSPOSE: executeTRANSPOSE(); break;
+            case ORDERBY: executeORDERBY(); break;
+            default: cout<<"PARSING ERROR"<<endl;
+        }
+    }
+    if (!cacheKey.empty() && !reused)
+        resultCache.remember(cacheKey, inputs, result);
+    // Tables changed in place get a new version
+    string changedTable = parsedQuery.queryType == SORT ? parsedQuery.sortRelationName
+                          : parsedQuery.queryType == RENAME ? parsedQuery.renameRelationName : "";
+    if (!changedTable.empty() && tableCatalogue.isTable(changedTable)) {
+        tableCatalogue.touchTable(changedTable);
+        resultCache.forget(changedTable);
+    }
+    if (profile) {
+        profiler.finish(rowsIn, relationRows(result));
+        if (parsedQuery.analyze)
+            profiler.print(cout);
+        if (!STATS_FILE.empty()) {
+            string statement;
+            for (const string &token: tokenizedQuery)
+                statement += (statement.empty() ? "" : " ") + token;
+            // Sessions append whole lines, one at a time
+            static mutex statsFileLock;
+            lock_guard<mutex> guard(statsFileLock);
+            ofstream fout(STATS_FILE, ios::app);
+            profiler.writeJson(fout, statement);
+        }
     }
 
     return;
@@ -1,21 +1,30 @@
 #include"semanticParser.h"
+#include"operatorKernels.h"
+#include"predicateKernels.h"
+#include"pipeline.h"
+#include"costModel.h"
+#include"lockManager.h"
 
 void executeCommand();
+StatementLock lockStatement();
 
 void executeCLEAR();
 void executeCOMPUTE();
 void executeCROSS();
 void executeDISTINCT();
+void executeEXPLAIN();
 void executeEXPORT();
 void executeGROUPBY();
 void executeINDEX();
 void executeJOIN();
 void executeLIST();
 void executeLOAD();
+void executeMULTIPLY();
 void executePRINT();
 void executePROJECTION();
 void executeRENAME();
 void executeSELECTION();
+void executeSET();
 void executeSORT();
 void executeSOURCE();
 void executeSYMMETRY();
@@ -23,4 +32,7 @@ void executeTRANSPOSE();
 void executeORDERBY();
 
 bool evaluateBinOp(int value1, int value2, BinaryOperator binaryOperator);
-void printRowCount(int rowCount);
\ No newline at end of file
+int evaluateOnRanges(long long low1, long long high1, long long low2, long long high2, BinaryOperator binaryOperator);
+int evaluateOnZoneMap(const Table &table, uint pageIndex, const ParsedQuery &query);
+void printRowCount(int rowCount);
+bool applyConfig(const string &fileName);
\ No newline at end of file
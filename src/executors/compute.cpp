@@ -5,7 +5,7 @@
  */
 bool syntacticParseCOMPUTE()
 {
-    logger.log("syntacticParseCOMPUTE");
+    LOG_TRACE("syntacticParseCOMPUTE");
     if (tokenizedQuery.size() != 2) {
         cout << "SYNTAX ERROR" << endl;
         return false;
@@ -17,7 +17,7 @@ bool syntacticParseCOMPUTE()
 
 bool semanticParseCOMPUTE()
 {
-    logger.log("semanticParseCOMPUTE");
+    LOG_TRACE("semanticParseCOMPUTE");
     if (!tableCatalogue.isMatrix(parsedQuery.computeMatrixName))
     {
         cout << "SEMANTIC ERROR: Matrix doesn't exist" << endl;
@@ -28,7 +28,7 @@ bool semanticParseCOMPUTE()
 
 void executeCOMPUTE()
 {
-    logger.log("executeCOMPUTE");
+    LOG_TRACE("executeCOMPUTE");
     Matrix* matrix = tableCatalogue.getMatrix(parsedQuery.computeMatrixName);
     string matrixResultName = parsedQuery.computeMatrixName + "_RESULT";
     Matrix* matrixResult = new Matrix(matrixResultName, matrix);
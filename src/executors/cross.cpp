@@ -6,7 +6,7 @@
  */
 bool syntacticParseCROSS()
 {
-    logger.log("syntacticParseCROSS");
+    LOG_TRACE("syntacticParseCROSS");
     if (tokenizedQuery.size() != 5)
     {
         cout << "SYNTAX ERROR" << endl;
@@ -21,7 +21,7 @@ bool syntacticParseCROSS()
 
 bool semanticParseCROSS()
 {
-    logger.log("semanticParseCROSS");
+    LOG_TRACE("semanticParseCROSS");
     //Both tables must exist and resultant table shouldn't
     if (tableCatalogue.isTable(parsedQuery.crossResultRelationName))
     {
@@ -39,7 +39,7 @@ bool semanticParseCROSS()
 
 void executeCROSS()
 {
-    logger.log("executeCROSS");
+    LOG_TRACE("executeCROSS");
 
     Table table1 = *(tableCatalogue.getTable(parsedQuery.crossFirstRelationName));
     Table table2 = *(tableCatalogue.getTable(parsedQuery.crossSecondRelationName));
@@ -75,29 +75,38 @@ void executeCROSS()
 
     Table *resultantTable = new Table(parsedQuery.crossResultRelationName, columns);\
 
-    Cursor cursor1 = table1.getCursor();
-    Cursor cursor2 = table2.getCursor();
-
-    vector<int> row1 = cursor1.getNext();
-    vector<int> row2;
     vector<int> resultantRow;
     resultantRow.reserve(resultantTable->columnCount);
+    TableBuilder builder(resultantTable);
 
-    while (!row1.empty())
+    // Block nested loop: as many pages of the first table as the grant allows
+    // are held in memory and the second table is read once per such chunk
+    MemoryGrant grant = memoryManager.grant(table1.blockCount + 2);
+    const uint chunkPages = grant.workFrames();
+    vector<int> outerRows;
+    for (uint firstPage = 0; firstPage < table1.blockCount; firstPage += chunkPages)
     {
-
-        cursor2 = table2.getCursor();
-        row2 = cursor2.getNext();
-        while (!row2.empty())
+        outerRows.clear();
+        long long outerCount = table1.readPages(firstPage, chunkPages, outerRows);
+        Cursor cursor2 = table2.getCursor();
+        for (uint pageCounter = 0; pageCounter < table2.blockCount; pageCounter++)
         {
-            resultantRow = row1;
-            resultantRow.insert(resultantRow.end(), row2.begin(), row2.end());
-            resultantTable->writeRow<int>(resultantRow);
-            row2 = cursor2.getNext();
+            if (pageCounter)
+                cursor2.nextPage(pageCounter);
+            for (long long outerCounter = 0; outerCounter < outerCount; outerCounter++)
+            {
+                const int *row1 = outerRows.data() + outerCounter * table1.columnCount;
+                for (int rowCounter = 0; rowCounter < cursor2.page->getRowCount(); rowCounter++)
+                {
+                    RowView row2 = cursor2.page->getRowView(rowCounter);
+                    resultantRow.assign(row1, row1 + table1.columnCount);
+                    resultantRow.insert(resultantRow.end(), row2.begin(), row2.end());
+                    builder.addRow(resultantRow);
+                }
+            }
         }
-        row1 = cursor1.getNext();
     }
-    resultantTable->blockify();
+    builder.finish();
     tableCatalogue.insertTable(resultantTable);
     return;
 }
\ No newline at end of file
@@ -6,7 +6,7 @@
  */
 bool syntacticParseDISTINCT()
 {
-    logger.log("syntacticParseDISTINCT");
+    LOG_TRACE("syntacticParseDISTINCT");
     if (tokenizedQuery.size() != 4)
     {
         cout << "SYNTAX ERROR" << endl;
@@ -20,7 +20,7 @@ bool syntacticParseDISTINCT()
 
 bool semanticParseDISTINCT()
 {
-    logger.log("semanticParseDISTINCT");
+    LOG_TRACE("semanticParseDISTINCT");
     //The resultant table shouldn't exist and the table argument should
     if (tableCatalogue.isTable(parsedQuery.distinctResultRelationName))
     {
@@ -36,8 +36,62 @@ bool semanticParseDISTINCT()
     return true;
 }
 
+/**
+ * @brief Hash based duplicate elimination. The distinct rows seen so far are
+ * kept one after the other in a flat array, and a hash set of their positions
+ * tells whether a row has been seen. Rows are written in the order they are
+ * first seen.
+ */
+void hashDISTINCT(Table *table, TableBuilder &builder)
+{
+    LOG_TRACE("hashDISTINCT");
+    const uint columnCount = table->columnCount;
+    vector<int> rows;
+    auto rowAt = [&](size_t position) { return rows.data() + position * columnCount; };
+    auto hash = [&](size_t position) {
+        const int *row = rowAt(position);
+        uint hash = 0;
+        for (uint columnCounter = 0; columnCounter < columnCount; columnCounter++)
+            hash = Table::hashKey(row[columnCounter], hash + columnCounter);
+        return (size_t) hash;
+    };
+    auto equal = [&](size_t a, size_t b) { return std::equal(rowAt(a), rowAt(a) + columnCount, rowAt(b)); };
+    unordered_set<size_t, decltype(hash), decltype(equal)> seen(estimateDistinctRows(table), hash, equal);
+
+    Cursor cursor = table->getCursor();
+    for (RowView row = cursor.getNextView(); !row.empty(); row = cursor.getNextView()) {
+        size_t position = seen.size();
+        rows.insert(rows.end(), row.begin(), row.end());
+        if (seen.insert(position).second)
+            builder.addRow(RowView{rowAt(position), (int) columnCount, 1});
+        else
+            rows.resize(position * columnCount);
+    }
+}
+
+/**
+ * @brief Removes duplicate rows. If the estimated distinct rows fit into the
+ * work frames of a memory grant they are found with a hash set in a single scan
+ * (keeping the order of the relation), otherwise the copy of the relation is
+ * sorted on all its columns with duplicates dropped during the external sort
+ * (the result is in sorted order).
+ */
 void executeDISTINCT()
 {
-    logger.log("executeDISTINCT");
-    return;
-}
\ No newline at end of file
+    LOG_TRACE("executeDISTINCT");
+
+    Table *table = tableCatalogue.getTable(parsedQuery.distinctRelationName);
+    QueryPlan plan = planDistinct(table);
+    if (plan.algorithm == HASH_DISTINCT) {
+        MemoryGrant grant = memoryManager.grant(plan.memoryFrames);
+        auto *resultantTable = new Table(parsedQuery.distinctResultRelationName, table->columns);
+        TableBuilder builder(resultantTable);
+        hashDISTINCT(table, builder);
+        builder.finish();
+        tableCatalogue.insertTable(resultantTable);
+        return;
+    }
+    auto *resultantTable = new Table(parsedQuery.distinctResultRelationName, table);
+    tableCatalogue.insertTable(resultantTable);
+    resultantTable->sort(table->columns, vector<int>(table->columnCount, 1), table->tableName, true);
+}
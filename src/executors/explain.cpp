@@ -0,0 +1,160 @@
+#include "global.h"
+/**
+ * @brief 
+ * SYNTAX: EXPLAIN statement
+ *         EXPLAIN ANALYZE statement
+ *
+ * The statement is any assignment statement or SORT. It is parsed and checked
+ * as usual but not run; instead the plan the cost model picks for it is
+ * printed with its estimates.
+ *
+ * With ANALYZE the statement can be any statement but SOURCE. It is run after
+ * its plan is printed, and what each of its operators took is printed after
+ * it (see Profiler).
+ */
+bool syntacticParseEXPLAIN()
+{
+    LOG_TRACE("syntacticParseEXPLAIN");
+    tokenizedQuery.erase(tokenizedQuery.begin());
+    bool analyze = tokenizedQuery[0] == "ANALYZE";
+    if (analyze)
+        tokenizedQuery.erase(tokenizedQuery.begin());
+    if (tokenizedQuery.size() < 2)
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    if (!syntacticParse())
+        return false;
+    parsedQuery.analyze = analyze;
+    if (analyze && parsedQuery.queryType != SOURCE)
+    {
+        parsedQuery.explain = true;
+        return true;
+    }
+    switch (parsedQuery.queryType)
+    {
+    case CROSS:
+    case DISTINCT:
+    case GROUPBY:
+    case JOIN:
+    case ORDERBY:
+    case PROJECTION:
+    case SELECTION:
+    case SORT:
+        parsedQuery.explain = true;
+        return true;
+    default:
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Plan of a SELECT, naming the index it uses
+ */
+QueryPlan explainSELECTION(string &detail)
+{
+    Table *table = tableCatalogue.getTable(parsedQuery.selectionRelationName);
+    QueryPlan plan = planSelection(table, parsedQuery);
+    detail = " ON " + table->tableName;
+    if (plan.algorithm == INDEX_SCAN)
+        detail += " USING INDEX ON " + parsedQuery.selectionFirstColumnName;
+    return plan;
+}
+
+/**
+ * @brief Plan of a JOIN, naming the build or inner relation
+ */
+QueryPlan explainJOIN(string &detail)
+{
+    Table *table1 = tableCatalogue.getTable(parsedQuery.joinFirstRelationName);
+    Table *table2 = tableCatalogue.getTable(parsedQuery.joinSecondRelationName);
+    QueryPlan plan = planJoin(table1, table1->getColumnIndex(parsedQuery.joinFirstColumnName), table2,
+                              table2->getColumnIndex(parsedQuery.joinSecondColumnName), parsedQuery.joinBinaryOperator);
+    string first = parsedQuery.joinFirstRelationName, second = parsedQuery.joinSecondRelationName;
+    if (plan.algorithm == HASH_JOIN)
+        detail = " BUILD " + (plan.firstIsBuild ? first : second) + " PROBE " + (plan.firstIsBuild ? second : first);
+    else if (plan.algorithm == INDEX_NESTED_LOOP_JOIN)
+        detail = " OUTER " + (plan.firstIsBuild ? second : first) + " INNER " + (plan.firstIsBuild ? first : second)
+                 + " USING INDEX ON " + (plan.firstIsBuild ? parsedQuery.joinFirstColumnName : parsedQuery.joinSecondColumnName);
+    else
+        detail = " " + first + ", " + second;
+    return plan;
+}
+
+/**
+ * @brief Prints the plan of the parsed statement: its algorithm, the number
+ * of rows it is expected to produce and the block accesses it is expected to
+ * take (not counting the writing of its result)
+ */
+void executeEXPLAIN()
+{
+    LOG_TRACE("executeEXPLAIN");
+    QueryPlan plan;
+    string detail;
+    Table *table = nullptr;
+    switch (parsedQuery.queryType)
+    {
+    case SELECTION:
+        plan = explainSELECTION(detail);
+        break;
+    case JOIN:
+        plan = explainJOIN(detail);
+        break;
+    case GROUPBY:
+        table = tableCatalogue.getTable(parsedQuery.groupByRelationName);
+        // Key, row count and aggregates of a group plus hash table pointers, as in executeGROUPBY
+        plan = planGroupBy(table, table->getColumnIndex(parsedQuery.groupByGroupingAttribute),
+                           sizeof(int) + sizeof(long long) * (parsedQuery.groupByReturnAttributes.size() + 2) + 2 * sizeof(size_t));
+        detail = " ON " + table->tableName + " BY " + parsedQuery.groupByGroupingAttribute;
+        break;
+    case DISTINCT:
+        table = tableCatalogue.getTable(parsedQuery.distinctRelationName);
+        plan = planDistinct(table);
+        detail = " ON " + table->tableName;
+        break;
+    case PROJECTION:
+        table = tableCatalogue.getTable(parsedQuery.projectionRelationName);
+        plan.cost = table->blockCount;
+        plan.estimatedRows = table->rowCount;
+        detail = " ON " + table->tableName;
+        break;
+    case CROSS:
+    {
+        Table *table1 = tableCatalogue.getTable(parsedQuery.crossFirstRelationName);
+        Table *table2 = tableCatalogue.getTable(parsedQuery.crossSecondRelationName);
+        plan.memoryFrames = max(MIN_GRANT_FRAMES, min(memoryManager.availableFrames(), table1->blockCount + 2));
+        const long long chunkPages = plan.memoryFrames - 2;
+        plan.algorithm = BLOCK_NESTED_LOOP_PRODUCT;
+        plan.cost = table1->blockCount + (table1->blockCount + chunkPages - 1) / chunkPages * table2->blockCount;
+        plan.estimatedRows = table1->rowCount * table2->rowCount;
+        detail = " " + table1->tableName + ", " + table2->tableName;
+        break;
+    }
+    case ORDERBY:
+        table = tableCatalogue.getTable(parsedQuery.orderByRelationName);
+        plan = planOrderBy(table, table->getColumnIndex(parsedQuery.orderByColumnName), parsedQuery.orderByMultiplier,
+                           parsedQuery.orderByLimit);
+        detail = " ON " + table->tableName;
+        break;
+    case SORT:
+    {
+        table = tableCatalogue.getTable(parsedQuery.sortRelationName);
+        vector<int> multipliers(parsedQuery.sortingStrategies.begin(), parsedQuery.sortingStrategies.end());
+        plan.algorithm = EXTERNAL_SORT;
+        plan.cost = sortCost(table, table->getColumnIndex(parsedQuery.sortColumnNames), multipliers);
+        plan.estimatedRows = table->rowCount;
+        detail = " ON " + table->tableName;
+        break;
+    }
+    default:
+        // Statements without a plan, only run by EXPLAIN ANALYZE
+        return;
+    }
+    cout << physicalOperatorNames[plan.algorithm] << detail << endl;
+    cout << "Estimated rows: " << plan.estimatedRows << endl;
+    cout << "Estimated block I/O: " << plan.cost << endl;
+    if (plan.memoryFrames)
+        cout << "Memory grant: " << plan.memoryFrames << " frames" << endl;
+}
@@ -2,16 +2,26 @@
 
 /**
  * @brief 
- * SYNTAX: EXPORT <relation_name> 
+ * SYNTAX: EXPORT <relation_name> [BINARY]
+ * SYNTAX: EXPORT MATRIX <matrix_name>
+ *
+ * A table is exported to <relation_name>.csv, or with BINARY to the binary
+ * columnar file <relation_name>.col (see ColumnarFile), which LOAD ... BINARY
+ * reads back.
  */
 
 bool syntacticParseEXPORT()
 {
-    logger.log("syntacticParseEXPORT");
+    LOG_TRACE("syntacticParseEXPORT");
     if (tokenizedQuery.size() == 2) {
         parsedQuery.queryType = EXPORT;
         parsedQuery.exportRelationName = tokenizedQuery[1];
     }
+    else if (tokenizedQuery.size() == 3 && tokenizedQuery[2] == "BINARY") {
+        parsedQuery.queryType = EXPORT;
+        parsedQuery.exportRelationName = tokenizedQuery[1];
+        parsedQuery.exportBinary = true;
+    }
     else if (tokenizedQuery.size() == 3 && tokenizedQuery[1] == "MATRIX") {
         parsedQuery.queryType = EXPORT;
         parsedQuery.exportMatrixName = tokenizedQuery[2];
@@ -25,7 +35,7 @@ bool syntacticParseEXPORT()
 
 bool semanticParseEXPORT()
 {
-    logger.log("semanticParseEXPORT");
+    LOG_TRACE("semanticParseEXPORT");
     //Table should exist
     if (!parsedQuery.exportRelationName.empty()) {
         if (tableCatalogue.isTable(parsedQuery.exportRelationName))
@@ -43,10 +53,16 @@ bool semanticParseEXPORT()
 
 void executeEXPORT()
 {
-    logger.log("executeEXPORT");
+    LOG_TRACE("executeEXPORT");
     if (!parsedQuery.exportRelationName.empty()) {
         Table* table = tableCatalogue.getTable(parsedQuery.exportRelationName);
-        table->makePermanent();
+        if (parsedQuery.exportBinary)
+        {
+            if (!ColumnarFile::write(table))
+                cout << "Export failed" << endl;
+        }
+        else
+            table->makePermanent();
     }
     else {
         Matrix* matrix = tableCatalogue.getMatrix(parsedQuery.exportMatrixName);
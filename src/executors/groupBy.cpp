@@ -1,28 +1,18 @@
 #include "global.h"
 
-bool lesser_than(int x, int y) { return x < y; }
-bool greater_than(int x, int y) { return x > y; }
-bool leq(int x, int y) { return x <= y; }
-bool geq(int x, int y) { return x >= y; }
-bool equal(int x, int y) { return x == y; }
-bool not_equal(int x, int y) { return x != y; }
-bool (*comparators[])(int, int) = {lesser_than, greater_than, leq, geq, equal, not_equal};
-
-long long min(long long x, long long y) { return std::min(x, y); }
-long long max(long long x, long long y) { return std::max(x, y); }
-long long sum(long long x, long long y) { return x + y; }
-long long (*accumulators[])(long long, long long) = {min, max, sum, sum};
+const string aggregateNames[] = {"MIN", "MAX", "SUM", "AVG", "COUNT"};
 
 optional<pair<AggregateFunction, string>> parseAggregateFunction(string agg) {
     int len = agg.length();
     optional<pair<AggregateFunction, string>> parsedValues;
     pair<AggregateFunction, string> val;
-    if(len < 6 || agg[3] != '(' || agg[len-1] != ')') {
+    size_t open = agg.find('(');
+    if(open == string::npos || open + 2 >= len || agg[len-1] != ')') {
         parsedValues.reset();
         return parsedValues;
     }
 
-    string func = agg.substr(0, 3);
+    string func = agg.substr(0, open);
     if (func == "MIN")
         val.first = MIN;
     else if (func == "MAX")
@@ -31,12 +21,14 @@ optional<pair<AggregateFunction, string>> parseAggregateFunction(string agg) {
         val.first = SUM;
     else if (func == "AVG")
         val.first = AVG;
+    else if (func == "COUNT")
+        val.first = COUNT;
     else {
         parsedValues.reset();
         return parsedValues;
     }
 
-    string s = agg.substr(4, len - 5);
+    string s = agg.substr(open + 1, len - open - 2);
     val.second = s;
     parsedValues = val;
     return parsedValues;
@@ -46,14 +38,15 @@ optional<pair<AggregateFunction, string>> parseAggregateFunction(string agg) {
  * @brief File contains method to process GROUP BY commands.
  *
  * syntax:
- * <new_table> <- GROUP BY <grouping_attribute> FROM <table_name> HAVING <aggregate(attribute)> <bin_op> <attribute_value> RETURN <aggregate_func(attribute)>
+ * <new_table> <- GROUP BY <grouping_attribute> FROM <table_name> HAVING <aggregate(attribute)> <bin_op> <attribute_value> RETURN <aggregate_func(attribute)>[, <aggregate_func(attribute)>...]
  *
+ * aggregate_func: MIN | MAX | SUM | AVG | COUNT
  */
 bool syntacticParseGROUPBY() {
-    logger.log("syntacticParseGROUPBY");
+    LOG_TRACE("syntacticParseGROUPBY");
     auto numTokens = tokenizedQuery.size();
 
-    if(numTokens != 13 || tokenizedQuery[3] != "BY" || tokenizedQuery[5] != "FROM" || tokenizedQuery[7] != "HAVING" || tokenizedQuery[11] != "RETURN") {
+    if(numTokens < 13 || tokenizedQuery[3] != "BY" || tokenizedQuery[5] != "FROM" || tokenizedQuery[7] != "HAVING" || tokenizedQuery[11] != "RETURN") {
         cout << "SYNTAX ERROR" << endl;
         return false;
     }
@@ -104,21 +97,24 @@ bool syntacticParseGROUPBY() {
         return false;
     }
 
-    parsedAggregateFunction = parseAggregateFunction(tokenizedQuery[12]);
-    if(parsedAggregateFunction.has_value())
-        parsedQuery.groupByReturnAggregateFunction = parsedAggregateFunction->first,
-        parsedQuery.groupByReturnAttribute = parsedAggregateFunction->second;
-    else
-    {
-        cout << "SYNTAX ERROR" << endl;
-        return false;
+    for (int i = 12; i < numTokens; i++) {
+        parsedAggregateFunction = parseAggregateFunction(tokenizedQuery[i]);
+        if(parsedAggregateFunction.has_value()) {
+            parsedQuery.groupByReturnAggregateFunctions.push_back(parsedAggregateFunction->first);
+            parsedQuery.groupByReturnAttributes.push_back(parsedAggregateFunction->second);
+        }
+        else
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
     }
 
     return true;
 }
 
 bool semanticParseGROUPBY() {
-    logger.log("semanticParseGROUPBY");
+    LOG_TRACE("semanticParseGROUPBY");
 
     if (tableCatalogue.isTable(parsedQuery.groupByResultantRelationName)) {
         cout << "SEMANTIC ERROR: Resultant Relation already exists" << endl;
@@ -140,95 +136,315 @@ bool semanticParseGROUPBY() {
         return false;
     }
 
-    if (!tableCatalogue.isColumnFromTable(parsedQuery.groupByReturnAttribute, parsedQuery.groupByRelationName)) {
-        cout << "SEMANTIC ERROR: Column does not exist in relation" << endl;
-        return false;
+    set<string> returnColumns;
+    for (int i = 0; i < parsedQuery.groupByReturnAttributes.size(); i++) {
+        if (!tableCatalogue.isColumnFromTable(parsedQuery.groupByReturnAttributes[i], parsedQuery.groupByRelationName)) {
+            cout << "SEMANTIC ERROR: Column does not exist in relation" << endl;
+            return false;
+        }
+        string columnName = aggregateNames[parsedQuery.groupByReturnAggregateFunctions[i]] + parsedQuery.groupByReturnAttributes[i];
+        if (columnName == parsedQuery.groupByGroupingAttribute || !returnColumns.insert(columnName).second) {
+            cout << "SEMANTIC ERROR: Aggregate returned twice" << endl;
+            return false;
+        }
     }
 
     return true;
 }
 
-void executeGROUPBY() {
-    logger.log("executeGROUPBY");
+/**
+ * @brief Folds a column of a page into the groups of its rows: row i goes
+ * into the aggregate at states[groups[i] * stride]
+ */
+template <AggregateFunction function>
+void accumulateColumn(ColumnView column, const uint *groups, long long *states, size_t stride)
+{
+    for (int rowCounter = 0; rowCounter < column.size(); rowCounter++) {
+        long long &state = states[groups[rowCounter] * stride];
+        state = accumulateValue<function>(state, column[rowCounter]);
+    }
+}
 
-    string tempTableName = "Temp_GROUP_BY_" + parsedQuery.groupByRelationName;
+/**
+ * @brief Aggregates a GROUP BY computes: the HAVING aggregate comes first,
+ * followed by the RETURN aggregates.
+ */
+struct GroupByPlan {
+    int groupingColumn;
+    vector<AggregateFunction> functions;
+    vector<int> columns;
+    BinaryOperator binaryOperator;
+    long long attributeValue;
+
+    /**
+     * @brief Memory a group takes in the hash table: key, row count and the
+     * aggregates, plus the bucket and node pointers
+     */
+    size_t groupBytes() const {
+        return sizeof(int) + sizeof(long long) * (this->functions.size() + 1) + 2 * sizeof(size_t);
+    }
 
-    Table *table = tableCatalogue.getTable(parsedQuery.groupByRelationName);
-    auto *tempTable = new Table(tempTableName, table);
-    tableCatalogue.insertTable(tempTable);
-    tempTable->sort(parsedQuery.groupByGroupingAttribute, ASC, parsedQuery.groupByRelationName);
-
-    logger.log("sort done");
-
-    const BinaryOperator binaryOperator = parsedQuery.groupByBinaryOperator;
-    const AggregateFunction havingAggregateFunction = parsedQuery.groupByHavingAggregateFunction;
-    const AggregateFunction returnAggregateFunction = parsedQuery.groupByReturnAggregateFunction;
-
-    const int groupingAttribute = tempTable->getColumnIndex(parsedQuery.groupByGroupingAttribute);
-    const int havingAttribute = tempTable->getColumnIndex(parsedQuery.groupByHavingAttribute);
-    const int returnAttribute = tempTable->getColumnIndex(parsedQuery.groupByReturnAttribute);
-    string aggregateOutputColumnName;
-
-    if (returnAggregateFunction == MIN)
-        aggregateOutputColumnName = "MIN" + parsedQuery.groupByReturnAttribute;
-    else if (returnAggregateFunction == MAX)
-        aggregateOutputColumnName = "MAX" + parsedQuery.groupByReturnAttribute;
-    else if (returnAggregateFunction == SUM)
-        aggregateOutputColumnName = "SUM" + parsedQuery.groupByReturnAttribute;
-    else if (returnAggregateFunction == AVG)
-        aggregateOutputColumnName = "AVG" + parsedQuery.groupByReturnAttribute;
-
-    auto *resultantTable = new Table(parsedQuery.groupByResultantRelationName, vector<string>{parsedQuery.groupByGroupingAttribute, aggregateOutputColumnName});
-
-    Cursor cursor = tempTable->getCursor();
-    vector<int> row = cursor.getNext();
-    vector<vector<int>> rowsToWrite(resultantTable->maxRowsPerBlock, vector<int>(resultantTable->columnCount));
-    int numRowsToWrite = 0;
-    int prevGroup = row[groupingAttribute];
-    long long accum = row[havingAttribute];
-    long long ret = row[returnAttribute];
-    const long long val = parsedQuery.groupByAttributeValue;
-    int numRowsInGroup = 1;
-
-    for(int i = 1; i < tempTable->rowCount; i++) {
-        row = cursor.getNext();
-        if (row[groupingAttribute] == prevGroup) {
-            accum = accumulators[havingAggregateFunction](accum, row[havingAttribute]);
-            ret = accumulators[returnAggregateFunction](ret, row[returnAttribute]);
-            numRowsInGroup++;
+    /**
+     * @brief Appends the aggregates of a group without rows to states
+     */
+    void addGroup(vector<long long> &states) const {
+        for (AggregateFunction function: this->functions)
+            states.push_back(withAggregateFunction(function, [](auto function) {
+                return aggregateIdentity<function>();
+            }));
+    }
+
+    /**
+     * @brief Accumulates the rows of a page into their groups, groups[i]
+     * being the group of row i. The function of an aggregate is resolved
+     * once for the whole page.
+     */
+    void accumulatePage(Page *page, const vector<uint> &groups, long long *states) const {
+        for (size_t aggregate = 0; aggregate < this->functions.size(); aggregate++)
+            withAggregateFunction(this->functions[aggregate], [&](auto function) {
+                accumulateColumn<function>(page->getColumnView(this->columns[aggregate]), groups.data(),
+                                           states + aggregate, this->functions.size());
+            });
+    }
+
+    /**
+     * @brief Adds the aggregates of a group accumulated over other rows to
+     * states
+     */
+    void combineGroup(long long *states, const long long *otherStates) const {
+        for (size_t aggregate = 0; aggregate < this->functions.size(); aggregate++)
+            states[aggregate] = withAggregateFunction(this->functions[aggregate], [&](auto function) {
+                return combineStates<function>(states[aggregate], otherStates[aggregate]);
+            });
+    }
+};
+
+/**
+ * @brief Finishes the aggregates of a group and writes it to the result if
+ * it passes the HAVING clause
+ *
+ * @param key value of the grouping attribute
+ * @param state aggregates of the group, in the order of the plan
+ * @param rowCount rows in the group
+ */
+void writeGroup(int key, long long *state, long long rowCount, const GroupByPlan &plan, vector<int> &resultantRow,
+                TableBuilder &builder)
+{
+    for (size_t aggregate = 0; aggregate < plan.functions.size(); aggregate++)
+        if (plan.functions[aggregate] == AVG)
+            state[aggregate] /= rowCount;
+    bool passes = withBinaryOperator(plan.binaryOperator, [&](auto binaryOperator) {
+        return compare<binaryOperator>(state[0], plan.attributeValue);
+    });
+    if (!passes)
+        return;
+    resultantRow[0] = key;
+    for (size_t aggregate = 1; aggregate < plan.functions.size(); aggregate++)
+        resultantRow[aggregate] = (int) state[aggregate];
+    builder.addRow(resultantRow);
+}
+
+/**
+ * @brief Groups of a hash aggregation: the position of every key in keys,
+ * and the row count and aggregates of each group
+ */
+struct HashGroups {
+    unordered_map<int, size_t> groupOf;
+    vector<int> keys;
+    vector<long long> rowCounts, values;
+
+    /**
+     * @brief Position of the group of the key, which is added without rows
+     * if it is new
+     */
+    size_t groupOfKey(int key, const GroupByPlan &plan) {
+        auto [it, inserted] = this->groupOf.try_emplace(key, this->keys.size());
+        if (inserted) {
+            this->keys.push_back(key);
+            this->rowCounts.push_back(0);
+            plan.addGroup(this->values);
         }
-        else {
-            if (havingAggregateFunction == AVG)
-                accum /= numRowsInGroup;
-            if(returnAggregateFunction == AVG)
-                ret /= numRowsInGroup;
-            vector<int> resultantRow {prevGroup, (int) ret};
-            if (comparators[binaryOperator](accum, val)) {
-                rowsToWrite[numRowsToWrite++] = resultantRow;
-                if(numRowsToWrite == resultantTable->maxRowsPerBlock) {
-                    resultantTable->writeRows(rowsToWrite, numRowsToWrite);
-                    numRowsToWrite = 0;
-                }
+        return it->second;
+    }
+};
+
+/**
+ * @brief Aggregates all groups of the table in one scan, holding one entry
+ * per group in a hash table. The pages are scanned in morsels on all
+ * threads, each aggregating into groups of its own, which are combined at
+ * the end. The groups that pass the HAVING clause are written in the order
+ * of their keys.
+ */
+void aggregateInMemory(Table *table, const GroupByPlan &plan, TableBuilder &builder)
+{
+    LOG_TRACE("aggregateInMemory");
+    ProfileScope scope("hash aggregate");
+    long long rowsBefore = builder.rowCount();
+    const size_t aggregateCount = plan.functions.size();
+    vector<HashGroups> partialGroups(threadPool.size());
+    threadPool.runMorsels((table->blockCount + MORSEL_PAGES - 1) / MORSEL_PAGES, [&](uint worker, uint morsel) {
+        HashGroups &partial = partialGroups[worker];
+        vector<uint> groups;
+        uint firstPage = morsel * MORSEL_PAGES, lastPage = min(table->blockCount, firstPage + MORSEL_PAGES);
+        Cursor cursor(table->tableName, firstPage, TABLE);
+        for (uint pageCounter = firstPage; pageCounter < lastPage; pageCounter++) {
+            if (pageCounter != firstPage)
+                cursor.nextPage(pageCounter);
+            ColumnView keyColumn = cursor.page->getColumnView(plan.groupingColumn);
+            groups.resize(keyColumn.size());
+            for (int rowCounter = 0; rowCounter < keyColumn.size(); rowCounter++) {
+                groups[rowCounter] = partial.groupOfKey(keyColumn[rowCounter], plan);
+                partial.rowCounts[groups[rowCounter]]++;
             }
+            plan.accumulatePage(cursor.page, groups, partial.values.data());
+        }
+    });
+
+    HashGroups &groups = partialGroups[0];
+    for (size_t worker = 1; worker < partialGroups.size(); worker++) {
+        HashGroups &partial = partialGroups[worker];
+        for (size_t group = 0; group < partial.keys.size(); group++) {
+            size_t target = groups.groupOfKey(partial.keys[group], plan);
+            groups.rowCounts[target] += partial.rowCounts[group];
+            plan.combineGroup(groups.values.data() + target * aggregateCount,
+                              partial.values.data() + group * aggregateCount);
+        }
+        partial = HashGroups();
+    }
+    vector<size_t> order(groups.keys.size());
+    iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return groups.keys[a] < groups.keys[b]; });
+    vector<int> resultantRow(aggregateCount);
+    for (size_t group: order)
+        writeGroup(groups.keys[group], groups.values.data() + group * aggregateCount, groups.rowCounts[group], plan,
+                   resultantRow, builder);
+    scope.setRows(table->rowCount, builder.rowCount() - rowsBefore);
+}
 
-            prevGroup = row[groupingAttribute];
-            accum = row[havingAttribute];
-            ret = row[returnAttribute];
-            numRowsInGroup = 1;
+/**
+ * @brief Aggregates the table sorted on the grouping attribute in one scan.
+ * The rows of a group are consecutive, so only one group is held at a time;
+ * groups come out in the order of their keys. A table that already is in
+ * that order is aggregated as it is.
+ */
+void sortAggregate(Table *table, const GroupByPlan &plan, TableBuilder &builder)
+{
+    LOG_TRACE("sortAggregate");
+    Table *sortedTable = table->sortedOn(table->columns[plan.groupingColumn], ASC, "Temp_GROUPBY_" + table->tableName);
+
+    const size_t aggregateCount = plan.functions.size();
+    // The groups of the current page; the first may have started on an
+    // earlier page and the last may go on in the next one
+    vector<int> keys;
+    vector<long long> rowCounts, states;
+    vector<uint> groups;
+    vector<int> resultantRow(aggregateCount);
+    Cursor cursor = sortedTable->getCursor();
+    for (int pageCounter = 0; pageCounter < sortedTable->blockCount; pageCounter++) {
+        if (pageCounter)
+            cursor.nextPage(pageCounter);
+        ColumnView keyColumn = cursor.page->getColumnView(plan.groupingColumn);
+        groups.resize(keyColumn.size());
+        for (int rowCounter = 0; rowCounter < keyColumn.size(); rowCounter++) {
+            if (keys.empty() || keyColumn[rowCounter] != keys.back()) {
+                keys.push_back(keyColumn[rowCounter]);
+                rowCounts.push_back(0);
+                plan.addGroup(states);
+            }
+            groups[rowCounter] = keys.size() - 1;
+            rowCounts.back()++;
         }
+        plan.accumulatePage(cursor.page, groups, states.data());
+        if (keys.size() < 2)
+            continue;
+        size_t complete = keys.size() - 1;
+        for (size_t group = 0; group < complete; group++)
+            writeGroup(keys[group], states.data() + group * aggregateCount, rowCounts[group], plan, resultantRow,
+                       builder);
+        keys.erase(keys.begin(), keys.begin() + complete);
+        rowCounts.erase(rowCounts.begin(), rowCounts.begin() + complete);
+        states.erase(states.begin(), states.begin() + complete * aggregateCount);
     }
-    if (havingAggregateFunction == AVG)
-        accum /= numRowsInGroup;
-    if(returnAggregateFunction == AVG)
-        ret /= numRowsInGroup;
-    vector<int> resultantRow {prevGroup, (int) ret};
-    if (comparators[binaryOperator](accum, val)) {
-        rowsToWrite[numRowsToWrite++] = resultantRow;
+    if (!keys.empty())
+        writeGroup(keys[0], states.data(), rowCounts[0], plan, resultantRow, builder);
+    if (sortedTable != table)
+        tableCatalogue.deleteTable(sortedTable->tableName);
+}
+
+/**
+ * @brief Hash aggregation. If the groups of the table (known from its
+ * statistics) don't fit into the work frames of the grant, the table is
+ * partitioned on the grouping attribute and every partition is aggregated on
+ * its own, recursively. After a few levels a partition is aggregated in
+ * memory anyway.
+ */
+void hashAggregate(Table *table, const GroupByPlan &plan, TableBuilder &builder, uint depth, const MemoryGrant &grant)
+{
+    const size_t memoryBytes = (size_t) grant.workFrames() * BLOCK_SIZE * 1000, maxDepth = 4;
+    size_t groupCount = table->rowCount;
+    if (plan.groupingColumn < table->distinctValuesPerColumnCount.size())
+        groupCount = table->distinctValuesPerColumnCount[plan.groupingColumn];
+    size_t groupsBytes = groupCount * plan.groupBytes();
+    if (groupsBytes <= memoryBytes || depth == maxDepth)
+        return aggregateInMemory(table, plan, builder);
+    LOG_DEBUG("hashAggregate: partitioning");
+    uint partitionCount = min((size_t) grant.size() - 1, max((size_t) 2, (groupsBytes * 5 / 4 + memoryBytes - 1) / memoryBytes));
+    for (Table *partition: table->partition(plan.groupingColumn, partitionCount, depth))
+        if (partition) {
+            hashAggregate(partition, plan, builder, depth + 1, grant);
+            tableCatalogue.deleteTable(partition->tableName);
+        }
+}
+
+void executeGROUPBY() {
+    LOG_TRACE("executeGROUPBY");
+
+    Table *table = tableCatalogue.getTable(parsedQuery.groupByRelationName);
+    GroupByPlan plan;
+    plan.groupingColumn = table->getColumnIndex(parsedQuery.groupByGroupingAttribute);
+    plan.functions.push_back(parsedQuery.groupByHavingAggregateFunction);
+    plan.columns.push_back(table->getColumnIndex(parsedQuery.groupByHavingAttribute));
+    plan.binaryOperator = parsedQuery.groupByBinaryOperator;
+    plan.attributeValue = parsedQuery.groupByAttributeValue;
+    vector<string> columns{parsedQuery.groupByGroupingAttribute};
+    for (int i = 0; i < parsedQuery.groupByReturnAttributes.size(); i++) {
+        plan.functions.push_back(parsedQuery.groupByReturnAggregateFunctions[i]);
+        plan.columns.push_back(table->getColumnIndex(parsedQuery.groupByReturnAttributes[i]));
+        columns.push_back(aggregateNames[parsedQuery.groupByReturnAggregateFunctions[i]] + parsedQuery.groupByReturnAttributes[i]);
+    }
+
+    // Of a DSM table only the referenced columns are read: they are
+    // projected, without copying, into a narrow table that is aggregated
+    // instead
+    Table *narrowTable = nullptr;
+    if (table->layout == DSM) {
+        vector<int> referencedColumns{plan.groupingColumn};
+        for (int &column: plan.columns) {
+            auto it = find(referencedColumns.begin(), referencedColumns.end(), column);
+            if (it == referencedColumns.end())
+                it = referencedColumns.insert(referencedColumns.end(), column);
+            column = it - referencedColumns.begin();
+        }
+        plan.groupingColumn = 0;
+        narrowTable = new Table(tableCatalogue.temporaryName("Temp_GROUPBY_COLUMNS_" + table->tableName), table, referencedColumns);
+        tableCatalogue.insertTable(narrowTable);
+        table = narrowTable;
     }
-    if (numRowsToWrite)
-        resultantTable->writeRows(rowsToWrite, numRowsToWrite);
 
-    resultantTable->blockify();
+    auto *resultantTable = new Table(parsedQuery.groupByResultantRelationName, columns);
+    TableBuilder builder(resultantTable);
+    QueryPlan queryPlan = planGroupBy(table, plan.groupingColumn, plan.groupBytes());
+    if (queryPlan.algorithm == SORT_AGGREGATE) {
+        sortAggregate(table, plan, builder);
+        resultantTable->sortColumns = {0};
+        resultantTable->sortMultipliers = {ASC};
+    }
+    else {
+        MemoryGrant grant = memoryManager.grant(queryPlan.memoryFrames);
+        hashAggregate(table, plan, builder, 0, grant);
+    }
+    builder.finish();
     tableCatalogue.insertTable(resultantTable);
-    tableCatalogue.deleteTable(tempTableName);
+    if (narrowTable)
+        tableCatalogue.deleteTable(narrowTable->tableName);
 }
@@ -2,11 +2,16 @@
 /**
  * @brief 
  * SYNTAX: INDEX ON column_name FROM relation_name USING indexing_strategy
- * indexing_strategy: ASC | DESC | NOTHING
+ * indexing_strategy: BTREE | HASH | NOTHING
+ *
+ * BTREE builds a B+-tree over the column that SELECT uses for comparisons
+ * with an integer literal, HASH a hash index that serves == only. Equi joins
+ * with an indexed relation look up its rows through the index. NOTHING drops
+ * the index of the relation.
  */
 bool syntacticParseINDEX()
 {
-    logger.log("syntacticParseINDEX");
+    LOG_TRACE("syntacticParseINDEX");
     if (tokenizedQuery.size() != 7 || tokenizedQuery[1] != "ON" || tokenizedQuery[3] != "FROM" || tokenizedQuery[5] != "USING")
     {
         cout << "SYNTAX ERROR" << endl;
@@ -32,7 +37,7 @@ bool syntacticParseINDEX()
 
 bool semanticParseINDEX()
 {
-    logger.log("semanticParseINDEX");
+    LOG_TRACE("semanticParseINDEX");
     if (!tableCatalogue.isTable(parsedQuery.indexRelationName))
     {
         cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
@@ -44,7 +49,7 @@ bool semanticParseINDEX()
         return false;
     }
     Table* table = tableCatalogue.getTable(parsedQuery.indexRelationName);
-    if(table->indexed){
+    if(table->indexed && parsedQuery.indexingStrategy != NOTHING){
         cout << "SEMANTIC ERROR: Table already indexed" << endl;
         return false;
     }
@@ -53,6 +58,8 @@ bool semanticParseINDEX()
 
 void executeINDEX()
 {
-    logger.log("executeINDEX");
+    LOG_TRACE("executeINDEX");
+    Table* table = tableCatalogue.getTable(parsedQuery.indexRelationName);
+    table->createIndex(parsedQuery.indexColumnName, parsedQuery.indexingStrategy);
     return;
 }
\ No newline at end of file
@@ -3,11 +3,10 @@
  * @brief 
  * SYNTAX: R <- JOIN relation_name1, relation_name2 ON column_name1 bin_op column_name2
  */
-extern bool (*comparators[])(int, int);
 
 bool syntacticParseJOIN()
 {
-    logger.log("syntacticParseJOIN");
+    LOG_TRACE("syntacticParseJOIN");
     if (tokenizedQuery.size() != 9 || tokenizedQuery[5] != "ON")
     {
         cout << "SYNTAX ERROR" << endl;
@@ -43,7 +42,7 @@ bool syntacticParseJOIN()
 
 bool semanticParseJOIN()
 {
-    logger.log("semanticParseJOIN");
+    LOG_TRACE("semanticParseJOIN");
 
     if (tableCatalogue.isTable(parsedQuery.joinResultRelationName))
     {
@@ -65,26 +64,167 @@ bool semanticParseJOIN()
     return true;
 }
 
-void executeJOIN()
+/**
+ * @brief Index nested loop join for equi joins: every row of the outer
+ * relation looks its matches up through the index of the inner one, so only
+ * the inner pages holding matches are read. The result lists the rows of
+ * the first relation before those of the second either way.
+ *
+ * @param table1 first relation of the join
+ * @param table2 second relation of the join
+ * @param innerIsSecond whether table2 is the indexed (inner) relation
+ */
+void executeIndexJOIN(Table *table1, Table *table2, bool innerIsSecond)
 {
-    logger.log("executeJOIN");
-    int rowsFilled = 0;
-    vector<vector<int>> rowBuffer;
-    auto writeRowBuffer = [&] (Table* table, const vector<int>& row) {
-        rowBuffer[rowsFilled++] = row;
-        if (rowsFilled == rowBuffer.size()) {
-            table->writeRows(rowBuffer, rowsFilled);
-            rowsFilled = 0;
+    LOG_TRACE("executeIndexJOIN");
+    Table *outer = innerIsSecond ? table1 : table2, *inner = innerIsSecond ? table2 : table1;
+    int outerColumn = outer->getColumnIndex(innerIsSecond ? parsedQuery.joinFirstColumnName : parsedQuery.joinSecondColumnName);
+    auto columns = table1->columns;
+    columns.insert(columns.end(), table2->columns.begin(), table2->columns.end());
+    auto* resultantTable = new Table(parsedQuery.joinResultRelationName, columns);
+    tableCatalogue.insertTable(resultantTable);
+    TableBuilder builder(resultantTable);
+
+    Cursor outerCursor = outer->getCursor(), innerCursor = inner->getCursor();
+    vector<RowId> rowIds;
+    vector<int> result;
+    for (RowView outerRow = outerCursor.getNextView(); !outerRow.empty(); outerRow = outerCursor.getNextView()) {
+        rowIds.clear();
+        inner->index->lookup(outerRow[outerColumn], outerRow[outerColumn], rowIds);
+        std::sort(rowIds.begin(), rowIds.end());
+        for (const RowId &rowId : rowIds) {
+            if (rowId.pageIndex != innerCursor.pageIndex)
+                innerCursor.nextPage(rowId.pageIndex);
+            RowView innerRow = innerCursor.page->getRowView(rowId.slot);
+            RowView first = innerIsSecond ? outerRow : innerRow, second = innerIsSecond ? innerRow : outerRow;
+            result.assign(first.begin(), first.end());
+            result.insert(result.end(), second.begin(), second.end());
+            builder.addRow(result);
         }
-    };
+    }
+    builder.finish();
+}
+
+/**
+ * @brief Writes the concatenation of the row of the first and of the second
+ * relation to the result
+ */
+void writeJoinedRow(RowView buildRow, RowView probeRow, bool buildIsFirst, vector<int> &result, TableBuilder &builder)
+{
+    RowView first = buildIsFirst ? buildRow : probeRow, second = buildIsFirst ? probeRow : buildRow;
+    result.assign(first.begin(), first.end());
+    result.insert(result.end(), second.begin(), second.end());
+    builder.addRow(result);
+}
+
+/**
+ * @brief Loads the build relation into a hash table and streams the probe
+ * relation past it
+ */
+void inMemoryHashJOIN(Table *build, int buildColumn, Table *probe, int probeColumn, bool buildIsFirst, TableBuilder &builder)
+{
+    LOG_TRACE("inMemoryHashJOIN");
+    ProfileScope scope("hash build and probe");
+    long long rowsBefore = builder.rowCount();
+    vector<int> buildRows;
+    buildRows.reserve(build->rowCount * build->columnCount);
+    unordered_multimap<int, size_t> hashTable(build->rowCount);
+    Cursor buildCursor = build->getCursor();
+    for (RowView row = buildCursor.getNextView(); !row.empty(); row = buildCursor.getNextView()) {
+        hashTable.emplace(row[buildColumn], buildRows.size());
+        buildRows.insert(buildRows.end(), row.begin(), row.end());
+    }
+    vector<int> result;
+    Cursor probeCursor = probe->getCursor();
+    for (RowView row = probeCursor.getNextView(); !row.empty(); row = probeCursor.getNextView()) {
+        auto matches = hashTable.equal_range(row[probeColumn]);
+        for (auto it = matches.first; it != matches.second; it++)
+            writeJoinedRow(RowView{buildRows.data() + it->second, (int) build->columnCount, 1}, row, buildIsFirst, result, builder);
+    }
+    scope.setRows(build->rowCount + probe->rowCount, builder.rowCount() - rowsBefore);
+}
+
+/**
+ * @brief Hash joins build with probe. If build doesn't fit into the frames
+ * granted to the join, less an input and an output frame, both relations are
+ * partitioned (Grace hash join) and matching partitions are joined
+ * recursively, the smaller one of each pair being the build side. Partitions
+ * that keep being too large after a few levels (many copies of one key) are
+ * joined in memory anyway.
+ */
+void hashJOIN(Table *build, int buildColumn, Table *probe, int probeColumn, bool buildIsFirst, TableBuilder &builder, uint depth,
+              const MemoryGrant &grant)
+{
+    const uint memoryBlocks = grant.workFrames(), maxDepth = 4;
+    if (build->blockCount <= memoryBlocks || depth == maxDepth)
+        return inMemoryHashJOIN(build, buildColumn, probe, probeColumn, buildIsFirst, builder);
+    LOG_DEBUG("hashJOIN: partitioning");
+    uint partitionCount = min(grant.size() - 1, max(2u, (build->blockCount * 5 / 4 + memoryBlocks - 1) / memoryBlocks));
+    vector<Table*> buildPartitions = build->partition(buildColumn, partitionCount, depth);
+    vector<Table*> probePartitions = probe->partition(probeColumn, partitionCount, depth);
+    for (uint partition = 0; partition < partitionCount; partition++) {
+        Table *buildPartition = buildPartitions[partition], *probePartition = probePartitions[partition];
+        if (buildPartition && probePartition) {
+            if (buildPartition->blockCount <= probePartition->blockCount)
+                hashJOIN(buildPartition, buildColumn, probePartition, probeColumn, buildIsFirst, builder, depth + 1, grant);
+            else
+                hashJOIN(probePartition, probeColumn, buildPartition, buildColumn, !buildIsFirst, builder, depth + 1, grant);
+        }
+        if (buildPartition)
+            tableCatalogue.deleteTable(buildPartition->tableName);
+        if (probePartition)
+            tableCatalogue.deleteTable(probePartition->tableName);
+    }
+}
+
+/**
+ * @brief Equi join by hashing
+ *
+ * @param table1 first relation of the join
+ * @param table2 second relation of the join
+ * @param plan tells whether table1 is the build side and the frames to ask for
+ */
+void executeHashJOIN(Table *table1, Table *table2, const QueryPlan &plan)
+{
+    LOG_TRACE("executeHashJOIN");
+    int col1 = table1->getColumnIndex(parsedQuery.joinFirstColumnName), col2 = table2->getColumnIndex(parsedQuery.joinSecondColumnName);
+    auto columns = table1->columns;
+    columns.insert(columns.end(), table2->columns.begin(), table2->columns.end());
+    auto* resultantTable = new Table(parsedQuery.joinResultRelationName, columns);
+    tableCatalogue.insertTable(resultantTable);
+    TableBuilder builder(resultantTable);
+    MemoryGrant grant = memoryManager.grant(plan.memoryFrames);
+    if (plan.firstIsBuild)
+        hashJOIN(table1, col1, table2, col2, true, builder, 0, grant);
+    else
+        hashJOIN(table2, col2, table1, col1, false, builder, 0, grant);
+    builder.finish();
+}
+
+void executeJOIN()
+{
+    LOG_TRACE("executeJOIN");
+    if (parsedQuery.joinBinaryOperator == EQUAL) {
+        Table *table1 = tableCatalogue.getTable(parsedQuery.joinFirstRelationName);
+        Table *table2 = tableCatalogue.getTable(parsedQuery.joinSecondRelationName);
+        // The cost model picks between the index of either relation, hashing
+        // and sort-merge (below)
+        QueryPlan plan = planJoin(table1, table1->getColumnIndex(parsedQuery.joinFirstColumnName),
+                                  table2, table2->getColumnIndex(parsedQuery.joinSecondColumnName), EQUAL);
+        if (plan.algorithm == INDEX_NESTED_LOOP_JOIN)
+            return executeIndexJOIN(table1, table2, !plan.firstIsBuild);
+        if (plan.algorithm == HASH_JOIN)
+            return executeHashJOIN(table1, table2, plan);
+    }
     if (parsedQuery.joinBinaryOperator < 4) {
         // Table 1 doesn't need to be sorted, no advantage achieved
         auto* table1 = tableCatalogue.getTable(parsedQuery.joinFirstRelationName);
-        // Table 2 is sorted according to the binary operator we use
-        auto* table2 = new Table("Temp_JOIN_" + parsedQuery.joinSecondRelationName, tableCatalogue.getTable(parsedQuery.joinSecondRelationName));
-        tableCatalogue.insertTable(table2);
+        // Table 2 is sorted according to the binary operator we use, unless
+        // it already is
+        Table *relation2 = tableCatalogue.getTable(parsedQuery.joinSecondRelationName);
         SortingStrategy sortingStrategy = (parsedQuery.joinBinaryOperator % 2) ? ASC : DESC;
-        table2->sort(parsedQuery.joinSecondColumnName, sortingStrategy, parsedQuery.joinSecondRelationName);
+        Table *table2 = relation2->sortedOn(parsedQuery.joinSecondColumnName, sortingStrategy,
+                                            "Temp_JOIN_" + parsedQuery.joinSecondRelationName);
 
         // Get the corresponding concerned column indices in each of the relations
         int col1 = table1->getColumnIndex(parsedQuery.joinFirstColumnName), col2 = table2->getColumnIndex(parsedQuery.joinSecondColumnName);
@@ -93,101 +233,149 @@ void executeJOIN()
 
         auto* resultantTable = new Table(parsedQuery.joinResultRelationName, columns);
         tableCatalogue.insertTable(resultantTable);
-        rowBuffer.assign(resultantTable->maxRowsPerBlock, vector<int>(columns.size()));
-
-        auto cursor1 = table1->getCursor();
-        auto row1 = cursor1.getNext();
-
-        // Find the appropriate comparator function
-        bool (*f) (int,int) = *comparators[parsedQuery.joinBinaryOperator];
-        while (!row1.empty()) {
-            auto cursor2 = table2->getCursor();
-            vector<int> row2 = cursor2.getNext(), result;
-            while (!row2.empty() && f(row1[col1], row2[col2])) {
-                result = row1;
-                result.insert(result.end(), row2.begin(), row2.end());
-                writeRowBuffer(resultantTable, result);
-                row2 = cursor2.getNext();
+        TableBuilder builder(resultantTable);
+
+        // Block nested loop: as many pages of table 1 as the grant allows are
+        // held in memory while table 2 streams past them. The rows of table 2
+        // that match a row of table 1 are a prefix of its sort order, so the
+        // stream stops once every row of the chunk has found the end of its
+        // prefix, which is binary searched in the page it falls into. The
+        // comparison is resolved once per page of table 2.
+        MemoryGrant grant = memoryManager.grant(table1->blockCount + 2);
+        const uint chunkPages = grant.workFrames();
+        vector<int> outerRows, result;
+        vector<char> finished;
+        for (uint firstPage = 0; firstPage < table1->blockCount; firstPage += chunkPages) {
+            outerRows.clear();
+            long long outerCount = table1->readPages(firstPage, chunkPages, outerRows), active = outerCount;
+            finished.assign(outerCount, false);
+            int chunkLow = INT_MAX, chunkHigh = INT_MIN;
+            for (long long outerCounter = 0; outerCounter < outerCount; outerCounter++) {
+                chunkLow = min(chunkLow, outerRows[outerCounter * table1->columnCount + col1]);
+                chunkHigh = max(chunkHigh, outerRows[outerCounter * table1->columnCount + col1]);
+            }
+            Cursor cursor2 = table2->getCursor();
+            for (uint pageCounter = 0; pageCounter < table2->blockCount && active; pageCounter++) {
+                // A page no row of the chunk can match, going by its zone map,
+                // ends every prefix: the rest of table 2 isn't read
+                const ZoneMap *zoneMap = table2->getZoneMap(pageCounter);
+                if (zoneMap && !evaluateOnRanges(chunkLow, chunkHigh, zoneMap->minimum[col2], zoneMap->maximum[col2],
+                                                 parsedQuery.joinBinaryOperator))
+                    break;
+                if (pageCounter)
+                    cursor2.nextPage(pageCounter);
+                ColumnView keys = cursor2.page->getColumnView(col2);
+                withBinaryOperator(parsedQuery.joinBinaryOperator, [&](auto binaryOperator) {
+                    for (long long outerCounter = 0; outerCounter < outerCount; outerCounter++) {
+                        if (finished[outerCounter])
+                            continue;
+                        RowView row1{outerRows.data() + outerCounter * table1->columnCount, (int) table1->columnCount, 1};
+                        int matching = keys.size();
+                        if (!compare<binaryOperator>(row1[col1], keys[keys.size() - 1])) {
+                            int low = 0, high = keys.size() - 1;
+                            while (low < high) {
+                                int middle = (low + high) / 2;
+                                if (compare<binaryOperator>(row1[col1], keys[middle]))
+                                    low = middle + 1;
+                                else
+                                    high = middle;
+                            }
+                            matching = low;
+                            finished[outerCounter] = true;
+                            active--;
+                        }
+                        for (int rowCounter = 0; rowCounter < matching; rowCounter++) {
+                            RowView row2 = cursor2.page->getRowView(rowCounter);
+                            result.assign(row1.begin(), row1.end());
+                            result.insert(result.end(), row2.begin(), row2.end());
+                            builder.addRow(result);
+                        }
+                    }
+                });
             }
-            row1 = cursor1.getNext();
         }
-        resultantTable->writeRows(rowBuffer, rowsFilled);
-        resultantTable->blockify();
-        tableCatalogue.deleteTable(table2->tableName);
+        builder.finish();
+        // The rows of a chunk of table 1 come out again for every page of
+        // table 2, so the result has no order of its own
+        if (table2 != relation2)
+            tableCatalogue.deleteTable(table2->tableName);
     }
     else {
-        auto* table1 = new Table("Temp_JOIN_" + parsedQuery.joinFirstRelationName, tableCatalogue.getTable(parsedQuery.joinFirstRelationName));
-        auto* table2 = new Table("Temp_JOIN_" + parsedQuery.joinSecondRelationName, tableCatalogue.getTable(parsedQuery.joinSecondRelationName));
-        tableCatalogue.insertTable(table1);
-        tableCatalogue.insertTable(table2);
-        table1->sort(parsedQuery.joinFirstColumnName, ASC, parsedQuery.joinFirstRelationName);
-        table2->sort(parsedQuery.joinSecondColumnName, ASC, parsedQuery.joinSecondRelationName);
+        // Both relations are sorted, those that aren't in order yet as copies
+        Table *relation1 = tableCatalogue.getTable(parsedQuery.joinFirstRelationName);
+        Table *relation2 = tableCatalogue.getTable(parsedQuery.joinSecondRelationName);
+        Table *table1 = relation1->sortedOn(parsedQuery.joinFirstColumnName, ASC, "Temp_JOIN_" + parsedQuery.joinFirstRelationName);
+        Table *table2 = relation2->sortedOn(parsedQuery.joinSecondColumnName, ASC, "Temp_JOIN_" + parsedQuery.joinSecondRelationName);
 
         int col1 = table1->getColumnIndex(parsedQuery.joinFirstColumnName), col2 = table2->getColumnIndex(parsedQuery.joinSecondColumnName);
         auto columns = table1->columns;
         columns.insert(columns.end(), table2->columns.begin(), table2->columns.end());
         auto* resultantTable = new Table(parsedQuery.joinResultRelationName, columns);
         tableCatalogue.insertTable(resultantTable);
-        rowBuffer.assign(resultantTable->maxRowsPerBlock, vector<int>(columns.size()));
+        TableBuilder builder(resultantTable);
 
         auto cursor1 = table1->getCursor(), cursor2 = table2->getCursor();
-        auto row1 = cursor1.getNext(), row2 = cursor2.getNext();
+        auto row1 = cursor1.getNextView(), row2 = cursor2.getNextView();
         if (parsedQuery.joinBinaryOperator == EQUAL) {
             // Two pointer approach
             while (!row1.empty() && !row2.empty()) {
-                if (row1[col1] < row2[col2]) row1 = cursor1.getNext();
-                else if (row1[col1] > row2[col2]) row2 = cursor2.getNext();
+                if (row1[col1] < row2[col2]) row1 = cursor1.getNextView();
+                else if (row1[col1] > row2[col2]) row2 = cursor2.getNextView();
                 else {
                     // Different initializations of r1, r2 to avoid matching row1, row2 twice
                     auto c1 = cursor1, c2 = cursor2;
-                    auto r1 = c1.getNext(), r2 = row2;
+                    auto r1 = c1.getNextView(), r2 = row2;
                     vector<int> result;
                     while (!r2.empty() && row1[col1] == r2[col2]) {
-                        result = row1;
+                        result.assign(row1.begin(), row1.end());
                         result.insert(result.end(), r2.begin(), r2.end());
-                        writeRowBuffer(resultantTable, result);
-                        r2 = c2.getNext();
+                        builder.addRow(result);
+                        r2 = c2.getNextView();
                     }
                     while (!r1.empty() && r1[col1] == row2[col2]) {
-                        result = r1;
+                        result.assign(r1.begin(), r1.end());
                         result.insert(result.end(), row2.begin(), row2.end());
-                        writeRowBuffer(resultantTable, result);
-                        r1 = c1.getNext();
+                        builder.addRow(result);
+                        r1 = c1.getNextView();
                     }
-                    row1 = cursor1.getNext();
-                    row2 = cursor2.getNext();
+                    row1 = cursor1.getNextView();
+                    row2 = cursor2.getNextView();
                 }
             }
         }
         else {
             while (!row1.empty()) {
                 // row2 corresponds to the first row greater than row1 (may be empty)
-                if (!row2.empty() && row1[col1] >= row2[col2]) row2 = cursor2.getNext();
+                if (!row2.empty() && row1[col1] >= row2[col2]) row2 = cursor2.getNextView();
                 else {
                     auto a = table2->getCursor();
-                    vector<int> b = a.getNext(), result;
-                    auto iterate = [&] (Cursor& c, bool (*f)(int, int)) {
-                        while (!b.empty() && f(b[col2], row1[col1])) {
-                            result = row1;
+                    RowView b = a.getNextView();
+                    vector<int> result;
+                    auto iterate = [&] (Cursor& c, auto binaryOperator) {
+                        while (!b.empty() && compare<binaryOperator>(b[col2], row1[col1])) {
+                            result.assign(row1.begin(), row1.end());
                             result.insert(result.end(), b.begin(), b.end());
-                            writeRowBuffer(resultantTable, result);
-                            b = c.getNext();
+                            builder.addRow(result);
+                            b = c.getNextView();
                         }
                     };
                     // Start from the beginning of table2, keep going while row2 < row1
-                    iterate(a, *comparators[0]);
+                    iterate(a, integral_constant<BinaryOperator, LESS_THAN>());
                     b = row2;
                     // Start from position of row2, keep going till empty
                     Cursor cc2 = cursor2;
-                    iterate(cc2, *comparators[1]);
-                    row1 = cursor1.getNext();
+                    iterate(cc2, integral_constant<BinaryOperator, GREATER_THAN>());
+                    row1 = cursor1.getNextView();
                 }
             }
         }
-        resultantTable->writeRows(rowBuffer, rowsFilled);
-        resultantTable->blockify();
-        tableCatalogue.deleteTable(table2->tableName);
-        tableCatalogue.deleteTable(table1->tableName);
+        builder.finish();
+        resultantTable->sortColumns = {col1};
+        resultantTable->sortMultipliers = {ASC};
+        if (table2 != relation2)
+            tableCatalogue.deleteTable(table2->tableName);
+        if (table1 != relation1)
+            tableCatalogue.deleteTable(table1->tableName);
 
     }
     return;
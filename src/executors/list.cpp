@@ -5,7 +5,7 @@
  */
 bool syntacticParseLIST()
 {
-    logger.log("syntacticParseLIST");
+    LOG_TRACE("syntacticParseLIST");
     if (tokenizedQuery.size() != 2 || (tokenizedQuery[1] != "TABLES" && tokenizedQuery[1] != "MATRICES"))
     {
         cout << "SYNTAX ERROR" << endl;
@@ -18,12 +18,12 @@ bool syntacticParseLIST()
 
 bool semanticParseLIST()
 {
-    logger.log("semanticParseLIST");
+    LOG_TRACE("semanticParseLIST");
     return true;
 }
 
 void executeLIST()
 {
-    logger.log("executeLIST");
+    LOG_TRACE("executeLIST");
     tableCatalogue.print(parsedQuery.queryData);
 }
\ No newline at end of file
@@ -1,21 +1,41 @@
 #include "global.h"
 /**
  * @brief 
- * SYNTAX: LOAD relation_name
+ * SYNTAX: LOAD relation_name [BINARY] [NSM | PAX | DSM] [COMPRESSED]
  * SYNTAX: LOAD MATRIX matrix_name
+ *
+ * With BINARY the table is read from its binary columnar file
+ * (relation_name.col, see ColumnarFile) instead of its csv file.
  */
 bool syntacticParseLOAD()
 {
-    logger.log("syntacticParseLOAD");
-    if (tokenizedQuery.size() == 2) {
-        parsedQuery.queryType = LOAD;
-        parsedQuery.loadRelationName = tokenizedQuery[1];
-    }
-    else if (tokenizedQuery.size() == 3 && tokenizedQuery[1] == "MATRIX") {
+    LOG_TRACE("syntacticParseLOAD");
+    if (tokenizedQuery.size() == 3 && tokenizedQuery[1] == "MATRIX") {
         parsedQuery.queryType = LOAD;
         parsedQuery.loadMatrixName = tokenizedQuery[2];
+        return true;
     }
-    else {
+    if (tokenizedQuery.size() < 2 || tokenizedQuery.size() > 5) {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    parsedQuery.queryType = LOAD;
+    parsedQuery.loadRelationName = tokenizedQuery[1];
+    int tokenIndex = 2;
+    if (tokenIndex < tokenizedQuery.size() && tokenizedQuery[tokenIndex] == "BINARY") {
+        parsedQuery.loadBinary = true;
+        tokenIndex++;
+    }
+    if (tokenIndex < tokenizedQuery.size() && (tokenizedQuery[tokenIndex] == "NSM" || tokenizedQuery[tokenIndex] == "PAX"
+                                               || tokenizedQuery[tokenIndex] == "DSM")) {
+        const string &layout = tokenizedQuery[tokenIndex++];
+        parsedQuery.loadPageLayout = layout == "DSM" ? DSM : layout == "PAX" ? PAX : NSM;
+    }
+    if (tokenIndex < tokenizedQuery.size() && tokenizedQuery[tokenIndex] == "COMPRESSED") {
+        parsedQuery.loadCompressed = true;
+        tokenIndex++;
+    }
+    if (tokenIndex != tokenizedQuery.size()) {
         cout << "SYNTAX ERROR" << endl;
         return false;
     }
@@ -24,13 +44,14 @@ bool syntacticParseLOAD()
 
 bool semanticParseLOAD()
 {
-    logger.log("semanticParseLOAD");
+    LOG_TRACE("semanticParseLOAD");
     if (!parsedQuery.loadRelationName.empty()) {
         if (tableCatalogue.isTable(parsedQuery.loadRelationName)) {
             cout << "SEMANTIC ERROR: Relation already exists" << endl;
             return false;
         }
-        if (!isFileExists(parsedQuery.loadRelationName))
+        if (parsedQuery.loadBinary ? !ColumnarFile::exists(parsedQuery.loadRelationName)
+                                   : !isFileExists(parsedQuery.loadRelationName))
         {
             cout << "SEMANTIC ERROR: Data file doesn't exist" << endl;
             return false;
@@ -54,10 +75,12 @@ bool semanticParseLOAD()
 
 void executeLOAD()
 {
-    logger.log("executeLOAD");
+    LOG_TRACE("executeLOAD");
     if (!parsedQuery.loadRelationName.empty()) {
         Table *table = new Table(parsedQuery.loadRelationName);
-        if (table->load())
+        table->layout = parsedQuery.loadPageLayout;
+        table->compressed = parsedQuery.loadCompressed;
+        if (parsedQuery.loadBinary ? table->loadBinary() : table->load())
         {
             tableCatalogue.insertTable(table);
             cout << "Loaded Table. Column Count: " << table->columnCount << " Row Count: " << table->rowCount << endl;
@@ -0,0 +1,58 @@
+#include "global.h"
+/**
+ * @brief
+ * SYNTAX: R <- MULTIPLY matrix_name matrix_name
+ */
+bool syntacticParseMULTIPLY()
+{
+    LOG_TRACE("syntacticParseMULTIPLY");
+    if (tokenizedQuery.size() != 5)
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    parsedQuery.queryType = MULTIPLY;
+    parsedQuery.multiplyResultMatrixName = tokenizedQuery[0];
+    parsedQuery.multiplyFirstMatrixName = tokenizedQuery[3];
+    parsedQuery.multiplySecondMatrixName = tokenizedQuery[4];
+    return true;
+}
+
+bool semanticParseMULTIPLY()
+{
+    LOG_TRACE("semanticParseMULTIPLY");
+    //Both matrices must exist and resultant matrix shouldn't
+    if (tableCatalogue.isMatrix(parsedQuery.multiplyResultMatrixName) ||
+        tableCatalogue.isTable(parsedQuery.multiplyResultMatrixName))
+    {
+        cout << "SEMANTIC ERROR: Resultant matrix already exists" << endl;
+        return false;
+    }
+    if (!tableCatalogue.isMatrix(parsedQuery.multiplyFirstMatrixName) ||
+        !tableCatalogue.isMatrix(parsedQuery.multiplySecondMatrixName))
+    {
+        cout << "SEMANTIC ERROR: Matrix doesn't exist" << endl;
+        return false;
+    }
+    Matrix *first = tableCatalogue.getMatrix(parsedQuery.multiplyFirstMatrixName);
+    Matrix *second = tableCatalogue.getMatrix(parsedQuery.multiplySecondMatrixName);
+    if (first->dimension != second->dimension || first->m != second->m)
+    {
+        cout << "SEMANTIC ERROR: Matrix dimensions don't match" << endl;
+        return false;
+    }
+    return true;
+}
+
+void executeMULTIPLY()
+{
+    LOG_TRACE("executeMULTIPLY");
+    Matrix *first = tableCatalogue.getMatrix(parsedQuery.multiplyFirstMatrixName);
+    Matrix *second = tableCatalogue.getMatrix(parsedQuery.multiplySecondMatrixName);
+    Matrix *matrixResult = new Matrix(parsedQuery.multiplyResultMatrixName, first);
+    matrixResult->symmetric = -1;
+    matrixResult->multiply(first, second);
+    tableCatalogue.insertMatrix(matrixResult);
+    blockStats.log();
+    return;
+}
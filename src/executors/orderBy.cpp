@@ -4,16 +4,26 @@
  * @brief File contains method to process ORDER BY commands.
  *
  * syntax:
- * <new_table> <- ORDER BY <attribute> ASC|DESC ON <table_name>
+ * <new_table> <- ORDER BY <attribute> ASC|DESC ON <table_name> [LIMIT <row_count>]
  *
+ * With LIMIT only the first row_count rows of the order are kept.
  */
 bool syntacticParseORDERBY() {
-    logger.log("syntacticParseORDERBY");
+    LOG_TRACE("syntacticParseORDERBY");
     auto numTokens = tokenizedQuery.size();
-    if (tokenizedQuery[3] != "BY" || tokenizedQuery[6] != "ON" || numTokens != 8 || (tokenizedQuery[5] != "ASC" && tokenizedQuery[5] != "DESC")) {
+    if ((numTokens != 8 && numTokens != 10) || tokenizedQuery[3] != "BY" || tokenizedQuery[6] != "ON" || (tokenizedQuery[5] != "ASC" && tokenizedQuery[5] != "DESC")) {
         cout << "SYNTAX ERROR" << endl;
         return false;
     }
+    if (numTokens == 10) {
+        const string &limit = tokenizedQuery[9];
+        size_t digits = limit.size() - min(limit.find_first_not_of('0'), limit.size());
+        if (tokenizedQuery[8] != "LIMIT" || !isIntegerLiteral(limit) || limit[0] == '-' || !digits || digits > 18) {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+        parsedQuery.orderByLimit = stoll(tokenizedQuery[9]);
+    }
     parsedQuery.queryType = ORDERBY;
     parsedQuery.orderByRelationName = tokenizedQuery[7];
     parsedQuery.orderByResultantRelationName = tokenizedQuery[0];
@@ -24,7 +34,7 @@ bool syntacticParseORDERBY() {
 }
 
 bool semanticParseORDERBY() {
-    logger.log("semanticParseORDERBY");
+    LOG_TRACE("semanticParseORDERBY");
 
     if (!tableCatalogue.isTable(parsedQuery.orderByRelationName)) {
         cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
@@ -42,11 +52,93 @@ bool semanticParseORDERBY() {
     return true;
 }
 
+/**
+ * @brief Writes the first limit rows of the table in the order of the column
+ * after a single scan. The rows that are first so far are kept in a heap
+ * whose top is the last of them, which every row that comes before it
+ * replaces. Equal values keep the order of the table, as in the sort.
+ */
+void topKORDERBY(Table *table, int column, int multiplier, long long limit, TableBuilder &builder)
+{
+    LOG_TRACE("topKORDERBY");
+    struct HeapEntry {
+        int key;
+        long long position;
+        size_t slot;
+    };
+    auto before = [multiplier](const HeapEntry &A, const HeapEntry &B) {
+        if (A.key != B.key)
+            return (multiplier < 0) != (A.key < B.key);
+        return A.position < B.position;
+    };
+    const uint columnCount = table->columnCount;
+    vector<HeapEntry> heap;
+    vector<int> rows;
+    long long position = 0;
+    Cursor cursor = table->getCursor();
+    for (RowView row = cursor.getNextView(); !row.empty(); row = cursor.getNextView(), position++) {
+        HeapEntry entry{row[column], position, heap.size()};
+        if (heap.size() == limit) {
+            if (!before(entry, heap.front()))
+                continue;
+            pop_heap(heap.begin(), heap.end(), before);
+            entry.slot = heap.back().slot;
+            heap.pop_back();
+            copy(row.begin(), row.end(), rows.begin() + entry.slot * columnCount);
+        }
+        else
+            rows.insert(rows.end(), row.begin(), row.end());
+        heap.push_back(entry);
+        push_heap(heap.begin(), heap.end(), before);
+    }
+    sort_heap(heap.begin(), heap.end(), before);
+    for (const HeapEntry &entry: heap)
+        builder.addRow(RowView{rows.data() + entry.slot * columnCount, (int) columnCount, 1});
+}
+
+/**
+ * @brief Sorts a copy of the relation. With a LIMIT whose rows fit into
+ * memory the first rows are found in one scan instead (see topKORDERBY);
+ * larger limits sort a temporary copy and keep its first rows. A relation
+ * that already is in the order is copied as it is, up to the limit.
+ */
 void executeORDERBY() {
-    logger.log("executeORDERBY");
+    LOG_TRACE("executeORDERBY");
 
     Table *table = tableCatalogue.getTable(parsedQuery.orderByRelationName);
-    auto *resultantTable = new Table(parsedQuery.orderByResultantRelationName, table);
-    resultantTable->sort(parsedQuery.orderByColumnName, parsedQuery.orderByMultiplier, parsedQuery.orderByRelationName);
+    int column = table->getColumnIndex(parsedQuery.orderByColumnName);
+    long long limit = parsedQuery.orderByLimit;
+    QueryPlan plan = planOrderBy(table, column, parsedQuery.orderByMultiplier, limit);
+    if (limit < 0 && plan.algorithm != TABLE_SCAN) {
+        auto *resultantTable = new Table(parsedQuery.orderByResultantRelationName, table);
+        tableCatalogue.insertTable(resultantTable);
+        resultantTable->sort(parsedQuery.orderByColumnName, parsedQuery.orderByMultiplier, parsedQuery.orderByRelationName);
+        return;
+    }
+
+    auto *resultantTable = new Table(parsedQuery.orderByResultantRelationName, table->columns);
+    resultantTable->layout = table->layout;
+    resultantTable->compressed = table->compressed;
+    // Any subset of the rows compresses at least as well as the whole table
+    if (table->compressed || table->layout == DSM)
+        resultantTable->maxRowsPerBlock = table->maxRowsPerBlock;
+    TableBuilder builder(resultantTable);
+    if (plan.algorithm == TOP_K_HEAP) {
+        MemoryGrant grant = memoryManager.grant(plan.memoryFrames);
+        topKORDERBY(table, column, parsedQuery.orderByMultiplier, limit, builder);
+    }
+    else {
+        Table *sortedTable = table->sortedOn(parsedQuery.orderByColumnName, parsedQuery.orderByMultiplier,
+                                             "Temp_ORDERBY_" + parsedQuery.orderByResultantRelationName);
+        Cursor cursor = sortedTable->getCursor();
+        RowView row = cursor.getNextView();
+        for (long long rowCounter = 0; (limit < 0 || rowCounter < limit) && !row.empty(); rowCounter++, row = cursor.getNextView())
+            builder.addRow(row);
+        if (sortedTable != table)
+            tableCatalogue.deleteTable(sortedTable->tableName);
+    }
+    builder.finish();
+    resultantTable->sortColumns = {column};
+    resultantTable->sortMultipliers = {parsedQuery.orderByMultiplier};
     tableCatalogue.insertTable(resultantTable);
 }
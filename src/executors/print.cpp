@@ -6,7 +6,7 @@
  */
 bool syntacticParsePRINT()
 {
-    logger.log("syntacticParsePRINT");
+    LOG_TRACE("syntacticParsePRINT");
     if (tokenizedQuery.size() == 2) {
         parsedQuery.queryType = PRINT;
         parsedQuery.printRelationName = tokenizedQuery[1];
@@ -24,7 +24,7 @@ bool syntacticParsePRINT()
 
 bool semanticParsePRINT()
 {
-    logger.log("semanticParsePRINT");
+    LOG_TRACE("semanticParsePRINT");
     if (!parsedQuery.printRelationName.empty()) {
         if (!tableCatalogue.isTable(parsedQuery.printRelationName))
         {
@@ -44,7 +44,7 @@ bool semanticParsePRINT()
 
 void executePRINT()
 {
-    logger.log("executePRINT");
+    LOG_TRACE("executePRINT");
     if (!parsedQuery.printRelationName.empty()) {
         Table* table = tableCatalogue.getTable(parsedQuery.printRelationName);
         table->print();
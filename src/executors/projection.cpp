@@ -5,7 +5,7 @@
  */
 bool syntacticParsePROJECTION()
 {
-    logger.log("syntacticParsePROJECTION");
+    LOG_TRACE("syntacticParsePROJECTION");
     if (tokenizedQuery.size() < 5 || *(tokenizedQuery.end() - 2) != "FROM")
     {
         cout << "SYNTAX ERROR" << endl;
@@ -21,7 +21,7 @@ bool syntacticParsePROJECTION()
 
 bool semanticParsePROJECTION()
 {
-    logger.log("semanticParsePROJECTION");
+    LOG_TRACE("semanticParsePROJECTION");
 
     if (tableCatalogue.isTable(parsedQuery.projectionResultRelationName))
     {
@@ -49,29 +49,48 @@ bool semanticParsePROJECTION()
 
 void executePROJECTION()
 {
-    logger.log("executePROJECTION");
+    LOG_TRACE("executePROJECTION");
+    Table *sourceTable = tableCatalogue.getTable(parsedQuery.projectionRelationName);
+    if (sourceTable->layout == DSM)
+    {
+        // The result borrows the column chains of the projected columns, so
+        // no page is read or written
+        Table *resultantTable = new Table(parsedQuery.projectionResultRelationName, sourceTable,
+                                          sourceTable->getColumnIndex(parsedQuery.projectionColumnList));
+        tableCatalogue.insertTable(resultantTable);
+        return;
+    }
     Table* resultantTable = new Table(parsedQuery.projectionResultRelationName, parsedQuery.projectionColumnList);
-    Table table = *tableCatalogue.getTable(parsedQuery.projectionRelationName);
-    Cursor cursor = table.getCursor();
+    Table table = *sourceTable;
     vector<int> columnIndices;
     for (int columnCounter = 0; columnCounter < parsedQuery.projectionColumnList.size(); columnCounter++)
     {
         columnIndices.emplace_back(table.getColumnIndex(parsedQuery.projectionColumnList[columnCounter]));
     }
-    vector<int> row = cursor.getNext();
-    vector<int> resultantRow(columnIndices.size(), 0);
+    TableBuilder builder(resultantTable);
 
-    while (!row.empty())
+    // The pages are projected in morsels on all threads, a column at a time
+    builder.addMorsels((table.blockCount + MORSEL_PAGES - 1) / MORSEL_PAGES, [&](uint morsel, vector<int> &values)
     {
-
-        for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+        uint firstPage = morsel * MORSEL_PAGES, lastPage = min(table.blockCount, firstPage + MORSEL_PAGES);
+        Cursor cursor(table.tableName, firstPage, TABLE);
+        for (uint pageCounter = firstPage; pageCounter < lastPage; pageCounter++)
         {
-            resultantRow[columnCounter] = row[columnIndices[columnCounter]];
+            if (pageCounter != firstPage)
+                cursor.nextPage(pageCounter);
+            size_t firstValue = values.size(), rowCount = cursor.page->getRowCount();
+            values.resize(firstValue + rowCount * columnIndices.size());
+            for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+            {
+                ColumnView column = cursor.page->getColumnView(columnIndices[columnCounter]);
+                int *target = values.data() + firstValue + columnCounter;
+                for (size_t rowCounter = 0; rowCounter < rowCount; rowCounter++)
+                    target[rowCounter * columnIndices.size()] = column[rowCounter];
+            }
         }
-        resultantTable->writeRow<int>(resultantRow);
-        row = cursor.getNext();
-    }
-    resultantTable->blockify();
+    });
+    builder.finish();
+    resultantTable->inheritSortOrder(&table, columnIndices);
     tableCatalogue.insertTable(resultantTable);
     return;
 }
\ No newline at end of file
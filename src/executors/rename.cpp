@@ -6,7 +6,7 @@
  */
 bool syntacticParseRENAME()
 {
-    logger.log("syntacticParseRENAME");
+    LOG_TRACE("syntacticParseRENAME");
     if (tokenizedQuery.size() == 4 && tokenizedQuery[1] == "MATRIX") {
         parsedQuery.queryType = RENAME;
         parsedQuery.renameFromMatrixName = tokenizedQuery[2];
@@ -28,7 +28,7 @@ bool syntacticParseRENAME()
 
 bool semanticParseRENAME()
 {
-    logger.log("semanticParseRENAME");
+    LOG_TRACE("semanticParseRENAME");
     if (!parsedQuery.renameRelationName.empty()) {
         if (!tableCatalogue.isTable(parsedQuery.renameRelationName))
         {
@@ -66,7 +66,7 @@ bool semanticParseRENAME()
 
 void executeRENAME()
 {
-    logger.log("executeRENAME");
+    LOG_TRACE("executeRENAME");
     if (!parsedQuery.renameRelationName.empty()) {
         Table* table = tableCatalogue.getTable(parsedQuery.renameRelationName);
         table->renameColumn(parsedQuery.renameFromColumnName, parsedQuery.renameToColumnName);
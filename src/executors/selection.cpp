@@ -5,7 +5,7 @@
  */
 bool syntacticParseSELECTION()
 {
-    logger.log("syntacticParseSELECTION");
+    LOG_TRACE("syntacticParseSELECTION");
     if (tokenizedQuery.size() != 8 || tokenizedQuery[6] != "FROM")
     {
         cout << "SYNTAC ERROR" << endl;
@@ -34,9 +34,8 @@ bool syntacticParseSELECTION()
         cout << "SYNTAC ERROR" << endl;
         return false;
     }
-    regex numeric("[-]?[0-9]+");
     string secondArgument = tokenizedQuery[5];
-    if (regex_match(secondArgument, numeric))
+    if (isIntegerLiteral(secondArgument))
     {
         parsedQuery.selectType = INT_LITERAL;
         parsedQuery.selectionIntLiteral = stoi(secondArgument);
@@ -51,7 +50,7 @@ bool syntacticParseSELECTION()
 
 bool semanticParseSELECTION()
 {
-    logger.log("semanticParseSELECTION");
+    LOG_TRACE("semanticParseSELECTION");
 
     if (tableCatalogue.isTable(parsedQuery.selectionResultRelationName))
     {
@@ -83,57 +82,229 @@ bool semanticParseSELECTION()
 }
 
 bool evaluateBinOp(int value1, int value2, BinaryOperator binaryOperator)
+{
+    if (binaryOperator == NO_BINOP_CLAUSE)
+        return false;
+    return withBinaryOperator(binaryOperator, [&](auto binaryOperator) {
+        return compare<binaryOperator>(value1, value2);
+    });
+}
+
+/**
+ * @brief Decides "column bin_op literal" for a whole page from the encoding
+ * of the column, without looking at the rows. The encoding bounds the values
+ * of the page: FOR codes cover [base, base + 2^bitWidth - 1], a delta encoded
+ * column is sorted and a dictionary lists every value.
+ *
+ * @return 1 if every row of the page matches, 0 if none does, -1 if the rows
+ * have to be evaluated
+ */
+int evaluateOnEncoding(const ColumnEncoding *encoding, ColumnView column, int literal, BinaryOperator binaryOperator)
+{
+    if (encoding == nullptr || column.empty())
+        return -1;
+    long long lowest, highest;
+    switch (encoding->type)
+    {
+    case FOR_ENCODING:
+        lowest = encoding->base;
+        highest = min((long long) INT_MAX, lowest + (1LL << encoding->bitWidth) - 1);
+        break;
+    case DELTA_ENCODING:
+        lowest = encoding->base;
+        highest = column[column.size() - 1];
+        break;
+    case DICTIONARY_ENCODING:
+        lowest = encoding->dictionary.front();
+        highest = encoding->dictionary.back();
+        if (binaryOperator == EQUAL || binaryOperator == NOT_EQUAL)
+        {
+            bool present = binary_search(encoding->dictionary.begin(), encoding->dictionary.end(), literal);
+            if (!present || encoding->dictionary.size() == 1)
+                return (present == (binaryOperator == EQUAL));
+            return -1;
+        }
+        break;
+    default:
+        return -1;
+    }
+    return evaluateOnRanges(lowest, highest, literal, literal, binaryOperator);
+}
+
+/**
+ * @brief Decides "value1 bin_op value2" for all values1 in [low1, high1] and
+ * values2 in [low2, high2] at once, as far as the ranges allow. A literal is
+ * the range holding just itself.
+ *
+ * @return 1 if every pair matches, 0 if none does, -1 if it depends on the
+ * values
+ */
+int evaluateOnRanges(long long low1, long long high1, long long low2, long long high2, BinaryOperator binaryOperator)
 {
     switch (binaryOperator)
     {
     case LESS_THAN:
-        return (value1 < value2);
+        return high1 < low2 ? 1 : low1 >= high2 ? 0 : -1;
     case GREATER_THAN:
-        return (value1 > value2);
+        return low1 > high2 ? 1 : high1 <= low2 ? 0 : -1;
     case LEQ:
-        return (value1 <= value2);
+        return high1 <= low2 ? 1 : low1 > high2 ? 0 : -1;
     case GEQ:
-        return (value1 >= value2);
+        return low1 >= high2 ? 1 : high1 < low2 ? 0 : -1;
     case EQUAL:
-        return (value1 == value2);
     case NOT_EQUAL:
-        return (value1 != value2);
+        if (high1 < low2 || high2 < low1)
+            return binaryOperator == NOT_EQUAL;
+        if (low1 == high1 && low2 == high2)
+            return binaryOperator == EQUAL;
+        return -1;
     default:
-        return false;
+        return -1;
     }
 }
 
+/**
+ * @brief Decides the predicate of a SELECTION query for a whole page of the
+ * table from the page's zone map
+ *
+ * @return 1 if every row of the page matches, 0 if none does, -1 if the rows
+ * have to be evaluated (or the page has no zone map)
+ */
+int evaluateOnZoneMap(const Table &table, uint pageIndex, const ParsedQuery &query)
+{
+    const ZoneMap *zoneMap = table.getZoneMap(pageIndex);
+    if (zoneMap == nullptr)
+        return -1;
+    int firstColumnIndex = table.colNameToIdx.at(query.selectionFirstColumnName);
+    long long low2 = query.selectionIntLiteral, high2 = query.selectionIntLiteral;
+    if (query.selectType == COLUMN)
+    {
+        int secondColumnIndex = table.colNameToIdx.at(query.selectionSecondColumnName);
+        low2 = zoneMap->minimum[secondColumnIndex], high2 = zoneMap->maximum[secondColumnIndex];
+    }
+    return evaluateOnRanges(zoneMap->minimum[firstColumnIndex], zoneMap->maximum[firstColumnIndex], low2, high2,
+                            query.selectionBinaryOperator);
+}
+
 void executeSELECTION()
 {
-    logger.log("executeSELECTION");
+    LOG_TRACE("executeSELECTION");
 
     Table table = *tableCatalogue.getTable(parsedQuery.selectionRelationName);
     Table* resultantTable = new Table(parsedQuery.selectionResultRelationName, table.columns);
-    Cursor cursor = table.getCursor();
-    vector<int> row = cursor.getNext();
+    resultantTable->layout = table.layout;
+    resultantTable->compressed = table.compressed;
+    // Any subset of the rows compresses at least as well as the whole table,
+    // so the source's page capacity holds for the result too (as it does
+    // for column chains)
+    if (table.compressed || table.layout == DSM)
+        resultantTable->maxRowsPerBlock = table.maxRowsPerBlock;
+    TableBuilder builder(resultantTable);
     int firstColumnIndex = table.getColumnIndex(parsedQuery.selectionFirstColumnName);
-    int secondColumnIndex;
+    int secondColumnIndex = firstColumnIndex;
     if (parsedQuery.selectType == COLUMN)
         secondColumnIndex = table.getColumnIndex(parsedQuery.selectionSecondColumnName);
-    while (!row.empty())
+    // The index is used when the cost model expects it to read fewer blocks
+    // than a scan
+    if (planSelection(&table, parsedQuery).algorithm == INDEX_SCAN)
     {
-
-        int value1 = row[firstColumnIndex];
-        int value2;
-        if (parsedQuery.selectType == INT_LITERAL)
-            value2 = parsedQuery.selectionIntLiteral;
-        else
-            value2 = row[secondColumnIndex];
-        if (evaluateBinOp(value1, value2, parsedQuery.selectionBinaryOperator))
-            resultantTable->writeRow<int>(row);
-        row = cursor.getNext();
+        // The matching rows are fetched in table order, so every page they
+        // are in is read once and the result is the same as a scan's
+        int low, high;
+        literalRange(parsedQuery.selectionIntLiteral, parsedQuery.selectionBinaryOperator, low, high);
+        vector<RowId> rowIds;
+        table.index->lookup(low, high, rowIds);
+        std::sort(rowIds.begin(), rowIds.end());
+        Cursor cursor = table.getCursor();
+        for (const RowId &rowId : rowIds)
+        {
+            if (rowId.pageIndex != cursor.pageIndex)
+                cursor.nextPage(rowId.pageIndex);
+            builder.addRow(cursor.page->getRowView(rowId.slot));
+        }
+    }
+    else
+    {
+        // The predicate is evaluated a page at a time over the compared columns
+        // only, which are contiguous in PAX pages, into a selection vector;
+        // rows are touched on a match. Pages whose zone maps rule the
+        // predicate out are not read at all, and for compressed pages the
+        // encoding alone often settles it. Of a DSM table only the compared
+        // columns are read at first, the others just for pages with matches.
+        // The pages are scanned in morsels on all threads, parsedQuery
+        // being read on this thread only.
+        const ParsedQuery &query = parsedQuery;
+        vector<int> predicateColumns{firstColumnIndex}, otherColumns;
+        if (secondColumnIndex != firstColumnIndex)
+            predicateColumns.push_back(secondColumnIndex);
+        for (int columnCounter = 0; columnCounter < table.columnCount; columnCounter++)
+            if (columnCounter != firstColumnIndex && columnCounter != secondColumnIndex)
+                otherColumns.push_back(columnCounter);
+        builder.addMorsels((table.blockCount + MORSEL_PAGES - 1) / MORSEL_PAGES, [&](uint morsel, vector<int> &values) {
+            vector<uint> selection(table.maxRowsPerBlock);
+            Cursor cursor;
+            Page columnPage;
+            auto addRow = [&values](RowView row) { values.insert(values.end(), row.begin(), row.end()); };
+            uint firstPage = morsel * MORSEL_PAGES, lastPage = min(table.blockCount, firstPage + MORSEL_PAGES);
+            for (uint pageCounter = firstPage; pageCounter < lastPage; pageCounter++)
+            {
+                int pageOutcome = evaluateOnZoneMap(table, pageCounter, query);
+                if (pageOutcome == 0)
+                    continue;
+                Page *page = &columnPage;
+                if (table.layout == DSM)
+                {
+                    columnPage = Page(table.tableName, pageCounter, TABLE, true);
+                    columnPage.readColumns(predicateColumns);
+                }
+                else
+                {
+                    if (!cursor.page)
+                        cursor = Cursor(table.tableName, pageCounter, TABLE);
+                    else if (pageCounter != cursor.pageIndex)
+                        cursor.nextPage(pageCounter);
+                    page = cursor.page;
+                }
+                ColumnView firstColumn = page->getColumnView(firstColumnIndex);
+                ColumnView secondColumn = page->getColumnView(secondColumnIndex);
+                if (pageOutcome == -1 && query.selectType == INT_LITERAL)
+                    pageOutcome = evaluateOnEncoding(page->getColumnEncoding(firstColumnIndex), firstColumn,
+                                                     query.selectionIntLiteral, query.selectionBinaryOperator);
+                if (pageOutcome == 0)
+                    continue;
+                if (pageOutcome == 1)
+                {
+                    if (table.layout == DSM)
+                        columnPage.readColumns(otherColumns);
+                    for (int rowCounter = 0; rowCounter < firstColumn.size(); rowCounter++)
+                        addRow(page->getRowView(rowCounter));
+                    continue;
+                }
+                selection.resize(max(selection.size(), (size_t) firstColumn.size()));
+                uint selected;
+                if (query.selectType == INT_LITERAL)
+                    selected = selectRows(firstColumn, query.selectionIntLiteral, query.selectionBinaryOperator,
+                                          selection.data());
+                else
+                    selected = selectRows(firstColumn, secondColumn, query.selectionBinaryOperator, selection.data());
+                if (selected && table.layout == DSM)
+                    columnPage.readColumns(otherColumns);
+                for (uint match = 0; match < selected; match++)
+                    addRow(page->getRowView(selection[match]));
+            }
+        });
     }
-    if(resultantTable->blockify())
+    if(builder.finish())
+    {
+        // Both the scan and the index lookups keep the rows in table order
+        resultantTable->sortColumns = table.sortColumns;
+        resultantTable->sortMultipliers = table.sortMultipliers;
         tableCatalogue.insertTable(resultantTable);
+    }
     else{
         cout<<"Empty Table"<<endl;
         resultantTable->unload();
         delete resultantTable;
     }
     return;
-}
\ No newline at end of file
+}
@@ -0,0 +1,119 @@
+#include "global.h"
+/**
+ * @brief
+ * SYNTAX: SET BUFFER_BLOCKS block_count
+ * SYNTAX: SET BLOCK_SIZE kilobytes
+ * SYNTAX: SET RESULT_CACHE_BLOCKS block_count
+ *
+ * BUFFER_BLOCKS is the number of frames of the buffer pool (BLOCK_COUNT),
+ * at least MIN_GRANT_FRAMES. Lowering it ejects pages until the pool fits.
+ * BLOCK_SIZE can only be changed while no table or matrix is loaded, since
+ * the pages on disk are laid out for the block size they were written with.
+ * RESULT_CACHE_BLOCKS bounds the results kept for reuse (see ResultCache);
+ * lowering it deletes kept results until they fit, 0 keeps none.
+ */
+bool syntacticParseSET()
+{
+    LOG_TRACE("syntacticParseSET");
+    if (tokenizedQuery.size() != 3 || (tokenizedQuery[1] != "BUFFER_BLOCKS" && tokenizedQuery[1] != "BLOCK_SIZE" &&
+                                       tokenizedQuery[1] != "RESULT_CACHE_BLOCKS"))
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    // A block count has up to 9 digits, BLOCK_SIZE up to 6 and an optional
+    // decimal part
+    bool isBlockSize = tokenizedQuery[1] == "BLOCK_SIZE";
+    const string &value = tokenizedQuery[2];
+    size_t point = isBlockSize ? value.find('.') : string::npos;
+    string integerPart = value.substr(0, point);
+    bool isNumber = isIntegerLiteral(integerPart) && integerPart[0] != '-' && integerPart.size() <= (isBlockSize ? 6 : 9);
+    if (isNumber && point != string::npos)
+        isNumber = isIntegerLiteral(value.substr(point + 1)) && value[point + 1] != '-';
+    if (!isNumber)
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    parsedQuery.queryType = SET;
+    parsedQuery.setVariableName = tokenizedQuery[1];
+    parsedQuery.setValue = stod(tokenizedQuery[2]);
+    return true;
+}
+
+bool semanticParseSET()
+{
+    LOG_TRACE("semanticParseSET");
+    if (parsedQuery.setVariableName == "BUFFER_BLOCKS" && parsedQuery.setValue < MIN_GRANT_FRAMES)
+    {
+        cout << "SEMANTIC ERROR: BUFFER_BLOCKS must be at least " << MIN_GRANT_FRAMES << endl;
+        return false;
+    }
+    if (parsedQuery.setVariableName == "BLOCK_SIZE")
+    {
+        if (parsedQuery.setValue < 0.1)
+        {
+            cout << "SEMANTIC ERROR: BLOCK_SIZE must be at least 0.1" << endl;
+            return false;
+        }
+        if (!tableCatalogue.isEmpty())
+        {
+            cout << "SEMANTIC ERROR: BLOCK_SIZE can only be set while no relation is loaded" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void executeSET()
+{
+    LOG_TRACE("executeSET");
+    if (parsedQuery.setVariableName == "BUFFER_BLOCKS")
+    {
+        BLOCK_COUNT = (uint) parsedQuery.setValue;
+        bufferManager.shrink();
+    }
+    else if (parsedQuery.setVariableName == "RESULT_CACHE_BLOCKS")
+    {
+        RESULT_CACHE_BLOCKS = (uint) parsedQuery.setValue;
+        resultCache.shrink();
+    }
+    else
+        BLOCK_SIZE = (float) parsedQuery.setValue;
+    LOG_INFO("SET " + parsedQuery.setVariableName + " " + tokenizedQuery[2]);
+    return;
+}
+
+/**
+ * @brief Applies the settings of a configuration file: one SET statement per
+ * line, without the SET, e.g. "BUFFER_BLOCKS 65536". Empty lines and lines
+ * starting with # are skipped. A setting that does not parse is reported and
+ * the rest are still applied.
+ *
+ * @param fileName
+ * @return false if the file can't be read
+ */
+bool applyConfig(const string &fileName)
+{
+    LOG_TRACE("applyConfig");
+    ifstream fin(fileName);
+    if (!fin)
+        return false;
+    string line;
+    for (int lineNumber = 1; getline(fin, line); lineNumber++)
+    {
+        tokenizedQuery = tokenize("SET " + line);
+        if (tokenizedQuery.size() == 1 || tokenizedQuery[1][0] == '#')
+            continue;
+        parsedQuery.clear();
+        cout << fileName << ":" << lineNumber << ": ";
+        if (syntacticParseSET() && semanticParseSET())
+        {
+            executeSET();
+            cout << line << endl;
+        }
+    }
+    tokenizedQuery.clear();
+    parsedQuery.clear();
+    return true;
+}
@@ -8,7 +8,7 @@
  *
  */
 bool syntacticParseSORT() {
-    logger.log("syntacticParseSORT");
+    LOG_TRACE("syntacticParseSORT");
     auto numTokens = tokenizedQuery.size(), numSortColumns = (numTokens - 4) / 2;
     auto IN_idx = numSortColumns + 3;
     if (numTokens < 6 || tokenizedQuery[2] != "BY" || (numTokens - 4) % 2 || tokenizedQuery[IN_idx] != "IN") {
@@ -30,7 +30,7 @@ bool syntacticParseSORT() {
 }
 
 bool semanticParseSORT() {
-    logger.log("semanticParseSORT");
+    LOG_TRACE("semanticParseSORT");
 
     if (!tableCatalogue.isTable(parsedQuery.sortRelationName)) {
         cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
@@ -48,7 +48,7 @@ bool semanticParseSORT() {
 }
 
 void executeSORT() {
-    logger.log("executeSORT");
+    LOG_TRACE("executeSORT");
 
     Table *table = tableCatalogue.getTable(parsedQuery.sortRelationName);
     vector<int> colMultipliers(parsedQuery.sortingStrategies.size());
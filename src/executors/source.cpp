@@ -5,7 +5,7 @@
  */
 bool syntacticParseSOURCE()
 {
-    logger.log("syntacticParseSOURCE");
+    LOG_TRACE("syntacticParseSOURCE");
     if (tokenizedQuery.size() != 2)
     {
         cout << "SYNTAX ERROR" << endl;
@@ -18,7 +18,7 @@ bool syntacticParseSOURCE()
 
 bool semanticParseSOURCE()
 {
-    logger.log("semanticParseSOURCE");
+    LOG_TRACE("semanticParseSOURCE");
     if (!isQueryFile(parsedQuery.sourceFileName))
     {
         cout << "SEMANTIC ERROR: File doesn't exist" << endl;
@@ -27,36 +27,118 @@ bool semanticParseSOURCE()
     return true;
 }
 
-void doCommand_()
+/**
+ * @brief Tells whether the result of the statement at position index of a
+ * script can be streamed into the next statement instead of being
+ * materialized. The next statement has to be a SELECT or PROJECT reading
+ * only that relation, and afterwards the relation may only be referred to
+ * by a CLEAR, which has to come before the script ends.
+ *
+ * @param statements tokens of every line of the script
+ * @param index
+ * @param relationName result of the statement at position index
+ */
+bool isStreamable(const vector<vector<string>> &statements, int index, const string &relationName)
 {
-    logger.log("doCommand_");
-    if (syntacticParse() && semanticParse())
-        executeCommand();
-    return;
+    LOG_TRACE("isStreamable");
+    int next = index + 1;
+    while (next < statements.size() && statements[next].empty())
+        next++;
+    if (next == statements.size())
+        return false;
+    const vector<string> &consumer = statements[next];
+    bool reads = consumer.size() >= 5 && consumer[1] == "<-" && consumer.back() == relationName
+                 && ((consumer[2] == "SELECT" && consumer.size() == 8) || consumer[2] == "PROJECT");
+    if (!reads || count(consumer.begin(), consumer.end(), relationName) != 1)
+        return false;
+    for (int later = next + 1; later < statements.size(); later++)
+    {
+        const vector<string> &statement = statements[later];
+        if (statement.empty())
+            continue;
+        if (statement.size() == 2 && statement[0] == "CLEAR" && statement[1] == relationName)
+            return true;
+        if (statement[0] == "QUIT" || statement[0] == "SOURCE"
+            || count(statement.begin(), statement.end(), relationName))
+            return false;
+    }
+    return false;
+}
+
+/**
+ * @brief Runs the pipeline over the table and the SELECTION and PROJECTION
+ * stages, materializing only its final result. The result gets the page
+ * layout it would have had if the stages had been run one by one.
+ */
+void executePipeline(Table *table, const vector<ParsedQuery> &stages, const string &resultantRelationName)
+{
+    LOG_TRACE("executePipeline");
+    Operator *root = buildPipeline(table, stages);
+    auto *resultantTable = new Table(resultantRelationName, root->columns);
+    bool projected = any_of(stages.begin(), stages.end(), [](const ParsedQuery &stage) {
+        return stage.queryType == PROJECTION;
+    });
+    bool selection = stages.back().queryType == SELECTION;
+    if (selection)
+    {
+        resultantTable->layout = projected ? NSM : table->layout;
+        resultantTable->compressed = !projected && table->compressed;
+        if (resultantTable->compressed || resultantTable->layout == DSM)
+            resultantTable->maxRowsPerBlock = table->maxRowsPerBlock;
+    }
+    TableBuilder builder(resultantTable);
+    materialize(root, builder);
+    delete root;
+    if (builder.finish() || !selection)
+        tableCatalogue.insertTable(resultantTable);
+    else
+    {
+        cout << "Empty Table" << endl;
+        resultantTable->unload();
+        delete resultantTable;
+    }
 }
 
+/**
+ * @brief Runs the statements of a script one after the other. Chains of
+ * SELECT and PROJECT statements whose intermediate results are read once,
+ * by the next statement, and are then cleared (see isStreamable) are fused
+ * into a pipeline: an intermediate is only registered with its columns, so
+ * that the next statement can be checked, and its rows stream between the
+ * operators without ever being written to pages. The CLEAR of a streamed
+ * intermediate only forgets it.
+ */
 void executeSOURCE()
 {
-    logger.log("executeSOURCE");
-    regex delim("[^\\s,]+");
+    LOG_TRACE("executeSOURCE");
     string command;
     string sourceFileName = "../data/" + parsedQuery.sourceFileName + ".ra";
     fstream fin(sourceFileName, ios::in);
 
-    while(!fin.eof())
-    {        
+    vector<string> commands;
+    vector<vector<string>> statements;
+    while (getline(fin, command))
+    {
+        commands.push_back(command);
+        statements.push_back(tokenize(command));
+    }
+
+    // Last deferred intermediate with the stages that produce it from a table
+    string pendingRelationName;
+    Table *pendingTable = nullptr;
+    vector<ParsedQuery> pendingStages;
+    set<string> streamedRelations;
+    for (int index = 0; index < commands.size(); index++)
+    {
         tokenizedQuery.clear();
         parsedQuery.clear();
-        logger.log("\nReading New Command: ");
-        getline(fin, command);
+        command = commands[index];
         if (command.empty()) continue;
-        logger.log(command);
+        LOG_INFO("Reading New Command: " + command);
         cout << "Executing command: " << command << endl;
-
-        auto words_begin = std::sregex_iterator(command.begin(), command.end(), delim);
-        auto words_end = std::sregex_iterator();
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i)
-            tokenizedQuery.emplace_back((*i).str());
+        tokenizedQuery = statements[index];
+        string consumableRelationName;
+        consumableRelationName.swap(pendingRelationName);
 
         if (tokenizedQuery.size() == 1 && tokenizedQuery.front() == "QUIT")
         {
@@ -74,7 +156,54 @@ void executeSOURCE()
             continue;
         }
 
-        doCommand_();
+        if (tokenizedQuery.size() == 2 && tokenizedQuery[0] == "CLEAR" && streamedRelations.erase(tokenizedQuery[1]))
+        {
+            // Only left in the catalogue if the statement reading it failed
+            if (tableCatalogue.isTable(tokenizedQuery[1]))
+                tableCatalogue.eraseTable(tokenizedQuery[1]);
+            continue;
+        }
+
+        if (!syntacticParseCached() || !semanticParse())
+            continue;
+        bool stage = !parsedQuery.explain && (parsedQuery.queryType == SELECTION || parsedQuery.queryType == PROJECTION);
+        string relationName = parsedQuery.queryType == SELECTION ? parsedQuery.selectionRelationName
+                                                                 : parsedQuery.projectionRelationName;
+        string resultantRelationName = parsedQuery.queryType == SELECTION ? parsedQuery.selectionResultRelationName
+                                                                          : parsedQuery.projectionResultRelationName;
+        bool consumes = stage && !consumableRelationName.empty() && relationName == consumableRelationName;
+        bool streamable = stage && isStreamable(statements, index, resultantRelationName);
+        if (!consumes && !streamable)
+        {
+            executeCommand();
+            continue;
+        }
+
+        vector<string> columns = parsedQuery.projectionColumnList;
+        if (parsedQuery.queryType == SELECTION)
+            columns = tableCatalogue.getTable(relationName)->columns;
+        vector<ParsedQuery> stages;
+        Table *table;
+        if (consumes)
+        {
+            stages.swap(pendingStages);
+            table = pendingTable;
+            tableCatalogue.eraseTable(relationName);
+        }
+        else
+            table = tableCatalogue.getTable(relationName);
+        stages.push_back(parsedQuery);
+
+        if (streamable)
+        {
+            pendingRelationName = resultantRelationName;
+            pendingTable = table;
+            pendingStages.swap(stages);
+            streamedRelations.insert(resultantRelationName);
+            tableCatalogue.insertTable(new Table(resultantRelationName, columns));
+            continue;
+        }
+        executePipeline(table, stages, resultantRelationName);
     }
 
     return;
@@ -5,7 +5,7 @@
  */
 bool syntacticParseSYMMETRY()
 {
-    logger.log("syntacticParseSYMMETRY");
+    LOG_TRACE("syntacticParseSYMMETRY");
     if (tokenizedQuery.size() != 2) {
         cout << "SYNTAX ERROR" << endl;
         return false;
@@ -17,7 +17,7 @@ bool syntacticParseSYMMETRY()
 
 bool semanticParseSYMMETRY()
 {
-    logger.log("semanticParseSYMMETRY");
+    LOG_TRACE("semanticParseSYMMETRY");
     if (!tableCatalogue.isMatrix(parsedQuery.symmetryMatrixName))
     {
         cout << "SEMANTIC ERROR: Matrix doesn't exist" << endl;
@@ -28,7 +28,7 @@ bool semanticParseSYMMETRY()
 
 void executeSYMMETRY()
 {
-    logger.log("executeSYMMETRY");
+    LOG_TRACE("executeSYMMETRY");
     Matrix* matrix = tableCatalogue.getMatrix(parsedQuery.symmetryMatrixName);
     bool symmetry = matrix->symmetry();
     if (symmetry) cout << "TRUE" << endl;
@@ -5,7 +5,7 @@
  */
 bool syntacticParseTRANSPOSE()
 {
-    logger.log("syntacticParseTRANSPOSE");
+    LOG_TRACE("syntacticParseTRANSPOSE");
     if (tokenizedQuery.size() != 3 || tokenizedQuery[1] != "MATRIX") {
         cout << "SYNTAX ERROR" << endl;
         return false;
@@ -17,7 +17,7 @@ bool syntacticParseTRANSPOSE()
 
 bool semanticParseTRANSPOSE()
 {
-    logger.log("semanticParseTRANSPOSE");
+    LOG_TRACE("semanticParseTRANSPOSE");
     if (!tableCatalogue.isMatrix(parsedQuery.transposeMatrixName))
     {
         cout << "SEMANTIC ERROR: Matrix doesn't exist" << endl;
@@ -28,7 +28,7 @@ bool semanticParseTRANSPOSE()
 
 void executeTRANSPOSE()
 {
-    logger.log("executeTRANSPOSE");
+    LOG_TRACE("executeTRANSPOSE");
     Matrix* matrix = tableCatalogue.getMatrix(parsedQuery.transposeMatrixName);
     matrix->transpose();
     blockStats.log();
@@ -1,11 +1,31 @@
 #include"executor.h"
 #include "blockStats.h"
+#include "profiler.h"
+#include "memoryManager.h"
+#include "session.h"
+#include "resultCache.h"
 
 extern float BLOCK_SIZE;
 extern uint BLOCK_COUNT;
 extern uint PRINT_COUNT;
-extern vector<string> tokenizedQuery;
-extern ParsedQuery parsedQuery;
+extern uint PREFETCH_COUNT;
+extern uint PREFETCH_FRAMES;
+extern uint WRITE_BEHIND_PAGES;
+extern uint WORKER_THREADS;
+extern uint SERVER_PORT;
+extern uint SESSION_THREADS;
+extern uint RESULT_CACHE_BLOCKS;
+extern string STATS_FILE;
+extern PageFormat PAGE_FORMAT;
+extern StorageMode STORAGE_MODE;
+extern IoBackendType IO_BACKEND;
+extern bool DIRECT_IO;
+extern ReplacementStrategy REPLACEMENT_STRATEGY;
+extern ThreadPool threadPool;
+extern thread_local vector<string> tokenizedQuery;
+extern thread_local ParsedQuery parsedQuery;
 extern TableCatalogue tableCatalogue;
+extern DiskManager diskManager;
 extern BufferManager bufferManager;
-extern BlockStats blockStats;
\ No newline at end of file
+extern BlockStats blockStats;
+extern thread_local Profiler profiler;
\ No newline at end of file
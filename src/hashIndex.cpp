@@ -0,0 +1,159 @@
+#include "global.h"
+
+/**
+ * @brief Construct a new HashIndex object. The index is empty until build is
+ * called.
+ *
+ * @param indexName name of the relation holding the buckets
+ * @param columnIndex indexed column
+ */
+HashIndex::HashIndex(const string &indexName, int columnIndex) {
+    LOG_TRACE("HashIndex::HashIndex");
+    this->indexName = indexName;
+    this->columnIndex = columnIndex;
+}
+
+/**
+ * @brief Scrambles the bits of the key (the murmur3 finalizer), so that runs
+ * of consecutive keys spread over all buckets
+ *
+ * @param key
+ * @return uint
+ */
+uint HashIndex::hash(int key) {
+    uint h = (uint) key;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+uint HashIndex::bucketOf(int key) const {
+    uint h = hash(key);
+    uint bucket = h & ((1u << this->level) - 1);
+    if (bucket < this->bucketCount - (1u << this->level))
+        bucket = h & ((1u << (this->level + 1)) - 1);
+    return bucket;
+}
+
+/**
+ * @brief Bulk loads the index. The (bucket, key, pageIndex, slot) rows of the
+ * table are sorted on the bucket with Table::sort into a temporary run, which
+ * is then cut into bucket pages. The index must already be known to the
+ * catalogue.
+ *
+ * @param table
+ * @return true if the index has been built
+ * @return false if the table has no rows
+ */
+bool HashIndex::build(Table *table) {
+    LOG_TRACE("HashIndex::build");
+    const uint entriesPerPage = (uint) ((BLOCK_SIZE * 1000) / (sizeof(int) * 3));
+    this->bucketCount = max(1LL, (table->rowCount * 5 + entriesPerPage * 4 - 1) / (entriesPerPage * 4));
+    while ((2u << this->level) <= this->bucketCount)
+        this->level++;
+
+    string runName = tableCatalogue.temporaryName("Temp_HASH_" + this->indexName);
+    Table *run = new Table(runName, vector<string>{"bucket", "key", "pageIndex", "slot"});
+    TableBuilder builder(run, false);
+    vector<int> entry(4);
+    Cursor cursor(table->tableName, 0, TABLE);
+    cursor.readAhead();
+    for (int pageCounter = 0; pageCounter < table->blockCount; pageCounter++) {
+        if (pageCounter)
+            cursor.nextPage(pageCounter);
+        ColumnView keys = cursor.page->getColumnView(this->columnIndex);
+        for (int slot = 0; slot < keys.size(); slot++) {
+            entry[0] = this->bucketOf(keys[slot]), entry[1] = keys[slot], entry[2] = pageCounter, entry[3] = slot;
+            builder.addRow(entry);
+        }
+    }
+    tableCatalogue.insertTable(run);
+    if (!builder.finish()) {
+        tableCatalogue.deleteTable(runName);
+        return false;
+    }
+    run->sort("bucket", ASC, runName);
+
+    vector<vector<int>> bucketRows(entriesPerPage, vector<int>(3));
+    int rowCount = 0;
+    auto writeBucketPage = [&]() {
+        if (!rowCount)
+            return;
+        this->dimsPerBlock.emplace_back(rowCount, 3);
+        bufferManager.writePage(this->indexName, this->blockCount++, bucketRows, rowCount, 3);
+        rowCount = 0;
+    };
+    this->bucketFirstPage.assign(this->bucketCount + 1, 0);
+    uint bucket = 0;
+    Cursor runCursor = run->getCursor();
+    for (long long rowCounter = 0; rowCounter < run->rowCount; rowCounter++) {
+        RowView row = runCursor.getNextView();
+        while (bucket < (uint) row[0]) {
+            writeBucketPage();
+            this->bucketFirstPage[++bucket] = this->blockCount;
+        }
+        if (rowCount == entriesPerPage)
+            writeBucketPage();
+        bucketRows[rowCount][0] = row[1], bucketRows[rowCount][1] = row[2], bucketRows[rowCount][2] = row[3];
+        rowCount++;
+    }
+    writeBucketPage();
+    while (bucket < this->bucketCount)
+        this->bucketFirstPage[++bucket] = this->blockCount;
+    tableCatalogue.deleteTable(runName);
+    return true;
+}
+
+bool HashIndex::supportsRanges() const {
+    return false;
+}
+
+/**
+ * @brief Appends the row ids of all rows whose key is low to rowIds. Only the
+ * pages of the key's bucket are read.
+ *
+ * @param low
+ * @param high must be equal to low
+ * @param rowIds
+ */
+void HashIndex::lookup(int low, int high, vector<RowId> &rowIds) {
+    LOG_TRACE("HashIndex::lookup");
+    if (low != high || !this->bucketCount)
+        return;
+    uint bucket = this->bucketOf(low);
+    for (uint pageIndex = this->bucketFirstPage[bucket]; pageIndex < this->bucketFirstPage[bucket + 1]; pageIndex++) {
+        Cursor cursor(this->indexName, pageIndex, INDEX_NODE);
+        Page *page = cursor.page;
+        ColumnView keys = page->getColumnView(0);
+        for (int slot = 0; slot < keys.size(); slot++)
+            if (keys[slot] == low)
+                rowIds.push_back({page->getCell(slot, 1), page->getCell(slot, 2)});
+    }
+}
+
+/**
+ * @brief A lookup reads the pages of one bucket, more of them only when the
+ * matching entries overflow it
+ *
+ * @param matchingRows
+ * @return long long
+ */
+long long HashIndex::lookupCost(long long matchingRows) const {
+    const long long entriesPerPage = (long long) ((BLOCK_SIZE * 1000) / (sizeof(int) * 3));
+    return max(1LL, (matchingRows + entriesPerPage - 1) / entriesPerPage);
+}
+
+void HashIndex::save(CatalogWriter &writer) const {
+    TableIndex::save(writer);
+    writer.write(this->bucketCount);
+    writer.write(this->level);
+    writer.write(this->bucketFirstPage);
+}
+
+bool HashIndex::restore(CatalogReader &reader) {
+    return TableIndex::restore(reader) && reader.read(this->bucketCount) && reader.read(this->level) &&
+           reader.read(this->bucketFirstPage);
+}
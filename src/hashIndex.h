@@ -0,0 +1,36 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+#include"tableIndex.h"
+
+/**
+ * @brief The HashIndex is a linear hash index over one column of a table,
+ * answering equality lookups.
+ *
+ * A key goes to bucket hash(key) mod 2^level, or mod 2^(level + 1) when that
+ * bucket has been split, i.e. lies below bucketCount - 2^level. The bucket
+ * count is fixed when the index is bulk loaded, so that buckets fill about
+ * four fifths of a page on average. The (key, pageIndex, slot) entries of a
+ * bucket fill consecutive pages of the index relation, followed by the
+ * overflow pages of buckets that need more than one (typically because of
+ * duplicate keys); bucketFirstPage tells where each bucket starts.
+ */
+class HashIndex : public TableIndex{
+
+    uint bucketCount = 0;
+    uint level = 0;
+    vector<uint> bucketFirstPage;
+
+    static uint hash(int key);
+    uint bucketOf(int key) const;
+
+    public:
+
+    HashIndex(const string &indexName, int columnIndex);
+    bool build(Table *table) override;
+    bool supportsRanges() const override;
+    void lookup(int low, int high, vector<RowId> &rowIds) override;
+    long long lookupCost(long long matchingRows) const override;
+    void save(CatalogWriter &writer) const override;
+    bool restore(CatalogReader &reader) override;
+};
+#endif //HASH_INDEX_H
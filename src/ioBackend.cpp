@@ -0,0 +1,233 @@
+#include "global.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define IO_BACKEND_URING
+#endif
+
+/**
+ * @brief Creates the backend of the given type. URING_IO falls back to
+ * POSIX_IO where io_uring is not available.
+ *
+ * @param type
+ * @return IoBackend*
+ */
+IoBackend *IoBackend::create(IoBackendType type) {
+    LOG_TRACE("IoBackend::create");
+    if (type == URING_IO) {
+        if (UringIoBackend::isSupported())
+            return new UringIoBackend();
+        LOG_WARNING("IoBackend::create: io_uring is not available, using POSIX I/O");
+    }
+    return new PosixIoBackend();
+}
+
+ssize_t IoBackend::read(int fd, const struct iovec *parts, int partCount, off_t offset) {
+    IoRequest request{false, fd, parts, partCount, offset};
+    this->perform(&request, 1);
+    return request.result;
+}
+
+ssize_t IoBackend::write(int fd, const struct iovec *parts, int partCount, off_t offset) {
+    IoRequest request{true, fd, parts, partCount, offset};
+    this->perform(&request, 1);
+    return request.result;
+}
+
+IoBackendType PosixIoBackend::type() const {
+    return POSIX_IO;
+}
+
+void PosixIoBackend::perform(IoRequest *requests, size_t count, const function<void(IoRequest &)> &completed) {
+    for (size_t requestCounter = 0; requestCounter < count; requestCounter++) {
+        IoRequest &request = requests[requestCounter];
+        if (request.write)
+            request.result = pwritev(request.fd, request.parts, request.partCount, request.offset);
+        else
+            request.result = preadv(request.fd, request.parts, request.partCount, request.offset);
+        if (completed)
+            completed(request);
+    }
+}
+
+#ifdef IO_BACKEND_URING
+namespace {
+
+/**
+ * @brief An io_uring of one thread: the submission and completion queues
+ * shared with the kernel, set up with raw system calls
+ */
+struct Ring {
+    int fd = -1;
+    bool failed = false;
+    unsigned entries = 0;
+    void *submissionRing = MAP_FAILED, *completionRing = MAP_FAILED;
+    size_t submissionRingBytes = 0, completionRingBytes = 0;
+    io_uring_sqe *submissions = (io_uring_sqe *) MAP_FAILED;
+    size_t submissionsBytes = 0;
+    unsigned *submissionHead, *submissionTail, *submissionMask, *submissionArray;
+    unsigned *completionHead, *completionTail, *completionMask;
+    io_uring_cqe *completions;
+
+    bool setUp() {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        this->fd = (int) syscall(__NR_io_uring_setup, IO_QUEUE_DEPTH, &params);
+        if (this->fd < 0)
+            return false;
+        this->entries = params.sq_entries;
+        this->submissionRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        this->completionRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMapping)
+            this->submissionRingBytes = this->completionRingBytes =
+                    max(this->submissionRingBytes, this->completionRingBytes);
+        this->submissionRing = mmap(nullptr, this->submissionRingBytes, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+        if (this->submissionRing == MAP_FAILED)
+            return false;
+        if (singleMapping)
+            this->completionRing = this->submissionRing;
+        else
+            this->completionRing = mmap(nullptr, this->completionRingBytes, PROT_READ | PROT_WRITE,
+                                        MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+        if (this->completionRing == MAP_FAILED)
+            return false;
+        this->submissionsBytes = params.sq_entries * sizeof(io_uring_sqe);
+        this->submissions = (io_uring_sqe *) mmap(nullptr, this->submissionsBytes, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES);
+        if (this->submissions == MAP_FAILED)
+            return false;
+        char *submissionRing = (char *) this->submissionRing, *completionRing = (char *) this->completionRing;
+        this->submissionHead = (unsigned *) (submissionRing + params.sq_off.head);
+        this->submissionTail = (unsigned *) (submissionRing + params.sq_off.tail);
+        this->submissionMask = (unsigned *) (submissionRing + params.sq_off.ring_mask);
+        this->submissionArray = (unsigned *) (submissionRing + params.sq_off.array);
+        this->completionHead = (unsigned *) (completionRing + params.cq_off.head);
+        this->completionTail = (unsigned *) (completionRing + params.cq_off.tail);
+        this->completionMask = (unsigned *) (completionRing + params.cq_off.ring_mask);
+        this->completions = (io_uring_cqe *) (completionRing + params.cq_off.cqes);
+        return true;
+    }
+
+    /**
+     * @return true if the ring can be used; it is set up on the first call
+     */
+    bool ready() {
+        if (this->fd < 0 && !this->failed && !this->setUp()) {
+            LOG_WARNING("Ring::setUp: Err");
+            this->tearDown();
+            this->failed = true;
+        }
+        return !this->failed;
+    }
+
+    void tearDown() {
+        if (this->submissions != MAP_FAILED)
+            munmap(this->submissions, this->submissionsBytes);
+        if (this->completionRing != MAP_FAILED && this->completionRing != this->submissionRing)
+            munmap(this->completionRing, this->completionRingBytes);
+        if (this->submissionRing != MAP_FAILED)
+            munmap(this->submissionRing, this->submissionRingBytes);
+        if (this->fd >= 0)
+            close(this->fd);
+        this->submissions = (io_uring_sqe *) MAP_FAILED;
+        this->submissionRing = this->completionRing = MAP_FAILED;
+        this->fd = -1;
+    }
+
+    ~Ring() {
+        this->tearDown();
+    }
+};
+
+thread_local Ring ring;
+
+}
+
+/**
+ * @brief Tells whether the kernel lets this thread set up an io_uring
+ */
+bool UringIoBackend::isSupported() {
+    return ring.ready();
+}
+
+IoBackendType UringIoBackend::type() const {
+    return URING_IO;
+}
+
+/**
+ * @brief Keeps up to a ring's worth of the requests submitted and hands out
+ * completions as they arrive, topping the submission queue up in between.
+ * A thread without a ring does the requests with POSIX I/O.
+ */
+void UringIoBackend::perform(IoRequest *requests, size_t count, const function<void(IoRequest &)> &completed) {
+    if (!ring.ready()) {
+        PosixIoBackend().perform(requests, count, completed);
+        return;
+    }
+    size_t submitted = 0, inFlight = 0;
+    while (submitted < count || inFlight) {
+        unsigned tail = *ring.submissionTail;
+        while (submitted < count && inFlight < ring.entries) {
+            IoRequest &request = requests[submitted];
+            unsigned slot = tail & *ring.submissionMask;
+            io_uring_sqe &submission = ring.submissions[slot];
+            memset(&submission, 0, sizeof(submission));
+            submission.opcode = request.write ? IORING_OP_WRITEV : IORING_OP_READV;
+            submission.fd = request.fd;
+            submission.addr = (uint64_t) request.parts;
+            submission.len = request.partCount;
+            submission.off = request.offset;
+            submission.user_data = submitted;
+            ring.submissionArray[slot] = slot;
+            tail++, submitted++, inFlight++;
+        }
+        __atomic_store_n(ring.submissionTail, tail, __ATOMIC_RELEASE);
+        unsigned unsubmitted = tail - __atomic_load_n(ring.submissionHead, __ATOMIC_ACQUIRE);
+        if (syscall(__NR_io_uring_enter, ring.fd, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+            errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            LOG_ERROR("UringIoBackend::perform: Err");
+            // The kernel owns the buffers of the requests in flight until they
+            // complete, so a ring that can't even wait for them leaves nothing
+            // to return to
+            if (!unsubmitted)
+                abort();
+            // The requests the ring hasn't taken are done with POSIX I/O,
+            // those it has are still waited for
+            size_t taken = submitted - unsubmitted;
+            __atomic_store_n(ring.submissionTail, tail - unsubmitted, __ATOMIC_RELEASE);
+            inFlight -= unsubmitted;
+            PosixIoBackend().perform(requests + taken, count - taken, completed);
+            submitted = count = taken;
+        }
+        unsigned head = *ring.completionHead;
+        unsigned available = __atomic_load_n(ring.completionTail, __ATOMIC_ACQUIRE);
+        for (; head != available; head++, inFlight--) {
+            const io_uring_cqe &completion = ring.completions[head & *ring.completionMask];
+            IoRequest &request = requests[completion.user_data];
+            request.result = completion.res;
+            if (completion.res < 0) {
+                errno = -completion.res;
+                request.result = -1;
+            }
+            if (completed)
+                completed(request);
+        }
+        __atomic_store_n(ring.completionHead, head, __ATOMIC_RELEASE);
+    }
+}
+#else
+bool UringIoBackend::isSupported() {
+    return false;
+}
+
+IoBackendType UringIoBackend::type() const {
+    return URING_IO;
+}
+
+void UringIoBackend::perform(IoRequest *requests, size_t count, const function<void(IoRequest &)> &completed) {
+    PosixIoBackend().perform(requests, count, completed);
+}
+#endif
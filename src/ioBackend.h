@@ -0,0 +1,67 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+#include"logger.h"
+
+enum IoBackendType {POSIX_IO, URING_IO};
+
+// Requests an io_uring backend keeps in flight per thread
+const unsigned IO_QUEUE_DEPTH = 64;
+// Alignment of the offsets, lengths and buffers of direct I/O
+const size_t DIRECT_IO_ALIGNMENT = 4096;
+
+/**
+ * @brief A positioned vectored read or write, one of a batch handed to an
+ * IoBackend. result receives the number of bytes transferred, -1 on failure.
+ */
+struct IoRequest {
+    bool write = false;
+    int fd = -1;
+    const struct iovec *parts = nullptr;
+    int partCount = 0;
+    off_t offset = 0;
+    ssize_t result = -1;
+};
+
+/**
+ * @brief The IoBackend performs the page I/O of the DiskManager. Requests
+ * come in batches; perform returns once every request of the batch has
+ * completed, calling completed for each request as it completes.
+ *
+ * - POSIX_IO issues one preadv or pwritev after the other. It runs
+ *   everywhere and is the fallback.
+ * - URING_IO submits the whole batch to an io_uring, up to IO_QUEUE_DEPTH
+ *   requests at a time, and reaps completions in whatever order the device
+ *   finishes them. Every thread gets a ring of its own on first use, so
+ *   threads never wait for each other's I/O. If the kernel doesn't provide
+ *   io_uring, create hands out the POSIX backend instead.
+ */
+class IoBackend{
+
+    public:
+
+    static IoBackend *create(IoBackendType type);
+    virtual ~IoBackend() = default;
+    virtual IoBackendType type() const = 0;
+    virtual void perform(IoRequest *requests, size_t count,
+                         const function<void(IoRequest &)> &completed = nullptr) = 0;
+    ssize_t read(int fd, const struct iovec *parts, int partCount, off_t offset);
+    ssize_t write(int fd, const struct iovec *parts, int partCount, off_t offset);
+};
+
+class PosixIoBackend : public IoBackend{
+
+    public:
+
+    IoBackendType type() const override;
+    void perform(IoRequest *requests, size_t count, const function<void(IoRequest &)> &completed) override;
+};
+
+class UringIoBackend : public IoBackend{
+
+    public:
+
+    static bool isSupported();
+    IoBackendType type() const override;
+    void perform(IoRequest *requests, size_t count, const function<void(IoRequest &)> &completed) override;
+};
+#endif //IO_BACKEND_H
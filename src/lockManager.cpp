@@ -0,0 +1,99 @@
+#include "global.h"
+
+/**
+ * @brief Tells whether a statement reading reads and writing writes could
+ * lock them now. lock has to be held.
+ */
+bool LockManager::grantable(const vector<string> &reads, const vector<string> &writes) {
+    if (this->exclusive || this->waitingExclusive)
+        return false;
+    for (const string &relation: reads) {
+        auto it = this->relations.find(relation);
+        if (it != this->relations.end() && it->second.writer)
+            return false;
+    }
+    for (const string &relation: writes) {
+        auto it = this->relations.find(relation);
+        if (it != this->relations.end() && (it->second.writer || it->second.readers))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Locks reads shared and writes exclusively, waiting until no other
+ * statement holds a conflicting lock
+ *
+ * @param reads relations the statement reads (none of writes)
+ * @param writes relations the statement creates or changes
+ * @return StatementLock
+ */
+StatementLock LockManager::lockRelations(const vector<string> &reads, const vector<string> &writes) {
+    LOG_TRACE("LockManager::lockRelations");
+    unique_lock<mutex> guard(this->lock);
+    this->released.wait(guard, [&] { return this->grantable(reads, writes); });
+    for (const string &relation: reads)
+        this->relations[relation].readers++;
+    for (const string &relation: writes)
+        this->relations[relation].writer = true;
+    this->runningStatements++;
+    return StatementLock(reads, writes, false);
+}
+
+/**
+ * @brief Locks the whole catalogue, waiting until every other statement has
+ * finished
+ *
+ * @return StatementLock
+ */
+StatementLock LockManager::lockCatalogue() {
+    LOG_TRACE("LockManager::lockCatalogue");
+    unique_lock<mutex> guard(this->lock);
+    this->waitingExclusive++;
+    this->released.wait(guard, [&] { return !this->exclusive && !this->runningStatements; });
+    this->waitingExclusive--;
+    this->exclusive = true;
+    return StatementLock({}, {}, true);
+}
+
+void LockManager::unlock(const vector<string> &reads, const vector<string> &writes, bool catalogue) {
+    {
+        lock_guard<mutex> guard(this->lock);
+        if (catalogue)
+            this->exclusive = false;
+        else
+            this->runningStatements--;
+        for (const string &relation: reads)
+            if (!--this->relations[relation].readers && !this->relations[relation].writer)
+                this->relations.erase(relation);
+        for (const string &relation: writes)
+            if (!this->relations[relation].readers)
+                this->relations.erase(relation);
+            else
+                this->relations[relation].writer = false;
+    }
+    this->released.notify_all();
+}
+
+StatementLock::StatementLock(StatementLock &&other) noexcept
+    : reads(std::move(other.reads)), writes(std::move(other.writes)), catalogue(other.catalogue), held(other.held) {
+    other.held = false;
+}
+
+StatementLock &StatementLock::operator=(StatementLock &&other) noexcept {
+    if (this == &other)
+        return *this;
+    if (this->held)
+        lockManager.unlock(this->reads, this->writes, this->catalogue);
+    this->reads = std::move(other.reads);
+    this->writes = std::move(other.writes);
+    this->catalogue = other.catalogue;
+    this->held = other.held;
+    other.held = false;
+    return *this;
+}
+
+StatementLock::~StatementLock() {
+    if (this->held)
+        lockManager.unlock(this->reads, this->writes, this->catalogue);
+}
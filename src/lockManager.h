@@ -0,0 +1,68 @@
+#ifndef LOCK_MANAGER_H
+#define LOCK_MANAGER_H
+#include"logger.h"
+
+class StatementLock;
+
+/**
+ * @brief The LockManager keeps statements of different sessions from getting
+ * in each other's way. Before a statement is checked and run it locks the
+ * relations it touches: shared for the relations it only reads, exclusive
+ * for the one it creates or changes. Statements whose relations aren't known
+ * up front (CLEAR, RENAME, INDEX, SOURCE, SET, the matrix statements, ...)
+ * lock the whole catalogue exclusively instead.
+ *
+ * All locks of a statement are taken at once, waiting until none of them
+ * conflicts with a lock held by another statement, so statements can never
+ * deadlock. A statement waiting for the whole catalogue keeps new statements
+ * from starting until it has run.
+ */
+class LockManager {
+
+    struct RelationLock {
+        uint readers = 0;
+        bool writer = false;
+    };
+
+    mutex lock;
+    condition_variable released;
+    unordered_map<string, RelationLock> relations;
+    uint runningStatements = 0;
+    uint waitingExclusive = 0;
+    bool exclusive = false;
+
+    bool grantable(const vector<string> &reads, const vector<string> &writes);
+
+    public:
+
+    StatementLock lockRelations(const vector<string> &reads, const vector<string> &writes);
+    StatementLock lockCatalogue();
+    void unlock(const vector<string> &reads, const vector<string> &writes, bool catalogue);
+};
+
+extern LockManager lockManager;
+
+/**
+ * @brief Locks held by one statement. They are released when it goes out of
+ * scope.
+ */
+class StatementLock {
+
+    vector<string> reads;
+    vector<string> writes;
+    bool catalogue = false;
+    bool held = false;
+
+    public:
+
+    StatementLock() = default;
+    StatementLock(vector<string> reads, vector<string> writes, bool catalogue)
+        : reads(std::move(reads)), writes(std::move(writes)), catalogue(catalogue), held(true) {}
+    StatementLock(StatementLock &&other) noexcept;
+    StatementLock &operator=(StatementLock &&other) noexcept;
+    StatementLock(const StatementLock &) = delete;
+    StatementLock &operator=(const StatementLock &) = delete;
+    ~StatementLock();
+};
+
+#endif //LOCK_MANAGER_H
@@ -1,11 +1,96 @@
 #include "global.h"
 
-Logger::Logger()
+static const char *LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+
+Logger::Logger() : ring(new Slot[RING_SLOTS])
 {
     this->fout.open(this->logFile, ios::out);
+    for (size_t slot = 0; slot < RING_SLOTS; slot++)
+        this->ring[slot].sequence.store(slot, memory_order_relaxed);
+    this->drainer = thread(&Logger::drain, this);
+}
+
+/**
+ * @brief Writes out the messages still in the ring before closing the file
+ */
+Logger::~Logger()
+{
+    this->stopping = true;
+    this->wake.notify_one();
+    this->drainer.join();
+}
+
+/**
+ * @brief Queues a message for the drainer. Safe to call from any thread.
+ *
+ * @param level
+ * @param message
+ * @param length
+ */
+void Logger::log(LogLevel level, const char *message, size_t length)
+{
+    size_t position = this->head.load(memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+        slot = &this->ring[position % RING_SLOTS];
+        intptr_t lag = (intptr_t) slot->sequence.load(memory_order_acquire) - (intptr_t) position;
+        if (lag == 0 && this->head.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+            break;
+        if (lag < 0) {
+            // The drainer hasn't written out this slot's previous message yet
+            this->dropped++;
+            this->wake.notify_one();
+            return;
+        }
+        if (lag > 0)
+            position = this->head.load(memory_order_relaxed);
+    }
+    slot->level = level;
+    slot->length = min(length, (size_t) MESSAGE_BYTES);
+    memcpy(slot->text, message, slot->length);
+    slot->sequence.store(position + 1, memory_order_release);
+    if (level >= LEVEL_WARNING || position - this->tail.load(memory_order_relaxed) >= RING_SLOTS / 2)
+        this->wake.notify_one();
+}
+
+/**
+ * @brief Writes the oldest message of the ring to the file, if it has been
+ * filled in. Only called by the drainer.
+ *
+ * @return true if a message has been written
+ */
+bool Logger::writeNext()
+{
+    size_t position = this->tail.load(memory_order_relaxed);
+    Slot &slot = this->ring[position % RING_SLOTS];
+    if (slot.sequence.load(memory_order_acquire) != position + 1)
+        return false;
+    this->fout << LEVEL_NAMES[slot.level] << ' ';
+    this->fout.write(slot.text, slot.length);
+    this->fout << '\n';
+    slot.sequence.store(position + RING_SLOTS, memory_order_release);
+    this->tail.store(position + 1, memory_order_relaxed);
+    return true;
 }
 
-void Logger::log(string logString)
+/**
+ * @brief Body of the drainer thread
+ */
+void Logger::drain()
 {
-    fout << logString << endl;
+    while (true) {
+        bool stopping = this->stopping;
+        bool wrote = false;
+        while (this->writeNext())
+            wrote = true;
+        size_t dropped = this->dropped.exchange(0);
+        if (dropped)
+            this->fout << LEVEL_NAMES[LEVEL_WARNING] << ' ' << dropped << " log messages dropped\n";
+        if (wrote || dropped)
+            this->fout.flush();
+        if (stopping)
+            return;
+        unique_lock<mutex> guard(this->wakeLock);
+        this->wake.wait_for(guard, chrono::milliseconds(5));
+    }
 }
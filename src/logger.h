@@ -1,21 +1,110 @@
 #include<iostream>
 #include<bits/stdc++.h>
-#include<sys/stat.h> 
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/uio.h>
 #include<fstream>
 
 using namespace std;
 #ifndef LOGGER_H
 #define LOGGER_H
+
+/**
+ * @brief Severity of a log message. Messages below LOG_LEVEL (see server.cpp)
+ * are skipped at run time, messages below LOG_COMPILED_LEVEL aren't even
+ * compiled.
+ */
+enum LogLevel {LEVEL_TRACE, LEVEL_DEBUG, LEVEL_INFO, LEVEL_WARNING, LEVEL_ERROR};
+
+extern LogLevel LOG_LEVEL;
+
+// Lowest level whose log calls are compiled in. Release builds (NDEBUG)
+// leave out the trace calls made on entering every function; any build can
+// pick its own level with -DLOG_COMPILED_LEVEL=<0 to 5>.
+#ifndef LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILED_LEVEL 1
+#else
+#define LOG_COMPILED_LEVEL 0
+#endif
+#endif
+
+#define LOG_AT(level, message) \
+    do { if ((level) >= LOG_LEVEL) logger.log((level), (message)); } while (0)
+
+#if LOG_COMPILED_LEVEL <= 0
+#define LOG_TRACE(message) LOG_AT(LEVEL_TRACE, message)
+#else
+#define LOG_TRACE(message) ((void) 0)
+#endif
+#if LOG_COMPILED_LEVEL <= 1
+#define LOG_DEBUG(message) LOG_AT(LEVEL_DEBUG, message)
+#else
+#define LOG_DEBUG(message) ((void) 0)
+#endif
+#if LOG_COMPILED_LEVEL <= 2
+#define LOG_INFO(message) LOG_AT(LEVEL_INFO, message)
+#else
+#define LOG_INFO(message) ((void) 0)
+#endif
+#if LOG_COMPILED_LEVEL <= 3
+#define LOG_WARNING(message) LOG_AT(LEVEL_WARNING, message)
+#else
+#define LOG_WARNING(message) ((void) 0)
+#endif
+#if LOG_COMPILED_LEVEL <= 4
+#define LOG_ERROR(message) LOG_AT(LEVEL_ERROR, message)
+#else
+#define LOG_ERROR(message) ((void) 0)
+#endif
+
+/**
+ * @brief The Logger writes the log file from a thread of its own. Threads
+ * logging a message copy it into a slot of a fixed ring buffer, claimed with
+ * a compare and swap, and return; they never wait for a lock or the disk.
+ * The drainer writes out whatever the ring holds and flushes the file once
+ * per batch, waking up every few milliseconds, or as soon as the ring is
+ * half full or a warning comes in. Messages longer than a slot are cut, and
+ * messages finding the ring full are dropped and counted in the log.
+ *
+ * Messages still in the ring when the process dies abnormally are lost.
+ */
 class Logger{
 
+    static const size_t RING_SLOTS = 4096;
+    static const size_t MESSAGE_BYTES = 240;
+
+    struct Slot {
+        // Holds position when the slot is free, position + 1 once filled
+        atomic<size_t> sequence;
+        LogLevel level;
+        uint32_t length;
+        char text[MESSAGE_BYTES];
+    };
+
     string logFile = "log";
     ofstream fout;
-    
+    unique_ptr<Slot[]> ring;
+    atomic<size_t> head{0};
+    atomic<size_t> tail{0};
+    atomic<size_t> dropped{0};
+    atomic<bool> stopping{false};
+    mutex wakeLock;
+    condition_variable wake;
+    thread drainer;
+
+    bool writeNext();
+    void drain();
+
     public:
 
     Logger();
-    void log(string logString);
+    ~Logger();
+    void log(LogLevel level, const char *message, size_t length);
+    void log(LogLevel level, const char *message) { this->log(level, message, strlen(message)); }
+    void log(LogLevel level, const string &message) { this->log(level, message.data(), message.size()); }
 };
 
 extern Logger logger;
-#endif
\ No newline at end of file
+#endif
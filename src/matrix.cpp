@@ -6,7 +6,7 @@
  */
 Matrix::Matrix()
 {
-    logger.log("Matrix::Matrix");
+    LOG_TRACE("Matrix::Matrix");
 }
 
 /**
@@ -18,7 +18,7 @@ Matrix::Matrix()
  */
 Matrix::Matrix(string matrixName)
 {
-    logger.log("Matrix::Matrix");
+    LOG_TRACE("Matrix::Matrix");
     this->sourceFileName = "../data/" + matrixName + ".csv";
     this->matrixName = this->originalMatrixName = matrixName;
 }
@@ -33,7 +33,7 @@ Matrix::Matrix(string matrixName)
  */
 Matrix::Matrix(string matrixName, Matrix* originalMatrix)
 {
-    logger.log("Matrix::Matrix");
+    LOG_TRACE("Matrix::Matrix");
     this->sourceFileName = "../data/temp/" + matrixName + ".csv";
     this->matrixName = matrixName;
     this->originalMatrixName = matrixName;
@@ -43,6 +43,7 @@ Matrix::Matrix(string matrixName, Matrix* originalMatrix)
     this->m = originalMatrix->m;
     this->concurrentBlocks = originalMatrix->concurrentBlocks;
     this->dimsPerBlock = originalMatrix->dimsPerBlock;
+    this->nonZerosPerBlock = originalMatrix->nonZerosPerBlock;
 }
 
 /**
@@ -54,7 +55,7 @@ Matrix::Matrix(string matrixName, Matrix* originalMatrix)
  */
 bool Matrix::load()
 {
-    logger.log("Matrix::load");
+    LOG_TRACE("Matrix::load");
     if (this->extractDimension(this->sourceFileName)) {
         if (this->blockify())
             return true;
@@ -70,7 +71,7 @@ bool Matrix::load()
  */
 bool Matrix::extractDimension(string fileName)
 {
-    logger.log("Matrix::extractDimension");
+    LOG_TRACE("Matrix::extractDimension");
     fstream fin(fileName, ios::in);
     string line;
     if (getline(fin, line)) {
@@ -102,40 +103,42 @@ bool Matrix::blockDimensions() {
 
 /**
  * @brief This function splits all the rows and stores them in multiple files of
- * one block size.
+ * one block size. The source file is parsed in parallel (see CsvReader) and
+ * the tiles are filled in file order. Every tile is stored as dense as it is
+ * (see Page::writeTile).
  *
  * @return true if successfully blockified
  * @return false otherwise
  */
 bool Matrix::blockify() {
-    logger.log("Matrix::blockify");
-    ifstream fin(this->sourceFileName, ios::in);
+    LOG_TRACE("Matrix::blockify");
     if (!blockDimensions()) return false;
 
     vector<vector<vector<int>>> grids(concurrentBlocks, \
                               vector<vector<int>>(m, \
                                       vector<int>(m)));
-    string line, word;
-    int rowIndex = 0, rowsRead = 0;
+    int rowIndex = 0;
+    long long rowsRead = 0;
     function<void()> writeToBuffer = [&] () {
         for (int i = 0; i < concurrentBlocks; i++) {
             int colSize = (i == concurrentBlocks - 1 && this->dimension % m) ? (this->dimension % m) : m;
-            bufferManager.writePage(this->matrixName, this->blockCount, grids[i], rowIndex, colSize);
+            Page tile(this->matrixName, this->blockCount, grids[i], rowIndex, colSize);
+            this->nonZerosPerBlock.push_back(tile.writeTile());
             this->blockCount++;
             this->dimsPerBlock.emplace_back(rowIndex, colSize);
         }
         rowIndex = 0;
     };
-    while (getline(fin, line))
-    {
-        stringstream s(line);
-        for (int columnCounter = 0; columnCounter < this->dimension; columnCounter++) {
-            if (!getline(s, word, ',')) return false;
-            grids[columnCounter / m][rowIndex][columnCounter % m] = stoi(word);
+    CsvReader reader(this->sourceFileName);
+    bool parsed = reader.read(this->dimension, false, nullptr, [&](const vector<int> &values) {
+        for (size_t rowStart = 0; rowStart < values.size(); rowStart += this->dimension) {
+            for (int columnCounter = 0; columnCounter < this->dimension; columnCounter++)
+                grids[columnCounter / m][rowIndex][columnCounter % m] = values[rowStart + columnCounter];
+            rowIndex++, rowsRead++;
+            if (rowIndex == m) writeToBuffer();
         }
-        rowIndex++, rowsRead++;
-        if (rowIndex == m) writeToBuffer();
-    }
+    });
+    if (!parsed) return false;
     if (rowIndex) writeToBuffer();
     if (rowsRead != 0) return true;
     return false;
@@ -158,7 +161,7 @@ void Matrix::print()
             cursor.nextPage(i * concurrentBlocks + j);
 
             for (int k = 0; k < min(m, (int)count - i * m); k++) {
-                vector<int> row = cursor.getNext();
+                RowView row = cursor.getNextView();
                 for (int l = 0; l < min(m, (int)count - j * m); l++) {
                     mat[i * m + k][j * m + l] = row[l];
                 }
@@ -178,7 +181,7 @@ void Matrix::print()
  */
 void Matrix::getNextPage(Cursor *cursor)
 {
-    logger.log("Matrix::getNext");
+    LOG_TRACE("Matrix::getNext");
 
     if (cursor->pageIndex < this->blockCount - 1)
     {
@@ -192,29 +195,36 @@ void Matrix::getNextPage(Cursor *cursor)
  */
 void Matrix::makePermanent()
 {
-    logger.log("Matrix::makePermanent");
+    LOG_TRACE("Matrix::makePermanent");
     if(!this->isPermanent())
         bufferManager.deleteFile(this->sourceFileName);
     string newSourceFile = "../data/" + this->matrixName + ".csv";
-    ofstream fout(newSourceFile, ios::out);
+    CsvWriter writer(newSourceFile);
 
     vector<vector<int>> mat(m, vector<int>(this->dimension));
+    vector<string> rowTexts(m);
     Cursor cursor(this->matrixName, 0, MATRIX);
     for (int i = 0; i < concurrentBlocks; i++) {
         for (int j = 0; j < concurrentBlocks; j++) {
             cursor.nextPage(i * concurrentBlocks + j);
 
             for (int k = 0; k < min(m, (int)this->dimension - i * m); k++) {
-                vector<int> row = cursor.getNext();
+                RowView row = cursor.getNextView();
                 for (int l = 0; l < min(m, (int)this->dimension - j * m); l++) {
                     mat[k][j * m + l] = row[l];
                 }
             }
         }
+        // The rows of a band of tiles are formatted in parallel
         int rowCount = min(m, (int)this->dimension - i * m);
-        this->writeRows(mat, rowCount, fout);
+        threadPool.run(rowCount, [&](uint k) {
+            rowTexts[k].clear();
+            CsvWriter::appendRows(mat[k].data(), 1, (uint) this->dimension, rowTexts[k]);
+        });
+        writer.write(rowTexts, rowCount);
     }
-    fout.close();
+    if (!writer.close())
+        LOG_ERROR("Matrix::makePermanent: Err");
 }
 
 /**
@@ -225,7 +235,7 @@ void Matrix::makePermanent()
  */
 bool Matrix::isPermanent()
 {
-    logger.log("Matrix::isPermanent");
+    LOG_TRACE("Matrix::isPermanent");
     if (this->sourceFileName == "../data/" + this->originalMatrixName + ".csv")
         return true;
     return false;
@@ -237,9 +247,8 @@ bool Matrix::isPermanent()
  *
  */
 void Matrix::unload(){
-    logger.log("Matrix::~unload");
-    for (int pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
-        bufferManager.deleteFile(this->matrixName, pageCounter);
+    LOG_TRACE("Matrix::~unload");
+    bufferManager.deleteRelation(this->matrixName, this->blockCount);
     if (!isPermanent())
         bufferManager.deleteFile(this->sourceFileName);
 }
@@ -248,10 +257,8 @@ void Matrix::unload(){
  * @param newName
  */
 void Matrix::rename(string newName){
-    logger.log("Matrix::rename");
-    bufferManager.renamePagesInMemory(this->matrixName, newName);
-    for (int pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
-        bufferManager.renameFile(this->matrixName, newName, pageCounter);
+    LOG_TRACE("Matrix::rename");
+    bufferManager.renameRelation(this->matrixName, newName, this->blockCount);
     this->matrixName = newName;
 }
 
@@ -262,11 +269,12 @@ void Matrix::rename(string newName){
  * @return false if asymmetric
  */
 bool Matrix::symmetry() {
-    logger.log("Matrix::symmetry");
+    LOG_TRACE("Matrix::symmetry");
     if (symmetric != -1) return symmetric;
     for (int i = 0; i < concurrentBlocks; i++) {
         for (int j = i; j < concurrentBlocks; j++) {
             if (i == j) {
+                if (this->isZeroTile(i * concurrentBlocks + j)) continue;
                 Cursor a(this->matrixName, i * concurrentBlocks + j, MATRIX);
                 int lim = min((long long) this->m, this->dimension - i * m);
                 for (int k = 0; k < lim; k++)
@@ -274,11 +282,12 @@ bool Matrix::symmetry() {
                         if (a.getCell(k, l) != a.getCell(l, k)) return symmetric = false;
             }
             else {
+                if (this->isZeroTile(i * concurrentBlocks + j) && this->isZeroTile(j * concurrentBlocks + i)) continue;
                 Cursor a(this->matrixName, i * concurrentBlocks + j, MATRIX);
                 Cursor b(this->matrixName, j * concurrentBlocks + i, MATRIX);
                 int limrow = min((long long)this->m, this->dimension - i * m);
                 int limcol = min((long long)this->m, this->dimension - j * m);
-                logger.log(to_string(limrow) + " " + to_string(limcol) + " " + to_string(i * m + j) +  " " + to_string(j * m + i));
+                LOG_TRACE(to_string(limrow) + " " + to_string(limcol) + " " + to_string(i * m + j) +  " " + to_string(j * m + i));
                 for (int k = 0; k < limrow; k++)
                     for (int l = k + 1; l < limcol; l++)
                         if (a.getCell(k, l) != b.getCell(l, k)) return symmetric = false;
@@ -289,43 +298,199 @@ bool Matrix::symmetry() {
 }
 
 /**
- * @brief Tranposes the matrix in place
+ * @param pageIndex
+ * @return true if the tile has no non zero cell (and so no page)
+ */
+bool Matrix::isZeroTile(int pageIndex) {
+    return this->nonZerosPerBlock[pageIndex] == 0;
+}
+
+/**
+ * @brief Reads a tile straight from disk, without the buffer pool, so that
+ * any thread can. Tiles of zeros are made up without reading anything.
+ *
+ * @param row row of the tile in the tile grid
+ * @param column column of the tile in the tile grid
+ * @return Page
+ */
+Page Matrix::readTile(int row, int column) {
+    int block = row * this->concurrentBlocks + column;
+    int rowCount = this->dimsPerBlock[block].first, columnCount = this->dimsPerBlock[block].second;
+    if (this->isZeroTile(block))
+        return Page(this->matrixName, block, vector<vector<int>>(rowCount, vector<int>(columnCount)), rowCount,
+                    columnCount);
+    return Page(this->matrixName, block, rowCount, columnCount, NSM, false);
+}
+
+/**
+ * @brief Runs work on the tasks 0 .. taskCount - 1, which are handed out one
+ * at a time to at most maxWorkers threads of the pool.
+ *
+ * @param taskCount
+ * @param maxWorkers
+ * @param work
+ */
+static void forEachTask(size_t taskCount, uint maxWorkers, const function<void(size_t)> &work) {
+    uint workers = min((uint) taskCount, min(threadPool.size(), max(1u, maxWorkers)));
+    atomic<size_t> nextTask{0};
+    threadPool.run(workers, [&](uint) {
+        for (size_t task = nextTask++; task < taskCount; task = nextTask++)
+            work(task);
+    });
+}
+
+/**
+ * @brief Runs work on every tile pair (i, j), j >= i, of a grid of
+ * concurrentBlocks x concurrentBlocks tiles. The pairs are independent, so
+ * they are handed out to the threads of the pool, but never more at a time
+ * than pairs of tiles fit into the buffer. While one thread waits for its
+ * tiles, the others compute on theirs.
+ *
+ * @param concurrentBlocks
+ * @param work
+ */
+static void forEachTilePair(int concurrentBlocks, const function<void(int, int)> &work) {
+    vector<pair<int, int>> tilePairs;
+    for (int i = 0; i < concurrentBlocks; i++)
+        for (int j = i; j < concurrentBlocks; j++)
+            tilePairs.emplace_back(i, j);
+    // Two tiles per pair: pairs beyond the first want no more frames than
+    // there are threads to work on them
+    MemoryGrant grant = memoryManager.grant(2 * min((size_t) threadPool.size(), tilePairs.size()));
+    forEachTask(tilePairs.size(), grant.size() / 2, [&](size_t pair) {
+        work(tilePairs[pair].first, tilePairs[pair].second);
+    });
+}
+
+/**
+ * @brief Tranposes the matrix in place. Every tile pair is read, swapped and
+ * written back by one thread (see forEachTilePair); pairs of zero tiles are
+ * left alone.
  */
 void Matrix::transpose() {
-    logger.log("Matrix::transpose");
+    LOG_TRACE("Matrix::transpose");
     if (symmetric == 1) return;
-    for (int i = 0; i < concurrentBlocks; i++) {
-        Page* a = bufferManager.getPage(this->matrixName, i * concurrentBlocks + i, MATRIX);
-        a->transpose();
-        for (int j = i + 1; j < concurrentBlocks; j++) {
-            Page* a = bufferManager.getPage(this->matrixName, i * concurrentBlocks + j, MATRIX);
-            Page* b = bufferManager.getPage(this->matrixName, j * concurrentBlocks + i, MATRIX);
-            a->transpose(b);
+    // The tiles are read from disk and the pool must not keep the old ones
+    bufferManager.flushPages(this->matrixName);
+    bufferManager.dropPagesInMemory(this->matrixName);
+    int tiles = this->concurrentBlocks;
+    forEachTilePair(tiles, [&](int i, int j) {
+        if (this->isZeroTile(i * tiles + j) && this->isZeroTile(j * tiles + i))
+            return;
+        Page a = this->readTile(i, j);
+        if (i == j)
+            a.transpose();
+        else {
+            Page b = this->readTile(j, i);
+            a.transpose(&b);
+            this->nonZerosPerBlock[j * tiles + i] = b.writeTile();
         }
-    }
+        this->nonZerosPerBlock[i * tiles + j] = a.writeTile();
+    });
 }
 
 /**
  * Ran only for new matrices with no pages associated to it. Accesses pages of the
  * originalMatrix it was copied off of, and performs the computation, and writes a duplicate
- * page with it's own name, leaving the original page unchanged.
+ * page with it's own name, leaving the original page unchanged. The tile pairs are
+ * computed in parallel (see forEachTilePair). The result of a pair of zero
+ * tiles is zero without computing anything.
  * @param originalMatrix
  */
 void Matrix::compute(string originalMatrix) {
-    logger.log("Matrix::compute");
-    for (int i = 0; i < concurrentBlocks; i++) {
-        Page a = *bufferManager.getPage(originalMatrix, i * concurrentBlocks + i, MATRIX);
-        a.subtractTranspose();
-        a.setPageName(this->matrixName);
-        a.writePage();
-        for (int j = i + 1; j < concurrentBlocks; j++) {
-            Page a = *bufferManager.getPage(originalMatrix, i * concurrentBlocks + j, MATRIX);
-            Page b = *bufferManager.getPage(originalMatrix, j * concurrentBlocks + i, MATRIX);
+    LOG_TRACE("Matrix::compute");
+    bufferManager.flushPages(originalMatrix);
+    Matrix *original = tableCatalogue.getMatrix(originalMatrix);
+    int tiles = this->concurrentBlocks;
+    forEachTilePair(tiles, [&](int i, int j) {
+        if (original->isZeroTile(i * tiles + j) && original->isZeroTile(j * tiles + i)) {
+            this->nonZerosPerBlock[i * tiles + j] = this->nonZerosPerBlock[j * tiles + i] = 0;
+            return;
+        }
+        Page a = original->readTile(i, j);
+        if (i == j)
+            a.subtractTranspose();
+        else {
+            Page b = original->readTile(j, i);
             a.subtractTranspose(&b);
-            a.setPageName(this->matrixName); a.writePage();
-            b.setPageName(this->matrixName); b.writePage();
+            b.setPageName(this->matrixName);
+            this->nonZerosPerBlock[j * tiles + i] = b.writeTile();
+        }
+        a.setPageName(this->matrixName);
+        this->nonZerosPerBlock[i * tiles + j] = a.writeTile();
+    });
+}
+
+/**
+ * @brief Computes firstMatrix x secondMatrix into the (new, empty) tiles of
+ * this matrix, tile by tile: C(i, j) is the sum over k of A(i, k) x B(k, j).
+ *
+ * The result is computed in outer blocks of panelRows x panelColumns result
+ * tiles, which stay in memory while the k-th tile of every A row panel and
+ * every B column panel of the block is read. The shape of the block is the
+ * one that reads the fewest tiles with the block, one A tile per panel row
+ * and one B tile per panel column fitting into the frames granted to the
+ * product; every A
+ * tile is then read once per outer block column and every B tile once per
+ * outer block row. The tiles of a step are read by several threads, and
+ * each result tile is split into row stripes so that all threads of the
+ * pool multiply even when the block has fewer tiles than threads. Zero
+ * tiles are neither read nor multiplied.
+ *
+ * @param firstMatrix
+ * @param secondMatrix
+ */
+void Matrix::multiply(Matrix *firstMatrix, Matrix *secondMatrix) {
+    LOG_TRACE("Matrix::multiply");
+    bufferManager.flushPages(firstMatrix->matrixName);
+    bufferManager.flushPages(secondMatrix->matrixName);
+    int tiles = this->concurrentBlocks;
+    int panelRows = 1, panelColumns = 1;
+    long long fewestReads = -1;
+    // Every result tile, with a row and a column of input tiles, could be held
+    MemoryGrant grant = memoryManager.grant(tiles * tiles + 2 * tiles);
+    for (int rows = 1; rows <= tiles; rows++)
+        for (int columns = 1; columns <= tiles && rows * columns + rows + columns <= (int) grant.size(); columns++) {
+            long long reads = (long long) ((tiles + rows - 1) / rows) * ((tiles + columns - 1) / columns) *
+                              (rows + columns);
+            if (fewestReads == -1 || reads < fewestReads)
+                fewestReads = reads, panelRows = rows, panelColumns = columns;
+        }
+    for (int rowStart = 0; rowStart < tiles; rowStart += panelRows)
+        for (int columnStart = 0; columnStart < tiles; columnStart += panelColumns) {
+            int rows = min(panelRows, tiles - rowStart), columns = min(panelColumns, tiles - columnStart);
+            vector<Page> results, firstPanel(rows), secondPanel(columns);
+            for (int i = rowStart; i < rowStart + rows; i++)
+                for (int j = columnStart; j < columnStart + columns; j++) {
+                    pair<int, int> dims = this->dimsPerBlock[i * tiles + j];
+                    results.emplace_back(this->matrixName, i * tiles + j,
+                                         vector<vector<int>>(dims.first, vector<int>(dims.second)),
+                                         dims.first, dims.second);
+                }
+            int stripes = min(this->m, max(1, ((int) threadPool.size() + rows * columns - 1) / (rows * columns)));
+            for (int k = 0; k < tiles; k++) {
+                forEachTask(rows + columns, rows + columns, [&](size_t tile) {
+                    if ((int) tile < rows)
+                        firstPanel[tile] = firstMatrix->readTile(rowStart + tile, k);
+                    else
+                        secondPanel[tile - rows] = secondMatrix->readTile(k, columnStart + tile - rows);
+                });
+                forEachTask(results.size() * stripes, threadPool.size(), [&](size_t task) {
+                    int result = task / stripes, stripe = task % stripes;
+                    if (firstMatrix->isZeroTile((rowStart + result / columns) * tiles + k) ||
+                        secondMatrix->isZeroTile(k * tiles + columnStart + result % columns))
+                        return;
+                    int rowCount = firstPanel[result / columns].getRowCount();
+                    results[result].multiplyAccumulate(&firstPanel[result / columns], &secondPanel[result % columns],
+                                                       rowCount * stripe / stripes,
+                                                       rowCount * (stripe + 1) / stripes);
+                });
+            }
+            forEachTask(results.size(), results.size(), [&](size_t result) {
+                int pageIndex = (rowStart + result / columns) * tiles + columnStart + result % columns;
+                this->nonZerosPerBlock[pageIndex] = results[result].writeTile();
+            });
         }
-    }
 }
 
 /**
@@ -335,7 +500,43 @@ void Matrix::compute(string originalMatrix) {
  */
 Cursor Matrix::getCursor()
 {
-    logger.log("Matrix::getCursor");
+    LOG_TRACE("Matrix::getCursor");
     Cursor cursor(this->matrixName, 0, MATRIX);
     return cursor;
 }
+
+/**
+ * @brief Persists everything the catalogue knows about the matrix (see
+ * TableCatalogue::save), the symmetry once checked included
+ *
+ * @param writer
+ */
+void Matrix::save(CatalogWriter &writer) const {
+    LOG_TRACE("Matrix::save");
+    writer.write(this->sourceFileName);
+    writer.write(this->matrixName);
+    writer.write(this->originalMatrixName);
+    writer.write(this->dimension);
+    writer.write(this->blockCount);
+    writer.write(this->symmetric);
+    writer.write(this->m);
+    writer.write(this->concurrentBlocks);
+    writer.write(this->dimsPerBlock);
+    writer.write(this->nonZerosPerBlock);
+}
+
+/**
+ * @brief Reads back a matrix saved by save, into a matrix made with the
+ * default constructor
+ *
+ * @param reader
+ * @return false if the catalogue file is damaged
+ */
+bool Matrix::restore(CatalogReader &reader) {
+    LOG_TRACE("Matrix::restore");
+    return reader.read(this->sourceFileName) && reader.read(this->matrixName) &&
+           reader.read(this->originalMatrixName) && reader.read(this->dimension) && reader.read(this->blockCount) &&
+           reader.read(this->symmetric) && reader.read(this->m) && reader.read(this->concurrentBlocks) &&
+           reader.read(this->dimsPerBlock) && reader.read(this->nonZerosPerBlock) &&
+           this->dimsPerBlock.size() == this->blockCount && this->nonZerosPerBlock.size() == this->blockCount;
+}
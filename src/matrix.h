@@ -1,10 +1,16 @@
 #include "cursor.h"
+#include "catalogFile.h"
 
 /**
  * @brief The Matrix class holds all information related to a loaded matrix.
  * It also implements methods that interact with the parsers, executors, cursors
  * and buffer manager. A matrix is usually created by a LOAD command or by the
- * COMPUTE command.
+ * COMPUTE and MULTIPLY commands.
+ *
+ * Every tile is written in the form its density calls for (see
+ * Page::writeTile): dense, sparse or, for tiles of zeros, not at all. The
+ * number of non zero cells of every tile is kept to know which tiles have
+ * no page, and those are neither read nor computed on.
  */
 class Matrix
 {
@@ -18,6 +24,7 @@ public:
     int symmetric = -1; // -1 - not computed, 0 - not symmetric, 1 - symmetric
     int m, concurrentBlocks;
     vector<pair<int,int>> dimsPerBlock;
+    vector<int> nonZerosPerBlock; // tiles without non zero cells have no page
     bool blockify();
     Matrix();
     Matrix(string matrixName);
@@ -27,6 +34,8 @@ public:
     void print();
     void makePermanent();
     bool isPermanent();
+    bool isZeroTile(int pageIndex);
+    Page readTile(int row, int column);
     void transpose();
     bool blockDimensions();
     void getNextPage(Cursor *cursor);
@@ -34,7 +43,10 @@ public:
     Cursor getCursor();
     void unload();
     void compute(string originalMatrix);
+    void multiply(Matrix *firstMatrix, Matrix *secondMatrix);
     void rename(string newName);
+    void save(CatalogWriter &writer) const;
+    bool restore(CatalogReader &reader);
 
     /**
  * @brief Static function that takes a vector of valued and prints them out in a
@@ -46,7 +58,7 @@ public:
     template <typename T>
     void writeRow(vector<T> row, ostream &fout)
     {
-        logger.log("Table::printRow");
+        LOG_TRACE("Table::printRow");
         for (int columnCounter = 0; columnCounter < row.size(); columnCounter++)
         {
             if (columnCounter != 0)
@@ -66,7 +78,7 @@ public:
     template <typename T>
     void writeRow(vector<T> row)
     {
-        logger.log("Table::printRow");
+        LOG_TRACE("Table::printRow");
         ofstream fout(this->sourceFileName, ios::app);
         this->writeRow(row, fout);
         fout.close();
@@ -0,0 +1,33 @@
+#include "global.h"
+
+/**
+ * @brief Number of frames a grant asked for now would get at most
+ *
+ * @return uint
+ */
+uint MemoryManager::availableFrames() {
+    lock_guard<mutex> guard(this->lock);
+    return max(MIN_GRANT_FRAMES, BLOCK_COUNT > this->grantedFrames ? BLOCK_COUNT - this->grantedFrames : 0);
+}
+
+/**
+ * @brief Grants an operator the frames it wants, as far as they are free,
+ * but at least MIN_GRANT_FRAMES
+ *
+ * @param wantedFrames frames the operator could put to use
+ * @return MemoryGrant
+ */
+MemoryGrant MemoryManager::grant(uint wantedFrames) {
+    LOG_TRACE("MemoryManager::grant");
+    lock_guard<mutex> guard(this->lock);
+    uint freeFrames = BLOCK_COUNT > this->grantedFrames ? BLOCK_COUNT - this->grantedFrames : 0;
+    uint frames = max(MIN_GRANT_FRAMES, min(wantedFrames, freeFrames));
+    this->grantedFrames += frames;
+    LOG_DEBUG("MemoryManager::grant: " + to_string(frames) + " of " + to_string(wantedFrames) + " frames");
+    return MemoryGrant(frames);
+}
+
+void MemoryManager::release(uint frames) {
+    lock_guard<mutex> guard(this->lock);
+    this->grantedFrames -= frames;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef MEMORY_MANAGER_H
+#define MEMORY_MANAGER_H
+#include"logger.h"
+
+// One frame for input, one for output and one to work in
+const uint MIN_GRANT_FRAMES = 3;
+
+class MemoryGrant;
+
+/**
+ * @brief The MemoryManager divides the BLOCK_COUNT frames of the buffer pool
+ * among the operators running. Before it starts, an operator asks for a grant
+ * of the frames it could use and sizes its work to what it gets: an external
+ * sort merges grant - 1 runs at a time, hash joins and hash aggregation keep
+ * grant - 2 blocks in memory and split into at most grant - 1 partitions, and
+ * block nested loops hold grant - 2 blocks of the outer relation. The cost
+ * model plans with the frames a grant would get (availableFrames).
+ *
+ * A grant is never smaller than MIN_GRANT_FRAMES, even if other grants hold
+ * the rest of the pool; the pool then grows past BLOCK_COUNT for a while, as
+ * it does when every frame is pinned.
+ */
+class MemoryManager {
+
+    mutex lock;
+    uint grantedFrames = 0;
+
+    public:
+
+    uint availableFrames();
+    MemoryGrant grant(uint wantedFrames);
+    void release(uint frames);
+};
+
+extern MemoryManager memoryManager;
+
+/**
+ * @brief Frames granted to one operator. They are handed back to the
+ * MemoryManager when the grant goes out of scope.
+ */
+class MemoryGrant {
+
+    uint frames;
+
+    public:
+
+    explicit MemoryGrant(uint frames) : frames(frames) {}
+    MemoryGrant(MemoryGrant &&other) noexcept : frames(other.frames) { other.frames = 0; }
+    MemoryGrant(const MemoryGrant &) = delete;
+    MemoryGrant &operator=(const MemoryGrant &) = delete;
+    ~MemoryGrant() { memoryManager.release(this->frames); }
+    uint size() const { return this->frames; }
+    // Frames left to work in once an input and an output frame are set aside
+    uint workFrames() const { return this->frames - 2; }
+};
+
+#endif //MEMORY_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef OPERATOR_KERNELS_H
+#define OPERATOR_KERNELS_H
+
+/**
+ * @brief Comparison and aggregation kernels specialized at compile time on
+ * their operator. Loops over a batch of values take the operator as a
+ * template parameter, so the comparison or update inlines into the loop
+ * instead of being an indirect call per value. The operator of a query is
+ * resolved once per batch by withBinaryOperator or withAggregateFunction,
+ * which call the loop with an integral_constant holding it:
+ *
+ *     withBinaryOperator(op, [&](auto binaryOperator) {
+ *         for (...) matches += compare<binaryOperator>(a[i], b);
+ *     });
+ */
+
+template <BinaryOperator binaryOperator, typename T>
+inline bool compare(T value1, T value2)
+{
+    if constexpr (binaryOperator == LESS_THAN)
+        return value1 < value2;
+    else if constexpr (binaryOperator == GREATER_THAN)
+        return value1 > value2;
+    else if constexpr (binaryOperator == LEQ)
+        return value1 <= value2;
+    else if constexpr (binaryOperator == GEQ)
+        return value1 >= value2;
+    else if constexpr (binaryOperator == EQUAL)
+        return value1 == value2;
+    else
+        return value1 != value2;
+}
+
+/**
+ * @brief State of an aggregate over no rows. Accumulating every row of a
+ * group into it gives the aggregate; for AVG the sum, to be divided by the
+ * row count at the end.
+ */
+template <AggregateFunction function>
+constexpr long long aggregateIdentity()
+{
+    if constexpr (function == MIN)
+        return LLONG_MAX;
+    else if constexpr (function == MAX)
+        return LLONG_MIN;
+    else
+        return 0;
+}
+
+template <AggregateFunction function>
+inline long long accumulateValue(long long state, long long value)
+{
+    if constexpr (function == MIN)
+        return value < state ? value : state;
+    else if constexpr (function == MAX)
+        return value > state ? value : state;
+    else if constexpr (function == SUM || function == AVG)
+        return state + value;
+    else
+        return state + 1;
+}
+
+/**
+ * @brief Combines two states of an aggregate accumulated over different rows
+ * of a group into the state over all of them
+ */
+template <AggregateFunction function>
+inline long long combineStates(long long state1, long long state2)
+{
+    if constexpr (function == MIN)
+        return state2 < state1 ? state2 : state1;
+    else if constexpr (function == MAX)
+        return state2 > state1 ? state2 : state1;
+    else
+        return state1 + state2;
+}
+
+/**
+ * @brief Calls body with integral_constant<BinaryOperator, binaryOperator>.
+ * NO_BINOP_CLAUSE is not an operator and must be handled by the caller.
+ */
+template <typename Body>
+inline decltype(auto) withBinaryOperator(BinaryOperator binaryOperator, Body &&body)
+{
+    switch (binaryOperator)
+    {
+    case LESS_THAN: return body(integral_constant<BinaryOperator, LESS_THAN>());
+    case GREATER_THAN: return body(integral_constant<BinaryOperator, GREATER_THAN>());
+    case LEQ: return body(integral_constant<BinaryOperator, LEQ>());
+    case GEQ: return body(integral_constant<BinaryOperator, GEQ>());
+    case EQUAL: return body(integral_constant<BinaryOperator, EQUAL>());
+    default: return body(integral_constant<BinaryOperator, NOT_EQUAL>());
+    }
+}
+
+/**
+ * @brief Calls body with integral_constant<AggregateFunction, function>.
+ * NO_AGG_FUNC is not a function and must be handled by the caller.
+ */
+template <typename Body>
+inline decltype(auto) withAggregateFunction(AggregateFunction function, Body &&body)
+{
+    switch (function)
+    {
+    case MIN: return body(integral_constant<AggregateFunction, MIN>());
+    case MAX: return body(integral_constant<AggregateFunction, MAX>());
+    case SUM: return body(integral_constant<AggregateFunction, SUM>());
+    case AVG: return body(integral_constant<AggregateFunction, AVG>());
+    default: return body(integral_constant<AggregateFunction, COUNT>());
+    }
+}
+
+#endif //OPERATOR_KERNELS_H
@@ -12,7 +12,9 @@ Page::Page() {
     this->columnCount = 0;
     this->dirty = 0;
     this->deleted = 0;
-    this->rows.clear();
+    this->layout = NSM;
+    this->compressed = false;
+    this->cells.clear();
 }
 
 /**
@@ -21,44 +23,253 @@ Page::Page() {
  * and each block is stored in a different file named
  * "<tablename>_Page<pageindex>". For example, If the Page being loaded is of
  * table "R" and the pageIndex is 2 then the file name is "R_Page2". The page
- * loads the rows (or tuples) into a vector of rows (where each row is a vector
- * of integers).
+ * loads the rows (or tuples) into one contiguous array of cells laid out
+ * according to the table's PageLayout (matrix tiles are always stored row
+ * major). Binary pages are detected through their header, anything else is
+ * parsed as a text page. All zero matrix tiles have no page: their cells are
+ * zeroed without reading anything.
+ *
+ * With deferRead set only the page's shape is taken from the catalogue and
+ * the contents are left to a later readPage call, which the prefetcher makes
+ * off the main thread.
  *
  * @param tableName 
  * @param pageIndex 
+ * @param deferRead
  */
-Page::Page(string tableName, int pageIndex, datatype d) {
-    logger.log("Page::Page");
+Page::Page(string tableName, int pageIndex, datatype d, bool deferRead) {
+    LOG_TRACE("Page::Page");
     this->dirty = 0;
     this->deleted = 0;
     this->tableName = tableName;
     this->pageIndex = pageIndex;
     this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
-    uint maxRowCount;
     if (d == TABLE) {
-        Table table = *tableCatalogue.getTable(tableName);
-        this->columnCount = table.columnCount;
-        this->rowCount = table.rowsPerBlockCount[pageIndex];
-        maxRowCount = table.maxRowsPerBlock;
+        Table *table = tableCatalogue.getTable(tableName);
+        this->columnCount = table->columnCount;
+        this->rowCount = table->rowsPerBlockCount[pageIndex];
+        this->layout = table->layout;
+        this->compressed = table->compressed;
+        if (this->layout == DSM)
+            for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+                this->columnChains.push_back(table->columnChain(columnCounter));
+    } else if (d == INDEX_NODE) {
+        TableIndex *index = tableCatalogue.getIndex(tableName);
+        tie(this->rowCount, this->columnCount) = index->dimsPerBlock[pageIndex];
+        this->layout = NSM;
     } else {
-        Matrix matrix = *tableCatalogue.getMatrix(tableName);
-        tie(this->rowCount, this->columnCount) = matrix.dimsPerBlock[pageIndex];
-        maxRowCount = this->rowCount;
+        Matrix *matrix = tableCatalogue.getMatrix(tableName);
+        tie(this->rowCount, this->columnCount) = matrix->dimsPerBlock[pageIndex];
+        this->layout = NSM;
+        this->stored = !matrix->isZeroTile(pageIndex);
+    }
+    this->cells.assign((size_t) this->rowCount * this->columnCount, 0);
+    if (deferRead)
+        return;
+    for (int block = 0; block < this->getBlockSpan(); block++)
+        blockStats.ReadBlock();
+    this->readPage();
+}
+
+/**
+ * @brief Reads a table page whose dimensions and format the caller knows.
+ * Touches neither the catalogue nor the buffer pool, so any thread can read
+ * pages this way (the parallel merges of the external sort do).
+ *
+ * @param tableName
+ * @param pageIndex
+ * @param rowCount
+ * @param columnCount
+ * @param layout
+ * @param compressed
+ */
+Page::Page(string tableName, int pageIndex, int rowCount, int columnCount, PageLayout layout, bool compressed) {
+    LOG_TRACE("Page::Page");
+    this->tableName = tableName;
+    this->pageIndex = pageIndex;
+    this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
+    this->rowCount = rowCount;
+    this->columnCount = columnCount;
+    this->layout = layout;
+    this->compressed = compressed;
+    for (int columnCounter = 0; layout == DSM && columnCounter < columnCount; columnCounter++)
+        this->columnChains.push_back(Page::columnChainName(tableName, columnCounter));
+    this->cells.assign((size_t) rowCount * columnCount, 0);
+    for (int block = 0; block < this->getBlockSpan(); block++)
+        blockStats.ReadBlock();
+    this->readPage();
+}
+
+/**
+ * @brief Reads the contents of the page file into the cells. Doesn't touch
+ * the catalogue, so it is safe to call from the prefetch thread.
+ */
+void Page::readPage() {
+    LOG_TRACE("Page::readPage");
+    if (!this->stored)
+        return;
+    if (this->layout == DSM) {
+        vector<int> columnIndices(this->columnCount);
+        iota(columnIndices.begin(), columnIndices.end(), 0);
+        this->readColumnChains(columnIndices);
+    } else if (!this->readBinaryPage() && STORAGE_MODE == PAGE_FILES)
+        this->readTextPage();
+}
+
+/**
+ * @brief Reads only the given columns of a DSM page whose contents were left
+ * out at construction (deferRead), one block per column. The other columns
+ * keep whatever they held, so a scan can read the columns its predicate
+ * needs first and the rest only for pages with qualifying rows.
+ *
+ * @param columnIndices
+ */
+void Page::readColumns(const vector<int> &columnIndices) {
+    LOG_TRACE("Page::readColumns");
+    assert(this->layout == DSM); //Should never occur. Sanity check
+    for (size_t block = 0; block < columnIndices.size(); block++)
+        blockStats.ReadBlock();
+    this->readColumnChains(columnIndices);
+}
+
+/**
+ * @brief Single column page of the chain holding a column of this DSM page,
+ * with the shape of this page and zeroed cells
+ *
+ * @param columnIndex
+ * @return Page
+ */
+Page Page::chainPage(int columnIndex) {
+    Page column;
+    column.tableName = this->columnChains[columnIndex];
+    column.pageIndex = this->pageIndex;
+    column.pageName = "../data/temp/" + column.tableName + "_Page" + to_string(this->pageIndex);
+    column.rowCount = this->rowCount;
+    column.columnCount = 1;
+    column.layout = PAX;
+    column.compressed = this->compressed;
+    column.cells.assign(this->rowCount, 0);
+    return column;
+}
+
+/**
+ * @brief Reads the pages of the given column chains into their columns of
+ * the cell array. Every chain page is an ordinary single column page.
+ *
+ * @param columnIndices
+ */
+void Page::readColumnChains(const vector<int> &columnIndices) {
+    LOG_TRACE("Page::readColumnChains");
+    if (this->compressed && this->encodings.size() != this->columnCount)
+        this->encodings.assign(this->columnCount, ColumnEncoding());
+    for (int columnIndex: columnIndices) {
+        Page column = this->chainPage(columnIndex);
+        column.readPage();
+        copy(column.cells.begin(), column.cells.end(), this->cells.begin() + this->cellIndex(0, columnIndex));
+        if (this->compressed)
+            this->encodings[columnIndex] = column.encodings[0];
+    }
+}
+
+/**
+ * @brief Reads the header and the payload of the page straight into the cell
+ * array with a single read through the disk manager.
+ *
+ * @return true if the page was a binary page and has been read
+ * @return false if the file is not a binary page (it should be read as text)
+ */
+bool Page::readBinaryPage() {
+    LOG_TRACE("Page::readBinaryPage");
+    if (this->compressed)
+        return this->readCompressedPage();
+    PageHeader header;
+    struct iovec parts[2] = {{&header, sizeof(PageHeader)},
+                             {this->cells.data(), this->cells.size() * sizeof(int)}};
+    ssize_t bytesRead = diskManager.readPage(this->tableName, this->pageIndex, parts, 2);
+    if (bytesRead < (ssize_t) sizeof(PageHeader) || header.magic != PAGE_MAGIC) {
+        LOG_DEBUG("Page::readBinaryPage: not a binary page");
+        return false;
+    }
+    //Sanity checks
+    assert(header.rowCount == this->rowCount && header.columnCount == this->columnCount);
+    assert(header.layout == this->layout && !header.compressed);
+    if (header.sparseCells >= 0) {
+        // The pairs were read into the front of the cell array (a segment
+        // file returns the rest of the page slot after them)
+        assert(bytesRead >= (ssize_t) (sizeof(PageHeader) + 2 * header.sparseCells * sizeof(int)));
+        vector<int> pairs(this->cells.begin(), this->cells.begin() + 2 * header.sparseCells);
+        fill(this->cells.begin(), this->cells.end(), 0);
+        for (size_t pair = 0; pair < pairs.size(); pair += 2)
+            this->cells[pairs[pair]] = pairs[pair + 1];
+        return true;
     }
-    vector<int> row(columnCount, 0);
-    this->rows.assign(maxRowCount, row);
-    blockStats.ReadBlock();
+    assert(bytesRead == (ssize_t) (sizeof(PageHeader) + this->cells.size() * sizeof(int)));
+    return true;
+}
+
+/**
+ * @brief Reads a compressed page (at most one block after the header) and
+ * decodes its columns into the cell array. The encodings are kept so that
+ * predicates can be checked against them.
+ *
+ * @return true if the page was a compressed binary page and has been read
+ * @return false otherwise
+ */
+bool Page::readCompressedPage() {
+    LOG_TRACE("Page::readCompressedPage");
+    PageHeader header;
+    vector<char> payload(DiskManager::pageBytes() - sizeof(PageHeader));
+    struct iovec parts[2] = {{&header, sizeof(PageHeader)},
+                             {payload.data(), payload.size()}};
+    ssize_t bytesRead = diskManager.readPage(this->tableName, this->pageIndex, parts, 2);
+    if (bytesRead < (ssize_t) sizeof(PageHeader) || header.magic != PAGE_MAGIC) {
+        LOG_DEBUG("Page::readCompressedPage: not a binary page");
+        return false;
+    }
+    //Sanity checks
+    assert(header.rowCount == this->rowCount && header.columnCount == this->columnCount);
+    assert(header.layout == this->layout && header.compressed);
+
+    const char *in = payload.data(), *end = payload.data() + (bytesRead - sizeof(PageHeader));
+    this->encodings.assign(this->columnCount, ColumnEncoding());
+    for (int columnCounter = 0; columnCounter < this->columnCount && in; columnCounter++) {
+        ColumnView column = this->getColumnView(columnCounter);
+        in = PageCodec::decode(in, end, this->rowCount, this->encodings[columnCounter],
+                               this->cells.data() + this->cellIndex(0, columnCounter), column.stride);
+    }
+    assert(in); //Should never occur. Sanity check
+    return true;
+}
+
+/**
+ * @brief Reads a page written in the whitespace separated text format.
+ */
+void Page::readTextPage() {
+    LOG_TRACE("Page::readTextPage");
     ifstream fin(pageName, ios::in);
     int number;
-    for (uint rowCounter = 0; rowCounter < this->rowCount; rowCounter++) {
+    for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++) {
         for (int columnCounter = 0; columnCounter < columnCount; columnCounter++) {
             fin >> number;
-            this->rows[rowCounter][columnCounter] = number;
+            this->cells[this->cellIndex(rowCounter, columnCounter)] = number;
         }
     }
     fin.close();
 }
 
+/**
+ * @brief Position of a cell in the cell array
+ *
+ * @param row
+ * @param col
+ * @return int
+ */
+int Page::cellIndex(int row, int col) const {
+    if (this->layout != NSM)
+        return col * this->rowCount + row;
+    return row * this->columnCount + col;
+}
+
 /**
  * @brief Get row from page indexed by rowIndex
  * 
@@ -66,12 +277,103 @@ Page::Page(string tableName, int pageIndex, datatype d) {
  * @return vector<int> 
  */
 vector<int> Page::getRow(int rowIndex) {
-    logger.log("Page::getRow");
-    vector<int> result;
-    result.clear();
-    if (rowIndex >= this->rowCount)
-        return result;
-    return this->rows[rowIndex];
+    LOG_TRACE("Page::getRow");
+    RowView row = this->getRowView(rowIndex);
+    return vector<int>(row.begin(), row.end());
+}
+
+/**
+ * @brief Get a view of the row indexed by rowIndex without copying it. The
+ * view is empty if rowIndex is past the last row of the page.
+ *
+ * @param rowIndex
+ * @return RowView
+ */
+RowView Page::getRowView(int rowIndex) {
+    LOG_TRACE("Page::getRowView");
+    RowView view;
+    if (rowIndex < this->rowCount) {
+        view.data = this->cells.data() + this->cellIndex(rowIndex, 0);
+        view.length = this->columnCount;
+        view.stride = (this->layout != NSM) ? this->rowCount : 1;
+    }
+    return view;
+}
+
+/**
+ * @brief Get a view of all the values of a column in this page. For PAX pages
+ * the values are contiguous.
+ *
+ * @param columnIndex
+ * @return ColumnView
+ */
+ColumnView Page::getColumnView(int columnIndex) {
+    LOG_TRACE("Page::getColumnView");
+    ColumnView view;
+    view.data = this->cells.data() + this->cellIndex(0, columnIndex);
+    view.length = this->rowCount;
+    view.stride = (this->layout != NSM) ? 1 : this->columnCount;
+    return view;
+}
+
+/**
+ * @brief Encoding of a column as it was last read from or written to disk.
+ *
+ * @param columnIndex
+ * @return const ColumnEncoding* nullptr if the page isn't compressed (or has
+ * been modified since)
+ */
+const ColumnEncoding* Page::getColumnEncoding(int columnIndex) {
+    if (this->encodings.empty())
+        return nullptr;
+    return &this->encodings[columnIndex];
+}
+
+/**
+ * @return Number of rows stored in the page
+ */
+int Page::getRowCount() {
+    return this->rowCount;
+}
+
+/**
+ * @return Number of blocks the page takes on disk: one per column for DSM
+ * pages, one otherwise
+ */
+int Page::getBlockSpan() {
+    if (!this->stored)
+        return 0;
+    return this->layout == DSM ? this->columnCount : 1;
+}
+
+/**
+ * @brief Relation and page index of every block readPage reads: the page
+ * itself, or the page of every column chain for DSM. Pages that aren't
+ * stored have none.
+ *
+ * @return vector<pair<string, int>>
+ */
+vector<pair<string, int>> Page::getBlocks() {
+    vector<pair<string, int>> blocks;
+    if (!this->stored)
+        return blocks;
+    if (this->layout != DSM)
+        blocks.emplace_back(this->tableName, this->pageIndex);
+    for (const string &columnChain: this->columnChains)
+        blocks.emplace_back(columnChain, this->pageIndex);
+    return blocks;
+}
+
+/**
+ * @brief Name of the relation holding a column of a DSM table whose columns
+ * are stored under the table's own name
+ *
+ * @param tableName
+ * @param columnIndex
+ * @return string
+ */
+string Page::columnChainName(const string &tableName, int columnIndex) {
+    return tableName + "#" + to_string(columnIndex);
 }
 
 /**
@@ -80,9 +382,9 @@ vector<int> Page::getRow(int rowIndex) {
  * @return Returns value at cell specified by parameters
  */
 int Page::getCell(int row, int col) {
-    logger.log("Page::getCell");
+    LOG_TRACE("Page::getCell");
     assert(row < this->rowCount && col < this->columnCount);
-    return this->rows[row][col];
+    return this->cells[this->cellIndex(row, col)];
 }
 
 /**
@@ -94,47 +396,171 @@ void Page::setPageName(string newName) {
     this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(this->pageIndex);
 }
 
-Page::Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount) {
-    logger.log("Page::Page");
+Page::Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount, PageLayout layout,
+           bool compressed) {
+    LOG_TRACE("Page::Page");
     this->pageIndex = pageIndex;
-    this->rows = rows;
-    this->rowCount = rowCount;
-    this->columnCount = colCount;
+    this->layout = layout;
+    this->compressed = compressed;
+    this->setRows(rows, rowCount, colCount);
     this->tableName = tableName;
     this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
+    for (int columnCounter = 0; layout == DSM && columnCounter < colCount; columnCounter++)
+        this->columnChains.push_back(Page::columnChainName(tableName, columnCounter));
     this->dirty = 0;
     this->deleted = 0;
 }
 
 /**
- * @brief writes current page contents to file.
+ * @brief Replaces the contents of the page with the first newRowCount rows,
+ * laid out according to the page's layout.
+ *
+ * @param newRows
+ * @param newRowCount
+ * @param newColumnCount
+ */
+void Page::setRows(const vector<vector<int>> &newRows, int newRowCount, int newColumnCount) {
+    this->rowCount = newRowCount, this->columnCount = newColumnCount;
+    this->cells.resize((size_t) newRowCount * newColumnCount);
+    this->encodings.clear();
+    if (this->layout == NSM) {
+        for (int r = 0; r < newRowCount; r++)
+            copy(newRows[r].begin(), newRows[r].begin() + newColumnCount, this->cells.begin() + (size_t) r * newColumnCount);
+        return;
+    }
+    for (int r = 0; r < newRowCount; r++)
+        for (int c = 0; c < newColumnCount; c++)
+            this->cells[this->cellIndex(r, c)] = newRows[r][c];
+}
+
+/**
+ * @brief writes current page contents to disk in the format specified by
+ * PAGE_FORMAT (segment files are always binary).
  * 
  */
 void Page::writePage() {
-    logger.log("Page::writePage");
-    blockStats.WriteBlock();
+    LOG_TRACE("Page::writePage");
+    if (this->layout == DSM) {
+        this->writeColumnChains();
+        this->dirty = 0;
+        return;
+    }
+    blockStats.WriteBlock((long long) this->rowCount * this->columnCount * sizeof(int));
+    if (PAGE_FORMAT == TEXT_PAGE && STORAGE_MODE == PAGE_FILES)
+        this->writeTextPage();
+    else
+        this->writeBinaryPage();
+    this->dirty = 0;
+}
+
+/**
+ * @brief Writes a matrix tile in the smallest form its contents allow. A tile
+ * whose cells are all zero gets no page at all. A tile whose non zero cells
+ * take fewer bytes as (position, value) pairs than the cells themselves is
+ * written as a sparse binary page. Any other tile (and every tile in the
+ * text format) is written as an ordinary page.
+ *
+ * @return int number of non zero cells, which the matrix records to tell
+ * the tiles without a page apart
+ */
+int Page::writeTile() {
+    LOG_TRACE("Page::writeTile");
+    this->dirty = 0;
+    int nonZeroCells = this->cells.size() - count(this->cells.begin(), this->cells.end(), 0);
+    this->stored = nonZeroCells != 0;
+    if (!this->stored)
+        return 0;
+    if (2 * (size_t) nonZeroCells >= this->cells.size() || (PAGE_FORMAT == TEXT_PAGE && STORAGE_MODE == PAGE_FILES)) {
+        this->writePage();
+        return nonZeroCells;
+    }
+    blockStats.WriteBlock(2 * (long long) nonZeroCells * sizeof(int));
+    PageHeader header{PAGE_MAGIC, this->rowCount, this->columnCount, this->layout, 0, nonZeroCells};
+    vector<int> pairs;
+    pairs.reserve(2 * nonZeroCells);
+    for (size_t position = 0; position < this->cells.size(); position++)
+        if (this->cells[position])
+            pairs.push_back(position), pairs.push_back(this->cells[position]);
+    struct iovec parts[2] = {{&header, sizeof(PageHeader)},
+                             {pairs.data(), pairs.size() * sizeof(int)}};
+    if (!diskManager.writePage(this->tableName, this->pageIndex, parts, 2))
+        LOG_ERROR("Page::writeTile: Err");
+    return nonZeroCells;
+}
+
+/**
+ * @brief Writes every column of a DSM page as a single column page of its
+ * column chain, compressed on its own if the table is.
+ */
+void Page::writeColumnChains() {
+    LOG_TRACE("Page::writeColumnChains");
+    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
+        Page column = this->chainPage(columnCounter);
+        copy_n(this->cells.begin() + this->cellIndex(0, columnCounter), this->rowCount, column.cells.begin());
+        column.writePage();
+    }
+}
+
+/**
+ * @brief Writes the PageHeader followed by the cell array, as it is laid out
+ * in memory, with a single write through the disk manager.
+ */
+void Page::writeBinaryPage() {
+    LOG_TRACE("Page::writeBinaryPage");
+    if (this->compressed) {
+        this->writeCompressedPage();
+        return;
+    }
+    PageHeader header{PAGE_MAGIC, this->rowCount, this->columnCount, this->layout, 0, -1};
+    struct iovec parts[2] = {{&header, sizeof(PageHeader)},
+                             {this->cells.data(), this->cells.size() * sizeof(int)}};
+    if (!diskManager.writePage(this->tableName, this->pageIndex, parts, 2))
+        LOG_ERROR("Page::writeBinaryPage: Err");
+}
+
+/**
+ * @brief Writes the PageHeader followed by every column in the encoding the
+ * PageCodec finds smallest for it.
+ */
+void Page::writeCompressedPage() {
+    LOG_TRACE("Page::writeCompressedPage");
+    PageHeader header{PAGE_MAGIC, this->rowCount, this->columnCount, this->layout, 1, -1};
+    vector<char> payload;
+    this->encodings.assign(this->columnCount, ColumnEncoding());
+    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
+        ColumnView column = this->getColumnView(columnCounter);
+        this->encodings[columnCounter] = PageCodec::chooseEncoding(column.data, column.size(), column.stride);
+        PageCodec::encode(column.data, column.size(), column.stride, this->encodings[columnCounter], payload);
+    }
+    struct iovec parts[2] = {{&header, sizeof(PageHeader)},
+                             {payload.data(), payload.size()}};
+    if (!diskManager.writePage(this->tableName, this->pageIndex, parts, 2))
+        LOG_ERROR("Page::writeCompressedPage: Err");
+}
+
+/**
+ * @brief Writes the page as whitespace separated text, one row per line.
+ */
+void Page::writeTextPage() {
+    LOG_TRACE("Page::writeTextPage");
     ofstream fout(this->pageName, ios::trunc);
     for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++) {
         for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
             if (columnCounter != 0)
                 fout << " ";
-            fout << this->rows[rowCounter][columnCounter];
+            fout << this->cells[this->cellIndex(rowCounter, columnCounter)];
         }
         fout << endl;
     }
     fout.close();
-    this->dirty = 0;
 }
 
 /**
- * @brief transposes the submatrix stored in the page
+ * @brief Swaps the submatrix stored in the page with the transpose of the
+ * mirrored submatrix p (see transposeTiles)
  */
 void Page::transpose(Page *p) {
-    for (int i = 0; i < this->rowCount; i++) {
-        for (int j = 0; j < this->columnCount; j++) {
-            swap(this->rows[i][j], p->rows[j][i]);
-        }
-    }
+    transposeTiles(this->cells.data(), this->rowCount, this->columnCount, p->cells.data());
     this->dirty = 1, p->dirty = 1;
 }
 
@@ -142,11 +568,7 @@ void Page::transpose(Page *p) {
  * @brief Flips submatrix in place
  */
 void Page::transpose() {
-    for (int i = 0; i < this->rowCount; i++) {
-        for (int j = i + 1; j < this->columnCount; j++) {
-            swap(this->rows[i][j], this->rows[j][i]);
-        }
-    }
+    transposeTile(this->cells.data(), this->columnCount);
     this->dirty = 1;
 }
 
@@ -155,12 +577,7 @@ void Page::transpose() {
  * perform a transpose
  */
 void Page::subtractTranspose(Page *p) {
-    for (int i = 0; i < this->rowCount; i++) {
-        for (int j = 0; j < this->columnCount; j++) {
-            this->rows[i][j] -= p->rows[j][i];
-            p->rows[j][i] = -this->rows[i][j];
-        }
-    }
+    subtractTransposeTiles(this->cells.data(), this->rowCount, this->columnCount, p->cells.data());
     this->dirty = 1, p->dirty = 1;
 }
 
@@ -169,15 +586,25 @@ void Page::subtractTranspose(Page *p) {
  * the value to get the resultant.
  */
 void Page::subtractTranspose() {
-    for (int i = 0; i < this->rowCount; i++) {
-        for (int j = i; j < this->columnCount; j++) {
-            this->rows[i][j] -= this->rows[j][i];
-            this->rows[j][i] = -this->rows[i][j];
-        }
-    }
+    subtractTransposeTile(this->cells.data(), this->columnCount);
     this->dirty = 1;
 }
 
+/**
+ * @brief Adds rows [firstRow, lastRow) of the product of the tiles first and
+ * second to this tile. Threads may fill disjoint row ranges of one tile
+ * concurrently, so the page isn't marked dirty; the caller writes it.
+ *
+ * @param first
+ * @param second
+ * @param firstRow
+ * @param lastRow
+ */
+void Page::multiplyAccumulate(Page *first, Page *second, int firstRow, int lastRow) {
+    multiplyTiles(first->cells.data(), second->cells.data(), this->cells.data(), first->columnCount,
+                  this->columnCount, firstRow, lastRow);
+}
+
 /**
  * @brief returns if a page is Dirty or not (has been changed and needs to be
  * written to disk).
@@ -207,10 +634,8 @@ string Page::getTableName() {
  * @param newColumnCount
  */
 void Page::modifyPage(const vector<vector<int>> &newRows, int newRowCount, int newColumnCount) {
-    logger.log("Page::modifyPage");
-    columnCount = newColumnCount, rowCount = newRowCount;
-    rows.resize(rowCount);
-    for (int r = 0; r < rowCount; r++) rows[r] = newRows[r];
+    LOG_TRACE("Page::modifyPage");
+    this->setRows(newRows, newRowCount, newColumnCount);
     dirty = 1;
 }
 
@@ -221,3 +646,10 @@ void Page::modifyPage(const vector<vector<int>> &newRows, int newRowCount, int n
 void Page::setDeleted() {
     deleted = 1;
 }
+
+/**
+ * @brief Marks the page as changed, it is written out when evicted
+ */
+void Page::setDirty() {
+    dirty = 1;
+}
@@ -1,4 +1,5 @@
-#include"logger.h"
+#include"compression.h"
+#include"tileKernels.h"
 /**
  * @brief The Page object is the main memory representation of a physical page
  * (equivalent to a block). The page class and the page.h header file are at the
@@ -9,7 +10,83 @@
  * or Teams with justification and gaining approval from the TAs. 
  *</p>
  */
-enum datatype {TABLE, MATRIX};
+enum datatype {TABLE, MATRIX, INDEX_NODE};
+
+/**
+ * @brief On-disk encoding used when pages are written. BINARY pages hold a
+ * fixed PageHeader followed by the raw int32 payload in row-major order so a
+ * page can be read or written with a single syscall. TEXT pages hold one row
+ * per line of space separated integers and are kept around for debugging.
+ * Pages are always read back in whichever format they were written in.
+ */
+enum PageFormat {BINARY_PAGE, TEXT_PAGE};
+
+/**
+ * @brief Order in which the cells of a page are stored. NSM pages store the
+ * cells row after row, PAX pages store all values of a column next to each
+ * other so that scans over a few columns read dense arrays. DSM tables are
+ * column stores: every column is a relation of its own (a column chain, see
+ * Page::columnChainName) whose single column pages line up with the pages of
+ * the table. A DSM page in memory is laid out like a PAX page, and any subset
+ * of its columns can be read without touching the others.
+ */
+enum PageLayout {NSM, PAX, DSM};
+
+const uint32_t PAGE_MAGIC = 0x47424152; // "RABG"
+
+/**
+ * @brief Header of a binary page. In compressed pages the header is followed
+ * by the encoded columns (see PageCodec) instead of the raw cells. Sparse
+ * pages (matrix tiles with few non zero cells, see Page::writeTile) are
+ * followed by sparseCells (position, value) pairs; sparseCells is -1 in all
+ * other pages.
+ */
+struct PageHeader {
+    uint32_t magic;
+    int32_t rowCount;
+    int32_t columnCount;
+    int32_t layout;
+    int32_t compressed;
+    int32_t sparseCells;
+};
+
+/**
+ * @brief Non-owning strided view of a run of cells in a page, either a row or
+ * a column. The view points straight into the buffer pool frame holding the
+ * page, so it stays valid only while that page is pinned (for a Cursor: until
+ * the cursor moves on to another page).
+ */
+struct CellView {
+    const int *data = nullptr;
+    int length = 0;
+    int stride = 1;
+
+    struct iterator {
+        using iterator_category = forward_iterator_tag;
+        using value_type = int;
+        using difference_type = ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        const int *position;
+        int stride;
+
+        reference operator*() const { return *position; }
+        iterator& operator++() { position += stride; return *this; }
+        iterator operator++(int) { iterator old = *this; position += stride; return old; }
+        bool operator==(const iterator &other) const { return position == other.position; }
+        bool operator!=(const iterator &other) const { return position != other.position; }
+    };
+
+    bool empty() const { return length == 0; }
+    int size() const { return length; }
+    int operator[](int index) const { return data[index * stride]; }
+    iterator begin() const { return {data, stride}; }
+    iterator end() const { return {data + length * stride, stride}; }
+};
+typedef CellView RowView;
+typedef CellView ColumnView;
+
 class Page{
 
     string tableName;
@@ -18,25 +95,56 @@ class Page{
     int rowCount;
     int dirty = 0;
     int deleted = 0;
-    vector<vector<int>> rows;
+    PageLayout layout = NSM;
+    bool compressed = false;
+    bool stored = true;
+    vector<int> cells;
+    vector<ColumnEncoding> encodings;
+    vector<string> columnChains;
+
+    int cellIndex(int row, int col) const;
+    void setRows(const vector<vector<int>> &newRows, int newRowCount, int newColumnCount);
+    bool readBinaryPage();
+    bool readCompressedPage();
+    void readTextPage();
+    Page chainPage(int columnIndex);
+    void readColumnChains(const vector<int> &columnIndices);
+    void writeColumnChains();
+    void writeBinaryPage();
+    void writeCompressedPage();
+    void writeTextPage();
 
     public:
 
     string pageName = "";
     Page();
-    Page(string tableName, int pageIndex, datatype d);
-    Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount);
+    Page(string tableName, int pageIndex, datatype d, bool deferRead = false);
+    Page(string tableName, int pageIndex, int rowCount, int columnCount, PageLayout layout, bool compressed);
+    void readPage();
+    void readColumns(const vector<int> &columnIndices);
+    Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount, int colCount, PageLayout layout = NSM,
+         bool compressed = false);
     vector<int> getRow(int rowIndex);
+    RowView getRowView(int rowIndex);
+    ColumnView getColumnView(int columnIndex);
+    const ColumnEncoding* getColumnEncoding(int columnIndex);
+    int getRowCount();
+    int getBlockSpan();
+    vector<pair<string, int>> getBlocks();
     int getCell(int row, int col);
     void transpose(Page* p);
     void transpose();
     bool isDirty();
     bool isDeleted();
     void setDeleted();
+    void setDirty();
     void subtractTranspose(Page* p);
     void subtractTranspose();
+    void multiplyAccumulate(Page *first, Page *second, int firstRow, int lastRow);
     void setPageName(string newName);
     void writePage();
+    int writeTile();
     void modifyPage(const vector<vector<int>> &newRows, int newRowCount, int newColumnCount);
     string getTableName();
+    static string columnChainName(const string &tableName, int columnIndex);
 };
\ No newline at end of file
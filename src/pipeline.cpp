@@ -0,0 +1,198 @@
+#include "global.h"
+
+/**
+ * @brief Position of a column in the columns of an operator
+ */
+static int columnIndexIn(const vector<string> &columns, const string &columnName)
+{
+    return find(columns.begin(), columns.end(), columnName) - columns.begin();
+}
+
+ScanOperator::ScanOperator(Table *table, const ParsedQuery *pageFilter)
+{
+    LOG_TRACE("ScanOperator::ScanOperator");
+    this->table = table;
+    this->pageFilter = pageFilter;
+    this->columns = table->columns;
+}
+
+void ScanOperator::open()
+{
+    LOG_TRACE("ScanOperator::open");
+    this->pageIndex = 0;
+    if (this->table->blockCount)
+        this->cursor = this->table->getCursor();
+}
+
+bool ScanOperator::next(RowBatch &batch)
+{
+    LOG_TRACE("ScanOperator::next");
+    while (this->pageFilter && this->pageIndex < this->table->blockCount
+           && evaluateOnZoneMap(*this->table, this->pageIndex, *this->pageFilter) == 0)
+        this->pageIndex++;
+    if (this->pageIndex >= this->table->blockCount)
+        return false;
+    if (this->pageIndex != this->cursor.pageIndex)
+        this->cursor.nextPage(this->pageIndex);
+    batch.columnCount = this->table->columnCount;
+    batch.rowCount = this->table->rowsPerBlockCount[this->pageIndex];
+    batch.values.resize((size_t) batch.rowCount * batch.columnCount);
+    auto position = batch.values.begin();
+    for (uint rowCounter = 0; rowCounter < batch.rowCount; rowCounter++)
+    {
+        RowView row = this->cursor.page->getRowView(rowCounter);
+        position = copy(row.begin(), row.end(), position);
+    }
+    this->pageIndex++;
+    return true;
+}
+
+void ScanOperator::close()
+{
+    LOG_TRACE("ScanOperator::close");
+    this->cursor = Cursor();
+}
+
+SelectOperator::SelectOperator(Operator *input, const ParsedQuery &query)
+{
+    LOG_TRACE("SelectOperator::SelectOperator");
+    this->input = input;
+    this->columns = input->columns;
+    this->firstColumnIndex = columnIndexIn(this->columns, query.selectionFirstColumnName);
+    this->literal = query.selectType == INT_LITERAL;
+    this->secondColumnIndex = this->literal ? this->firstColumnIndex
+                                            : columnIndexIn(this->columns, query.selectionSecondColumnName);
+    this->intLiteral = query.selectionIntLiteral;
+    this->binaryOperator = query.selectionBinaryOperator;
+}
+
+SelectOperator::~SelectOperator()
+{
+    delete this->input;
+}
+
+void SelectOperator::open()
+{
+    LOG_TRACE("SelectOperator::open");
+    this->input->open();
+}
+
+bool SelectOperator::next(RowBatch &batch)
+{
+    LOG_TRACE("SelectOperator::next");
+    while (this->input->next(this->inputBatch))
+    {
+        this->selection.resize(max(this->selection.size(), (size_t) this->inputBatch.rowCount));
+        ColumnView firstColumn = this->inputBatch.column(this->firstColumnIndex);
+        uint selected;
+        if (this->literal)
+            selected = selectRows(firstColumn, this->intLiteral, this->binaryOperator, this->selection.data());
+        else
+            selected = selectRows(firstColumn, this->inputBatch.column(this->secondColumnIndex), this->binaryOperator,
+                                  this->selection.data());
+        if (!selected)
+            continue;
+        batch.columnCount = this->inputBatch.columnCount;
+        batch.rowCount = selected;
+        batch.values.resize((size_t) selected * batch.columnCount);
+        auto position = batch.values.begin();
+        for (uint match = 0; match < selected; match++)
+        {
+            RowView row = this->inputBatch.row(this->selection[match]);
+            position = copy(row.begin(), row.end(), position);
+        }
+        return true;
+    }
+    return false;
+}
+
+void SelectOperator::close()
+{
+    LOG_TRACE("SelectOperator::close");
+    this->input->close();
+}
+
+ProjectOperator::ProjectOperator(Operator *input, const ParsedQuery &query)
+{
+    LOG_TRACE("ProjectOperator::ProjectOperator");
+    this->input = input;
+    this->columns = query.projectionColumnList;
+    for (const string &columnName : query.projectionColumnList)
+        this->columnIndices.push_back(columnIndexIn(input->columns, columnName));
+}
+
+ProjectOperator::~ProjectOperator()
+{
+    delete this->input;
+}
+
+void ProjectOperator::open()
+{
+    LOG_TRACE("ProjectOperator::open");
+    this->input->open();
+}
+
+bool ProjectOperator::next(RowBatch &batch)
+{
+    LOG_TRACE("ProjectOperator::next");
+    if (!this->input->next(this->inputBatch))
+        return false;
+    batch.columnCount = this->columnIndices.size();
+    batch.rowCount = this->inputBatch.rowCount;
+    batch.values.resize((size_t) batch.rowCount * batch.columnCount);
+    auto position = batch.values.begin();
+    for (uint rowCounter = 0; rowCounter < batch.rowCount; rowCounter++)
+    {
+        RowView row = this->inputBatch.row(rowCounter);
+        for (int columnIndex : this->columnIndices)
+            *position++ = row[columnIndex];
+    }
+    return true;
+}
+
+void ProjectOperator::close()
+{
+    LOG_TRACE("ProjectOperator::close");
+    this->input->close();
+}
+
+/**
+ * @brief Builds the pipeline that scans the table and applies the stages
+ * (SELECTION and PROJECTION queries) in order, each stage reading the result
+ * of the previous one.
+ *
+ * @param table
+ * @param stages
+ * @return Operator* the last operator of the pipeline, owned by the caller
+ */
+Operator *buildPipeline(Table *table, const vector<ParsedQuery> &stages)
+{
+    LOG_TRACE("buildPipeline");
+    Operator *root = new ScanOperator(table, !stages.empty() && stages[0].queryType == SELECTION ? &stages[0] : nullptr);
+    for (const ParsedQuery &stage : stages)
+    {
+        if (stage.queryType == SELECTION)
+            root = new SelectOperator(root, stage);
+        else
+            root = new ProjectOperator(root, stage);
+    }
+    return root;
+}
+
+/**
+ * @brief Runs a pipeline to completion, handing every row of its result to
+ * the builder
+ *
+ * @param root
+ * @param builder
+ */
+void materialize(Operator *root, TableBuilder &builder)
+{
+    LOG_TRACE("materialize");
+    RowBatch batch;
+    root->open();
+    while (root->next(batch))
+        for (uint rowCounter = 0; rowCounter < batch.rowCount; rowCounter++)
+            builder.addRow(batch.row(rowCounter));
+    root->close();
+}
@@ -0,0 +1,95 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/**
+ * @brief A batch of rows passed between operators, stored row after row in
+ * one flat array.
+ */
+struct RowBatch {
+    vector<int> values;
+    uint rowCount = 0;
+    uint columnCount = 0;
+
+    RowView row(uint rowIndex) const { return {values.data() + (size_t) rowIndex * columnCount, (int) columnCount, 1}; }
+    ColumnView column(uint columnIndex) const { return {values.data() + columnIndex, (int) rowCount, (int) columnCount}; }
+};
+
+/**
+ * @brief An operator of a pipeline. It follows the iterator model a batch at
+ * a time: open prepares the operator (and its input), every call to next
+ * fills the batch with the next rows of the result and close releases what
+ * the operator holds. Batches are never empty; next returns false once the
+ * result is exhausted.
+ *
+ * An operator owns its input operator.
+ */
+class Operator {
+public:
+    vector<string> columns;
+
+    virtual ~Operator() = default;
+    virtual void open() = 0;
+    virtual bool next(RowBatch &batch) = 0;
+    virtual void close() = 0;
+};
+
+/**
+ * @brief Reads a table a page at a time, every page being one batch. Given
+ * the SELECTION right above it, the scan skips the pages whose zone maps rule
+ * its predicate out.
+ */
+class ScanOperator : public Operator {
+    Table *table;
+    const ParsedQuery *pageFilter;
+    Cursor cursor;
+    uint pageIndex = 0;
+
+public:
+    explicit ScanOperator(Table *table, const ParsedQuery *pageFilter = nullptr);
+    void open() override;
+    bool next(RowBatch &batch) override;
+    void close() override;
+};
+
+/**
+ * @brief Keeps the rows of its input that satisfy "column bin_op column" or
+ * "column bin_op literal", evaluated with the batch predicate kernels
+ */
+class SelectOperator : public Operator {
+    Operator *input;
+    RowBatch inputBatch;
+    vector<uint> selection;
+    int firstColumnIndex;
+    int secondColumnIndex;
+    bool literal;
+    int intLiteral;
+    BinaryOperator binaryOperator;
+
+public:
+    SelectOperator(Operator *input, const ParsedQuery &query);
+    ~SelectOperator() override;
+    void open() override;
+    bool next(RowBatch &batch) override;
+    void close() override;
+};
+
+/**
+ * @brief Keeps the given columns of its input, in the given order
+ */
+class ProjectOperator : public Operator {
+    Operator *input;
+    RowBatch inputBatch;
+    vector<int> columnIndices;
+
+public:
+    ProjectOperator(Operator *input, const ParsedQuery &query);
+    ~ProjectOperator() override;
+    void open() override;
+    bool next(RowBatch &batch) override;
+    void close() override;
+};
+
+Operator *buildPipeline(Table *table, const vector<ParsedQuery> &stages);
+void materialize(Operator *root, TableBuilder &builder);
+
+#endif //PIPELINE_H
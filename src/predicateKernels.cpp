@@ -0,0 +1,164 @@
+#include "global.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PREDICATE_KERNELS_X86
+#endif
+
+namespace {
+
+/**
+ * @brief Compares first[i * firstStride] with second[i * secondStride] for i
+ * in [begin, count). A literal is a second "column" with stride 0. The
+ * position is always stored and the count only advances on a match, so
+ * there is no branch on the outcome.
+ */
+template <BinaryOperator binaryOperator>
+uint selectScalar(const int *first, int firstStride, const int *second, int secondStride, uint begin, uint count,
+                  uint *selection, uint selected)
+{
+    for (uint row = begin; row < count; row++)
+    {
+        selection[selected] = row;
+        selected += compare<binaryOperator>(first[(size_t) row * firstStride], second[(size_t) row * secondStride]);
+    }
+    return selected;
+}
+
+/**
+ * @brief Appends the positions of the set bits of a comparison mask
+ */
+inline uint appendMatches(uint mask, uint base, uint *selection, uint selected)
+{
+    while (mask)
+    {
+        selection[selected++] = base + __builtin_ctz(mask);
+        mask &= mask - 1;
+    }
+    return selected;
+}
+
+#ifdef PREDICATE_KERNELS_X86
+/**
+ * @brief Lane mask of "first op second". Only <, > and == exist as
+ * instructions; <=, >= and != are the complements of >, < and ==.
+ */
+template <BinaryOperator binaryOperator>
+inline uint compareMask(__m128i first, __m128i second)
+{
+    __m128i result;
+    if (binaryOperator == LESS_THAN || binaryOperator == GEQ)
+        result = _mm_cmplt_epi32(first, second);
+    else if (binaryOperator == GREATER_THAN || binaryOperator == LEQ)
+        result = _mm_cmpgt_epi32(first, second);
+    else
+        result = _mm_cmpeq_epi32(first, second);
+    uint mask = _mm_movemask_ps(_mm_castsi128_ps(result));
+    if (binaryOperator == LEQ || binaryOperator == GEQ || binaryOperator == NOT_EQUAL)
+        mask ^= 0xF;
+    return mask;
+}
+
+template <BinaryOperator binaryOperator>
+uint selectSSE2(const int *first, const int *second, bool secondIsLiteral, uint count, uint *selection)
+{
+    uint selected = 0, row = 0;
+    __m128i literal = _mm_set1_epi32(secondIsLiteral ? *second : 0);
+    for (; row + 4 <= count; row += 4)
+    {
+        __m128i values1 = _mm_loadu_si128((const __m128i *) (first + row));
+        __m128i values2 = secondIsLiteral ? literal : _mm_loadu_si128((const __m128i *) (second + row));
+        selected = appendMatches(compareMask<binaryOperator>(values1, values2), row, selection, selected);
+    }
+    return selectScalar<binaryOperator>(first, 1, second, !secondIsLiteral, row, count, selection, selected);
+}
+
+template <BinaryOperator binaryOperator>
+__attribute__((target("avx2"))) inline uint compareMask(__m256i first, __m256i second)
+{
+    __m256i result;
+    if (binaryOperator == LESS_THAN || binaryOperator == GEQ)
+        result = _mm256_cmpgt_epi32(second, first);
+    else if (binaryOperator == GREATER_THAN || binaryOperator == LEQ)
+        result = _mm256_cmpgt_epi32(first, second);
+    else
+        result = _mm256_cmpeq_epi32(first, second);
+    uint mask = _mm256_movemask_ps(_mm256_castsi256_ps(result));
+    if (binaryOperator == LEQ || binaryOperator == GEQ || binaryOperator == NOT_EQUAL)
+        mask ^= 0xFF;
+    return mask;
+}
+
+template <BinaryOperator binaryOperator>
+__attribute__((target("avx2"))) uint selectAVX2(const int *first, const int *second, bool secondIsLiteral, uint count,
+                                                 uint *selection)
+{
+    uint selected = 0, row = 0;
+    __m256i literal = _mm256_set1_epi32(secondIsLiteral ? *second : 0);
+    for (; row + 8 <= count; row += 8)
+    {
+        __m256i values1 = _mm256_loadu_si256((const __m256i *) (first + row));
+        __m256i values2 = secondIsLiteral ? literal : _mm256_loadu_si256((const __m256i *) (second + row));
+        selected = appendMatches(compareMask<binaryOperator>(values1, values2), row, selection, selected);
+    }
+    return selectScalar<binaryOperator>(first, 1, second, !secondIsLiteral, row, count, selection, selected);
+}
+
+const bool hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+template <BinaryOperator binaryOperator>
+uint selectWith(const int *first, int firstStride, const int *second, int secondStride, uint count, uint *selection)
+{
+#ifdef PREDICATE_KERNELS_X86
+    if (firstStride == 1 && secondStride <= 1)
+    {
+        if (hasAVX2)
+            return selectAVX2<binaryOperator>(first, second, secondStride == 0, count, selection);
+        return selectSSE2<binaryOperator>(first, second, secondStride == 0, count, selection);
+    }
+#endif
+    return selectScalar<binaryOperator>(first, firstStride, second, secondStride, 0, count, selection, 0);
+}
+
+uint select(const int *first, int firstStride, const int *second, int secondStride, uint count,
+            BinaryOperator binaryOperator, uint *selection)
+{
+    if (binaryOperator == NO_BINOP_CLAUSE)
+        return 0;
+    return withBinaryOperator(binaryOperator, [&](auto binaryOperator) {
+        return selectWith<binaryOperator>(first, firstStride, second, secondStride, count, selection);
+    });
+}
+
+}
+
+/**
+ * @brief Selects the rows with "column bin_op literal"
+ *
+ * @param column
+ * @param literal
+ * @param binaryOperator
+ * @param selection receives the positions of the matching rows
+ * @return uint number of matching rows
+ */
+uint selectRows(ColumnView column, int literal, BinaryOperator binaryOperator, uint *selection)
+{
+    LOG_TRACE("selectRows");
+    return select(column.data, column.stride, &literal, 0, column.size(), binaryOperator, selection);
+}
+
+/**
+ * @brief Selects the rows with "firstColumn bin_op secondColumn"
+ *
+ * @param firstColumn
+ * @param secondColumn
+ * @param binaryOperator
+ * @param selection receives the positions of the matching rows
+ * @return uint number of matching rows
+ */
+uint selectRows(ColumnView firstColumn, ColumnView secondColumn, BinaryOperator binaryOperator, uint *selection)
+{
+    LOG_TRACE("selectRows");
+    return select(firstColumn.data, firstColumn.stride, secondColumn.data, secondColumn.stride, firstColumn.size(),
+                  binaryOperator, selection);
+}
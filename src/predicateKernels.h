@@ -0,0 +1,18 @@
+#ifndef PREDICATE_KERNELS_H
+#define PREDICATE_KERNELS_H
+
+/**
+ * @brief Batch predicate kernels. A kernel compares a whole column of a page
+ * (a batch of rows) against a literal or against another column and writes
+ * the positions of the matching rows, in increasing order, into a selection
+ * vector that must have room for column.size() entries.
+ *
+ * The operator is resolved once per batch rather than once per row. When the
+ * compared columns are contiguous (PAX pages) the comparison runs on SIMD
+ * registers: AVX2 if the processor has it, SSE2 otherwise. Strided columns
+ * (NSM pages) and other processors use a branch free scalar loop.
+ */
+uint selectRows(ColumnView column, int literal, BinaryOperator binaryOperator, uint *selection);
+uint selectRows(ColumnView firstColumn, ColumnView secondColumn, BinaryOperator binaryOperator, uint *selection);
+
+#endif //PREDICATE_KERNELS_H
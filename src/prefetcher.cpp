@@ -0,0 +1,197 @@
+#include "global.h"
+
+/**
+ * @brief Stops the I/O thread. Pages still in the reserve are dropped, they
+ * were never modified.
+ */
+Prefetcher::~Prefetcher() {
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    if (this->worker.joinable())
+        this->worker.join();
+}
+
+/**
+ * @brief Body of the I/O thread. Whatever is queued is read as one batch: the
+ * blocks of all its pages go to the disk manager together (see
+ * DiskManager::readAhead), and a page is decoded and handed out as soon as
+ * its last block has arrived, in the order the reads complete.
+ */
+void Prefetcher::run() {
+    unique_lock<mutex> guard(this->lock);
+    while (true) {
+        this->changed.wait(guard, [this] { return this->stopping || !this->queue.empty(); });
+        if (this->stopping)
+            return;
+        vector<Slot*> batch(this->queue.begin(), this->queue.end());
+        this->queue.clear();
+        for (Slot *slot: batch)
+            slot->state = READING;
+        guard.unlock();
+
+        // Block i belongs to batch[owners[i]], which waits for missing[..]
+        // more blocks
+        vector<pair<string, int>> blocks;
+        vector<size_t> owners, missing(batch.size(), 0);
+        for (size_t slotCounter = 0; slotCounter < batch.size(); slotCounter++)
+            for (auto &block: batch[slotCounter]->page.getBlocks()) {
+                blocks.push_back(block);
+                owners.push_back(slotCounter);
+                missing[slotCounter]++;
+            }
+        auto finish = [&](size_t slotCounter) {
+            batch[slotCounter]->page.readPage();
+            lock_guard<mutex> readGuard(this->lock);
+            batch[slotCounter]->state = READY;
+            this->changed.notify_all();
+        };
+        for (size_t slotCounter = 0; slotCounter < batch.size(); slotCounter++)
+            if (!missing[slotCounter])
+                finish(slotCounter);
+        diskManager.readAhead(blocks, [&](size_t block) {
+            if (--missing[owners[block]] == 0)
+                finish(owners[block]);
+        });
+        diskManager.endReadAhead();
+        guard.lock();
+    }
+}
+
+/**
+ * @brief Removes the slot of a page from the reserve. A queued slot is taken
+ * off the queue, a slot that is being read is waited for first (another
+ * thread may remove it meanwhile).
+ *
+ * @param pageName
+ * @param guard must hold the lock
+ */
+void Prefetcher::erase(string pageName, unique_lock<mutex> &guard) {
+    auto it = this->slots.end();
+    this->changed.wait(guard, [&] {
+        it = this->slots.find(pageName);
+        return it == this->slots.end() || it->second.state != READING;
+    });
+    if (it == this->slots.end())
+        return;
+    if (it->second.state == QUEUED)
+        this->queue.erase(find(this->queue.begin(), this->queue.end(), &it->second));
+    this->arrivalOrder.erase(find(this->arrivalOrder.begin(), this->arrivalOrder.end(), pageName));
+    this->slots.erase(it);
+}
+
+/**
+ * @brief Frees the frame of the oldest page that has been read but not asked
+ * for yet.
+ *
+ * @param guard must hold the lock
+ * @return true if a frame was freed
+ */
+bool Prefetcher::dropOldestReady(unique_lock<mutex> &guard) {
+    for (auto &pageName: this->arrivalOrder) {
+        auto it = this->slots.find(pageName);
+        if (it->second.state == READY) {
+            LOG_TRACE("Prefetcher::dropOldestReady");
+            this->erase(pageName, guard);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Checks if a page is in the reserve or queued to be read
+ *
+ * @param pageName
+ * @return true
+ * @return false
+ */
+bool Prefetcher::contains(const string &pageName) {
+    lock_guard<mutex> guard(this->lock);
+    return this->slots.count(pageName);
+}
+
+/**
+ * @brief Queues a page to be read by the I/O thread. The page must have been
+ * constructed with deferRead set. The request is ignored if every reserved
+ * frame holds a page that is still being read.
+ *
+ * @param page
+ */
+void Prefetcher::request(Page page) {
+    LOG_TRACE("Prefetcher::request");
+    unique_lock<mutex> guard(this->lock);
+    if (this->slots.count(page.pageName))
+        return;
+    if (this->slots.size() >= PREFETCH_FRAMES && !this->dropOldestReady(guard))
+        return;
+    string pageName = page.pageName;
+    Slot &slot = this->slots[pageName];
+    slot.page = std::move(page);
+    this->arrivalOrder.push_back(pageName);
+    this->queue.push_back(&slot);
+    if (!this->worker.joinable())
+        this->worker = thread(&Prefetcher::run, this);
+    guard.unlock();
+    this->changed.notify_all();
+}
+
+/**
+ * @brief Moves a prefetched page into frame, waiting for the read to finish
+ * if it is in progress.
+ *
+ * @param pageName
+ * @param frame
+ * @return true if the page was moved into frame
+ * @return false if the page has to be read by the caller
+ */
+bool Prefetcher::take(const string &pageName, Page &frame) {
+    unique_lock<mutex> guard(this->lock);
+    auto it = this->slots.find(pageName);
+    if (it == this->slots.end())
+        return false;
+    if (it->second.state == QUEUED) {
+        LOG_DEBUG("Prefetcher::take: not started");
+        this->erase(pageName, guard);
+        return false;
+    }
+    // Another thread may take the page meanwhile
+    this->changed.wait(guard, [&] {
+        it = this->slots.find(pageName);
+        return it == this->slots.end() || it->second.state == READY;
+    });
+    if (it == this->slots.end())
+        return false;
+    LOG_TRACE("Prefetcher::take");
+    frame = std::move(it->second.page);
+    this->erase(pageName, guard);
+    return true;
+}
+
+/**
+ * @brief Drops a page from the reserve. Called before the page file is
+ * written, renamed or deleted so the reserve never holds stale contents.
+ *
+ * @param pageName
+ */
+void Prefetcher::discard(const string &pageName) {
+    unique_lock<mutex> guard(this->lock);
+    this->erase(pageName, guard);
+}
+
+/**
+ * @brief Drops every page of a table from the reserve
+ *
+ * @param tableName
+ */
+void Prefetcher::discardTable(const string &tableName) {
+    unique_lock<mutex> guard(this->lock);
+    vector<string> pageNames;
+    for (auto &[pageName, slot]: this->slots)
+        if (slot.page.getTableName() == tableName)
+            pageNames.emplace_back(pageName);
+    for (auto &pageName: pageNames)
+        this->erase(pageName, guard);
+}
@@ -0,0 +1,47 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+#include"page.h"
+
+/**
+ * @brief The Prefetcher reads pages ahead of sequential scans on a background
+ * I/O thread, all pages requested meanwhile in one batch. Prefetched pages
+ * are kept in a reserve of PREFETCH_FRAMES frames that sits next to the
+ * buffer pool, so read-ahead never evicts pages the executors are working
+ * with. When a cursor asks for a page the buffer
+ * manager moves it out of the reserve into the pool instead of reading it.
+ *
+ * A request that has not been picked up by the thread yet is simply dropped
+ * when its page is needed (the caller reads it itself), and a page that is
+ * being read is waited for. Once the reserve is full the oldest page that
+ * nobody asked for is discarded to make room.
+ */
+class Prefetcher{
+
+    enum SlotState {QUEUED, READING, READY};
+    struct Slot {
+        Page page;
+        SlotState state = QUEUED;
+    };
+
+    unordered_map<string, Slot> slots;
+    deque<string> arrivalOrder;
+    deque<Slot*> queue;
+    mutex lock;
+    condition_variable changed;
+    thread worker;
+    bool stopping = false;
+
+    void run();
+    void erase(string pageName, unique_lock<mutex> &guard);
+    bool dropOldestReady(unique_lock<mutex> &guard);
+
+    public:
+
+    ~Prefetcher();
+    bool contains(const string &pageName);
+    void request(Page page);
+    bool take(const string &pageName, Page &frame);
+    void discard(const string &pageName);
+    void discardTable(const string &tableName);
+};
+#endif //PREFETCHER_H
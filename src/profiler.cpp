@@ -0,0 +1,205 @@
+#include "global.h"
+
+static double milliseconds(clockid_t clock)
+{
+    timespec time;
+    clock_gettime(clock, &time);
+    return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+ProfileCounters ProfileCounters::now()
+{
+    ProfileCounters counters;
+    counters.wallMs = milliseconds(CLOCK_MONOTONIC);
+    counters.cpuMs = milliseconds(CLOCK_PROCESS_CPUTIME_ID);
+    counters.blocksRead = blockStats.blocksRead;
+    counters.blocksWritten = blockStats.blocksWritten;
+    counters.bytesWritten = blockStats.bytesWritten;
+    counters.poolHits = blockStats.poolHits;
+    counters.poolMisses = blockStats.poolMisses;
+    return counters;
+}
+
+ProfileCounters ProfileCounters::operator-(const ProfileCounters &start) const
+{
+    ProfileCounters difference;
+    difference.wallMs = this->wallMs - start.wallMs;
+    difference.cpuMs = this->cpuMs - start.cpuMs;
+    difference.blocksRead = this->blocksRead - start.blocksRead;
+    difference.blocksWritten = this->blocksWritten - start.blocksWritten;
+    difference.bytesWritten = this->bytesWritten - start.bytesWritten;
+    difference.poolHits = this->poolHits - start.poolHits;
+    difference.poolMisses = this->poolMisses - start.poolMisses;
+    return difference;
+}
+
+/**
+ * @brief Throws away the operators of the last statement and opens the
+ * operator standing for the whole statement
+ *
+ * @param statement name of the statement, e.g. JOIN
+ */
+void Profiler::start(const string &statement)
+{
+    this->operators.clear();
+    this->open.clear();
+    this->enabled = true;
+    this->begin(statement, false);
+}
+
+/**
+ * @brief Closes every operator still open, the statement last, and turns
+ * the profiler off
+ *
+ * @param rowsIn rows of the relations the statement read
+ * @param rowsOut rows of the relation it produced
+ */
+void Profiler::finish(long long rowsIn, long long rowsOut)
+{
+    this->setRows(0, rowsIn, rowsOut);
+    while (!this->open.empty())
+        this->end(this->open.back());
+    this->enabled = false;
+}
+
+/**
+ * @brief Opens an operator, nested in the innermost one open
+ *
+ * @return int id to close the operator with
+ */
+int Profiler::begin(const string &name, bool spills)
+{
+    OperatorProfile profile;
+    profile.name = name;
+    profile.depth = this->open.size();
+    profile.spills = spills;
+    profile.start = ProfileCounters::now();
+    this->operators.push_back(profile);
+    this->open.push_back(this->operators.size() - 1);
+    return this->operators.size() - 1;
+}
+
+/**
+ * @brief Closes an operator along with the ones opened inside it that are
+ * still open
+ *
+ * @param id
+ */
+void Profiler::end(int id)
+{
+    ProfileCounters now = ProfileCounters::now();
+    while (!this->open.empty() && this->open.back() >= id) {
+        OperatorProfile &profile = this->operators[this->open.back()];
+        profile.counters = now - profile.start;
+        this->open.pop_back();
+        if (!profile.spills)
+            continue;
+        profile.bytesSpilled = profile.counters.bytesWritten;
+        // A spilling phase also spills for the operators it is part of,
+        // unless one of those spills itself and so counts it already
+        bool counted = false;
+        for (int outer: this->open)
+            counted |= this->operators[outer].spills;
+        if (!counted)
+            for (int outer: this->open)
+                this->operators[outer].bytesSpilled += profile.bytesSpilled;
+    }
+}
+
+void Profiler::setRows(int id, long long rowsIn, long long rowsOut)
+{
+    if (id < 0 || id >= (int) this->operators.size())
+        return;
+    this->operators[id].rowsIn = rowsIn;
+    this->operators[id].rowsOut = rowsOut;
+}
+
+/**
+ * @brief Counts a pass over the data (the run generation or a merge pass of
+ * an external sort) for every operator open
+ */
+void Profiler::countPass()
+{
+    if (!this->enabled)
+        return;
+    for (int id: this->open)
+        this->operators[id].passes++;
+}
+
+/**
+ * @brief Prints every operator on a line, phases indented under the
+ * operators they belong to
+ */
+void Profiler::print(ostream &stream) const
+{
+    // Formatted on the side, as the flags of cout are shared by the sessions
+    ostringstream out;
+    out << fixed << setprecision(3);
+    for (const OperatorProfile &profile: this->operators) {
+        const ProfileCounters &counters = profile.counters;
+        long long accesses = counters.poolHits + counters.poolMisses;
+        out << string(2 * profile.depth, ' ') << profile.name << ": rows " << profile.rowsIn << " -> " << profile.rowsOut
+            << ", wall " << counters.wallMs << " ms, cpu " << counters.cpuMs << " ms, blocks read "
+            << counters.blocksRead << ", blocks written " << counters.blocksWritten << ", pool hits "
+            << counters.poolHits << "/" << accesses;
+        if (accesses)
+            out << " (" << setprecision(1) << 100.0 * counters.poolHits / accesses << "%)" << setprecision(3);
+        out << ", spilled " << profile.bytesSpilled << " bytes, passes " << profile.passes << endl;
+    }
+    stream << out.str();
+}
+
+static void writeJsonString(ostream &out, const string &text)
+{
+    out << '"';
+    for (char character: text) {
+        if (character == '"' || character == '\\')
+            out << '\\' << character;
+        else if ((unsigned char) character < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << (int) character << dec << setfill(' ');
+        else
+            out << character;
+    }
+    out << '"';
+}
+
+/**
+ * @brief Writes the operators of the statement as one line of JSON:
+ * {"statement": ..., "operators": [{"name": ..., "depth": ..., ...}, ...]}
+ */
+void Profiler::writeJson(ostream &out, const string &statement) const
+{
+    out << "{\"statement\":";
+    writeJsonString(out, statement);
+    out << ",\"operators\":[";
+    for (size_t id = 0; id < this->operators.size(); id++) {
+        const OperatorProfile &profile = this->operators[id];
+        const ProfileCounters &counters = profile.counters;
+        out << (id ? ",{" : "{") << "\"name\":";
+        writeJsonString(out, profile.name);
+        out << ",\"depth\":" << profile.depth << ",\"rowsIn\":" << profile.rowsIn << ",\"rowsOut\":" << profile.rowsOut
+            << ",\"wallMs\":" << counters.wallMs << ",\"cpuMs\":" << counters.cpuMs
+            << ",\"blocksRead\":" << counters.blocksRead << ",\"blocksWritten\":" << counters.blocksWritten
+            << ",\"poolHits\":" << counters.poolHits << ",\"poolMisses\":" << counters.poolMisses
+            << ",\"bytesSpilled\":" << profile.bytesSpilled << ",\"passes\":" << profile.passes << "}";
+    }
+    out << "]}" << endl;
+}
+
+ProfileScope::ProfileScope(const char *name, bool spills)
+{
+    if (profiler.enabled)
+        this->id = profiler.begin(name, spills);
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (this->id != -1)
+        profiler.end(this->id);
+}
+
+void ProfileScope::setRows(long long rowsIn, long long rowsOut)
+{
+    if (this->id != -1)
+        profiler.setRows(this->id, rowsIn, rowsOut);
+}
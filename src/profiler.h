@@ -0,0 +1,89 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/**
+ * @brief Counters of the server at one point in time: wall and CPU time (of
+ * all threads) in milliseconds and the block, byte and buffer pool counts of
+ * BlockStats. The counters of an operator are the difference between the
+ * snapshots taken when it starts and when it ends.
+ */
+struct ProfileCounters
+{
+    double wallMs = 0;
+    double cpuMs = 0;
+    long long blocksRead = 0;
+    long long blocksWritten = 0;
+    long long bytesWritten = 0;
+    long long poolHits = 0;
+    long long poolMisses = 0;
+
+    static ProfileCounters now();
+    ProfileCounters operator-(const ProfileCounters &start) const;
+};
+
+/**
+ * @brief What one operator (or phase of one) of a statement took. depth is
+ * 0 for the statement itself and grows by one with every phase nested in
+ * another. Bytes written while a spilling phase is open (runs of an external
+ * sort that needs merging, merge passes before the last one, hash partitions)
+ * count as spilled.
+ */
+struct OperatorProfile
+{
+    string name;
+    uint depth = 0;
+    bool spills = false;
+    long long rowsIn = 0;
+    long long rowsOut = 0;
+    long long passes = 0;
+    long long bytesSpilled = 0;
+    ProfileCounters start;
+    ProfileCounters counters;
+};
+
+/**
+ * @brief The Profiler records the operators of a statement while it runs.
+ * executeCommand starts it for statements run through EXPLAIN ANALYZE, and
+ * for every statement if STATS_FILE (see server.cpp) names a file to append
+ * the statistics to as a JSON line. Operators open their phases through
+ * ProfileScope, which costs nothing while the profiler is off. Phases are
+ * opened and closed on the thread running the statement; their counters
+ * include the work done for them on other threads. Every session has a
+ * profiler of its own; the block counts of BlockStats are server wide, so
+ * they include what statements of other sessions did meanwhile.
+ */
+class Profiler
+{
+    vector<OperatorProfile> operators;
+    vector<int> open;
+
+public:
+    bool enabled = false;
+
+    void start(const string &statement);
+    void finish(long long rowsIn, long long rowsOut);
+    int begin(const string &name, bool spills);
+    void end(int id);
+    void setRows(int id, long long rowsIn, long long rowsOut);
+    void countPass();
+    void print(ostream &out) const;
+    void writeJson(ostream &out, const string &statement) const;
+};
+
+extern thread_local Profiler profiler;
+
+/**
+ * @brief Profiles a phase of an operator from its construction to the end of
+ * its scope.
+ */
+class ProfileScope
+{
+    int id = -1;
+
+public:
+    explicit ProfileScope(const char *name, bool spills = false);
+    ~ProfileScope();
+    void setRows(long long rowsIn, long long rowsOut);
+};
+
+#endif //PROFILER_H
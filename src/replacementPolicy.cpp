@@ -0,0 +1,121 @@
+#include "global.h"
+
+/**
+ * @brief Factory that builds the policy object for the given strategy.
+ *
+ * @param strategy
+ * @return ReplacementPolicy*
+ */
+ReplacementPolicy* ReplacementPolicy::create(ReplacementStrategy strategy) {
+    switch (strategy) {
+        case FIFO: return new FIFOPolicy();
+        case CLOCK: return new ClockPolicy();
+        case LRU_K: return new LRUKPolicy(2);
+        case LRU:
+        default: return new LRUPolicy();
+    }
+}
+
+void FIFOPolicy::recordAccess(int frameId) {
+    if (this->position.count(frameId))
+        return;
+    this->queue.push_back(frameId);
+    this->position[frameId] = prev(this->queue.end());
+}
+
+void FIFOPolicy::remove(int frameId) {
+    auto it = this->position.find(frameId);
+    if (it == this->position.end())
+        return;
+    this->queue.erase(it->second);
+    this->position.erase(it);
+}
+
+int FIFOPolicy::pickVictim() {
+    if (this->queue.empty())
+        return -1;
+    return this->queue.front();
+}
+
+void LRUPolicy::recordAccess(int frameId) {
+    auto it = this->position.find(frameId);
+    if (it != this->position.end())
+        this->recency.erase(it->second);
+    this->recency.push_back(frameId);
+    this->position[frameId] = prev(this->recency.end());
+}
+
+void LRUPolicy::remove(int frameId) {
+    auto it = this->position.find(frameId);
+    if (it == this->position.end())
+        return;
+    this->recency.erase(it->second);
+    this->position.erase(it);
+}
+
+int LRUPolicy::pickVictim() {
+    if (this->recency.empty())
+        return -1;
+    return this->recency.front();
+}
+
+void ClockPolicy::recordAccess(int frameId) {
+    if (frameId >= this->inUse.size()) {
+        this->inUse.resize(frameId + 1, 0);
+        this->referenced.resize(frameId + 1, 0);
+    }
+    this->inUse[frameId] = 1;
+    this->referenced[frameId] = 1;
+}
+
+void ClockPolicy::remove(int frameId) {
+    if (frameId >= this->inUse.size())
+        return;
+    this->inUse[frameId] = 0;
+    this->referenced[frameId] = 0;
+}
+
+int ClockPolicy::pickVictim() {
+    int frames = this->inUse.size();
+    if (find(this->inUse.begin(), this->inUse.end(), 1) == this->inUse.end())
+        return -1;
+    // Two sweeps are always enough: the first one clears every reference bit
+    while (true) {
+        this->hand %= frames;
+        int frameId = this->hand++;
+        if (!this->inUse[frameId])
+            continue;
+        if (!this->referenced[frameId])
+            return frameId;
+        this->referenced[frameId] = 0;
+    }
+}
+
+void LRUKPolicy::recordAccess(int frameId) {
+    auto &accesses = this->history[frameId];
+    accesses.push_back(this->clock++);
+    if (accesses.size() > this->k)
+        accesses.pop_front();
+}
+
+void LRUKPolicy::remove(int frameId) {
+    this->history.erase(frameId);
+}
+
+int LRUKPolicy::pickVictim() {
+    int victim = -1;
+    bool victimFull = true;
+    long long victimTime = LLONG_MAX;
+    for (auto &[frameId, accesses]: this->history) {
+        // Frames with less than K accesses have an infinite backward K-distance
+        // and lose against any frame with a full history; ties go to LRU.
+        bool full = accesses.size() >= this->k;
+        long long time = full ? accesses.front() : accesses.back();
+        if ((victimFull && !full) || (full == victimFull && time < victimTime)) {
+            victim = frameId;
+            victimFull = full;
+            victimTime = time;
+        }
+    }
+    return victim;
+}
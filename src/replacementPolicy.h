@@ -0,0 +1,81 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+#include"logger.h"
+
+enum ReplacementStrategy {FIFO, LRU, CLOCK, LRU_K};
+
+/**
+ * @brief A ReplacementPolicy decides which frame of the buffer pool is evicted
+ * when a new page has to be brought in and the pool is full. The buffer
+ * manager reports every access to a frame through recordAccess and every frame
+ * it empties (or pins) through remove; pickVictim returns -1 when no frame
+ * can be replaced.
+ */
+class ReplacementPolicy{
+    public:
+    virtual ~ReplacementPolicy() = default;
+    virtual void recordAccess(int frameId) = 0;
+    virtual void remove(int frameId) = 0;
+    virtual int pickVictim() = 0;
+    static ReplacementPolicy* create(ReplacementStrategy strategy);
+};
+
+/**
+ * @brief Evicts the frame that was filled first. Accesses to a page that is
+ * already in the pool do not change its position.
+ */
+class FIFOPolicy : public ReplacementPolicy{
+    list<int> queue;
+    unordered_map<int, list<int>::iterator> position;
+
+    public:
+    void recordAccess(int frameId) override;
+    void remove(int frameId) override;
+    int pickVictim() override;
+};
+
+/**
+ * @brief Evicts the least recently used frame.
+ */
+class LRUPolicy : public ReplacementPolicy{
+    list<int> recency;
+    unordered_map<int, list<int>::iterator> position;
+
+    public:
+    void recordAccess(int frameId) override;
+    void remove(int frameId) override;
+    int pickVictim() override;
+};
+
+/**
+ * @brief Second chance approximation of LRU. Every frame has a reference bit
+ * that is set on access; the clock hand sweeps over the frames clearing bits
+ * and evicts the first frame whose bit is already clear.
+ */
+class ClockPolicy : public ReplacementPolicy{
+    vector<char> inUse, referenced;
+    int hand = 0;
+
+    public:
+    void recordAccess(int frameId) override;
+    void remove(int frameId) override;
+    int pickVictim() override;
+};
+
+/**
+ * @brief Evicts the frame whose K-th most recent access is the oldest. Frames
+ * with fewer than K accesses are evicted first (in LRU order), which keeps a
+ * single sequential scan from flushing pages that are reused.
+ */
+class LRUKPolicy : public ReplacementPolicy{
+    uint k;
+    long long clock = 0;
+    unordered_map<int, deque<long long>> history;
+
+    public:
+    explicit LRUKPolicy(uint k) : k(k) {}
+    void recordAccess(int frameId) override;
+    void remove(int frameId) override;
+    int pickVictim() override;
+};
+#endif //REPLACEMENT_POLICY_H
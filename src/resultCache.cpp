@@ -0,0 +1,211 @@
+#include "global.h"
+
+/**
+ * @brief Key of the parsed statement: its tokens after the result name and
+ * the versions of its inputs
+ *
+ * @param tokens
+ * @param inputs relations the statement reads
+ * @return string empty if the result of the statement can't be cached
+ */
+string ResultCache::keyFor(const vector<string> &tokens, const vector<string> &inputs) {
+    LOG_TRACE("ResultCache::keyFor");
+    if (!RESULT_CACHE_BLOCKS || parsedQuery.explain || tokens.size() < 3)
+        return "";
+    switch (parsedQuery.queryType) {
+        case CROSS: case DISTINCT: case GROUPBY: case JOIN: case PROJECTION: case SELECTION: case ORDERBY: break;
+        default: return "";
+    }
+    string key;
+    for (size_t position = 2; position < tokens.size(); position++)
+        key += tokens[position] + " ";
+    for (const string &input: inputs) {
+        unsigned long long version = tableCatalogue.getVersion(input);
+        if (!version)
+            return "";
+        key += "@" + to_string(version);
+    }
+    return key;
+}
+
+/**
+ * @brief Tells whether the inputs of the entry still have the versions its
+ * result was computed from
+ */
+bool ResultCache::isCurrent(const Entry &entry) {
+    for (auto &[relationName, version]: entry.inputs)
+        if (tableCatalogue.getVersion(relationName) != version)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Makes the result kept under key the relation resultName
+ *
+ * @param key
+ * @param resultName
+ * @return false if no result is kept under key
+ */
+bool ResultCache::reuse(const string &key, const string &resultName) {
+    LOG_TRACE("ResultCache::reuse");
+    lock_guard<mutex> guard(this->lock);
+    auto it = this->entries.find(key);
+    if (it == this->entries.end() || !it->second.keptTable)
+        return false;
+    Entry &entry = it->second;
+    Table *table = entry.keptTable;
+    this->keptKeys.erase(entry.keptPosition);
+    this->keptBlocks -= table->blockCount;
+    entry.keptTable = nullptr;
+
+    string keptName = table->tableName;
+    table->rename(resultName);
+    table->sourceFileName = "../data/temp/" + resultName + ".csv";
+    tableCatalogue.insertTable(table);
+    tableCatalogue.releaseName(keptName);
+    entry.holderName = resultName;
+    entry.holderVersion = tableCatalogue.getVersion(resultName);
+    this->keyOfHolder[resultName] = key;
+    LOG_INFO("ResultCache::reuse: " + resultName + " taken from " + keptName);
+    return true;
+}
+
+/**
+ * @brief Records that the statement with the given key just computed
+ * resultName
+ *
+ * @param key
+ * @param inputs
+ * @param resultName
+ */
+void ResultCache::remember(const string &key, const vector<string> &inputs, const string &resultName) {
+    LOG_TRACE("ResultCache::remember");
+    if (!tableCatalogue.isTable(resultName))
+        return;
+    lock_guard<mutex> guard(this->lock);
+    // Whatever was held under the name before is gone
+    auto previous = this->keyOfHolder.find(resultName);
+    if (previous != this->keyOfHolder.end() && previous->second != key)
+        this->erase(previous->second);
+    Entry &entry = this->entries[key];
+    if (entry.keptTable)
+        return;
+    if (!entry.holderName.empty())
+        this->keyOfHolder.erase(entry.holderName);
+    entry.inputs.clear();
+    for (const string &input: inputs)
+        entry.inputs.emplace_back(input, tableCatalogue.getVersion(input));
+    entry.holderName = resultName;
+    entry.holderVersion = tableCatalogue.getVersion(resultName);
+    this->keyOfHolder[resultName] = key;
+}
+
+/**
+ * @brief Called when relationName is cleared. If it holds a result that can
+ * still be reused, the cache takes the table over: it is removed from the
+ * catalogue and its pages are kept under a hidden name. Results computed
+ * from relationName are dropped.
+ *
+ * @param relationName
+ * @return true if the cache took the table over, false if it still has to be
+ * deleted
+ */
+bool ResultCache::release(const string &relationName) {
+    LOG_TRACE("ResultCache::release");
+    Table *table = tableCatalogue.getTable(relationName);
+    lock_guard<mutex> guard(this->lock);
+    this->eraseReaders(relationName);
+    auto holder = this->keyOfHolder.find(relationName);
+    if (!table || holder == this->keyOfHolder.end())
+        return false;
+    string key = holder->second;
+    this->keyOfHolder.erase(holder);
+    Entry &entry = this->entries[key];
+    bool keep = entry.holderVersion == tableCatalogue.getVersion(relationName) && this->isCurrent(entry) &&
+                !table->indexed && table->layout != DSM && table->blockCount <= RESULT_CACHE_BLOCKS;
+    if (!keep) {
+        this->erase(key);
+        return false;
+    }
+
+    string keptName = tableCatalogue.temporaryName("Temp_RESULT_");
+    tableCatalogue.takeTable(relationName);
+    table->rename(keptName);
+    table->sourceFileName = "../data/temp/" + keptName + ".csv";
+    entry.holderName = "";
+    entry.keptTable = table;
+    entry.keptPosition = this->keptKeys.insert(this->keptKeys.end(), key);
+    this->keptBlocks += table->blockCount;
+    this->evict(RESULT_CACHE_BLOCKS);
+    LOG_INFO("ResultCache::release: " + relationName + " kept as " + keptName);
+    return true;
+}
+
+/**
+ * @brief Drops the results computed from relationName and the one it holds,
+ * after it was changed in place
+ *
+ * @param relationName
+ */
+void ResultCache::forget(const string &relationName) {
+    LOG_TRACE("ResultCache::forget");
+    lock_guard<mutex> guard(this->lock);
+    this->eraseReaders(relationName);
+    auto holder = this->keyOfHolder.find(relationName);
+    if (holder != this->keyOfHolder.end())
+        this->erase(holder->second);
+}
+
+/**
+ * @brief Deletes kept results until they fit into RESULT_CACHE_BLOCKS
+ */
+void ResultCache::shrink() {
+    LOG_TRACE("ResultCache::shrink");
+    lock_guard<mutex> guard(this->lock);
+    this->evict(RESULT_CACHE_BLOCKS);
+}
+
+void ResultCache::eraseReaders(const string &relationName) {
+    vector<string> readers;
+    for (auto &[key, entry]: this->entries)
+        for (auto &input: entry.inputs)
+            if (input.first == relationName) {
+                readers.push_back(key);
+                break;
+            }
+    for (const string &key: readers)
+        this->erase(key);
+}
+
+/**
+ * @brief Forgets the entry, deleting its result if it is kept
+ *
+ * @param key
+ */
+void ResultCache::erase(string key) {
+    auto it = this->entries.find(key);
+    if (it == this->entries.end())
+        return;
+    Entry &entry = it->second;
+    if (entry.keptTable) {
+        this->keptKeys.erase(entry.keptPosition);
+        this->keptBlocks -= entry.keptTable->blockCount;
+        string keptName = entry.keptTable->tableName;
+        entry.keptTable->unload();
+        delete entry.keptTable;
+        tableCatalogue.releaseName(keptName);
+    }
+    auto holder = this->keyOfHolder.find(entry.holderName);
+    if (holder != this->keyOfHolder.end() && holder->second == key)
+        this->keyOfHolder.erase(holder);
+    this->entries.erase(it);
+}
+
+void ResultCache::evict(unsigned long long blockBudget) {
+    while (this->keptBlocks > blockBudget && !this->keptKeys.empty())
+        this->erase(string(this->keptKeys.front()));
+}
+
+ResultCache::~ResultCache() {
+    this->evict(0);
+}
@@ -0,0 +1,60 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+#include"logger.h"
+
+class Table;
+
+/**
+ * @brief The ResultCache lets an assignment (SELECT, PROJECT, JOIN, CROSS,
+ * DISTINCT, GROUP BY, ORDER BY) take over the result of an earlier run of the
+ * same statement instead of computing it again, as long as none of its
+ * inputs has changed since. Results are keyed by the statement without its
+ * result name and the versions its inputs had (see TableCatalogue::
+ * getVersion); a relation gets a new version whenever it is created or
+ * changed in place, so a key never matches a result computed from other data.
+ *
+ * A result stays with the relation it was assigned to until that relation is
+ * cleared. The cache then keeps its pages under a hidden name instead of
+ * deleting them, and the next run of the statement renames them to its
+ * result, without copying a page. Kept results take up at most
+ * RESULT_CACHE_BLOCKS blocks on disk; beyond that the least recently kept are
+ * deleted. Results that are indexed or in DSM layout, whose pages may be read
+ * by other tables, are deleted as usual.
+ */
+class ResultCache {
+
+    struct Entry {
+        vector<pair<string, unsigned long long>> inputs;
+        string holderName;
+        unsigned long long holderVersion = 0;
+        // Set while the result is kept after its holder was cleared
+        Table *keptTable = nullptr;
+        list<string>::iterator keptPosition;
+    };
+
+    mutex lock;
+    unordered_map<string, Entry> entries;
+    unordered_map<string, string> keyOfHolder;
+    // Keys of the kept results, least recently kept first
+    list<string> keptKeys;
+    unsigned long long keptBlocks = 0;
+
+    bool isCurrent(const Entry &entry);
+    void erase(string key);
+    void eraseReaders(const string &relationName);
+    void evict(unsigned long long blockBudget);
+
+    public:
+
+    string keyFor(const vector<string> &tokens, const vector<string> &inputs);
+    bool reuse(const string &key, const string &resultName);
+    void remember(const string &key, const vector<string> &inputs, const string &resultName);
+    bool release(const string &relationName);
+    void forget(const string &relationName);
+    void shrink();
+    ~ResultCache();
+};
+
+extern ResultCache resultCache;
+
+#endif //RESULT_CACHE_H
@@ -1,7 +1,7 @@
 #include"global.h"
 
 bool semanticParse(){
-    logger.log("semanticParse");
+    LOG_TRACE("semanticParse");
     switch(parsedQuery.queryType){
         case CLEAR: return semanticParseCLEAR();
         case CROSS: return semanticParseCROSS();
@@ -12,10 +12,12 @@ bool semanticParse(){
         case JOIN: return semanticParseJOIN();
         case LIST: return semanticParseLIST();
         case LOAD: return semanticParseLOAD();
+        case MULTIPLY: return semanticParseMULTIPLY();
         case PRINT: return semanticParsePRINT();
         case PROJECTION: return semanticParsePROJECTION();
         case RENAME: return semanticParseRENAME();
         case SELECTION: return semanticParseSELECTION();
+        case SET: return semanticParseSET();
         case SORT: return semanticParseSORT();
         case SOURCE: return semanticParseSOURCE();
         case SYMMETRY: return semanticParseSYMMETRY();
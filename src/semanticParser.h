@@ -11,10 +11,12 @@ bool semanticParseINDEX();
 bool semanticParseJOIN();
 bool semanticParseLIST();
 bool semanticParseLOAD();
+bool semanticParseMULTIPLY();
 bool semanticParsePRINT();
 bool semanticParsePROJECTION();
 bool semanticParseRENAME();
 bool semanticParseSELECTION();
+bool semanticParseSET();
 bool semanticParseSORT();
 bool semanticParseSOURCE();
 bool semanticParseSYMMETRY();
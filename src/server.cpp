@@ -6,60 +6,174 @@ using namespace std;
 float BLOCK_SIZE = 1;
 uint BLOCK_COUNT = 7;
 uint PRINT_COUNT = 20;
+uint PREFETCH_COUNT = 2;
+uint PREFETCH_FRAMES = 6;
+uint WRITE_BEHIND_PAGES = 16;
+// Threads of the ThreadPool, the statement's own included
+uint WORKER_THREADS = thread::hardware_concurrency();
+// Port clients connect to (see SessionServer); 0 reads statements from the
+// console instead
+uint SERVER_PORT = 0;
+uint SESSION_THREADS = 8;
+// Blocks of disk the results kept for reuse may take up (see ResultCache); 0
+// keeps none
+uint RESULT_CACHE_BLOCKS = 1000;
+PageFormat PAGE_FORMAT = BINARY_PAGE;
+StorageMode STORAGE_MODE = SEGMENT_FILES;
+// Page I/O (see IoBackend); io_uring falls back to POSIX I/O where the kernel
+// lacks it. Direct I/O bypasses the page cache for segment files. Both are
+// fixed once the server has started.
+IoBackendType IO_BACKEND = URING_IO;
+bool DIRECT_IO = false;
+ReplacementStrategy REPLACEMENT_STRATEGY = LRU;
+LogLevel LOG_LEVEL = LEVEL_INFO;
+// File every statement appends its operator statistics to as a line of JSON
+// (see Profiler::writeJson); nothing is recorded if empty
+string STATS_FILE = "";
 Logger logger;
-vector<string> tokenizedQuery;
-ParsedQuery parsedQuery;
-TableCatalogue tableCatalogue;
-BufferManager bufferManager;
+ThreadPool threadPool;
+thread_local vector<string> tokenizedQuery;
+thread_local ParsedQuery parsedQuery;
+// The disk and buffer managers must outlive the catalogue, whose destructor
+// unloads tables
 BlockStats blockStats;
+thread_local Profiler profiler;
+MemoryManager memoryManager;
+LockManager lockManager;
+DiskManager diskManager;
+BufferManager bufferManager;
+TableCatalogue tableCatalogue;
+// Unloads the results it keeps, so it goes before the catalogue
+ResultCache resultCache;
 
+/**
+ * @brief Parses and runs the statement in tokenizedQuery. The statement is
+ * checked and run holding the locks it needs, so that another session can't
+ * change its relations in between.
+ */
 void doCommand()
 {
-    logger.log("doCommand");
-    if (syntacticParse() && semanticParse())
+    LOG_TRACE("doCommand");
+    if (!syntacticParseCached())
+        return;
+    StatementLock lock = lockStatement();
+    if (semanticParse())
         executeCommand();
     return;
 }
 
-int main(void)
+/**
+ * @brief Runs a line of input, read from the console or sent by a client
+ *
+ * @param command
+ * @return false if the line is QUIT
+ */
+bool runCommand(const string &command)
 {
+    parsedQuery.clear();
+    LOG_INFO("Reading New Command: " + command);
+    tokenizedQuery = tokenize(command);
 
-    regex delim("[^\\s,]+");
-    string command;
-    system("rm -rf ../data/temp");
-    system("mkdir ../data/temp");
+    if (tokenizedQuery.size() == 1 && tokenizedQuery.front() == "QUIT")
+        return false;
+    if (tokenizedQuery.empty())
+        return true;
+    if (tokenizedQuery.size() == 1)
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return true;
+    }
+    doCommand();
+    return true;
+}
 
-    while(!cin.eof())
+/**
+ * @brief Applies the command line options, which override the settings
+ * above and those of the configuration file: --config path (server.conf by
+ * default, see applyConfig), --block-count n, --stats-file path, --port n
+ * (serve clients on port n instead of reading the console), --sessions n,
+ * --threads n, --io-backend posix|uring and --direct-io on|off
+ *
+ * @return false if an option is unknown or lacks its value
+ */
+bool parseArguments(int argc, char *argv[])
+{
+    string configFile = "server.conf";
+    for (int argument = 1; argument + 1 < argc; argument += 2)
+        if (string(argv[argument]) == "--config")
+            configFile = argv[argument + 1];
+    // Only a file asked for explicitly has to exist
+    if (!applyConfig(configFile) && configFile != "server.conf")
     {
-        cout << "\n> ";
-        tokenizedQuery.clear();
-        parsedQuery.clear();
-        logger.log("\nReading New Command: ");
-        getline(cin, command);
-        logger.log(command);
+        cerr << "Cannot read " << configFile << endl;
+        return false;
+    }
 
+    for (int argument = 1; argument < argc; argument += 2)
+    {
+        string option = argv[argument];
+        if (argument + 1 == argc)
+            return false;
+        string value = argv[argument + 1];
+        if (option == "--block-count")
+            BLOCK_COUNT = max((int) MIN_GRANT_FRAMES, atoi(argv[argument + 1]));
+        else if (option == "--config")
+            continue;
+        else if (option == "--stats-file")
+            STATS_FILE = argv[argument + 1];
+        else if (option == "--port")
+            SERVER_PORT = atoi(argv[argument + 1]);
+        else if (option == "--sessions")
+            SESSION_THREADS = max(1, atoi(argv[argument + 1]));
+        else if (option == "--threads")
+            WORKER_THREADS = max(1, atoi(argv[argument + 1]));
+        else if (option == "--io-backend" && (value == "posix" || value == "uring"))
+            IO_BACKEND = value == "uring" ? URING_IO : POSIX_IO;
+        else if (option == "--direct-io" && (value == "on" || value == "off"))
+            DIRECT_IO = value == "on";
+        else
+            return false;
+    }
+    return true;
+}
 
-        auto words_begin = std::sregex_iterator(command.begin(), command.end(), delim);
-        auto words_end = std::sregex_iterator();
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i)
-            tokenizedQuery.emplace_back((*i).str());
+int main(int argc, char *argv[])
+{
+    if (!parseArguments(argc, argv))
+    {
+        cerr << "Usage: " << argv[0] << " [--config path] [--block-count n] [--stats-file path]"
+             << " [--port n] [--sessions n] [--threads n] [--io-backend posix|uring] [--direct-io on|off]" << endl;
+        return 1;
+    }
 
-        if (tokenizedQuery.size() == 1 && tokenizedQuery.front() == "QUIT")
-        {
-            break;
-        }
+    string command;
+    // Pages are kept between runs if the last server left its catalogue
+    if (!tableCatalogue.restore()) {
+        system("rm -rf ../data/temp");
+        system("mkdir ../data/temp");
+    }
 
-        if (tokenizedQuery.empty())
+    if (SERVER_PORT)
+    {
+        SessionServer server;
+        if (!server.listen(SERVER_PORT))
         {
-            continue;
+            cerr << "Cannot listen on port " << SERVER_PORT << endl;
+            return 1;
         }
-
-        if (tokenizedQuery.size() == 1)
+        streambuf *console = cout.rdbuf();
+        SessionOutput output(console);
+        cout.rdbuf(&output);
+        server.run();
+        cout.rdbuf(console);
+    }
+    else
+        while(!cin.eof())
         {
-            cout << "SYNTAX ERROR" << endl;
-            continue;
+            cout << "\n> ";
+            getline(cin, command);
+            if (!runCommand(command))
+                break;
         }
-
-        doCommand();
-    }
+    tableCatalogue.save();
 }
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "global.h"
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+thread_local streambuf *SessionOutput::target = nullptr;
+
+streambuf *SessionOutput::current() {
+    return target ? target : this->console;
+}
+
+int SessionOutput::overflow(int character) {
+    return this->current()->sputc(character);
+}
+
+streamsize SessionOutput::xsputn(const char *characters, streamsize count) {
+    return this->current()->sputn(characters, count);
+}
+
+int SessionOutput::sync() {
+    return this->current()->pubsync();
+}
+
+/**
+ * @brief Sends what the calling thread writes to cout to buffer from now on,
+ * or to the console again if buffer is nullptr
+ *
+ * @param buffer
+ */
+void SessionOutput::redirect(streambuf *buffer) {
+    target = buffer;
+}
+
+SocketBuffer::SocketBuffer(int socket) : socket(socket) {
+    this->setp(this->buffer, this->buffer + sizeof(this->buffer));
+}
+
+/**
+ * @brief Sends the buffered output to the client
+ *
+ * @return false if the client is gone
+ */
+bool SocketBuffer::flush() {
+    const char *next = this->pbase();
+    while (next < this->pptr()) {
+        ssize_t sent = send(this->socket, next, this->pptr() - next, MSG_NOSIGNAL);
+        if (sent <= 0)
+            break;
+        next += sent;
+    }
+    bool delivered = next == this->pptr();
+    this->setp(this->buffer, this->buffer + sizeof(this->buffer));
+    return delivered;
+}
+
+int SocketBuffer::overflow(int character) {
+    if (!this->flush())
+        return traits_type::eof();
+    if (character != traits_type::eof())
+        this->sputc(character);
+    return traits_type::not_eof(character);
+}
+
+int SocketBuffer::sync() {
+    return this->flush() ? 0 : -1;
+}
+
+/**
+ * @brief Reads the next line the client sent, without its line break
+ *
+ * @param line
+ * @return false once the client has disconnected
+ */
+bool Session::readLine(string &line) {
+    size_t end;
+    while ((end = this->input.find('\n')) == string::npos) {
+        char buffer[4096];
+        ssize_t received = recv(this->socket, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            if (this->input.empty())
+                return false;
+            end = this->input.size();
+            this->input += '\n';
+            break;
+        }
+        this->input.append(buffer, received);
+    }
+    line = this->input.substr(0, end);
+    this->input.erase(0, end + 1);
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return true;
+}
+
+void Session::run() {
+    LOG_INFO("Session " + to_string(this->socket) + " started");
+    ostream out(&this->output);
+    SessionOutput::redirect(&this->output);
+    string command;
+    do
+        out << "\n> " << flush;
+    while (this->readLine(command) && runCommand(command));
+    out << flush;
+    SessionOutput::redirect(nullptr);
+    LOG_INFO("Session " + to_string(this->socket) + " ended");
+}
+
+static int stopSignalPipe = -1;
+
+static void stopOnSignal(int) {
+    // write may set errno, which the interrupted code could be looking at
+    int savedErrno = errno;
+    char signal = 1;
+    ssize_t written = write(stopSignalPipe, &signal, 1);
+    (void) written;
+    errno = savedErrno;
+}
+
+/**
+ * @brief Opens the listening socket on port, on all interfaces
+ *
+ * @param port
+ * @return false if the port can't be listened on
+ */
+bool SessionServer::listen(uint port) {
+    LOG_TRACE("SessionServer::listen");
+    this->listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(this->listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (this->listener < 0 || bind(this->listener, (sockaddr *) &address, sizeof(address)) ||
+        ::listen(this->listener, SOMAXCONN) || pipe(this->stopPipe)) {
+        LOG_ERROR("SessionServer::listen: cannot listen on port " + to_string(port));
+        if (this->listener >= 0)
+            close(this->listener);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Body of a session thread. Serves the waiting clients one after the
+ * other until the server stops.
+ */
+void SessionServer::serve() {
+    unique_lock<mutex> guard(this->lock);
+    while (true) {
+        this->changed.wait(guard, [&] { return this->stopping || !this->waitingClients.empty(); });
+        if (this->stopping)
+            return;
+        int client = this->waitingClients.front();
+        this->waitingClients.pop_front();
+        this->connectedClients.insert(client);
+        guard.unlock();
+        Session(client).run();
+        guard.lock();
+        this->connectedClients.erase(client);
+        close(client);
+    }
+}
+
+/**
+ * @brief Accepts clients until SIGINT or SIGTERM arrives, then disconnects
+ * every client and waits for the session threads to finish
+ */
+void SessionServer::run() {
+    LOG_TRACE("SessionServer::run");
+    stopSignalPipe = this->stopPipe[1];
+    void (*previousInterruptHandler)(int) = signal(SIGINT, stopOnSignal);
+    void (*previousTerminateHandler)(int) = signal(SIGTERM, stopOnSignal);
+    for (uint worker = 0; worker < max(1u, SESSION_THREADS); worker++)
+        this->workers.emplace_back(&SessionServer::serve, this);
+    cout << "Listening on port " << SERVER_PORT << endl;
+
+    pollfd events[2] = {{this->listener, POLLIN, 0}, {this->stopPipe[0], POLLIN, 0}};
+    while (true) {
+        if (poll(events, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (events[1].revents)
+            break;
+        if (!(events[0].revents & POLLIN))
+            continue;
+        int client = accept(this->listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        lock_guard<mutex> guard(this->lock);
+        this->waitingClients.push_back(client);
+        this->changed.notify_one();
+    }
+
+    // Signals arriving from here on, e.g. while the catalogue is saved, are
+    // handled as they were before the server ran
+    signal(SIGINT, previousInterruptHandler == SIG_ERR ? SIG_DFL : previousInterruptHandler);
+    signal(SIGTERM, previousTerminateHandler == SIG_ERR ? SIG_DFL : previousTerminateHandler);
+    close(this->listener);
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->stopping = true;
+        // Sessions notice once their running statement is done
+        for (int client: this->connectedClients)
+            shutdown(client, SHUT_RDWR);
+        for (int client: this->waitingClients)
+            close(client);
+        this->waitingClients.clear();
+    }
+    this->changed.notify_all();
+    for (thread &worker: this->workers)
+        worker.join();
+    close(this->stopPipe[0]);
+    close(this->stopPipe[1]);
+    cout << "Stopped listening" << endl;
+}
@@ -0,0 +1,99 @@
+#ifndef SESSION_H
+#define SESSION_H
+#include"logger.h"
+
+/**
+ * @brief Stream buffer put behind cout when the server listens for clients.
+ * What a thread writes to cout goes to the stream buffer the thread set
+ * through redirect, i.e. to the client of the session it serves, and to the
+ * console on threads that serve no session.
+ */
+class SessionOutput : public streambuf {
+
+    streambuf *console;
+    static thread_local streambuf *target;
+
+    streambuf *current();
+
+    protected:
+
+    int overflow(int character) override;
+    streamsize xsputn(const char *characters, streamsize count) override;
+    int sync() override;
+
+    public:
+
+    explicit SessionOutput(streambuf *console) : console(console) {}
+    static void redirect(streambuf *buffer);
+};
+
+/**
+ * @brief Buffered output to the socket of a client
+ */
+class SocketBuffer : public streambuf {
+
+    int socket;
+    char buffer[4096];
+
+    bool flush();
+
+    protected:
+
+    int overflow(int character) override;
+    int sync() override;
+
+    public:
+
+    explicit SocketBuffer(int socket);
+};
+
+/**
+ * @brief A Session serves one client: it reads statements from the client's
+ * socket line by line and runs them as the console does, sending back what
+ * they print. Every session runs on a thread of its own, with a parser state
+ * (tokenizedQuery, parsedQuery) and a profiler of its own.
+ */
+class Session {
+
+    int socket;
+    SocketBuffer output;
+    string input;
+
+    bool readLine(string &line);
+
+    public:
+
+    explicit Session(int socket) : socket(socket), output(socket) {}
+    void run();
+};
+
+/**
+ * @brief The SessionServer listens on SERVER_PORT and hands every client
+ * that connects to one of SESSION_THREADS threads, which serves it until it
+ * sends QUIT or disconnects. Clients connecting while every thread is busy
+ * wait for one to become free. The server stops on SIGINT or SIGTERM: it
+ * stops accepting clients, disconnects the connected ones once their running
+ * statements have finished and returns from run.
+ */
+class SessionServer {
+
+    int listener = -1;
+    int stopPipe[2] = {-1, -1};
+    vector<thread> workers;
+    mutex lock;
+    condition_variable changed;
+    deque<int> waitingClients;
+    unordered_set<int> connectedClients;
+    bool stopping = false;
+
+    void serve();
+
+    public:
+
+    bool listen(uint port);
+    void run();
+};
+
+bool runCommand(const string &command);
+
+#endif //SESSION_H
@@ -0,0 +1,219 @@
+#include "global.h"
+
+HyperLogLog::HyperLogLog() : registers(1 << PRECISION, 0) {}
+
+/**
+ * @param hash 64 bit hash of the value
+ */
+void HyperLogLog::add(uint64_t hash) {
+    uint64_t bucket = hash >> (64 - PRECISION);
+    uint64_t remaining = hash << PRECISION;
+    uint8_t rank = remaining ? __builtin_clzll(remaining) + 1 : 64 - PRECISION + 1;
+    this->registers[bucket] = max(this->registers[bucket], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog &other) {
+    for (size_t bucket = 0; bucket < this->registers.size(); bucket++)
+        this->registers[bucket] = max(this->registers[bucket], other.registers[bucket]);
+}
+
+/**
+ * @brief The harmonic mean estimate, with linear counting over the empty
+ * registers when the estimate is small
+ *
+ * @return uint64_t estimated number of distinct values added
+ */
+uint64_t HyperLogLog::estimate() const {
+    const double registerCount = this->registers.size();
+    double sum = 0;
+    int emptyRegisters = 0;
+    for (uint8_t rank: this->registers) {
+        sum += ldexp(1.0, -rank);
+        emptyRegisters += rank == 0;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / registerCount) * registerCount * registerCount / sum;
+    if (estimate <= 2.5 * registerCount && emptyRegisters)
+        estimate = registerCount * log(registerCount / emptyRegisters);
+    return llround(estimate);
+}
+
+/**
+ * @brief The splitmix64 finalizer
+ */
+uint64_t ColumnStatistics::hash(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+void ColumnStatistics::addToSample(uint64_t rowHash, int value) {
+    if (this->sample.size() == SAMPLE_SIZE) {
+        if (rowHash >= this->sample.front().first)
+            return;
+        pop_heap(this->sample.begin(), this->sample.end());
+        this->sample.pop_back();
+    }
+    this->sample.emplace_back(rowHash, value);
+    push_heap(this->sample.begin(), this->sample.end());
+}
+
+/**
+ * @param value
+ * @param rowId any number that no other row of the table uses
+ */
+void ColumnStatistics::add(int value, uint64_t rowId) {
+    this->valueCount++;
+    this->minimum = min(this->minimum, value);
+    this->maximum = max(this->maximum, value);
+    this->sketch.add(hash((uint32_t) value));
+    this->addToSample(hash(rowId ^ 0x5bd1e995ULL << 32), value);
+}
+
+/**
+ * @brief Adds statistics collected over other rows of the column. The other
+ * statistics are consumed.
+ *
+ * @param other
+ */
+void ColumnStatistics::merge(ColumnStatistics &other) {
+    this->valueCount += other.valueCount;
+    this->minimum = min(this->minimum, other.minimum);
+    this->maximum = max(this->maximum, other.maximum);
+    this->sketch.merge(other.sketch);
+    for (auto &[rowHash, value]: other.sample)
+        this->addToSample(rowHash, value);
+    vector<pair<uint64_t, int>>().swap(other.sample);
+}
+
+/**
+ * @brief Builds the histogram from the sample once every row has been
+ * added, and frees the sample
+ */
+void ColumnStatistics::finish() {
+    this->histogram.clear();
+    if (!this->sample.empty()) {
+        vector<int> values;
+        for (auto &[rowHash, value]: this->sample)
+            values.push_back(value);
+        std::sort(values.begin(), values.end());
+        for (uint bucket = 0; bucket <= HISTOGRAM_BUCKETS; bucket++)
+            this->histogram.push_back(values[(values.size() - 1) * bucket / HISTOGRAM_BUCKETS]);
+        this->histogram.front() = this->minimum;
+        this->histogram.back() = this->maximum;
+    }
+    vector<pair<uint64_t, int>>().swap(this->sample);
+}
+
+/**
+ * @return uint64_t estimated number of distinct values, at most the number
+ * of values
+ */
+uint64_t ColumnStatistics::distinctCount() const {
+    return min((uint64_t) this->valueCount, max((uint64_t) (this->valueCount > 0), this->sketch.estimate()));
+}
+
+/**
+ * @brief Estimated share of the rows with values in [low, high]. Values are
+ * assumed to spread evenly over the integers of a bucket.
+ *
+ * @param low
+ * @param high
+ * @return double between 0 and 1
+ */
+double ColumnStatistics::rangeSelectivity(long long low, long long high) const {
+    low = max(low, (long long) this->minimum);
+    high = min(high, (long long) this->maximum);
+    if (low > high || this->histogram.empty())
+        return 0;
+    const int buckets = this->histogram.size() - 1;
+    if (buckets == 0)
+        return 1;
+    double selectivity = 0;
+    for (int bucket = 0; bucket < buckets; bucket++) {
+        long long bucketLow = this->histogram[bucket], bucketHigh = this->histogram[bucket + 1];
+        long long overlapLow = max(low, bucketLow), overlapHigh = min(high, bucketHigh);
+        if (overlapLow > overlapHigh)
+            continue;
+        selectivity += (double) (overlapHigh - overlapLow + 1) / (bucketHigh - bucketLow + 1) / buckets;
+    }
+    return min(1.0, selectivity);
+}
+
+/**
+ * @brief Estimated share of the rows equal to value: the histogram's share
+ * for values that fill whole buckets, one distinct value's share otherwise
+ *
+ * @param value
+ * @return double between 0 and 1
+ */
+double ColumnStatistics::equalitySelectivity(int value) const {
+    if (value < this->minimum || value > this->maximum || !this->valueCount)
+        return 0;
+    const int buckets = this->histogram.size() - 1;
+    int fullBuckets = 0;
+    for (int bucket = 0; bucket < buckets; bucket++)
+        fullBuckets += this->histogram[bucket] == value && this->histogram[bucket + 1] == value;
+    if (fullBuckets)
+        return (double) fullBuckets / buckets;
+    return 1.0 / this->distinctCount();
+}
+
+/**
+ * @brief Zone map of the first rowCount rows
+ */
+ZoneMap::ZoneMap(const vector<vector<int>> &rows, uint rowCount, uint columnCount)
+    : minimum(columnCount, INT_MAX), maximum(columnCount, INT_MIN) {
+    for (uint rowCounter = 0; rowCounter < rowCount; rowCounter++)
+        for (uint columnCounter = 0; columnCounter < columnCount; columnCounter++) {
+            this->minimum[columnCounter] = min(this->minimum[columnCounter], rows[rowCounter][columnCounter]);
+            this->maximum[columnCounter] = max(this->maximum[columnCounter], rows[rowCounter][columnCounter]);
+        }
+}
+
+/**
+ * @brief Persists the sketch (see TableCatalogue::save)
+ */
+void HyperLogLog::save(CatalogWriter &writer) const {
+    writer.write(this->registers);
+}
+
+/**
+ * @brief Reads back a sketch saved by save
+ *
+ * @return false if the catalogue file is damaged
+ */
+bool HyperLogLog::restore(CatalogReader &reader) {
+    return reader.read(this->registers) && this->registers.size() == (1u << PRECISION);
+}
+
+/**
+ * @brief Persists the statistics, with the sample if they aren't finished
+ */
+void ColumnStatistics::save(CatalogWriter &writer) const {
+    writer.write(this->sample);
+    this->sketch.save(writer);
+    writer.write(this->valueCount);
+    writer.write(this->minimum);
+    writer.write(this->maximum);
+    writer.write(this->histogram);
+}
+
+/**
+ * @brief Reads back statistics saved by save
+ *
+ * @return false if the catalogue file is damaged
+ */
+bool ColumnStatistics::restore(CatalogReader &reader) {
+    return reader.read(this->sample) && this->sketch.restore(reader) && reader.read(this->valueCount) &&
+           reader.read(this->minimum) && reader.read(this->maximum) && reader.read(this->histogram);
+}
+
+void ZoneMap::save(CatalogWriter &writer) const {
+    writer.write(this->minimum);
+    writer.write(this->maximum);
+}
+
+bool ZoneMap::restore(CatalogReader &reader) {
+    return reader.read(this->minimum) && reader.read(this->maximum);
+}
@@ -0,0 +1,81 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+#include"catalogFile.h"
+
+/**
+ * @brief HyperLogLog sketch of the distinct values of a column. Every value is
+ * hashed; the first PRECISION bits of the hash pick a register, which keeps
+ * the longest run of leading zeros seen in the remaining bits. The sketch
+ * takes 2^PRECISION bytes whatever the number of values, estimates with a
+ * standard error of about 1.04 / sqrt(2^PRECISION) (2.3%) and two sketches
+ * merge into the sketch of the union.
+ */
+class HyperLogLog {
+    static const int PRECISION = 11;
+    vector<uint8_t> registers;
+
+public:
+    HyperLogLog();
+    void add(uint64_t hash);
+    void merge(const HyperLogLog &other);
+    uint64_t estimate() const;
+    void save(CatalogWriter &writer) const;
+    bool restore(CatalogReader &reader);
+};
+
+/**
+ * @brief Statistics of one column: its range, a HyperLogLog sketch of its
+ * distinct values and an equi-depth histogram.
+ *
+ * <p>
+ * While rows are added a sample of SAMPLE_SIZE values is kept: the values
+ * whose rows have the smallest hashes of their row ids (a bottom-k sample),
+ * which is uniform and merges like the sketch. finish turns the sample into
+ * the histogram: HISTOGRAM_BUCKETS buckets holding the same share of the
+ * rows, given by their bounds, and frees it. A bucket with equal bounds
+ * stands for a value that makes up at least one bucket of rows.
+ * </p>
+ */
+class ColumnStatistics {
+    static const uint SAMPLE_SIZE = 1024;
+    static const uint HISTOGRAM_BUCKETS = 32;
+
+    // Max-heap on the row hash
+    vector<pair<uint64_t, int>> sample;
+    void addToSample(uint64_t rowHash, int value);
+
+public:
+    HyperLogLog sketch;
+    long long valueCount = 0;
+    int minimum = INT_MAX;
+    int maximum = INT_MIN;
+    vector<int> histogram;
+
+    static uint64_t hash(uint64_t value);
+    void add(int value, uint64_t rowId);
+    void merge(ColumnStatistics &other);
+    void finish();
+    uint64_t distinctCount() const;
+    double rangeSelectivity(long long low, long long high) const;
+    double equalitySelectivity(int value) const;
+    void save(CatalogWriter &writer) const;
+    bool restore(CatalogReader &reader);
+};
+
+/**
+ * @brief Zone map of a page: the smallest and the largest value of each of
+ * its columns. Tables record one for every page they write, so a scan can
+ * tell from the map alone that no row of a page satisfies its predicate and
+ * skip reading the page.
+ */
+struct ZoneMap {
+    vector<int> minimum;
+    vector<int> maximum;
+
+    ZoneMap() = default;
+    ZoneMap(const vector<vector<int>> &rows, uint rowCount, uint columnCount);
+    void save(CatalogWriter &writer) const;
+    bool restore(CatalogReader &reader);
+};
+
+#endif //STATISTICS_H
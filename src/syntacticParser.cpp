@@ -1,8 +1,97 @@
 #include "global.h"
 
+static inline bool isDelimiter(char character)
+{
+    return character == ',' || isspace((unsigned char) character);
+}
+
+/**
+ * @brief Splits a statement into its tokens, the runs of characters that are
+ * neither white space nor commas, in a single pass over the statement
+ *
+ * @param command
+ * @return vector<string>
+ */
+vector<string> tokenize(const string &command)
+{
+    vector<string> tokens;
+    size_t length = command.size();
+    for (size_t start = 0; start < length;)
+    {
+        if (isDelimiter(command[start]))
+        {
+            start++;
+            continue;
+        }
+        size_t end = start + 1;
+        while (end < length && !isDelimiter(command[end]))
+            end++;
+        tokens.emplace_back(command, start, end - start);
+        start = end;
+    }
+    return tokens;
+}
+
+/**
+ * @brief Checks that the token is an integer: digits, optionally preceded by
+ * a minus sign
+ */
+bool isIntegerLiteral(const string &token)
+{
+    size_t start = !token.empty() && token[0] == '-';
+    if (start == token.size())
+        return false;
+    for (size_t position = start; position < token.size(); position++)
+        if (!isdigit((unsigned char) token[position]))
+            return false;
+    return true;
+}
+
+/**
+ * @brief Statements the session parsed, by their tokens joined by single
+ * spaces. Tokens hold no white space, so two statements share a key only if
+ * they have the same tokens.
+ */
+static thread_local unordered_map<string, ParsedQuery> parseCache;
+
+/**
+ * @brief Same as syntacticParse, except that a statement with the same
+ * tokens as one the session parsed before takes the ParsedQuery of that
+ * statement instead of being parsed again. Parsing only looks at the tokens,
+ * so the result is the same. Statements that fail to parse aren't kept, so
+ * that their errors are printed every time, nor are EXPLAIN statements, which
+ * rewrite tokenizedQuery as they are parsed. Once PARSE_CACHE_ENTRIES
+ * statements are kept, the cache starts over.
+ */
+bool syntacticParseCached()
+{
+    LOG_TRACE("syntacticParseCached");
+    if (tokenizedQuery.empty() || tokenizedQuery[0] == "EXPLAIN")
+        return syntacticParse();
+    string key;
+    for (const string &token: tokenizedQuery)
+    {
+        if (!key.empty())
+            key += ' ';
+        key += token;
+    }
+    auto cached = parseCache.find(key);
+    if (cached != parseCache.end())
+    {
+        parsedQuery = cached->second;
+        return true;
+    }
+    if (!syntacticParse())
+        return false;
+    if (parseCache.size() >= PARSE_CACHE_ENTRIES)
+        parseCache.clear();
+    parseCache.emplace(move(key), parsedQuery);
+    return true;
+}
+
 bool syntacticParse()
 {
-    logger.log("syntacticParse");
+    LOG_TRACE("syntacticParse");
     string possibleQueryType = tokenizedQuery[0];
 
     if (tokenizedQuery.size() < 2)
@@ -35,6 +124,10 @@ bool syntacticParse()
         return syntacticParseCOMPUTE();
     else if(possibleQueryType == "SORT")
         return syntacticParseSORT();
+    else if(possibleQueryType == "SET")
+        return syntacticParseSET();
+    else if(possibleQueryType == "EXPLAIN")
+        return syntacticParseEXPLAIN();
     else
     {
         string resultantRelationName = possibleQueryType;
@@ -58,6 +151,8 @@ bool syntacticParse()
             return syntacticParseORDERBY();
         else if(possibleQueryType == "GROUP")
             return syntacticParseGROUPBY();
+        else if(possibleQueryType == "MULTIPLY")
+            return syntacticParseMULTIPLY();
         else
         {
             cout << "SYNTAX ERROR" << endl;
@@ -73,8 +168,10 @@ ParsedQuery::ParsedQuery()
 
 void ParsedQuery::clear()
 {
-    logger.log("ParseQuery::clear");
+    LOG_TRACE("ParseQuery::clear");
     this->queryType = UNDETERMINED;
+    this->explain = false;
+    this->analyze = false;
 
     this->clearRelationName = "";
 
@@ -86,6 +183,7 @@ void ParsedQuery::clear()
     this->distinctRelationName = "";
 
     this->exportRelationName = "";
+    this->exportBinary = false;
 
     this->groupByResultantRelationName = "";
     this->groupByGroupingAttribute = "";
@@ -94,8 +192,8 @@ void ParsedQuery::clear()
     this->groupByHavingAggregateFunction = NO_AGG_FUNC;
     this->groupByBinaryOperator = NO_BINOP_CLAUSE;
     this->groupByAttributeValue = 0;
-    this->groupByReturnAggregateFunction = NO_AGG_FUNC;
-    this->groupByReturnAttribute = "";
+    this->groupByReturnAggregateFunctions.clear();
+    this->groupByReturnAttributes.clear();
 
     this->indexingStrategy = NOTHING;
     this->indexColumnName = "";
@@ -109,6 +207,9 @@ void ParsedQuery::clear()
     this->joinSecondColumnName = "";
 
     this->loadRelationName = "";
+    this->loadPageLayout = NSM;
+    this->loadCompressed = false;
+    this->loadBinary = false;
 
     this->printRelationName = "";
 
@@ -128,6 +229,9 @@ void ParsedQuery::clear()
     this->selectionSecondColumnName = "";
     this->selectionIntLiteral = 0;
 
+    this->setVariableName = "";
+    this->setValue = 0;
+
     this->sortingStrategies.clear();
     this->sortColumnNames.clear();
     this->sortRelationName = "";
@@ -136,6 +240,7 @@ void ParsedQuery::clear()
     this->orderByResultantRelationName = "";
     this->orderByColumnName = "";
     this->orderByMultiplier = NO_SORT_CLAUSE;
+    this->orderByLimit = -1;
 
     this->sourceFileName = "";
     this->sourceFileName = "";
@@ -144,6 +249,9 @@ void ParsedQuery::clear()
     this->transposeMatrixName = "";
     this->symmetryMatrixName = "";
     this->computeMatrixName = "";
+    this->multiplyResultMatrixName = "";
+    this->multiplyFirstMatrixName = "";
+    this->multiplySecondMatrixName = "";
     this->exportMatrixName = "";
     this->renameFromMatrixName = "";
     this->renameToMatrixName = "";
@@ -14,10 +14,12 @@ enum QueryType
     JOIN,
     LIST,
     LOAD,
+    MULTIPLY,
     PRINT,
     PROJECTION,
     RENAME,
     SELECTION,
+    SET,
     SORT,
     SOURCE,
     SYMMETRY,
@@ -32,6 +34,7 @@ enum AggregateFunction
     MAX = 1,
     SUM = 2,
     AVG = 3,
+    COUNT = 4,
     NO_AGG_FUNC
 };
 
@@ -66,6 +69,8 @@ class ParsedQuery
 public:
     QueryType queryType = UNDETERMINED;
     string queryData = "";
+    bool explain = false;
+    bool analyze = false;
 
     string clearRelationName = "";
 
@@ -77,6 +82,7 @@ public:
     string distinctRelationName = "";
 
     string exportRelationName = "";
+    bool exportBinary = false;
 
     string groupByResultantRelationName = "";
     string groupByGroupingAttribute = "";
@@ -85,8 +91,8 @@ public:
     AggregateFunction groupByHavingAggregateFunction = NO_AGG_FUNC;
     BinaryOperator groupByBinaryOperator = NO_BINOP_CLAUSE;
     int groupByAttributeValue = 0;
-    AggregateFunction groupByReturnAggregateFunction = NO_AGG_FUNC;
-    string groupByReturnAttribute = "";
+    vector<AggregateFunction> groupByReturnAggregateFunctions;
+    vector<string> groupByReturnAttributes;
 
     IndexingStrategy indexingStrategy = NOTHING;
     string indexColumnName = "";
@@ -100,6 +106,9 @@ public:
     string joinSecondColumnName = "";
 
     string loadRelationName = "";
+    PageLayout loadPageLayout = NSM;
+    bool loadCompressed = false;
+    bool loadBinary = false;
 
     string printRelationName = "";
 
@@ -119,6 +128,9 @@ public:
     string selectionSecondColumnName = "";
     int selectionIntLiteral = 0;
 
+    string setVariableName = "";
+    double setValue = 0;
+
     vector<SortingStrategy> sortingStrategies;
     vector<string> sortColumnNames;
     string sortRelationName = "";
@@ -127,6 +139,7 @@ public:
     string orderByResultantRelationName = "";
     string orderByColumnName = "";
     SortingStrategy orderByMultiplier = NO_SORT_CLAUSE;
+    long long orderByLimit = -1;
 
     string sourceFileName = "";
     string loadMatrixName = "";
@@ -134,6 +147,9 @@ public:
     string transposeMatrixName = "";
     string symmetryMatrixName = "";
     string computeMatrixName = "";
+    string multiplyResultMatrixName = "";
+    string multiplyFirstMatrixName = "";
+    string multiplySecondMatrixName = "";
     string exportMatrixName = "";
     string renameFromMatrixName = "";
     string renameToMatrixName = "";
@@ -142,20 +158,31 @@ public:
     void clear();
 };
 
+// Parsed statements a session keeps for statements it runs again (see
+// syntacticParseCached)
+const uint PARSE_CACHE_ENTRIES = 4096;
+
+vector<string> tokenize(const string &command);
+bool isIntegerLiteral(const string &token);
+
 bool syntacticParse();
+bool syntacticParseCached();
 bool syntacticParseCLEAR();
 bool syntacticParseCROSS();
 bool syntacticParseDISTINCT();
+bool syntacticParseEXPLAIN();
 bool syntacticParseEXPORT();
 bool syntacticParseGROUPBY();
 bool syntacticParseINDEX();
 bool syntacticParseJOIN();
 bool syntacticParseLIST();
 bool syntacticParseLOAD();
+bool syntacticParseMULTIPLY();
 bool syntacticParsePRINT();
 bool syntacticParsePROJECTION();
 bool syntacticParseRENAME();
 bool syntacticParseSELECTION();
+bool syntacticParseSET();
 bool syntacticParseSORT();
 bool syntacticParseSOURCE();
 bool syntacticParseSYMMETRY();
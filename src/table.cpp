@@ -6,7 +6,7 @@
  *
  */
 Table::Table() {
-    logger.log("Table::Table");
+    LOG_TRACE("Table::Table");
 }
 
 /**
@@ -17,7 +17,7 @@ Table::Table() {
  * @param tableName 
  */
 Table::Table(string tableName) {
-    logger.log("Table::Table");
+    LOG_TRACE("Table::Table");
     this->sourceFileName = "../data/" + tableName + ".csv";
     this->tableName = tableName;
 }
@@ -25,24 +25,26 @@ Table::Table(string tableName) {
 /**
  * @brief Construct a new Table:: Table object used when an assignment command
  * is encountered. To create the table object both the table name and the
- * columns the table holds should be specified.
+ * columns the table holds should be specified. The rows are then added
+ * through a TableBuilder.
  *
  * @param tableName 
  * @param columns 
  */
 Table::Table(string tableName, vector<string> columns) {
-    logger.log("Table::Table");
+    LOG_TRACE("Table::Table");
     this->sourceFileName = "../data/temp/" + tableName + ".csv";
     this->tableName = tableName;
     this->columns = columns;
     this->columnCount = columns.size();
     for (int i = 0; i < columns.size(); i++) this->colNameToIdx[columns[i]] = i;
     this->maxRowsPerBlock = (uint) ((BLOCK_SIZE * 1000) / (sizeof(int) * columnCount));
-    this->writeRow<string>(columns);
 }
 
 /**
- * @brief Construct a new Table::Table object using the originalTable provided
+ * @brief Construct a new Table::Table object using the originalTable provided.
+ * The copy starts out without an index, copies are usually rewritten (sorted)
+ * right away.
  *
  * @param tableName
  * @param originalTable
@@ -51,18 +53,63 @@ Table::Table(string tableName, Table *originalTable) {
     this->sourceFileName = "../data" + tableName + ".csv";
     this->tableName = tableName;
     this->columns = originalTable->columns;
+    this->columnStatistics = originalTable->columnStatistics;
     this->distinctValuesPerColumnCount = originalTable->distinctValuesPerColumnCount;
     this->columnCount = originalTable->columnCount;
     this->rowCount = originalTable->rowCount;
     this->blockCount = originalTable->blockCount;
     this->maxRowsPerBlock = originalTable->maxRowsPerBlock;
     this->rowsPerBlockCount = originalTable->rowsPerBlockCount;
-    this->indexed = originalTable->indexed;
-    this->indexedColumn = originalTable->indexedColumn;
-    this->indexingStrategy = originalTable->indexingStrategy;
+    this->zoneMaps = originalTable->zoneMaps;
+    this->layout = originalTable->layout;
+    this->compressed = originalTable->compressed;
     this->colNameToIdx = originalTable->colNameToIdx;
 }
 
+/**
+ * @brief Construct a new Table::Table object holding the given columns of a
+ * DSM table without copying any of them: the new table reads the column
+ * chains of the original. The page shapes, zone maps and statistics of the
+ * columns are taken over as they are.
+ *
+ * @param tableName
+ * @param originalTable
+ * @param columnIndices
+ */
+Table::Table(string tableName, Table *originalTable, const vector<int> &columnIndices) {
+    LOG_TRACE("Table::Table");
+    assert(originalTable->layout == DSM); //Should never occur. Sanity check
+    this->sourceFileName = "../data/temp/" + tableName + ".csv";
+    this->tableName = tableName;
+    this->columnCount = columnIndices.size();
+    this->rowCount = originalTable->rowCount;
+    this->blockCount = originalTable->blockCount;
+    this->maxRowsPerBlock = originalTable->maxRowsPerBlock;
+    this->rowsPerBlockCount = originalTable->rowsPerBlockCount;
+    this->layout = DSM;
+    this->compressed = originalTable->compressed;
+    for (int columnIndex: columnIndices) {
+        this->colNameToIdx[originalTable->columns[columnIndex]] = this->columns.size();
+        this->columns.push_back(originalTable->columns[columnIndex]);
+        this->columnChains.push_back(originalTable->columnChain(columnIndex));
+        if (columnIndex < originalTable->columnStatistics.size()) {
+            this->columnStatistics.push_back(originalTable->columnStatistics[columnIndex]);
+            this->distinctValuesPerColumnCount.push_back(originalTable->distinctValuesPerColumnCount[columnIndex]);
+        }
+    }
+    this->zoneMaps.resize(originalTable->zoneMaps.size());
+    for (uint pageCounter = 0; pageCounter < this->zoneMaps.size(); pageCounter++) {
+        const ZoneMap *zoneMap = originalTable->getZoneMap(pageCounter);
+        if (!zoneMap)
+            continue;
+        for (int columnIndex: columnIndices) {
+            this->zoneMaps[pageCounter].minimum.push_back(zoneMap->minimum[columnIndex]);
+            this->zoneMaps[pageCounter].maximum.push_back(zoneMap->maximum[columnIndex]);
+        }
+    }
+    this->inheritSortOrder(originalTable, columnIndices);
+}
+
 /**
  * @brief The load function is used when the LOAD command is encountered. It
  * reads data from the source file, splits it into blocks and updates table
@@ -72,7 +119,7 @@ Table::Table(string tableName, Table *originalTable) {
  * @return false if an error occurred 
  */
 bool Table::load() {
-    logger.log("Table::load");
+    LOG_TRACE("Table::load");
     fstream fin(this->sourceFileName, ios::in);
     string line;
     if (getline(fin, line)) {
@@ -85,6 +132,52 @@ bool Table::load() {
     return false;
 }
 
+/**
+ * @brief Loads the table from its binary columnar file (see ColumnarFile)
+ * instead of its csv file. The columns are read in place from the mapped
+ * file: the statistics of every column are collected in parallel and the
+ * rows go to the pages without being parsed.
+ *
+ * @return true if successfully loaded
+ * @return false otherwise
+ */
+bool Table::loadBinary() {
+    LOG_TRACE("Table::loadBinary");
+    ColumnarFile file(this->tableName);
+    if (!file.isValid() || file.rows() > INT_MAX)
+        return false;
+    for (const string &columnName: file.columns()) {
+        if (this->colNameToIdx.count(columnName))
+            return false;
+        this->colNameToIdx[columnName] = this->columns.size();
+        this->columns.push_back(columnName);
+    }
+    this->columnCount = this->columns.size();
+    uint pageWidth = this->layout == DSM ? 1 : this->columnCount;
+    this->maxRowsPerBlock = (uint) ((BLOCK_SIZE * 1000) / (sizeof(int) * pageWidth));
+    int rowCount = (int) file.rows();
+
+    vector<vector<ColumnStatistics>> partialStatistics(1, vector<ColumnStatistics>(this->columnCount));
+    vector<pair<int, int>> columnRanges(this->columnCount, {INT_MAX, INT_MIN});
+    threadPool.run(this->columnCount, [&](uint columnCounter) {
+        const int *column = file.column(columnCounter);
+        ColumnStatistics &statistics = partialStatistics[0][columnCounter];
+        for (int rowCounter = 0; rowCounter < rowCount; rowCounter++) {
+            statistics.add(column[rowCounter], rowCounter);
+            columnRanges[columnCounter].first = min(columnRanges[columnCounter].first, column[rowCounter]);
+            columnRanges[columnCounter].second = max(columnRanges[columnCounter].second, column[rowCounter]);
+        }
+    });
+    if (this->compressed && !this->setCompressedBlockSize(columnRanges))
+        return false;
+    TableBuilder builder(this, false);
+    // A row is every rowCount-th value, starting in the first column
+    for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+        builder.addRow(RowView{file.column(0) + rowCounter, (int) this->columnCount, rowCount});
+    this->mergeStatistics(partialStatistics);
+    return builder.finish();
+}
+
 /**
  * @brief Function extracts column names from the header line of the .csv data
  * file. 
@@ -95,7 +188,7 @@ bool Table::load() {
  * @return false otherwise
  */
 bool Table::extractColumnNames(string firstLine) {
-    logger.log("Table::extractColumnNames");
+    LOG_TRACE("Table::extractColumnNames");
     string word;
     stringstream s(firstLine);
     int idx = 0;
@@ -107,75 +200,145 @@ bool Table::extractColumnNames(string firstLine) {
         this->columns.emplace_back(word);
     }
     this->columnCount = this->columns.size();
-    this->maxRowsPerBlock = (uint) ((BLOCK_SIZE * 1000) / (sizeof(int) * this->columnCount));
+    // Every page of a column chain is a block of its own
+    uint pageWidth = this->layout == DSM ? 1 : this->columnCount;
+    this->maxRowsPerBlock = (uint) ((BLOCK_SIZE * 1000) / (sizeof(int) * pageWidth));
     return true;
 }
 
 /**
- * @brief This function splits all the rows and stores them in multiple files of
- * one block size. 
+ * @brief Compressed tables hold as many rows per block as the value ranges of
+ * their columns allow (see PageCodec::maxRowsPerBlock). The ranges are found
+ * with an extra pass over the source file.
  *
- * @return true if successfully blockified
+ * @param reader
+ * @return true if at least one row fits into a block
  * @return false otherwise
  */
-bool Table::blockify() {
-    logger.log("Table::blockify");
-    ifstream fin(this->sourceFileName, ios::in);
-    string line, word;
-    vector<int> row(this->columnCount, 0);
-    vector<vector<int>> rowsInPage(this->maxRowsPerBlock, row);
-    int pageCounter = 0;
-    unordered_set<int> dummy;
-    dummy.clear();
-    this->distinctValuesInColumns.assign(this->columnCount, dummy);
-    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
-    getline(fin, line);
-    while (getline(fin, line)) {
-        stringstream s(line);
+bool Table::computeCompressedBlockSize(CsvReader &reader) {
+    LOG_TRACE("Table::computeCompressedBlockSize");
+    vector<vector<pair<int, int>>> partialRanges(reader.windowSize(), vector<pair<int, int>>(this->columnCount, {INT_MAX, INT_MIN}));
+    bool parsed = reader.read(this->columnCount, true, [&](uint slot, const vector<int> &values) {
+        vector<pair<int, int>> &ranges = partialRanges[slot];
+        for (size_t rowStart = 0; rowStart < values.size(); rowStart += this->columnCount)
+            for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
+                ranges[columnCounter].first = min(ranges[columnCounter].first, values[rowStart + columnCounter]);
+                ranges[columnCounter].second = max(ranges[columnCounter].second, values[rowStart + columnCounter]);
+            }
+    }, nullptr);
+    if (!parsed)
+        return false;
+    vector<pair<int, int>> columnRanges(this->columnCount, {INT_MAX, INT_MIN});
+    for (auto &ranges: partialRanges)
         for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
-            if (!getline(s, word, ','))
-                return false;
-            row[columnCounter] = stoi(word);
-            rowsInPage[pageCounter][columnCounter] = row[columnCounter];
-        }
-        pageCounter++;
-        this->updateStatistics(row);
-        if (pageCounter == this->maxRowsPerBlock) {
-            bufferManager.writePage(this->tableName, this->blockCount, rowsInPage, pageCounter, rowsInPage[0].size());
-            this->blockCount++;
-            this->rowsPerBlockCount.emplace_back(pageCounter);
-            pageCounter = 0;
+            columnRanges[columnCounter].first = min(columnRanges[columnCounter].first, ranges[columnCounter].first);
+            columnRanges[columnCounter].second = max(columnRanges[columnCounter].second, ranges[columnCounter].second);
         }
+    return this->setCompressedBlockSize(columnRanges);
+}
+
+/**
+ * @brief Sets maxRowsPerBlock to the rows of compressed pages that fit into a
+ * block, given the range of values of every column
+ *
+ * @param columnRanges
+ * @return false if not even one row fits
+ */
+bool Table::setCompressedBlockSize(const vector<pair<int, int>> &columnRanges) {
+    if (columnRanges[0].first > columnRanges[0].second)
+        return true;
+    if (this->layout != DSM)
+        this->maxRowsPerBlock = PageCodec::maxRowsPerBlock(columnRanges);
+    else {
+        // Every column chain page has to fit into a block on its own
+        this->maxRowsPerBlock = UINT_MAX;
+        for (auto &range: columnRanges)
+            this->maxRowsPerBlock = min(this->maxRowsPerBlock, PageCodec::maxRowsPerBlock({range}));
     }
-    if (pageCounter) {
-        bufferManager.writePage(this->tableName, this->blockCount, rowsInPage, pageCounter, rowsInPage[0].size());
-        this->blockCount++;
-        this->rowsPerBlockCount.emplace_back(pageCounter);
-        pageCounter = 0;
-    }
+    return this->maxRowsPerBlock > 0;
+}
 
-    if (this->rowCount == 0)
+/**
+ * @brief This function splits all the rows and stores them in multiple files of
+ * one block size. The source file is parsed in parallel (see CsvReader); the
+ * column statistics are collected per chunk slot alongside and merged at the
+ * end, while pages are written in file order.
+ *
+ * @return true if successfully blockified
+ * @return false otherwise
+ */
+bool Table::blockify() {
+    LOG_TRACE("Table::blockify");
+    CsvReader reader(this->sourceFileName);
+    if (this->compressed && !this->computeCompressedBlockSize(reader))
         return false;
-    this->distinctValuesInColumns.clear();
-    return true;
+    vector<vector<ColumnStatistics>> partialStatistics(reader.windowSize(), vector<ColumnStatistics>(this->columnCount));
+    vector<uint64_t> slotRowCounts(reader.windowSize(), 0);
+    TableBuilder builder(this, false);
+    bool parsed = reader.read(this->columnCount, true, [&](uint slot, const vector<int> &values) {
+        vector<ColumnStatistics> &statistics = partialStatistics[slot];
+        for (size_t rowStart = 0; rowStart < values.size(); rowStart += this->columnCount) {
+            // Row ids only have to be unique, so every slot numbers its own rows
+            uint64_t rowId = (uint64_t) slot << 40 | slotRowCounts[slot]++;
+            for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+                statistics[columnCounter].add(values[rowStart + columnCounter], rowId);
+        }
+    }, [&](const vector<int> &values) {
+        for (size_t rowStart = 0; rowStart < values.size(); rowStart += this->columnCount)
+            builder.addRow(RowView{values.data() + rowStart, (int) this->columnCount, 1});
+    });
+    if (!parsed)
+        return false;
+    this->mergeStatistics(partialStatistics);
+    return builder.finish();
+}
+
+/**
+ * @brief Resets the statistics before the rows of the table are added
+ */
+void Table::startStatistics() {
+    this->rowCount = 0;
+    this->columnStatistics.assign(this->columnCount, ColumnStatistics());
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+}
+
+/**
+ * @brief Builds the histograms and distinct counts once all rows have been
+ * added
+ */
+void Table::finishStatistics() {
+    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
+        this->columnStatistics[columnCounter].finish();
+        this->distinctValuesPerColumnCount[columnCounter] = this->columnStatistics[columnCounter].distinctCount();
+    }
 }
 
 /**
  * @brief Given a row of values, this function will update the statistics it
- * stores i.e. it updates the number of rows that are present in the column and
- * the number of distinct values present in each column. These statistics are to
- * be used during optimisation.
+ * stores i.e. the range, distinct value sketch and histogram sample of each
+ * column. These statistics are to be used during optimisation. The rows
+ * themselves are counted by the TableBuilder.
  *
  * @param row 
  */
-void Table::updateStatistics(vector<int> row) {
-    this->rowCount++;
-    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
-        if (!this->distinctValuesInColumns[columnCounter].count(row[columnCounter])) {
-            this->distinctValuesInColumns[columnCounter].insert(row[columnCounter]);
-            this->distinctValuesPerColumnCount[columnCounter]++;
-        }
-    }
+void Table::updateStatistics(const vector<int> &row) {
+    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+        this->columnStatistics[columnCounter].add(row[columnCounter], this->rowCount);
+}
+
+/**
+ * @brief Adds statistics that were collected apart from the table, one per
+ * column for every part, to the statistics of the table. The columns are
+ * merged in parallel and the parts are consumed.
+ *
+ * @param partialStatistics
+ */
+void Table::mergeStatistics(vector<vector<ColumnStatistics>> &partialStatistics) {
+    LOG_TRACE("Table::mergeStatistics");
+    threadPool.run(this->columnCount, [&](uint columnCounter) {
+        for (auto &part: partialStatistics)
+            this->columnStatistics[columnCounter].merge(part[columnCounter]);
+    });
 }
 
 /**
@@ -186,7 +349,7 @@ void Table::updateStatistics(vector<int> row) {
  * @return false 
  */
 bool Table::isColumn(string columnName) {
-    logger.log("Table::isColumn");
+    LOG_TRACE("Table::isColumn");
 
     return (colNameToIdx.find(columnName) != colNameToIdx.end());
 }
@@ -200,12 +363,14 @@ bool Table::isColumn(string columnName) {
  * @param toColumnName 
  */
 void Table::renameColumn(string fromColumnName, string toColumnName) {
-    logger.log("Table::renameColumn");
+    LOG_TRACE("Table::renameColumn");
 
     if (colNameToIdx.find(fromColumnName) == colNameToIdx.end()) return; // Should never occur. Sanity check
 
     int target = colNameToIdx[fromColumnName];
     columns[target] = toColumnName;
+    if (this->indexedColumn == fromColumnName)
+        this->indexedColumn = toColumnName;
     auto nodeHandler = colNameToIdx.extract(fromColumnName);
     nodeHandler.key() = toColumnName;
     colNameToIdx.insert(std::move(nodeHandler));
@@ -218,16 +383,16 @@ void Table::renameColumn(string fromColumnName, string toColumnName) {
  *
  */
 void Table::print() {
-    logger.log("Table::print");
+    LOG_TRACE("Table::print");
     uint count = min((long long) PRINT_COUNT, this->rowCount);
 
     //print headings
     this->writeRow(this->columns, cout);
 
     Cursor cursor(this->tableName, 0, TABLE);
-    vector<int> row;
+    RowView row;
     for (int rowCounter = 0; rowCounter < count; rowCounter++) {
-        row = cursor.getNext();
+        row = cursor.getNextView();
         this->writeRow(row, cout);
     }
     printRowCount(this->rowCount);
@@ -242,7 +407,7 @@ void Table::print() {
  * @return vector<int> 
  */
 void Table::getNextPage(Cursor *cursor) {
-    logger.log("Table::getNext");
+    LOG_TRACE("Table::getNext");
 
     if (cursor->pageIndex < this->blockCount - 1) {
         cursor->nextPage(cursor->pageIndex + 1);
@@ -256,22 +421,37 @@ void Table::getNextPage(Cursor *cursor) {
  *
  */
 void Table::makePermanent() {
-    logger.log("Table::makePermanent");
+    LOG_TRACE("Table::makePermanent");
     if (!this->isPermanent())
         bufferManager.deleteFile(this->sourceFileName);
     string newSourceFile = "../data/" + this->tableName + ".csv";
-    ofstream fout(newSourceFile, ios::out);
+    CsvWriter writer(newSourceFile);
 
     //print headings
-    this->writeRow(this->columns, fout);
+    string headings;
+    CsvWriter::appendRow(this->columns, headings);
+    writer.write(headings);
 
-    Cursor cursor(this->tableName, 0, TABLE);
-    vector<int> row;
-    for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++) {
-        row = cursor.getNext();
-        this->writeRow(row, fout);
+    // A chunk of pages is read at a time; its pages are formatted in
+    // parallel and written in order
+    uint chunkPages = max(1u, (uint) (CsvWriter::CHUNK_BYTES / (BLOCK_SIZE * 1000)));
+    vector<vector<int>> pageValues(chunkPages);
+    vector<string> pageTexts(chunkPages);
+    for (uint firstPage = 0; firstPage < this->blockCount; firstPage += chunkPages) {
+        uint pageCount = min(chunkPages, this->blockCount - firstPage);
+        for (uint pageCounter = 0; pageCounter < pageCount; pageCounter++) {
+            pageValues[pageCounter].clear();
+            this->readPages(firstPage + pageCounter, 1, pageValues[pageCounter]);
+        }
+        threadPool.run(pageCount, [&](uint pageCounter) {
+            pageTexts[pageCounter].clear();
+            CsvWriter::appendRows(pageValues[pageCounter].data(), pageValues[pageCounter].size() / this->columnCount,
+                                  this->columnCount, pageTexts[pageCounter]);
+        });
+        writer.write(pageTexts, pageCount);
     }
-    fout.close();
+    if (!writer.close())
+        LOG_ERROR("Table::makePermanent: Err");
 }
 
 /**
@@ -281,7 +461,7 @@ void Table::makePermanent() {
  * @return false otherwise
  */
 bool Table::isPermanent() {
-    logger.log("Table::isPermanent");
+    LOG_TRACE("Table::isPermanent");
     if (this->sourceFileName == "../data/" + this->tableName + ".csv")
         return true;
     return false;
@@ -293,21 +473,181 @@ bool Table::isPermanent() {
  *
  */
 void Table::unload() {
-    logger.log("Table::~unload");
-    for (int pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
-        bufferManager.deleteFile(this->tableName, pageCounter);
+    LOG_TRACE("Table::~unload");
+    this->dropIndex();
+    if (this->layout == DSM) {
+        this->detachColumnChains();
+        bufferManager.dropPagesInMemory(this->tableName);
+        set<string> chains;
+        for (uint columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+            chains.insert(this->columnChain(columnCounter));
+        for (const string &chain: chains)
+            if (tableCatalogue.getChainReaders(chain, this).empty())
+                bufferManager.deleteRelation(chain, this->blockCount);
+    } else
+        bufferManager.deleteRelation(this->tableName, this->blockCount);
     if (!isPermanent())
         bufferManager.deleteFile(this->sourceFileName);
 }
 
+/**
+ * @brief Zone map of a page of the table
+ *
+ * @param pageIndex
+ * @return const ZoneMap* nullptr if none was recorded for the page
+ */
+const ZoneMap *Table::getZoneMap(uint pageIndex) const {
+    if (pageIndex >= this->zoneMaps.size() || this->zoneMaps[pageIndex].minimum.size() != this->columnCount)
+        return nullptr;
+    return &this->zoneMaps[pageIndex];
+}
+
+/**
+ * @brief Relation holding a column of a DSM table
+ *
+ * @param columnIndex
+ * @return string
+ */
+string Table::columnChain(uint columnIndex) const {
+    if (this->columnChains.empty())
+        return Page::columnChainName(this->tableName, columnIndex);
+    return this->columnChains[columnIndex];
+}
+
+/**
+ * @brief Makes sure no other table reads the column chains named after this
+ * table, so that they can be rewritten or deleted. Chains that are borrowed
+ * (by projections) are renamed and every table reading them, this one
+ * included, is pointed to the new name.
+ */
+void Table::detachColumnChains() {
+    LOG_TRACE("Table::detachColumnChains");
+    static uint detachedChainCount = 0;
+    if (this->layout != DSM)
+        return;
+    for (uint columnCounter = 0; columnCounter < this->columnCount; columnCounter++) {
+        string chain = Page::columnChainName(this->tableName, columnCounter);
+        vector<Table *> readers = tableCatalogue.getChainReaders(chain, this);
+        if (readers.empty())
+            continue;
+        string newChain = chain + "~" + to_string(detachedChainCount++);
+        bufferManager.renameRelation(chain, newChain, this->blockCount);
+        readers.push_back(this);
+        for (Table *reader: readers) {
+            if (reader->columnChains.empty())
+                for (uint readerColumn = 0; readerColumn < reader->columnCount; readerColumn++)
+                    reader->columnChains.push_back(Page::columnChainName(reader->tableName, readerColumn));
+            replace(reader->columnChains.begin(), reader->columnChains.end(), chain, newChain);
+        }
+    }
+}
+
+/**
+ * @brief Makes the table read its columns from the chains named after it
+ * again. Borrowed chains that no other table reads are deleted.
+ */
+void Table::releaseBorrowedChains() {
+    LOG_TRACE("Table::releaseBorrowedChains");
+    set<string> chains(this->columnChains.begin(), this->columnChains.end());
+    for (uint columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+        chains.erase(Page::columnChainName(this->tableName, columnCounter));
+    for (const string &chain: chains)
+        if (tableCatalogue.getChainReaders(chain, this).empty())
+            bufferManager.deleteRelation(chain, this->blockCount);
+    this->columnChains.clear();
+}
+
+/**
+ * @brief Appends the rows of up to pageCount pages, starting at firstPage, to
+ * values, row after row. Used to hold a chunk of the table in memory.
+ *
+ * @param firstPage
+ * @param pageCount
+ * @param values
+ * @return long long number of rows appended
+ */
+long long Table::readPages(uint firstPage, uint pageCount, vector<int> &values) {
+    LOG_TRACE("Table::readPages");
+    long long rowCount = 0;
+    uint lastPage = min(this->blockCount, firstPage + pageCount);
+    if (firstPage >= lastPage)
+        return 0;
+    Cursor cursor(this->tableName, firstPage, TABLE);
+    for (uint pageCounter = firstPage; pageCounter < lastPage; pageCounter++) {
+        if (pageCounter != firstPage)
+            cursor.nextPage(pageCounter);
+        for (int rowCounter = 0; rowCounter < cursor.page->getRowCount(); rowCounter++) {
+            RowView row = cursor.page->getRowView(rowCounter);
+            values.insert(values.end(), row.begin(), row.end());
+            rowCount++;
+        }
+    }
+    return rowCount;
+}
+
+/**
+ * @brief Hash of a value used to partition tables. Partitioning with another
+ * seed splits rows that fell into one partition before.
+ *
+ * @param key
+ * @param seed
+ * @return uint
+ */
+uint Table::hashKey(int key, uint seed) {
+    uint h = (uint) key ^ (seed * 0x9e3779b9u);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * @brief Splits the table into partitionCount temporary tables by the hash of
+ * a column, as hash joins and hash aggregation do when their input doesn't
+ * fit into memory. Every partition has one page of rows in memory while the
+ * table is scanned. The partitions are in the catalogue; empty ones are
+ * returned as nullptr.
+ *
+ * @param columnIndex
+ * @param partitionCount
+ * @param seed
+ * @return vector<Table*>
+ */
+vector<Table*> Table::partition(int columnIndex, uint partitionCount, uint seed) {
+    LOG_TRACE("Table::partition");
+    vector<Table*> partitions(partitionCount);
+    vector<TableBuilder> builders;
+    builders.reserve(partitionCount);
+    for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++) {
+        string partitionName = tableCatalogue.temporaryName("Temp_PARTITION_" + this->tableName + "_" + to_string(partitionCounter));
+        partitions[partitionCounter] = new Table(partitionName, this->columns);
+        tableCatalogue.insertTable(partitions[partitionCounter]);
+        builders.emplace_back(partitions[partitionCounter]);
+    }
+    ProfileScope scope("partition", true);
+    scope.setRows(this->rowCount, this->rowCount);
+    Cursor cursor = this->getCursor();
+    for (RowView row = cursor.getNextView(); !row.empty(); row = cursor.getNextView())
+        builders[hashKey(row[columnIndex], seed) % partitionCount].addRow(row);
+    for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+        if (!builders[partitionCounter].finish()) {
+            tableCatalogue.deleteTable(partitions[partitionCounter]->tableName);
+            partitions[partitionCounter] = nullptr;
+        }
+    return partitions;
+}
+
 /**
  * @brief Function that returns a cursor that reads rows from this table
  * 
  * @return Cursor 
  */
 Cursor Table::getCursor() {
-    logger.log("Table::getCursor");
+    LOG_TRACE("Table::getCursor");
     Cursor cursor(this->tableName, 0, TABLE);
+    cursor.readAhead();
     return cursor;
 }
 
@@ -318,7 +658,7 @@ Cursor Table::getCursor() {
  * @return int 
  */
 int Table::getColumnIndex(string columnName) {
-    logger.log("Table::getColumnIndex");
+    LOG_TRACE("Table::getColumnIndex");
 
     if (colNameToIdx.find(columnName) == colNameToIdx.end()) return -1; //Should never occur. Sanity check
     return colNameToIdx[columnName];
@@ -331,7 +671,7 @@ int Table::getColumnIndex(string columnName) {
  * @return vector<int> containing the indices of the columnNames in order of input
  */
 vector<int> Table::getColumnIndex(const vector<string> &columnNames) {
-    logger.log("Table::getColumnIndex");
+    LOG_TRACE("Table::getColumnIndex");
 
     vector<int> ret;
     for (const auto &i: columnNames) ret.emplace_back(getColumnIndex(i));
@@ -343,12 +683,34 @@ vector<int> Table::getColumnIndex(const vector<string> &columnNames) {
  *
  * @param colNames Names of columns to sort the table on
  * @param colMultipliers Specifies the multipliers for each of the columns
+ * @param dropDuplicates If set, only the first of the rows that are equal on
+ * all the sort columns is kept. Duplicates are dropped while the runs are
+ * formed and in every merge pass, so each pass has less to write.
+ *
+ * The sort is stable, so a table that already is in the order is left as it
+ * is.
  */
-void Table::sort(const vector<std::string> &colNames, const vector<int> &colMultipliers, const string& originalTableName) {
-    logger.log("Table::sort");
+void Table::sort(const vector<std::string> &colNames, const vector<int> &colMultipliers, const string& originalTableName,
+                 bool dropDuplicates) {
+    LOG_TRACE("Table::sort");
     auto colIndices = getColumnIndex(colNames);
-    sortingPhase(colIndices, colMultipliers, originalTableName);
-    mergingPhase(colIndices, colMultipliers);
+    if (originalTableName == this->tableName && !dropDuplicates && this->isSortedOn(colIndices, colMultipliers)) {
+        LOG_DEBUG("Table::sort: already sorted");
+        return;
+    }
+    // Sorting moves rows, which invalidates the row ids held by an index
+    this->dropIndex();
+    // The runs are written to the column chains named after the table
+    this->detachColumnChains();
+    ProfileScope scope("external sort");
+    long long rowsIn = this->rowCount;
+    // More frames than it takes to sort the table in a single run are of no use
+    MemoryGrant grant = memoryManager.grant(this->blockCount + 1);
+    auto runRows = sortingPhase(colIndices, colMultipliers, originalTableName, dropDuplicates, grant.size() - 1);
+    mergingPhase(colIndices, colMultipliers, runRows, dropDuplicates, grant.size() - 1);
+    this->sortColumns = colIndices;
+    this->sortMultipliers = colMultipliers;
+    scope.setRows(rowsIn, this->rowCount);
 }
 
 /**
@@ -358,132 +720,584 @@ void Table::sort(const vector<std::string> &colNames, const vector<int> &colMult
  * @param colMultiplier Specifies the multiplier for the column
  */
 void Table::sort(const std::string &colName, int colMultiplier, const string& originalTableName) {
-    logger.log("Table::sort");
+    LOG_TRACE("Table::sort");
     sort(vector<string>{colName}, vector<int>{colMultiplier}, originalTableName);
 }
+
+/**
+ * @brief Tells whether the rows of the table are in the given order, that
+ * is whether it is a prefix of the order they were sorted in. Sorting the
+ * table on it would not move any row.
+ *
+ * @param colIndices
+ * @param colMultipliers
+ */
+bool Table::isSortedOn(const vector<int> &colIndices, const vector<int> &colMultipliers) const {
+    if (colIndices.size() > this->sortColumns.size())
+        return false;
+    for (int k = 0; k < colIndices.size(); k++)
+        if (colIndices[k] != this->sortColumns[k] || colMultipliers[k] != this->sortMultipliers[k])
+            return false;
+    return true;
+}
+
+/**
+ * @brief Sets the order of the rows of a table holding the given columns of
+ * originalTable, row for row: the sort columns of the original for as long
+ * as they are among the columns.
+ *
+ * @param originalTable
+ * @param columnIndices columns of originalTable, in the order of this table
+ */
+void Table::inheritSortOrder(const Table *originalTable, const vector<int> &columnIndices) {
+    this->sortColumns.clear();
+    this->sortMultipliers.clear();
+    for (int k = 0; k < originalTable->sortColumns.size(); k++) {
+        auto it = find(columnIndices.begin(), columnIndices.end(), originalTable->sortColumns[k]);
+        if (it == columnIndices.end())
+            break;
+        this->sortColumns.push_back(it - columnIndices.begin());
+        this->sortMultipliers.push_back(originalTable->sortMultipliers[k]);
+    }
+}
+
+/**
+ * @brief The table in the order of the column: the table itself if it is in
+ * that order already, otherwise a sorted copy under a temporary name made
+ * from copyName, which the caller deletes.
+ *
+ * @param colName
+ * @param colMultiplier
+ * @param copyName
+ * @return Table*
+ */
+Table *Table::sortedOn(const string &colName, int colMultiplier, const string &copyName) {
+    LOG_TRACE("Table::sortedOn");
+    if (this->isSortedOn({this->getColumnIndex(colName)}, {colMultiplier}))
+        return this;
+    auto *sortedTable = new Table(tableCatalogue.temporaryName(copyName), this);
+    tableCatalogue.insertTable(sortedTable);
+    sortedTable->sort(colName, colMultiplier, this->tableName);
+    return sortedTable;
+}
+
+/**
+ * @brief Writes a sorted run into consecutive pages of a table, every page but
+ * the last one full, and records the row count of each page.
+ *
+ * @param table Table (in the catalogue) the pages belong to
+ * @param firstBlock First page of the run
+ * @param rows
+ * @param rowCount Number of rows in the run
+ */
+void Table::writeRun(Table *table, uint firstBlock, const vector<vector<int>> &rows, uint rowCount) {
+    LOG_TRACE("Table::writeRun");
+    vector<vector<int>> writeRows(table->maxRowsPerBlock);
+    for (uint written = 0, block = firstBlock; written < rowCount; block++) {
+        uint pageRows = min((uint) table->maxRowsPerBlock, rowCount - written);
+        for (uint r = 0; r < pageRows; r++)
+            writeRows[r] = rows[written + r];
+        table->rowsPerBlockCount[block] = pageRows;
+        table->zoneMaps[block] = ZoneMap(writeRows, pageRows, table->columnCount);
+        bufferManager.writePage(table->tableName, block, writeRows, pageRows, table->columnCount, table->layout, table->compressed);
+        written += pageRows;
+    }
+}
+
+/**
+ * @brief Order preserving encoding of the sort columns of a row. Every value
+ * becomes an unsigned 32 bit code (the sign bit flipped, and all bits flipped
+ * for descending columns) and the codes are packed two to a 64 bit word, so
+ * comparing the words in order compares the rows: a single integer compare
+ * for up to two sort columns.
+ *
+ * @param row
+ * @param colIndices
+ * @param colMultipliers 1 for ascending, -1 for descending columns
+ * @param key receives (colIndices.size() + 1) / 2 words
+ */
+static void normalizeKey(RowView row, const vector<int> &colIndices, const vector<int> &colMultipliers,
+                         uint64_t *key) {
+    for (int k = 0; k < colIndices.size(); k++) {
+        uint32_t code = (uint32_t) row[colIndices[k]] ^ 0x80000000u;
+        if (colMultipliers[k] < 0)
+            code = ~code;
+        if (k % 2 == 0)
+            key[k / 2] = (uint64_t) code << 32;
+        else
+            key[k / 2] |= code;
+    }
+}
+
 /**
- * @brief Performs the sorting phase of the external sort algorithm
+ * @brief LSD radix sort of row positions by the normalized keys of the rows,
+ * keyWords words per row: one counting pass per byte, from the last byte of
+ * the last word to the first byte of the first one. Passes over a byte that
+ * is the same in every key are skipped, such as the unused half of the last
+ * word for an odd number of sort columns. The sort is stable.
+ *
+ * @param keys
+ * @param keyWords
+ * @param first
+ * @param last
+ */
+static void radixSortRows(const vector<uint64_t> &keys, int keyWords, uint32_t *first, uint32_t *last) {
+    const size_t count = last - first;
+    vector<uint32_t> buffer(count);
+    uint32_t *from = first, *to = buffer.data();
+    for (int word = keyWords - 1; word >= 0; word--) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            size_t offsets[257] = {};
+            for (size_t position = 0; position < count; position++)
+                offsets[((keys[(size_t) from[position] * keyWords + word] >> shift) & 0xFF) + 1]++;
+            if (*max_element(offsets + 1, offsets + 257) == count)
+                continue;
+            partial_sum(offsets, offsets + 257, offsets);
+            for (size_t position = 0; position < count; position++)
+                to[offsets[(keys[(size_t) from[position] * keyWords + word] >> shift) & 0xFF]++] = from[position];
+            swap(from, to);
+        }
+    }
+    if (from != first)
+        copy(from, from + count, first);
+}
+
+/**
+ * @brief Puts rows[order[i]] at position i for every i, moving every row
+ * once by following the cycles of the permutation
+ *
+ * @param rows
+ * @param order
+ */
+static void permuteRows(vector<vector<int>> &rows, const vector<uint32_t> &order) {
+    vector<char> placed(order.size(), 0);
+    for (uint32_t start = 0; start < order.size(); start++) {
+        if (placed[start] || order[start] == start)
+            continue;
+        vector<int> first = std::move(rows[start]);
+        uint32_t position = start;
+        while (order[position] != start) {
+            rows[position] = std::move(rows[order[position]]);
+            placed[position] = 1;
+            position = order[position];
+        }
+        rows[position] = std::move(first);
+        placed[position] = 1;
+    }
+}
+
+/**
+ * @brief Performs the sorting phase of the external sort algorithm. Run i is
+ * written starting at block i * bufferBlocks.
  *
  * @param colIndices Indices of the columns to perform the sort on
  * @param colMultipliers Specifies the ordering for each column via multipliers (1 or -1)
+ * @param dropDuplicates
+ * @param bufferBlocks Blocks of a run, one less than the frames granted to the sort
+ * @return vector<uint> number of rows in each run
  */
-void Table::sortingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers, const string& originalTableName) {
-    logger.log("Table::sortingPhase");
+vector<uint> Table::sortingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers,
+                                 const string& originalTableName, bool dropDuplicates, uint bufferBlocks) {
+    LOG_TRACE("Table::sortingPhase");
 
-    const auto nb = BLOCK_COUNT - 1; //size of the buffer in blocks
+    const auto nb = bufferBlocks; //size of the buffer in blocks
     const auto b = blockCount; //size of the file in blocks
     const auto nr = (b + nb - 1) / nb; //Number of initial runs: ceil(B/Nb)
+    // The runs only spill if they are merged afterwards
+    ProfileScope scope("run generation", nr > 1);
+    profiler.countPass();
 
     Cursor cursor(originalTableName, 0, TABLE);
+    cursor.readAhead();
     vector<vector<int>> rows(maxRowsPerBlock * nb, vector<int>(columnCount));
-    vector<vector<int>> writeRows(maxRowsPerBlock, vector<int>(columnCount));
-    auto cmp = [&colIndices, &colMultipliers](const vector<int> &A, const vector<int> &B) {
-        for (int k = 0; k < colIndices.size() - 1; k++) {
-            if (A[colIndices[k]] != B[colIndices[k]])
-                return (A[colIndices[k]] * colMultipliers[k] < B[colIndices[k]] * colMultipliers[k]);
-        }
-        return (A[colIndices.back()] * colMultipliers.back() < B[colIndices.back()] * colMultipliers.back());
+    const int keyWords = (colIndices.size() + 1) / 2;
+    vector<uint64_t> keys;
+    vector<uint32_t> order;
+    auto keyLess = [&keys, keyWords](uint32_t A, uint32_t B) {
+        for (int word = 0; word < keyWords; word++)
+            if (keys[(size_t) A * keyWords + word] != keys[(size_t) B * keyWords + word])
+                return keys[(size_t) A * keyWords + word] < keys[(size_t) B * keyWords + word];
+        return A < B;
+    };
+    auto equal = [&colIndices](const vector<int> &A, const vector<int> &B) {
+        for (int k: colIndices)
+            if (A[k] != B[k])
+                return false;
+        return true;
     };
-    auto remBlocksToRead = b, remBlocksToWrite = b;
-    auto blocksRead = 0, blocksWritten = 0;
+    vector<uint> runRows(nr);
+    auto remBlocksToRead = b;
+    auto blocksRead = 0;
     for (int runIdx = 0; runIdx < nr; runIdx++) {
         int rowReadCounter = 0;
         for (int blkIdx = 0; blkIdx < min(nb, remBlocksToRead); blkIdx++) {
-            for (int r = 0; r < rowsPerBlockCount[blocksRead]; r++)
-                rows[rowReadCounter++] = cursor.getNext();
+            for (int r = 0; r < rowsPerBlockCount[blocksRead]; r++) {
+                RowView row = cursor.getNextView();
+                rows[rowReadCounter++].assign(row.begin(), row.end());
+            }
             blocksRead++;
         }
         remBlocksToRead = b - blocksRead;
-        std::sort(rows.begin(), rows.begin() + rowReadCounter, cmp);
-        int rowWrittenCounter = 0;
-        for (int blkIdx = 0; blkIdx < min(nb, remBlocksToWrite); blkIdx++) {
-            for (int r = 0; r < rowsPerBlockCount[blocksWritten]; r++)
-                writeRows[r] = rows[rowWrittenCounter++];
-            bufferManager.writePage(tableName, blocksWritten, writeRows, rowsPerBlockCount[blocksWritten], columnCount);
-            blocksWritten++;
+        // The next run is read from disk while this one is being sorted
+        for (uint blkIdx = blocksRead; blkIdx < min(b, blocksRead + PREFETCH_FRAMES); blkIdx++)
+            bufferManager.prefetch(originalTableName, blkIdx, TABLE);
+        // The rows are sorted through their normalized keys: the positions
+        // are radix sorted (a part per thread, the parts then merged), and
+        // the rows are moved into place once
+        keys.resize((size_t) rowReadCounter * keyWords);
+        for (int r = 0; r < rowReadCounter; r++)
+            normalizeKey(RowView{rows[r].data(), (int) columnCount, 1}, colIndices, colMultipliers,
+                         &keys[(size_t) r * keyWords]);
+        order.resize(rowReadCounter);
+        iota(order.begin(), order.end(), 0);
+        threadPool.sortWith(order.begin(), order.end(), keyLess,
+                            [&](vector<uint32_t>::iterator first, vector<uint32_t>::iterator last) {
+                                radixSortRows(keys, keyWords, order.data() + (first - order.begin()),
+                                              order.data() + (last - order.begin()));
+                            });
+        permuteRows(rows, order);
+        if (dropDuplicates)
+            rowReadCounter = std::unique(rows.begin(), rows.begin() + rowReadCounter, equal) - rows.begin();
+        writeRun(this, runIdx * nb, rows, rowReadCounter);
+        runRows[runIdx] = rowReadCounter;
+    }
+    // Every page has been rewritten into the table's own column chains
+    this->releaseBorrowedChains();
+    scope.setRows(this->rowCount, accumulate(runRows.begin(), runRows.end(), 0LL));
+    return runRows;
+}
+
+/**
+ * @brief Rows of a sorted run that one merge reads: rowCount rows from row
+ * firstRow on, of the run whose (packed) pages start at block firstBlock
+ */
+struct RunSegment {
+    uint firstBlock;
+    uint firstRow;
+    uint rowCount;
+};
+
+/**
+ * @brief Reads the rows of a run segment one after the other. Pages are read
+ * straight from disk, bypassing the buffer pool, so that merges can run on
+ * several threads.
+ */
+class RunReader {
+    const Table *table;
+    uint block;
+    uint slot;
+    uint remainingRows;
+    Page page;
+
+    void readPage() {
+        this->page = Page(this->table->tableName, this->block, this->table->rowsPerBlockCount[this->block],
+                          this->table->columnCount, this->table->layout, this->table->compressed);
+    }
+
+public:
+    RunReader(const Table *table, const RunSegment &segment) {
+        this->table = table;
+        this->block = segment.firstBlock + segment.firstRow / table->maxRowsPerBlock;
+        this->slot = segment.firstRow % table->maxRowsPerBlock;
+        this->remainingRows = segment.rowCount;
+        if (this->remainingRows)
+            this->readPage();
+    }
+
+    bool empty() const { return this->remainingRows == 0; }
+    RowView row() { return this->page.getRowView(this->slot); }
+
+    void advance() {
+        this->remainingRows--, this->slot++;
+        if (this->remainingRows && this->slot == this->page.getRowCount()) {
+            this->block++, this->slot = 0;
+            this->readPage();
         }
-        remBlocksToWrite = b - blocksWritten;
     }
+};
+
+/**
+ * @brief Tournament tree of losers over k inputs. Inner node i (1 <= i < k)
+ * keeps the loser of the match between its subtrees, node 0 the overall
+ * winner; the inputs are the leaves k .. 2k - 1. Once the winner has moved on
+ * to its next element, only the matches on its path to the root are replayed,
+ * which takes log2(k) comparisons.
+ *
+ * @tparam Less strict order on input indices (by their current elements)
+ */
+template <typename Less>
+class LoserTree {
+    vector<int> nodes;
+    int inputCount;
+    Less less;
+
+    int play(int node) {
+        if (node >= this->inputCount)
+            return node - this->inputCount;
+        int first = this->play(2 * node), second = this->play(2 * node + 1);
+        if (this->less(second, first)) {
+            this->nodes[node] = first;
+            return second;
+        }
+        this->nodes[node] = second;
+        return first;
+    }
+
+public:
+    LoserTree(int inputCount, Less less) : nodes(max(inputCount, 1), 0), inputCount(inputCount), less(less) {
+        if (inputCount > 1)
+            this->nodes[0] = this->play(1);
+    }
+
+    int winner() const { return this->nodes[0]; }
+
+    void replay() {
+        int winner = this->nodes[0];
+        for (int node = (winner + this->inputCount) / 2; node >= 1; node /= 2)
+            if (this->less(this->nodes[node], winner))
+                swap(this->nodes[node], winner);
+        this->nodes[0] = winner;
+    }
+};
+
+/**
+ * @brief Merges run segments of readTable into one run written, packed, from
+ * block firstBlock of writeTable on, keeping writeTable's rowsPerBlockCount
+ * and zone maps up to date. Rows are compared through their normalized keys (see
+ * normalizeKey) in a loser tree. Neither the buffer pool nor the catalogue is
+ * used, so several merges writing different blocks can run at the same time.
+ *
+ * @tparam fixedWords words of a key if known at compile time, 0 otherwise
+ * @return uint number of rows written
+ */
+template <int fixedWords>
+static uint mergeRunSegmentsWith(const Table *readTable, const vector<RunSegment> &segments, Table *writeTable,
+                                 uint firstBlock, const vector<int> &colIndices, const vector<int> &colMultipliers,
+                                 bool dropDuplicates) {
+    LOG_TRACE("mergeRunSegments");
+    vector<RunReader> readers;
+    for (const RunSegment &segment: segments)
+        if (segment.rowCount)
+            readers.emplace_back(readTable, segment);
+    if (readers.empty())
+        return 0;
+    // keys[reader * keyWords ..] is the key of the reader's current row
+    const int keyWords = fixedWords ? fixedWords : (colIndices.size() + 1) / 2;
+    vector<uint64_t> keys(readers.size() * keyWords);
+    for (int reader = 0; reader < readers.size(); reader++)
+        normalizeKey(readers[reader].row(), colIndices, colMultipliers, &keys[reader * keyWords]);
+    // Exhausted readers lose every match; equal rows leave in reader order
+    auto less = [&](int A, int B) {
+        if (readers[A].empty() || readers[B].empty())
+            return !readers[A].empty();
+        const uint64_t *keyA = &keys[A * keyWords], *keyB = &keys[B * keyWords];
+        for (int word = 0; word < keyWords; word++)
+            if (keyA[word] != keyB[word])
+                return keyA[word] < keyB[word];
+        return A < B;
+    };
+    LoserTree<decltype(less)> tree(readers.size(), less);
+
+    const uint maxRowsPerBlock = writeTable->maxRowsPerBlock, columnCount = writeTable->columnCount;
+    vector<vector<int>> writeRows(maxRowsPerBlock, vector<int>(columnCount));
+    uint writeRowCounter = 0, writeBlockCounter = firstBlock, rowsWritten = 0;
+    auto writePage = [&]() {
+        writeTable->rowsPerBlockCount[writeBlockCounter] = writeRowCounter;
+        writeTable->zoneMaps[writeBlockCounter] = ZoneMap(writeRows, writeRowCounter, columnCount);
+        Page(writeTable->tableName, writeBlockCounter++, writeRows, writeRowCounter, columnCount, writeTable->layout,
+             writeTable->compressed).writePage();
+        writeRowCounter = 0;
+    };
+    // Rows are duplicates when their keys are equal
+    vector<uint64_t> lastKey;
+    while (!readers[tree.winner()].empty()) {
+        int reader = tree.winner();
+        const uint64_t *key = &keys[reader * keyWords];
+        if (!dropDuplicates || lastKey.empty() || !equal(key, key + keyWords, lastKey.begin())) {
+            if (writeRowCounter == maxRowsPerBlock)
+                writePage();
+            RowView row = readers[reader].row();
+            writeRows[writeRowCounter++].assign(row.begin(), row.end());
+            rowsWritten++;
+            if (dropDuplicates)
+                lastKey.assign(key, key + keyWords);
+        }
+        readers[reader].advance();
+        if (!readers[reader].empty())
+            normalizeKey(readers[reader].row(), colIndices, colMultipliers, &keys[reader * keyWords]);
+        tree.replay();
+    }
+    if (writeRowCounter)
+        writePage();
+    return rowsWritten;
 }
 
 /**
- * @brief Performs the merging phase of the external sort algorithm
+ * @brief Merges run segments (see mergeRunSegmentsWith). Keys of up to four
+ * sort columns fit into one or two words; for those the comparisons of the
+ * loser tree are compiled for the exact key length.
+ */
+static uint mergeRunSegments(const Table *readTable, const vector<RunSegment> &segments, Table *writeTable,
+                             uint firstBlock, const vector<int> &colIndices, const vector<int> &colMultipliers,
+                             bool dropDuplicates) {
+    switch ((colIndices.size() + 1) / 2) {
+    case 1:
+        return mergeRunSegmentsWith<1>(readTable, segments, writeTable, firstBlock, colIndices, colMultipliers,
+                                       dropDuplicates);
+    case 2:
+        return mergeRunSegmentsWith<2>(readTable, segments, writeTable, firstBlock, colIndices, colMultipliers,
+                                       dropDuplicates);
+    default:
+        return mergeRunSegmentsWith<0>(readTable, segments, writeTable, firstBlock, colIndices, colMultipliers,
+                                       dropDuplicates);
+    }
+}
+
+/**
+ * @brief Performs the merging phase of the external sort algorithm. In every
+ * pass bufferBlocks runs are merged into one, which is written where the
+ * first of them starts. The merges of a pass are independent and run on the
+ * thread pool, each with a budget of bufferBlocks + 1 blocks. The final merge is
+ * split by key range instead (see parallelFinalMerge). Once a single run is
+ * left the table is resized to it.
  *
  * @param colIndices
  * @param colMultipliers
+ * @param runRows Number of rows in each of the runs formed by sortingPhase
+ * @param dropDuplicates
+ * @param bufferBlocks Runs merged at a time, as in sortingPhase
  */
-void Table::mergingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers) {
-    logger.log("Table::mergingPhase");
+void Table::mergingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers, vector<uint> runRows,
+                         bool dropDuplicates, uint bufferBlocks) {
+    LOG_TRACE("Table::mergingPhase");
 
-    const auto nb = BLOCK_COUNT - 1; //size of the buffer in blocks
+    const auto nb = bufferBlocks; //size of the buffer in blocks
     const auto b = blockCount; //size of the file in blocks
     auto nr = (b + nb - 1) / nb; //Number of initial runs: ceil(B/Nb)
-    vector<vector<int>> writeRows(maxRowsPerBlock, vector<int>(columnCount));
     auto runSize = nb;
-    vector<uint> remRows(nb, 0);
-    vector<Cursor> currCursors(nb);
-    auto cmp = [&colIndices, &colMultipliers](const pair<vector<int>, int> &A, const pair<vector<int>, int> &B) {
-        for (int k = 0; k < colIndices.size() - 1; k++) {
-            if (A.first[colIndices[k]] != B.first[colIndices[k]])
-                return (A.first[colIndices[k]] * colMultipliers[k] > B.first[colIndices[k]] * colMultipliers[k]);
-        }
-        return (A.first[colIndices.back()] * colMultipliers.back() >
-                B.first[colIndices.back()] * colMultipliers.back());
-    };
-    //TODO: Make cmp util?
-    priority_queue<pair<vector<int>, int>, vector<pair<vector<int>, int>>, decltype(cmp)> pq(cmp);
-    string readTableName = tableName, writeTableName = "sort_buffer_" + tableName;
-    while (tableCatalogue.isTable(writeTableName)) writeTableName += "_"; //TODO: Random?
+    uint sortedBlockCount = (runRows[0] + this->maxRowsPerBlock - 1) / this->maxRowsPerBlock;
+    string readTableName = tableName, writeTableName = tableCatalogue.temporaryName("sort_buffer_" + tableName);
     auto writeTable = new Table(writeTableName, this);
     tableCatalogue.insertTable(writeTable);
     while (nr > 1) {
-        logger.log("Table:MergePhaseStage");
-        logger.log(to_string(nr) + "," + to_string(runSize));
+        LOG_TRACE("Table:MergePhaseStage");
+        LOG_DEBUG(to_string(nr) + "," + to_string(runSize));
         auto curr = (nr + nb - 1) / nb; //Number of subfiles to write in this pass: ceil(nr / nb)
-        int writeBlockCounter = 0;
-        for (uint runIdx = 0; runIdx < curr; runIdx++) {
-            int i = 0;
-            for (auto blkIdx = runIdx * nb * runSize; blkIdx < min((runIdx + 1) * nb * runSize, b); blkIdx += runSize) {
-                currCursors[i] = Cursor(readTableName, blkIdx, TABLE);
-                logger.log(to_string(runIdx) + "," + to_string(blkIdx));
-                for (int j = 0; j < runSize and blkIdx + j < b; j++)
-                    remRows[i] += rowsPerBlockCount[blkIdx + j]; //TODO: use maxRowsPerBlock instead?
-                assert(remRows[i]); //Should never happen. Sanity check
-                vector<int> row = currCursors[i].getNext();
-                remRows[i]--;
-                pq.emplace(row, i);
-                i++;
-            }
-            for (auto &j: remRows) logger.log(to_string(j) + ":");
-            auto writeRowCounter = 0;
-            while (!pq.empty()) {
-                if (writeRowCounter == maxRowsPerBlock) {
-                    bufferManager.writePage(writeTableName, writeBlockCounter++, writeRows, writeRowCounter,
-                                            columnCount);
-                    writeRowCounter = 0;
-                }
-                auto [row, idx] = pq.top();
-                pq.pop();
-                writeRows[writeRowCounter++] = row;
-                if (remRows[idx]) {
-                    remRows[idx]--;
-                    row = currCursors[idx].getNext();
-                    pq.emplace(row, idx);
-                }
-            }
-            if (writeRowCounter) {
-                bufferManager.writePage(writeTableName, writeBlockCounter++, writeRows, writeRowCounter, columnCount);
-                writeRowCounter = 0;
-            }
+        ProfileScope scope("merge pass", curr > 1);
+        profiler.countPass();
+        Table *readingTable = readTableName == tableName ? this : writeTable;
+        Table *writingTable = writeTableName == tableName ? this : writeTable;
+        // The merges read and write pages without the pool: the pages to be
+        // read have to be on disk and the pool must not keep stale copies of
+        // the pages being replaced
+        bufferManager.flushPages(readTableName);
+        bufferManager.dropPagesInMemory(writeTableName);
+        vector<uint> mergedRunRows(curr, 0);
+        if (curr == 1 && !dropDuplicates && threadPool.size() > 1)
+            sortedBlockCount = parallelFinalMerge(readingTable, writingTable, nr, runSize, runRows, mergedRunRows[0],
+                                                  colIndices, colMultipliers);
+        else {
+            threadPool.run(curr, [&](uint runIdx) {
+                vector<RunSegment> segments;
+                for (uint run = runIdx * nb; run < min((runIdx + 1) * nb, nr); run++)
+                    segments.push_back({run * runSize, 0, runRows[run]});
+                mergedRunRows[runIdx] = mergeRunSegments(readingTable, segments, writingTable, runIdx * nb * runSize,
+                                                         colIndices, colMultipliers, dropDuplicates);
+            });
+            sortedBlockCount = (mergedRunRows[0] + this->maxRowsPerBlock - 1) / this->maxRowsPerBlock;
         }
+        scope.setRows(accumulate(runRows.begin(), runRows.end(), 0LL),
+                      accumulate(mergedRunRows.begin(), mergedRunRows.end(), 0LL));
         nr = curr, runSize *= nb;
+        runRows.swap(mergedRunRows);
         readTableName.swap(writeTableName);
     }
     readTableName.swap(writeTableName);
+    Table *sortedTable = writeTableName == tableName ? this : writeTable;
+    this->rowCount = runRows[0];
+    this->blockCount = sortedBlockCount;
+    if (sortedTable != this) {
+        this->rowsPerBlockCount = sortedTable->rowsPerBlockCount;
+        this->zoneMaps = sortedTable->zoneMaps;
+    }
+    this->rowsPerBlockCount.resize(this->blockCount);
+    this->zoneMaps.resize(this->blockCount);
     if (writeTableName != tableName) {
         writeTable->rename(tableName);
         tableCatalogue.eraseTable(writeTableName);
-    } else tableCatalogue.eraseTable(readTableName);
+    } else tableCatalogue.deleteTable(readTableName);
+}
+
+/**
+ * @brief Merges the last runCount runs into one on all threads of the pool.
+ * Rows of the longest run at evenly spaced positions split the key space
+ * into one range per thread; binary searches find where every run crosses
+ * the splitters, and each thread merges its range of every run into its own
+ * stretch of blocks. Only the last page of a stretch can be partly filled.
+ *
+ * @param rowsMerged receives the number of rows of the merged run
+ * @return uint number of blocks of the merged run
+ */
+uint Table::parallelFinalMerge(Table *readingTable, Table *writingTable, uint runCount, uint runSize,
+                               const vector<uint> &runRows, uint &rowsMerged, const vector<int> &colIndices,
+                               const vector<int> &colMultipliers) {
+    LOG_TRACE("Table::parallelFinalMerge");
+    const uint parts = threadPool.size();
+    unordered_map<uint, Page> probedPages;
+    auto rowAt = [&](uint run, uint row) {
+        uint block = run * runSize + row / this->maxRowsPerBlock;
+        auto it = probedPages.find(block);
+        if (it == probedPages.end())
+            it = probedPages.emplace(block, Page(readingTable->tableName, block, readingTable->rowsPerBlockCount[block],
+                                                 this->columnCount, this->layout, this->compressed)).first;
+        return it->second.getRow(row % this->maxRowsPerBlock);
+    };
+    auto less = [&](const vector<int> &A, const vector<int> &B) {
+        for (int k = 0; k < colIndices.size(); k++)
+            if (A[colIndices[k]] != B[colIndices[k]])
+                return (colMultipliers[k] < 0) != (A[colIndices[k]] < B[colIndices[k]]);
+        return false;
+    };
+    uint longestRun = max_element(runRows.begin(), runRows.begin() + runCount) - runRows.begin();
+    vector<vector<int>> splitters;
+    for (uint part = 1; part < parts; part++)
+        splitters.push_back(rowAt(longestRun, (size_t) runRows[longestRun] * part / parts));
+
+    // bounds[run][part] is the first row of the run that belongs to the part
+    vector<vector<uint>> bounds(runCount, vector<uint>(parts + 1, 0));
+    vector<uint> partRows(parts, 0);
+    for (uint run = 0; run < runCount; run++) {
+        bounds[run][parts] = runRows[run];
+        for (uint part = 1; part < parts; part++) {
+            uint low = bounds[run][part - 1], high = runRows[run];
+            while (low < high) {
+                uint middle = low + (high - low) / 2;
+                if (less(rowAt(run, middle), splitters[part - 1]))
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            bounds[run][part] = low;
+        }
+        for (uint part = 0; part < parts; part++)
+            partRows[part] += bounds[run][part + 1] - bounds[run][part];
+    }
+    vector<uint> firstBlocks(parts + 1, 0);
+    for (uint part = 0; part < parts; part++)
+        firstBlocks[part + 1] = firstBlocks[part] + (partRows[part] + this->maxRowsPerBlock - 1) / this->maxRowsPerBlock;
+    if (writingTable->rowsPerBlockCount.size() < firstBlocks[parts]) {
+        writingTable->rowsPerBlockCount.resize(firstBlocks[parts]);
+        writingTable->zoneMaps.resize(firstBlocks[parts]);
+    }
+
+    threadPool.run(parts, [&](uint part) {
+        vector<RunSegment> segments;
+        for (uint run = 0; run < runCount; run++)
+            segments.push_back({run * runSize, bounds[run][part], bounds[run][part + 1] - bounds[run][part]});
+        mergeRunSegments(readingTable, segments, writingTable, firstBlocks[part], colIndices, colMultipliers, false);
+    });
+    rowsMerged = accumulate(partRows.begin(), partRows.end(), 0u);
+    return firstBlocks[parts];
 }
 
 /**
@@ -491,10 +1305,166 @@ void Table::mergingPhase(const vector<int> &colIndices, const vector<int> &colMu
  * @param newName
  */
 void Table::rename(const string &newName) {
-    logger.log("Table::rename");
-    bufferManager.renamePagesInMemory(tableName, newName);
-
-    for (int pageCounter = 0; pageCounter < blockCount; pageCounter++)
-        bufferManager.renameFile(tableName, newName, pageCounter);
+    LOG_TRACE("Table::rename");
+    if (layout == DSM) {
+        detachColumnChains();
+        bufferManager.dropPagesInMemory(tableName);
+        bufferManager.dropPagesInMemory(newName);
+        if (columnChains.empty())
+            for (uint columnCounter = 0; columnCounter < columnCount; columnCounter++)
+                bufferManager.renameRelation(Page::columnChainName(tableName, columnCounter),
+                                             Page::columnChainName(newName, columnCounter), blockCount);
+    } else
+        bufferManager.renameRelation(tableName, newName, blockCount);
     tableName = newName;
+    if (this->index)
+        tableCatalogue.renameIndex(this->index->indexName, this->indexNameFor(newName));
+}
+
+/**
+ * @brief Name of the relation holding the index of the table tableName. It
+ * must not clash with any table.
+ *
+ * @param tableName
+ * @return string
+ */
+string Table::indexNameFor(const string &tableName) {
+    string indexName = tableName + "_Index";
+    while (tableCatalogue.isTable(indexName) || tableCatalogue.isIndex(indexName))
+        indexName += "_";
+    return indexName;
+}
+
+/**
+ * @brief Indexes the table on the given column, replacing the index it had.
+ * Creating an index with the NOTHING strategy just drops the current one.
+ *
+ * @param columnName
+ * @param strategy
+ * @return true if the index has been built
+ * @return false otherwise
+ */
+bool Table::createIndex(const string &columnName, IndexingStrategy strategy) {
+    LOG_TRACE("Table::createIndex");
+    this->dropIndex();
+    if (strategy == NOTHING)
+        return true;
+    TableIndex *index;
+    if (strategy == HASH)
+        index = new HashIndex(this->indexNameFor(this->tableName), this->getColumnIndex(columnName));
+    else
+        index = new BPlusTree(this->indexNameFor(this->tableName), this->getColumnIndex(columnName));
+    tableCatalogue.insertIndex(index);
+    if (!index->build(this)) {
+        tableCatalogue.deleteIndex(index->indexName);
+        return false;
+    }
+    this->index = index;
+    this->indexed = true;
+    this->indexedColumn = columnName;
+    this->indexingStrategy = strategy;
+    return true;
+}
+
+/**
+ * @brief Deletes the index of the table, if there is one
+ */
+void Table::dropIndex() {
+    LOG_TRACE("Table::dropIndex");
+    if (!this->index)
+        return;
+    tableCatalogue.deleteIndex(this->index->indexName);
+    this->index = nullptr;
+    this->indexed = false;
+    this->indexedColumn = "";
+    this->indexingStrategy = NOTHING;
+}
+
+/**
+ * @brief Persists everything the catalogue knows about the table (see
+ * TableCatalogue::save), its index included. The pages themselves stay
+ * where they are.
+ *
+ * @param writer
+ */
+void Table::save(CatalogWriter &writer) const {
+    LOG_TRACE("Table::save");
+    writer.write(this->sourceFileName);
+    writer.write(this->tableName);
+    writer.write(this->columns);
+    writer.write((uint64_t) this->columnStatistics.size());
+    for (const ColumnStatistics &statistics: this->columnStatistics)
+        statistics.save(writer);
+    writer.write(this->distinctValuesPerColumnCount);
+    writer.write(this->columnCount);
+    writer.write(this->rowCount);
+    writer.write(this->blockCount);
+    writer.write(this->maxRowsPerBlock);
+    writer.write(this->rowsPerBlockCount);
+    writer.write((uint64_t) this->zoneMaps.size());
+    for (const ZoneMap &zoneMap: this->zoneMaps)
+        zoneMap.save(writer);
+    writer.write(this->layout);
+    writer.write(this->compressed);
+    writer.write(this->columnChains);
+    writer.write(this->sortColumns);
+    writer.write(this->sortMultipliers);
+    writer.write(this->indexed);
+    writer.write(this->indexedColumn);
+    writer.write(this->indexingStrategy);
+    writer.write(this->index != nullptr);
+    if (this->index)
+        this->index->save(writer);
+}
+
+/**
+ * @brief Reads back a table saved by save, into a table made with the
+ * default constructor. Inserting the table and its index into the catalogue
+ * is left to the caller.
+ *
+ * @param reader
+ * @return false if the catalogue file is damaged
+ */
+bool Table::restore(CatalogReader &reader) {
+    LOG_TRACE("Table::restore");
+    uint64_t statisticsCount = 0, zoneMapCount = 0;
+    if (!reader.read(this->sourceFileName) || !reader.read(this->tableName) || !reader.read(this->columns) ||
+        !reader.read(statisticsCount) || statisticsCount > this->columns.size())
+        return false;
+    this->columnStatistics.assign(statisticsCount, ColumnStatistics());
+    for (ColumnStatistics &statistics: this->columnStatistics)
+        if (!statistics.restore(reader))
+            return false;
+    if (!reader.read(this->distinctValuesPerColumnCount) || !reader.read(this->columnCount) ||
+        !reader.read(this->rowCount) || !reader.read(this->blockCount) || !reader.read(this->maxRowsPerBlock) ||
+        !reader.read(this->rowsPerBlockCount) || !reader.read(zoneMapCount) || zoneMapCount > this->blockCount)
+        return false;
+    this->zoneMaps.assign(zoneMapCount, ZoneMap());
+    for (ZoneMap &zoneMap: this->zoneMaps)
+        if (!zoneMap.restore(reader))
+            return false;
+    bool hasIndex = false;
+    if (!reader.read(this->layout) || !reader.read(this->compressed) || !reader.read(this->columnChains) ||
+        !reader.read(this->sortColumns) || !reader.read(this->sortMultipliers) ||
+        this->sortColumns.size() != this->sortMultipliers.size() ||
+        any_of(this->sortColumns.begin(), this->sortColumns.end(),
+               [this](int column) { return column < 0 || column >= this->columnCount; }) ||
+        !reader.read(this->indexed) || !reader.read(this->indexedColumn) || !reader.read(this->indexingStrategy) ||
+        !reader.read(hasIndex) || this->columns.size() != this->columnCount ||
+        this->rowsPerBlockCount.size() != this->blockCount)
+        return false;
+    for (int columnCounter = 0; columnCounter < this->columns.size(); columnCounter++)
+        this->colNameToIdx[this->columns[columnCounter]] = columnCounter;
+    if (!hasIndex)
+        return true;
+    if (this->indexingStrategy == HASH)
+        this->index = new HashIndex("", -1);
+    else
+        this->index = new BPlusTree("", -1);
+    if (!this->index->restore(reader)) {
+        delete this->index;
+        this->index = nullptr;
+        return false;
+    }
+    return true;
 }
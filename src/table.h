@@ -1,4 +1,10 @@
 #include "cursor.h"
+#include "csvReader.h"
+#include "csvWriter.h"
+#include "columnarFile.h"
+#include "bPlusTree.h"
+#include "hashIndex.h"
+#include "statistics.h"
 
 enum IndexingStrategy
 {
@@ -15,34 +21,58 @@ enum IndexingStrategy
  * command and the second is to use assignment statements (SELECT, PROJECT,
  * JOIN, SORT, CROSS and DISTINCT). 
  *
+ * The columns of a DSM table are stored in column chains named after the
+ * table (see Page::columnChainName). A table projected out of a DSM table
+ * borrows the chains of its columns instead, and columnChains lists them;
+ * a chain is deleted once no table reads it anymore.
+ *
+ * sortColumns and sortMultipliers record the physical order of the rows:
+ * they are sorted on those columns, in those directions, as Table::sort
+ * leaves them. Operators that keep the order of their input (SELECT,
+ * PROJECT) pass it on, and operators that need sorted input use a table
+ * that already is in order as it is (see isSortedOn).
+ *
  */
 class Table
 {
-    vector<unordered_set<int>> distinctValuesInColumns;
-
 public:
     string sourceFileName = "";
     string tableName = "";
     vector<string> columns;
+    vector<ColumnStatistics> columnStatistics;
     vector<uint> distinctValuesPerColumnCount;
     uint columnCount = 0;
     long long int rowCount = 0;
     uint blockCount = 0;
     uint maxRowsPerBlock = 0;
     vector<uint> rowsPerBlockCount;
+    vector<ZoneMap> zoneMaps;
     bool indexed = false;
     string indexedColumn = "";
     IndexingStrategy indexingStrategy = NOTHING;
+    TableIndex *index = nullptr;
+    PageLayout layout = NSM;
+    bool compressed = false;
+    vector<string> columnChains;
     map<string, int> colNameToIdx;
+    vector<int> sortColumns;
+    vector<int> sortMultipliers;
 
     bool extractColumnNames(string firstLine);
     bool blockify();
-    void updateStatistics(vector<int> row);
+    bool computeCompressedBlockSize(CsvReader &reader);
+    bool setCompressedBlockSize(const vector<pair<int, int>> &columnRanges);
+    void startStatistics();
+    void updateStatistics(const vector<int> &row);
+    void mergeStatistics(vector<vector<ColumnStatistics>> &partialStatistics);
+    void finishStatistics();
     Table();
     Table(string tableName);
     Table(string tableName, Table *originalTable);
     Table(string tableName, vector<string> columns);
+    Table(string tableName, Table *originalTable, const vector<int> &columnIndices);
     bool load();
+    bool loadBinary();
     bool isColumn(string columnName);
     void renameColumn(string fromColumnName, string toColumnName);
     void print();
@@ -50,14 +80,36 @@ public:
     bool isPermanent();
     void getNextPage(Cursor *cursor);
     Cursor getCursor();
+    long long readPages(uint firstPage, uint pageCount, vector<int> &values);
+    const ZoneMap *getZoneMap(uint pageIndex) const;
+    string columnChain(uint columnIndex) const;
+    void detachColumnChains();
+    void releaseBorrowedChains();
+    static uint hashKey(int key, uint seed);
+    vector<Table*> partition(int columnIndex, uint partitionCount, uint seed);
     int getColumnIndex(string columnName);
     vector<int> getColumnIndex(const vector<string> &columnNames);
     void unload();
-    void sort(const vector<string> &colNames, const vector<int> &colMultipliers, const string& originalTableName);
+    void sort(const vector<string> &colNames, const vector<int> &colMultipliers, const string& originalTableName,
+              bool dropDuplicates = false);
     void sort(const std::string &colName, int colMultiplier, const string& originalTableName);
-    void sortingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers, const string& originalTableName);
-    void mergingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers);
+    bool isSortedOn(const vector<int> &colIndices, const vector<int> &colMultipliers) const;
+    void inheritSortOrder(const Table *originalTable, const vector<int> &columnIndices);
+    Table *sortedOn(const string &colName, int colMultiplier, const string &copyName);
+    static void writeRun(Table *table, uint firstBlock, const vector<vector<int>> &rows, uint rowCount);
+    vector<uint> sortingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers,
+                              const string& originalTableName, bool dropDuplicates, uint bufferBlocks);
+    void mergingPhase(const vector<int> &colIndices, const vector<int> &colMultipliers, vector<uint> runRows,
+                      bool dropDuplicates, uint bufferBlocks);
+    uint parallelFinalMerge(Table *readingTable, Table *writingTable, uint runCount, uint runSize,
+                            const vector<uint> &runRows, uint &rowsMerged, const vector<int> &colIndices,
+                            const vector<int> &colMultipliers);
     void rename(const string &newName);
+    static string indexNameFor(const string &tableName);
+    bool createIndex(const string &columnName, IndexingStrategy strategy);
+    void dropIndex();
+    void save(CatalogWriter &writer) const;
+    bool restore(CatalogReader &reader);
 
     /**
  * @brief Static function that takes a vector of valued and prints them out in a
@@ -67,9 +119,9 @@ public:
  * @param row 
  */
 template <typename T>
-void writeRow(vector<T> row, ostream &fout)
+void writeRow(const vector<T> &row, ostream &fout)
 {
-    logger.log("Table::printRow");
+    LOG_TRACE("Table::printRow");
     for (int columnCounter = 0; columnCounter < row.size(); columnCounter++)
     {
         if (columnCounter != 0)
@@ -80,34 +132,19 @@ void writeRow(vector<T> row, ostream &fout)
 }
 
 /**
- * @brief Static function that takes a vector of valued and prints them out in a
- * comma seperated format.
- *
- * @tparam T current usaages include int and string
- * @param row 
- */
-template <typename T>
-void writeRow(vector<T> row)
-{
-    logger.log("Table::printRow");
-    ofstream fout(this->sourceFileName, ios::app);
-    this->writeRow(row, fout);
-    fout.close();
-}
-
-/**
- * @brief Static function that takes a vector of valued and prints them out in a
- * comma seperated format.
+ * @brief Takes a view of a row and prints it out in a comma seperated format.
  *
- * @tparam T current usaages include int and string
  * @param row
  */
-    template <typename T>
-    void writeRows(const vector<vector<T>>& rows, const int rowCount)
+void writeRow(RowView row, ostream &fout)
+{
+    LOG_TRACE("Table::printRow");
+    for (int columnCounter = 0; columnCounter < row.size(); columnCounter++)
     {
-        logger.log("Table::printRow");
-        ofstream fout(this->sourceFileName, ios::app);
-        for (int i = 0; i < rowCount; i++) this->writeRow(rows[i], fout);
-        fout.close();
+        if (columnCounter != 0)
+            fout << ", ";
+        fout << row[columnCounter];
     }
+    fout << endl;
+}
 };
\ No newline at end of file
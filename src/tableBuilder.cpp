@@ -0,0 +1,132 @@
+#include "global.h"
+
+/**
+ * @brief Construct a new TableBuilder object that fills the given table
+ *
+ * @param table
+ * @param collectStatistics
+ */
+TableBuilder::TableBuilder(Table *table, bool collectStatistics) : table(table), collectStatistics(collectStatistics) {
+    LOG_TRACE("TableBuilder::TableBuilder");
+    this->rowsInPage.assign(table->maxRowsPerBlock, vector<int>(table->columnCount, 0));
+    table->startStatistics();
+}
+
+/**
+ * @brief Hands the rows collected so far to the buffer manager as the next
+ * page of the table.
+ */
+void TableBuilder::writePage() {
+    LOG_TRACE("TableBuilder::writePage");
+    bufferManager.writePage(this->table->tableName, this->table->blockCount, this->rowsInPage, this->pageRowCount,
+                            this->table->columnCount, this->table->layout, this->table->compressed);
+    this->table->blockCount++;
+    this->table->rowsPerBlockCount.emplace_back(this->pageRowCount);
+    this->table->zoneMaps.emplace_back(this->rowsInPage, this->pageRowCount, this->table->columnCount);
+    this->pageRowCount = 0;
+}
+
+/**
+ * @brief Appends a row to the table
+ *
+ * @param row
+ */
+void TableBuilder::addRow(const vector<int> &row) {
+    vector<int> &pageRow = this->rowsInPage[this->pageRowCount++];
+    copy(row.begin(), row.begin() + this->table->columnCount, pageRow.begin());
+    this->table->rowCount++;
+    if (this->collectStatistics)
+        this->table->updateStatistics(pageRow);
+    if (this->pageRowCount == this->table->maxRowsPerBlock)
+        this->writePage();
+}
+
+/**
+ * @brief Appends a row read through a cursor (or taken from a page) to the
+ * table
+ *
+ * @param row
+ */
+void TableBuilder::addRow(RowView row) {
+    vector<int> &pageRow = this->rowsInPage[this->pageRowCount++];
+    copy(row.begin(), row.end(), pageRow.begin());
+    this->table->rowCount++;
+    if (this->collectStatistics)
+        this->table->updateStatistics(pageRow);
+    if (this->pageRowCount == this->table->maxRowsPerBlock)
+        this->writePage();
+}
+
+/**
+ * @brief Appends the first rowCount rows to the table
+ *
+ * @param rows
+ * @param rowCount
+ */
+void TableBuilder::addRows(const vector<vector<int>> &rows, int rowCount) {
+    for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+        this->addRow(rows[rowCounter]);
+}
+
+/**
+ * @brief Appends the rows of morselCount morsels, which produce(morsel,
+ * values) computes on the thread pool, appending the values of the rows of
+ * the morsel row after row. The morsels run a wave at a time, so only the
+ * rows of one wave are held; the rows of a wave are appended in morsel
+ * order once it is done. The column statistics of the rows are collected by
+ * the workers as they go and merged at the end.
+ *
+ * @param morselCount
+ * @param produce
+ */
+void TableBuilder::addMorsels(uint morselCount, const function<void(uint morsel, vector<int> &values)> &produce) {
+    LOG_TRACE("TableBuilder::addMorsels");
+    const uint columnCount = this->table->columnCount, waveMorsels = threadPool.size() * 8;
+    vector<vector<ColumnStatistics>> partialStatistics;
+    if (this->collectStatistics)
+        partialStatistics.assign(threadPool.size(), vector<ColumnStatistics>(columnCount));
+    vector<vector<int>> outputs(min(waveMorsels, morselCount));
+    for (uint firstMorsel = 0; firstMorsel < morselCount; firstMorsel += waveMorsels) {
+        uint waveCount = min(waveMorsels, morselCount - firstMorsel);
+        threadPool.runMorsels(waveCount, [&](uint worker, uint morsel) {
+            vector<int> &values = outputs[morsel];
+            values.clear();
+            produce(firstMorsel + morsel, values);
+            if (partialStatistics.empty())
+                return;
+            // Row ids only have to be unique, so every morsel numbers its own rows
+            vector<ColumnStatistics> &statistics = partialStatistics[worker];
+            for (size_t rowStart = 0, rowCounter = 0; rowStart < values.size(); rowStart += columnCount, rowCounter++) {
+                uint64_t rowId = (uint64_t) (firstMorsel + morsel) << 32 | rowCounter;
+                for (uint columnCounter = 0; columnCounter < columnCount; columnCounter++)
+                    statistics[columnCounter].add(values[rowStart + columnCounter], rowId);
+            }
+        });
+        for (uint morsel = 0; morsel < waveCount; morsel++) {
+            const vector<int> &values = outputs[morsel];
+            for (size_t rowStart = 0; rowStart < values.size(); rowStart += columnCount) {
+                vector<int> &pageRow = this->rowsInPage[this->pageRowCount++];
+                copy(values.begin() + rowStart, values.begin() + rowStart + columnCount, pageRow.begin());
+                this->table->rowCount++;
+                if (this->pageRowCount == this->table->maxRowsPerBlock)
+                    this->writePage();
+            }
+        }
+    }
+    if (!partialStatistics.empty())
+        this->table->mergeStatistics(partialStatistics);
+}
+
+/**
+ * @brief Writes out the last, partially filled, page.
+ *
+ * @return true if the table has at least one row
+ * @return false if it is empty
+ */
+bool TableBuilder::finish() {
+    LOG_TRACE("TableBuilder::finish");
+    if (this->pageRowCount)
+        this->writePage();
+    this->table->finishStatistics();
+    return this->table->rowCount > 0;
+}
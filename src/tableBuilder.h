@@ -0,0 +1,42 @@
+#include "table.h"
+
+// Pages of a morsel, the part of a parallel scan a worker takes at a time
+const uint MORSEL_PAGES = 32;
+
+/**
+ * @brief The TableBuilder materializes a table row by row. Rows are collected
+ * into pages of maxRowsPerBlock rows that are handed straight to the buffer
+ * manager, while the builder keeps rowsPerBlockCount, blockCount and the table
+ * statistics up to date. This is how LOAD and every assignment statement fill
+ * their tables, so results never take a detour through a csv file.
+ *
+ * The table must have its columns (and layout and compression) set and must
+ * have no pages yet. Once finish has been called the table is ready to be
+ * read.
+ *
+ * A builder created without collectStatistics only counts rows; the caller
+ * then gathers the column statistics itself and hands them to
+ * Table::mergeStatistics before finishing.
+ *
+ * addMorsels fills the table from a scan run in parallel on the thread pool
+ * (see ThreadPool::runMorsels): every morsel produces its rows into a buffer
+ * of its own, and the buffers are appended in morsel order.
+ */
+class TableBuilder
+{
+    Table *table;
+    vector<vector<int>> rowsInPage;
+    uint pageRowCount = 0;
+    bool collectStatistics;
+
+    void writePage();
+
+public:
+    explicit TableBuilder(Table *table, bool collectStatistics = true);
+    void addRow(const vector<int> &row);
+    void addRow(RowView row);
+    void addRows(const vector<vector<int>> &rows, int rowCount);
+    void addMorsels(uint morselCount, const function<void(uint morsel, vector<int> &values)> &produce);
+    bool finish();
+    long long rowCount() const { return this->table->rowCount; }
+};
@@ -1,20 +1,28 @@
 #include "global.h"
 
+const string CATALOGUE_FILE = "../data/temp/catalogue";
+const uint32_t CATALOGUE_MAGIC = 0x54414352; // "RCAT"
+const uint32_t CATALOGUE_VERSION = 3;
+
 void TableCatalogue::insertTable(Table* table)
 {
-    logger.log("TableCatalogue::~insertTable"); 
+    LOG_TRACE("TableCatalogue::~insertTable"); 
+    unique_lock<shared_mutex> guard(this->latch);
     this->tables[table->tableName] = table;
+    this->versions[table->tableName] = ++this->lastVersion;
+    this->reservedNames.erase(table->tableName);
 }
 
 void TableCatalogue::insertMatrix(Matrix *matrix) {
-    logger.log("TableCatalogue::~insertTable");
+    LOG_TRACE("TableCatalogue::~insertTable");
+    unique_lock<shared_mutex> guard(this->latch);
     this->matrices[matrix->matrixName] = matrix;
 }
 
 void TableCatalogue::deleteTable(string tableName)
 {
-    logger.log("TableCatalogue::deleteTable"); 
-    this->tables[tableName]->unload();
+    LOG_TRACE("TableCatalogue::deleteTable"); 
+    this->getTable(tableName)->unload();
     eraseTable(tableName);
 }
 
@@ -26,34 +34,121 @@ void TableCatalogue::deleteTable(string tableName)
  */
 void TableCatalogue::eraseTable(std::string tableName)
 {
-    logger.log("TableCatalogue::eraseTable");
-    delete this->tables[tableName];
-    this->tables.erase(tableName);
+    LOG_TRACE("TableCatalogue::eraseTable");
+    unique_lock<shared_mutex> guard(this->latch);
+    auto it = this->tables.find(tableName);
+    if (it == this->tables.end())
+        return;
+    delete it->second;
+    this->tables.erase(it);
+    this->versions.erase(tableName);
+}
+
+/**
+ * @brief Removes the table from the catalogue and hands it to the caller,
+ * without unloading or deleting it
+ *
+ * @param tableName
+ * @return Table* nullptr if there is no such table
+ */
+Table* TableCatalogue::takeTable(string tableName)
+{
+    LOG_TRACE("TableCatalogue::takeTable");
+    unique_lock<shared_mutex> guard(this->latch);
+    auto it = this->tables.find(tableName);
+    if (it == this->tables.end())
+        return nullptr;
+    Table *table = it->second;
+    this->tables.erase(it);
+    this->versions.erase(tableName);
+    return table;
+}
+
+/**
+ * @brief Current version of the table
+ *
+ * @param tableName
+ * @return unsigned long long 0 if there is no such table
+ */
+unsigned long long TableCatalogue::getVersion(const string &tableName)
+{
+    LOG_TRACE("TableCatalogue::getVersion");
+    shared_lock<shared_mutex> guard(this->latch);
+    auto it = this->versions.find(tableName);
+    return it == this->versions.end() ? 0 : it->second;
+}
+
+/**
+ * @brief Gives the table a new version, after it was changed in place
+ *
+ * @param tableName
+ */
+void TableCatalogue::touchTable(const string &tableName)
+{
+    LOG_TRACE("TableCatalogue::touchTable");
+    unique_lock<shared_mutex> guard(this->latch);
+    if (this->tables.count(tableName))
+        this->versions[tableName] = ++this->lastVersion;
+}
+
+/**
+ * @brief A name for a temporary relation: tableName, with underscores added
+ * as long as a relation or a name handed out before and not yet inserted
+ * has it
+ *
+ * @param tableName
+ * @return string
+ */
+string TableCatalogue::temporaryName(string tableName)
+{
+    LOG_TRACE("TableCatalogue::temporaryName");
+    unique_lock<shared_mutex> guard(this->latch);
+    while (this->tables.count(tableName) || this->matrices.count(tableName) || this->reservedNames.count(tableName))
+        tableName += "_";
+    this->reservedNames.insert(tableName);
+    return tableName;
+}
+
+/**
+ * @brief Gives back a name from temporaryName that was never inserted
+ *
+ * @param tableName
+ */
+void TableCatalogue::releaseName(const string &tableName)
+{
+    LOG_TRACE("TableCatalogue::releaseName");
+    unique_lock<shared_mutex> guard(this->latch);
+    this->reservedNames.erase(tableName);
 }
 
 void TableCatalogue::deleteMatrix(string matrixName) {
-    logger.log("TableCatalogue::deleteTable");
-    this->tables[matrixName]->unload();
-    delete this->tables[matrixName];
-    this->tables.erase(matrixName);
+    LOG_TRACE("TableCatalogue::deleteMatrix");
+    Matrix *matrix = this->getMatrix(matrixName);
+    matrix->unload();
+    unique_lock<shared_mutex> guard(this->latch);
+    this->matrices.erase(matrixName);
+    delete matrix;
 }
 
 Table* TableCatalogue::getTable(string tableName)
 {
-    logger.log("TableCatalogue::getTable"); 
-    Table *table = this->tables[tableName];
-    return table;
+    LOG_TRACE("TableCatalogue::getTable"); 
+    shared_lock<shared_mutex> guard(this->latch);
+    auto it = this->tables.find(tableName);
+    return it == this->tables.end() ? nullptr : it->second;
 }
 
 Matrix* TableCatalogue::getMatrix(string matrixName) {
-    logger.log("TableCatalogue::getTable");
-    Matrix *matrix = this->matrices[matrixName];
-    return matrix;
+    LOG_TRACE("TableCatalogue::getTable");
+    shared_lock<shared_mutex> guard(this->latch);
+    auto it = this->matrices.find(matrixName);
+    return it == this->matrices.end() ? nullptr : it->second;
 }
 
 bool TableCatalogue::isTable(string tableName)
 {
-    logger.log("TableCatalogue::isTable"); 
+    LOG_TRACE("TableCatalogue::isTable"); 
+    shared_lock<shared_mutex> guard(this->latch);
     if (this->tables.count(tableName))
         return true;
     return false;
@@ -61,15 +156,26 @@ bool TableCatalogue::isTable(string tableName)
 
 bool TableCatalogue::isMatrix(string matrixName)
 {
-    logger.log("TableCatalogue::isMatrix");
+    LOG_TRACE("TableCatalogue::isMatrix");
+    shared_lock<shared_mutex> guard(this->latch);
     if (this->matrices.count(matrixName))
         return true;
     return false;
 }
 
+/**
+ * @brief True if no table or matrix is loaded (indexes belong to tables)
+ */
+bool TableCatalogue::isEmpty()
+{
+    LOG_TRACE("TableCatalogue::isEmpty");
+    shared_lock<shared_mutex> guard(this->latch);
+    return this->tables.empty() && this->matrices.empty();
+}
+
 bool TableCatalogue::isColumnFromTable(string columnName, string tableName)
 {
-    logger.log("TableCatalogue::isColumnFromTable"); 
+    LOG_TRACE("TableCatalogue::isColumnFromTable"); 
     if (this->isTable(tableName))
     {
         Table* table = this->getTable(tableName);
@@ -81,7 +187,8 @@ bool TableCatalogue::isColumnFromTable(string columnName, string tableName)
 
 void TableCatalogue::print(string type)
 {
-    logger.log("TableCatalogue::print");
+    LOG_TRACE("TableCatalogue::print");
+    shared_lock<shared_mutex> guard(this->latch);
     if (type == "TABLES") {
         cout << "\nRELATIONS" << endl;
 
@@ -106,20 +213,226 @@ void TableCatalogue::print(string type)
 }
 
 void TableCatalogue::renameMatrix(string oldName, string newName) {
-    auto nodeHandler = matrices.extract(oldName);
-    nodeHandler.key() = newName;
-    matrices.insert(std::move(nodeHandler));
-    matrices[newName]->rename(newName);
+    Matrix *matrix;
+    {
+        unique_lock<shared_mutex> guard(this->latch);
+        auto nodeHandler = matrices.extract(oldName);
+        nodeHandler.key() = newName;
+        matrix = nodeHandler.mapped();
+        matrices.insert(std::move(nodeHandler));
+    }
+    matrix->rename(newName);
+}
+
+void TableCatalogue::insertIndex(TableIndex *index) {
+    LOG_TRACE("TableCatalogue::insertIndex");
+    unique_lock<shared_mutex> guard(this->latch);
+    this->indexes[index->indexName] = index;
+}
+
+/**
+ * Unloads the index and erases it from the catalogue
+ *
+ * @param indexName
+ */
+void TableCatalogue::deleteIndex(string indexName) {
+    LOG_TRACE("TableCatalogue::deleteIndex");
+    TableIndex *index = this->getIndex(indexName);
+    index->unload();
+    unique_lock<shared_mutex> guard(this->latch);
+    this->indexes.erase(indexName);
+    delete index;
+}
+
+TableIndex* TableCatalogue::getIndex(string indexName) {
+    LOG_TRACE("TableCatalogue::getIndex");
+    shared_lock<shared_mutex> guard(this->latch);
+    auto it = this->indexes.find(indexName);
+    return it == this->indexes.end() ? nullptr : it->second;
+}
+
+bool TableCatalogue::isIndex(string indexName) {
+    LOG_TRACE("TableCatalogue::isIndex");
+    shared_lock<shared_mutex> guard(this->latch);
+    return this->indexes.count(indexName);
+}
+
+void TableCatalogue::renameIndex(string oldName, string newName) {
+    LOG_TRACE("TableCatalogue::renameIndex");
+    TableIndex *index;
+    {
+        unique_lock<shared_mutex> guard(this->latch);
+        auto nodeHandler = indexes.extract(oldName);
+        nodeHandler.key() = newName;
+        index = nodeHandler.mapped();
+        indexes.insert(std::move(nodeHandler));
+    }
+    index->rename(newName);
+}
+
+/**
+ * @brief Tables other than except that read the given column chain
+ *
+ * @param chainName
+ * @param except
+ * @return vector<Table*>
+ */
+vector<Table*> TableCatalogue::getChainReaders(const string &chainName, const Table *except)
+{
+    LOG_TRACE("TableCatalogue::getChainReaders");
+    shared_lock<shared_mutex> guard(this->latch);
+    vector<Table*> readers;
+    for (auto &[tableName, table]: this->tables) {
+        if (table == except || table->layout != DSM)
+            continue;
+        for (uint columnCounter = 0; columnCounter < table->columnCount; columnCounter++)
+            if (table->columnChain(columnCounter) == chainName) {
+                readers.push_back(table);
+                break;
+            }
+    }
+    return readers;
 }
 
 TableCatalogue::~TableCatalogue(){
-    logger.log("TableCatalogue::~TableCatalogue"); 
-    for(auto table: this->tables){
-        table.second->unload();
-        delete table.second;
+    LOG_TRACE("TableCatalogue::~TableCatalogue"); 
+    if (this->saved) {
+        // The pages belong to the saved catalogue now
+        for (auto table: this->tables)
+            delete table.second;
+        for (auto index: this->indexes)
+            delete index.second;
+        for (auto matrix: this->matrices)
+            delete matrix.second;
+        return;
+    }
+    // Tables are taken out of the catalogue one at a time, as unloading a
+    // table looks for the tables still reading its column chains
+    while (!this->tables.empty()) {
+        Table *table = this->tables.begin()->second;
+        table->unload();
+        this->tables.erase(this->tables.begin());
+        delete table;
     }
     for(auto matrix: this->matrices){
         matrix.second->unload();
         delete matrix.second;
     }
 }
+
+/**
+ * @brief Writes the catalogue to CATALOGUE_FILE, for the next server start
+ * to find every table, matrix and index (statistics, zone maps and the
+ * symmetry of matrices included) where this one left them. Every page is on
+ * disk by then, and from then on the catalogue leaves the pages alone when
+ * it is destroyed. The file is written under another name first and renamed
+ * when complete.
+ */
+void TableCatalogue::save()
+{
+    LOG_TRACE("TableCatalogue::save");
+    bufferManager.flushPages();
+    diskManager.flushWrites();
+    string partFile = CATALOGUE_FILE + ".part";
+    CatalogWriter writer(partFile);
+    writer.write(CATALOGUE_MAGIC);
+    writer.write(CATALOGUE_VERSION);
+    writer.write(BLOCK_SIZE);
+    writer.write(STORAGE_MODE);
+    writer.write((uint64_t) DiskManager::slotBytes());
+    writer.write(PAGE_FORMAT);
+    writer.write((uint64_t) this->tables.size());
+    for (auto table: this->tables)
+        table.second->save(writer);
+    writer.write((uint64_t) this->matrices.size());
+    for (auto matrix: this->matrices)
+        matrix.second->save(writer);
+    if (!writer.finish() || rename(partFile.c_str(), CATALOGUE_FILE.c_str())) {
+        LOG_ERROR("TableCatalogue::save: Err");
+        return;
+    }
+    this->saved = true;
+}
+
+/**
+ * @brief Tells whether the last page of a relation is on disk
+ */
+static bool hasPages(const string &relationName, int pageCount)
+{
+    return pageCount == 0 || diskManager.hasPage(relationName, pageCount - 1);
+}
+
+/**
+ * @brief Reattaches the tables, matrices and indexes of the catalogue saved
+ * by the last server. The file has to pass its checksum, come from this
+ * version with the same block size and page storage, and every relation has
+ * to find its last page on disk; otherwise nothing is restored. The file is
+ * removed once read, so that a server that dies never hands pages it may
+ * have changed to the next one.
+ *
+ * @return true if the catalogue has been restored
+ */
+bool TableCatalogue::restore()
+{
+    LOG_TRACE("TableCatalogue::restore");
+    CatalogReader reader(CATALOGUE_FILE);
+    remove(CATALOGUE_FILE.c_str());
+    uint32_t magic = 0, version = 0;
+    float blockSize = 0;
+    StorageMode storageMode;
+    uint64_t slotBytes = 0;
+    PageFormat pageFormat;
+    uint64_t tableCount = 0, matrixCount = 0;
+    bool restored = reader.read(magic) && magic == CATALOGUE_MAGIC && reader.read(version) &&
+                    version == CATALOGUE_VERSION && reader.read(blockSize) && blockSize == BLOCK_SIZE &&
+                    reader.read(storageMode) && storageMode == STORAGE_MODE && reader.read(slotBytes) &&
+                    slotBytes == DiskManager::slotBytes() && reader.read(pageFormat) &&
+                    pageFormat == PAGE_FORMAT && reader.read(tableCount);
+    vector<Table*> tables;
+    vector<Matrix*> matrices;
+    for (uint64_t tableCounter = 0; restored && tableCounter < tableCount; tableCounter++) {
+        tables.push_back(new Table());
+        restored = tables.back()->restore(reader);
+    }
+    restored = restored && reader.read(matrixCount);
+    for (uint64_t matrixCounter = 0; restored && matrixCounter < matrixCount; matrixCounter++) {
+        matrices.push_back(new Matrix());
+        restored = matrices.back()->restore(reader);
+    }
+    restored = restored && reader.atEnd();
+    for (int tableCounter = 0; restored && tableCounter < tables.size(); tableCounter++) {
+        Table *table = tables[tableCounter];
+        if (table->layout == DSM)
+            for (int columnCounter = 0; columnCounter < table->columnCount; columnCounter++)
+                restored = restored && hasPages(table->columnChain(columnCounter), table->blockCount);
+        else
+            restored = restored && hasPages(table->tableName, table->blockCount);
+        if (table->index)
+            restored = restored && hasPages(table->index->indexName, table->index->blockCount);
+    }
+    for (int matrixCounter = 0; restored && matrixCounter < matrices.size(); matrixCounter++) {
+        Matrix *matrix = matrices[matrixCounter];
+        int lastTile = matrix->blockCount - 1;
+        while (lastTile >= 0 && matrix->isZeroTile(lastTile))
+            lastTile--;
+        restored = hasPages(matrix->matrixName, lastTile + 1);
+    }
+    if (!restored) {
+        LOG_INFO("TableCatalogue::restore: no usable catalogue");
+        for (Table *table: tables) {
+            delete table->index;
+            delete table;
+        }
+        for (Matrix *matrix: matrices)
+            delete matrix;
+        return false;
+    }
+    for (Table *table: tables) {
+        this->insertTable(table);
+        if (table->index)
+            this->insertIndex(table->index);
+    }
+    for (Matrix *matrix: matrices)
+        this->insertMatrix(matrix);
+    return true;
+}
@@ -1,4 +1,4 @@
-#include "table.h"
+#include "tableBuilder.h"
 #include "matrix.h"
 
 /**
@@ -6,27 +6,62 @@
  * system. Everytime a table is added(removed) to(from) the system, it needs to
  * be added(removed) to(from) the tableCatalogue. 
  *
+ * The catalogue outlives the server: save writes it to a file next to the
+ * pages when the server stops, and restore reattaches the pages on the next
+ * start, so nothing has to be loaded again.
+ *
+ * Sessions look relations up at the same time, so the maps are guarded by a
+ * reader/writer latch, held only for the lookup or change itself. That the
+ * relation a pointer refers to stays around while it is used is up to the
+ * locks of the statement (see LockManager). Temporary relations get their
+ * names from temporaryName, which never hands out a name twice, even to
+ * sessions asking at the same time.
+ *
+ * Every table has a version, which changes whenever the table is created or
+ * changed in place (see touchTable). No two tables ever get the same version,
+ * so equal versions mean equal contents (see ResultCache).
+ *
  */
 class TableCatalogue
 {
 
     unordered_map<string, Table*> tables;
     unordered_map<string, Matrix*> matrices;
+    unordered_map<string, TableIndex*> indexes;
+    unordered_set<string> reservedNames;
+    unordered_map<string, unsigned long long> versions;
+    unsigned long long lastVersion = 0;
+    shared_mutex latch;
+    bool saved = false;
 
 public:
     TableCatalogue() {}
     void insertTable(Table* table);
     void deleteTable(string tableName);
     void eraseTable(string tableName);
+    Table* takeTable(string tableName);
+    string temporaryName(string tableName);
+    void releaseName(const string &tableName);
+    unsigned long long getVersion(const string &tableName);
+    void touchTable(const string &tableName);
     Table* getTable(string tableName);
     Matrix* getMatrix(string matrixName);
     bool isTable(string tableName);
     bool isMatrix(string matrixName);
     bool isLoaded(string dataName);
+    bool isEmpty();
     bool isColumnFromTable(string columnName, string tableName);
+    vector<Table*> getChainReaders(const string &chainName, const Table *except);
     void print(string type);
     void insertMatrix(Matrix* matrix);
     void renameMatrix(string oldName, string newName);
     void deleteMatrix(string matrixName);
+    void insertIndex(TableIndex* index);
+    void deleteIndex(string indexName);
+    TableIndex* getIndex(string indexName);
+    bool isIndex(string indexName);
+    void renameIndex(string oldName, string newName);
+    void save();
+    bool restore();
     ~TableCatalogue();
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "global.h"
+
+/**
+ * @brief Deletes the pages of the index
+ */
+void TableIndex::unload() {
+    LOG_TRACE("TableIndex::unload");
+    bufferManager.deleteRelation(this->indexName, this->blockCount);
+}
+
+/**
+ * @brief Renames the index and all its pages
+ *
+ * @param newName
+ */
+void TableIndex::rename(const string &newName) {
+    LOG_TRACE("TableIndex::rename");
+    bufferManager.renameRelation(this->indexName, newName, this->blockCount);
+    this->indexName = newName;
+}
+
+/**
+ * @brief Persists what every index knows about its pages
+ *
+ * @param writer
+ */
+void TableIndex::save(CatalogWriter &writer) const {
+    writer.write(this->indexName);
+    writer.write(this->columnIndex);
+    writer.write(this->blockCount);
+    writer.write(this->dimsPerBlock);
+}
+
+/**
+ * @brief Reads back an index saved by save. Its pages are left on disk.
+ *
+ * @param reader
+ * @return false if the catalogue file is damaged
+ */
+bool TableIndex::restore(CatalogReader &reader) {
+    return reader.read(this->indexName) && reader.read(this->columnIndex) && reader.read(this->blockCount) &&
+           reader.read(this->dimsPerBlock) && this->dimsPerBlock.size() == this->blockCount;
+}
@@ -0,0 +1,51 @@
+#ifndef TABLE_INDEX_H
+#define TABLE_INDEX_H
+#include"cursor.h"
+#include"catalogFile.h"
+
+class Table;
+
+/**
+ * @brief Location of a row: the page it is in and its position in the page.
+ * Row ids order the same way as a scan of the table.
+ */
+struct RowId {
+    int pageIndex;
+    int slot;
+
+    bool operator<(const RowId &other) const {
+        return pageIndex != other.pageIndex ? pageIndex < other.pageIndex : slot < other.slot;
+    }
+};
+
+/**
+ * @brief A TableIndex maps the values of one column of a table to the row ids
+ * holding them. Its nodes are stored as pages of a relation of their own
+ * (indexName) and go through the buffer manager like any other page; the
+ * catalogue knows the index by that name so pages can find their dimensions.
+ *
+ * The rows of a table never move once written, so an index built over a table
+ * stays valid until the table is sorted in place or unloaded.
+ */
+class TableIndex{
+
+    public:
+
+    string indexName = "";
+    int columnIndex = -1;
+    uint blockCount = 0;
+    vector<pair<int, int>> dimsPerBlock;
+
+    virtual ~TableIndex() {}
+    virtual bool build(Table *table) = 0;
+    virtual bool supportsRanges() const = 0;
+    virtual void lookup(int low, int high, vector<RowId> &rowIds) = 0;
+    // Index pages a lookup that finds matchingRows entries reads
+    virtual long long lookupCost(long long matchingRows) const = 0;
+    // Persists the index (see TableCatalogue::save)
+    virtual void save(CatalogWriter &writer) const;
+    virtual bool restore(CatalogReader &reader);
+    void unload();
+    void rename(const string &newName);
+};
+#endif //TABLE_INDEX_H
@@ -0,0 +1,183 @@
+#include "global.h"
+
+static thread_local bool insidePool = false;
+
+/**
+ * @brief Stops the workers. No run can be active at this point.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    for (thread &worker: this->workers)
+        worker.join();
+}
+
+/**
+ * @return uint number of threads a run is spread over, the caller included
+ */
+uint ThreadPool::size() const {
+    return max(1u, WORKER_THREADS);
+}
+
+/**
+ * @brief Body of a worker. Waits for a run and helps with its tasks.
+ */
+void ThreadPool::runWorker() {
+    insidePool = true;
+    unique_lock<mutex> guard(this->lock);
+    uint seenGeneration = 0;
+    while (true) {
+        // A worker only joins a run that is still going on, so a run cannot
+        // return while one of its tasks may still be picked up
+        this->changed.wait(guard, [&] {
+            return this->stopping || (this->task && this->generation != seenGeneration);
+        });
+        if (this->stopping)
+            return;
+        seenGeneration = this->generation;
+        this->activeWorkers++;
+        guard.unlock();
+        uint finished = this->work();
+        guard.lock();
+        this->activeWorkers--;
+        this->finishedTasks += finished;
+        this->changed.notify_all();
+    }
+}
+
+/**
+ * @brief Executes tasks of the current run until none are left
+ *
+ * @return uint number of tasks executed
+ */
+uint ThreadPool::work() {
+    uint finished = 0;
+    for (uint taskIndex = this->nextTask++; taskIndex < this->taskCount; taskIndex = this->nextTask++) {
+        (*this->task)(taskIndex);
+        finished++;
+    }
+    return finished;
+}
+
+/**
+ * @brief Executes task(0) .. task(taskCount - 1) in parallel and waits for all
+ * of them
+ *
+ * @param taskCount
+ * @param task
+ */
+void ThreadPool::run(uint taskCount, const function<void(uint)> &task) {
+    if (taskCount <= 1 || this->size() == 1 || insidePool) {
+        for (uint taskIndex = 0; taskIndex < taskCount; taskIndex++)
+            task(taskIndex);
+        return;
+    }
+    lock_guard<mutex> runGuard(this->runLock);
+    LOG_TRACE("ThreadPool::run " + to_string(taskCount));
+    {
+        lock_guard<mutex> guard(this->lock);
+        while (this->workers.size() < this->size() - 1)
+            this->workers.emplace_back(&ThreadPool::runWorker, this);
+        this->task = &task;
+        this->taskCount = taskCount;
+        this->nextTask = 0;
+        this->finishedTasks = 0;
+        this->generation++;
+    }
+    this->changed.notify_all();
+    insidePool = true;
+    uint finished = this->work();
+    insidePool = false;
+    unique_lock<mutex> guard(this->lock);
+    this->finishedTasks += finished;
+    this->changed.wait(guard, [&] { return this->finishedTasks == taskCount && this->activeWorkers == 0; });
+    this->task = nullptr;
+}
+
+namespace {
+
+/**
+ * @brief Morsels a thread of runMorsels has left, packed as next << 32 | end
+ * so that its owner and thieves can claim them with one compare and swap.
+ * Aligned to a cache line of its own.
+ */
+struct alignas(64) MorselRange {
+    atomic<uint64_t> bounds{0};
+
+    static uint64_t pack(uint next, uint end) {
+        return (uint64_t) next << 32 | end;
+    }
+
+    /**
+     * @brief Claims the first morsel of the range
+     *
+     * @return false if the range is empty
+     */
+    bool takeFront(uint &morsel) {
+        uint64_t bounds = this->bounds.load();
+        while ((uint) (bounds >> 32) < (uint) bounds)
+            if (this->bounds.compare_exchange_weak(bounds, bounds + ((uint64_t) 1 << 32))) {
+                morsel = bounds >> 32;
+                return true;
+            }
+        return false;
+    }
+
+    /**
+     * @brief Claims the back half (rounded up) of the range
+     *
+     * @return false if the range is empty
+     */
+    bool takeBack(uint &first, uint &end) {
+        uint64_t bounds = this->bounds.load();
+        while ((uint) (bounds >> 32) < (uint) bounds) {
+            uint next = bounds >> 32;
+            end = bounds;
+            first = end - (end - next + 1) / 2;
+            if (this->bounds.compare_exchange_weak(bounds, pack(next, first)))
+                return true;
+        }
+        return false;
+    }
+};
+
+}
+
+/**
+ * @brief Executes morsel(worker, 0) .. morsel(worker, morselCount - 1) in
+ * parallel and waits for all of them. worker tells which of the threads, 0 ..
+ * size() - 1, runs the morsel; no two morsels of the same worker run at the
+ * same time, so it can index state of the thread's own.
+ *
+ * @param morselCount
+ * @param morsel
+ */
+void ThreadPool::runMorsels(uint morselCount, const function<void(uint worker, uint morsel)> &morsel) {
+    uint workers = min(this->size(), morselCount);
+    if (workers <= 1 || insidePool) {
+        for (uint morselIndex = 0; morselIndex < morselCount; morselIndex++)
+            morsel(0, morselIndex);
+        return;
+    }
+    vector<MorselRange> ranges(workers);
+    for (uint worker = 0; worker < workers; worker++)
+        ranges[worker].bounds = MorselRange::pack((uint64_t) morselCount * worker / workers,
+                                                  (uint64_t) morselCount * (worker + 1) / workers);
+    this->run(workers, [&](uint worker) {
+        while (true) {
+            uint morselIndex, first, end;
+            while (ranges[worker].takeFront(morselIndex))
+                morsel(worker, morselIndex);
+            // Only the owner refills its range, and only while it is empty
+            bool stolen = false;
+            for (uint victim = (worker + 1) % workers; victim != worker && !stolen; victim = (victim + 1) % workers)
+                stolen = ranges[victim].takeBack(first, end);
+            if (!stolen)
+                return;
+            ranges[worker].bounds = MorselRange::pack(first, end);
+        }
+    });
+}
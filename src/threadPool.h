@@ -0,0 +1,74 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include"logger.h"
+
+/**
+ * @brief The ThreadPool runs data parallel work on WORKER_THREADS threads.
+ * run hands out the tasks 0 .. taskCount - 1 to the workers and to the calling
+ * thread, and returns once all of them have finished. The workers are started
+ * with the first parallel run and sleep in between.
+ *
+ * Only one run is active at a time; a task that calls run itself gets its
+ * tasks executed on its own thread.
+ *
+ * runMorsels spreads the morsels (ranges of pages) of a scan over the
+ * threads with work stealing: every thread starts on a contiguous share of
+ * the morsels, taking them from its front, and once it runs out steals the
+ * back half of what another thread has left.
+ */
+class ThreadPool{
+
+    vector<thread> workers;
+    mutex runLock;
+    mutex lock;
+    condition_variable changed;
+    const function<void(uint)> *task = nullptr;
+    uint taskCount = 0;
+    atomic<uint> nextTask{0};
+    uint finishedTasks = 0;
+    uint activeWorkers = 0;
+    uint generation = 0;
+    bool stopping = false;
+
+    void runWorker();
+    uint work();
+
+    public:
+
+    ~ThreadPool();
+    uint size() const;
+    void run(uint taskCount, const function<void(uint)> &task);
+    void runMorsels(uint morselCount, const function<void(uint worker, uint morsel)> &morsel);
+
+    /**
+     * @brief Sorts [first, last) on the pool: one part per thread is sorted
+     * on its own by sortPart(partFirst, partLast), then neighbouring parts
+     * are merged pairwise by compare, the merges of a round running in
+     * parallel. Ranges shorter than two minimum parts are sorted as a single
+     * part on the calling thread.
+     */
+    template <typename Iterator, typename Compare, typename SortPart>
+    void sortWith(Iterator first, Iterator last, Compare compare, SortPart sortPart, size_t minimumPart = 4096)
+    {
+        size_t length = last - first;
+        uint parts = min((size_t) this->size(), length / minimumPart);
+        if (parts < 2) {
+            sortPart(first, last);
+            return;
+        }
+        vector<size_t> bounds(parts + 1);
+        for (uint part = 0; part <= parts; part++)
+            bounds[part] = length * part / parts;
+        this->run(parts, [&](uint part) {
+            sortPart(first + bounds[part], first + bounds[part + 1]);
+        });
+        for (uint width = 1; width < parts; width *= 2) {
+            this->run((parts + 2 * width - 1) / (2 * width), [&](uint merge) {
+                uint low = merge * 2 * width, middle = min(low + width, parts), high = min(low + 2 * width, parts);
+                if (middle < high)
+                    std::inplace_merge(first + bounds[low], first + bounds[middle], first + bounds[high], compare);
+            });
+        }
+    }
+};
+#endif //THREAD_POOL_H
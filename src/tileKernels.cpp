@@ -0,0 +1,295 @@
+#include "global.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TILE_KERNELS_X86
+#endif
+
+namespace {
+
+const int MICRO_TILE = 8;
+
+/**
+ * @brief Value a cell takes in a transpose: its mirror cell's
+ */
+struct Transpose {
+    static int apply(int, int mirror) { return mirror; }
+#ifdef TILE_KERNELS_X86
+    __attribute__((target("avx2"))) static __m256i apply(__m256i, __m256i mirror) { return mirror; }
+#endif
+};
+
+/**
+ * @brief Value a cell takes in a subtract transpose: itself minus its
+ * mirror cell
+ */
+struct SubtractTranspose {
+    static int apply(int value, int mirror) { return value - mirror; }
+#ifdef TILE_KERNELS_X86
+    __attribute__((target("avx2"))) static __m256i apply(__m256i value, __m256i mirror)
+    {
+        return _mm256_sub_epi32(value, mirror);
+    }
+#endif
+};
+
+/**
+ * @brief Updates a cell and its mirror cell, which may be the same cell
+ */
+template <typename Operation>
+inline void applyToCells(int &cell, int &mirror)
+{
+    int newCell = Operation::apply(cell, mirror), newMirror = Operation::apply(mirror, cell);
+    cell = newCell, mirror = newMirror;
+}
+
+typedef void (*MicroTileKernel)(int *first, int firstStride, int *second, int secondStride);
+
+/**
+ * @brief Updates the 8 x 8 micro tile at first and its mirror image at
+ * second (which may be the same micro tile) from copies of both
+ */
+template <typename Operation>
+void microTileScalar(int *first, int firstStride, int *second, int secondStride)
+{
+    int firstCells[MICRO_TILE][MICRO_TILE], secondCells[MICRO_TILE][MICRO_TILE];
+    for (int row = 0; row < MICRO_TILE; row++)
+        for (int column = 0; column < MICRO_TILE; column++) {
+            firstCells[row][column] = first[(size_t) row * firstStride + column];
+            secondCells[row][column] = second[(size_t) row * secondStride + column];
+        }
+    for (int row = 0; row < MICRO_TILE; row++)
+        for (int column = 0; column < MICRO_TILE; column++) {
+            first[(size_t) row * firstStride + column] = Operation::apply(firstCells[row][column], secondCells[column][row]);
+            second[(size_t) row * secondStride + column] = Operation::apply(secondCells[row][column], firstCells[column][row]);
+        }
+}
+
+#ifdef TILE_KERNELS_X86
+/**
+ * @brief Transposes 8 rows of 8 ints held in registers: the pairs of rows
+ * are interleaved by 32 and then 64 bit lanes, and the 128 bit halves are
+ * exchanged last.
+ */
+__attribute__((target("avx2"))) inline void transposeRegisters(__m256i rows[MICRO_TILE])
+{
+    __m256i interleaved[MICRO_TILE], paired[MICRO_TILE];
+    for (int row = 0; row < MICRO_TILE; row += 2) {
+        interleaved[row] = _mm256_unpacklo_epi32(rows[row], rows[row + 1]);
+        interleaved[row + 1] = _mm256_unpackhi_epi32(rows[row], rows[row + 1]);
+    }
+    for (int row = 0; row < MICRO_TILE; row += 4) {
+        paired[row] = _mm256_unpacklo_epi64(interleaved[row], interleaved[row + 2]);
+        paired[row + 1] = _mm256_unpackhi_epi64(interleaved[row], interleaved[row + 2]);
+        paired[row + 2] = _mm256_unpacklo_epi64(interleaved[row + 1], interleaved[row + 3]);
+        paired[row + 3] = _mm256_unpackhi_epi64(interleaved[row + 1], interleaved[row + 3]);
+    }
+    for (int row = 0; row < 4; row++) {
+        rows[row] = _mm256_permute2x128_si256(paired[row], paired[row + 4], 0x20);
+        rows[row + 4] = _mm256_permute2x128_si256(paired[row], paired[row + 4], 0x31);
+    }
+}
+
+template <typename Operation>
+__attribute__((target("avx2"))) void microTileAVX2(int *first, int firstStride, int *second, int secondStride)
+{
+    __m256i firstRows[MICRO_TILE], secondRows[MICRO_TILE], firstColumns[MICRO_TILE], secondColumns[MICRO_TILE];
+    for (int row = 0; row < MICRO_TILE; row++) {
+        firstRows[row] = firstColumns[row] = _mm256_loadu_si256((const __m256i *) (first + (size_t) row * firstStride));
+        secondRows[row] = secondColumns[row] = _mm256_loadu_si256((const __m256i *) (second + (size_t) row * secondStride));
+    }
+    transposeRegisters(firstColumns);
+    transposeRegisters(secondColumns);
+    for (int row = 0; row < MICRO_TILE; row++) {
+        _mm256_storeu_si256((__m256i *) (first + (size_t) row * firstStride),
+                            Operation::apply(firstRows[row], secondColumns[row]));
+        _mm256_storeu_si256((__m256i *) (second + (size_t) row * secondStride),
+                            Operation::apply(secondRows[row], firstColumns[row]));
+    }
+}
+
+/**
+ * @brief Adds rows [firstRow, lastRow) of first x second to result, 32 and
+ * then 8 columns of a result row at a time held in registers while the
+ * inner dimension is walked.
+ */
+__attribute__((target("avx2"))) void multiplyAVX2(const int *first, const int *second, int *result, int inner,
+                                                  int columns, int firstRow, int lastRow)
+{
+    for (int row = firstRow; row < lastRow; row++) {
+        const int *firstCells = first + (size_t) row * inner;
+        int *resultRow = result + (size_t) row * columns;
+        int column = 0;
+        for (; column + 4 * MICRO_TILE <= columns; column += 4 * MICRO_TILE) {
+            __m256i sums[4];
+            for (int part = 0; part < 4; part++)
+                sums[part] = _mm256_loadu_si256((const __m256i *) (resultRow + column + part * MICRO_TILE));
+            for (int k = 0; k < inner; k++) {
+                __m256i value = _mm256_set1_epi32(firstCells[k]);
+                const int *secondRow = second + (size_t) k * columns + column;
+                for (int part = 0; part < 4; part++)
+                    sums[part] = _mm256_add_epi32(sums[part], _mm256_mullo_epi32(value,
+                        _mm256_loadu_si256((const __m256i *) (secondRow + part * MICRO_TILE))));
+            }
+            for (int part = 0; part < 4; part++)
+                _mm256_storeu_si256((__m256i *) (resultRow + column + part * MICRO_TILE), sums[part]);
+        }
+        for (; column + MICRO_TILE <= columns; column += MICRO_TILE) {
+            __m256i sum = _mm256_loadu_si256((const __m256i *) (resultRow + column));
+            for (int k = 0; k < inner; k++)
+                sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_set1_epi32(firstCells[k]),
+                    _mm256_loadu_si256((const __m256i *) (second + (size_t) k * columns + column))));
+            _mm256_storeu_si256((__m256i *) (resultRow + column), sum);
+        }
+        for (; column < columns; column++) {
+            unsigned sum = resultRow[column];
+            for (int k = 0; k < inner; k++)
+                sum += (unsigned) firstCells[k] * (unsigned) second[(size_t) k * columns + column];
+            resultRow[column] = (int) sum;
+        }
+    }
+}
+
+const bool hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+/**
+ * @brief Adds rows [firstRow, lastRow) of first x second to result, walking
+ * a row of second for every cell of first so that all accesses are row
+ * major. The products wrap around like the AVX2 ones.
+ */
+void multiplyScalar(const int *first, const int *second, int *result, int inner, int columns, int firstRow,
+                    int lastRow)
+{
+    for (int row = firstRow; row < lastRow; row++) {
+        unsigned *resultRow = (unsigned *) result + (size_t) row * columns;
+        for (int k = 0; k < inner; k++) {
+            unsigned value = first[(size_t) row * inner + k];
+            const int *secondRow = second + (size_t) k * columns;
+            for (int column = 0; column < columns; column++)
+                resultRow[column] += value * (unsigned) secondRow[column];
+        }
+    }
+}
+
+template <typename Operation>
+MicroTileKernel microTileKernel()
+{
+#ifdef TILE_KERNELS_X86
+    if (hasAVX2)
+        return microTileAVX2<Operation>;
+#endif
+    return microTileScalar<Operation>;
+}
+
+/**
+ * @brief Applies the operation to every pair of mirrored cells of a square
+ * tile, the part covered by whole micro tiles first
+ */
+template <typename Operation>
+void processTile(int *tile, int size)
+{
+    MicroTileKernel kernel = microTileKernel<Operation>();
+    int blocked = size / MICRO_TILE * MICRO_TILE;
+    for (int row = 0; row < blocked; row += MICRO_TILE)
+        for (int column = row; column < blocked; column += MICRO_TILE)
+            kernel(tile + (size_t) row * size + column, size, tile + (size_t) column * size + row, size);
+    for (int row = 0; row < size; row++)
+        for (int column = row < blocked ? blocked : row; column < size; column++)
+            applyToCells<Operation>(tile[(size_t) row * size + column], tile[(size_t) column * size + row]);
+}
+
+/**
+ * @brief Applies the operation to every cell of a rows x columns tile and
+ * its mirror cell in the columns x rows mirror tile
+ */
+template <typename Operation>
+void processTiles(int *tile, int rows, int columns, int *mirror)
+{
+    MicroTileKernel kernel = microTileKernel<Operation>();
+    int blockedRows = rows / MICRO_TILE * MICRO_TILE, blockedColumns = columns / MICRO_TILE * MICRO_TILE;
+    for (int row = 0; row < blockedRows; row += MICRO_TILE)
+        for (int column = 0; column < blockedColumns; column += MICRO_TILE)
+            kernel(tile + (size_t) row * columns + column, columns, mirror + (size_t) column * rows + row, rows);
+    for (int row = 0; row < rows; row++)
+        for (int column = row < blockedRows ? blockedColumns : 0; column < columns; column++)
+            applyToCells<Operation>(tile[(size_t) row * columns + column], mirror[(size_t) column * rows + row]);
+}
+
+}
+
+/**
+ * @brief Transposes a square tile in place
+ *
+ * @param tile
+ * @param size number of rows (and columns) of the tile
+ */
+void transposeTile(int *tile, int size)
+{
+    LOG_TRACE("transposeTile");
+    processTile<Transpose>(tile, size);
+}
+
+/**
+ * @brief Swaps a tile with the transpose of its mirror tile
+ *
+ * @param tile rows x columns cells
+ * @param rows
+ * @param columns
+ * @param mirror columns x rows cells
+ */
+void transposeTiles(int *tile, int rows, int columns, int *mirror)
+{
+    LOG_TRACE("transposeTiles");
+    processTiles<Transpose>(tile, rows, columns, mirror);
+}
+
+/**
+ * @brief Replaces a square tile A by A - transpose(A) in place
+ *
+ * @param tile
+ * @param size number of rows (and columns) of the tile
+ */
+void subtractTransposeTile(int *tile, int size)
+{
+    LOG_TRACE("subtractTransposeTile");
+    processTile<SubtractTranspose>(tile, size);
+}
+
+/**
+ * @brief Replaces a tile A and its mirror tile B by A - transpose(B) and
+ * B - transpose(A)
+ *
+ * @param tile rows x columns cells
+ * @param rows
+ * @param columns
+ * @param mirror columns x rows cells
+ */
+void subtractTransposeTiles(int *tile, int rows, int columns, int *mirror)
+{
+    LOG_TRACE("subtractTransposeTiles");
+    processTiles<SubtractTranspose>(tile, rows, columns, mirror);
+}
+
+/**
+ * @brief Adds rows [firstRow, lastRow) of the product of two tiles to a
+ * result tile. Different row ranges of one result tile can be computed by
+ * different threads at the same time.
+ *
+ * @param first rows x inner cells
+ * @param second inner x columns cells
+ * @param result rows x columns cells
+ * @param inner
+ * @param columns
+ * @param firstRow
+ * @param lastRow
+ */
+void multiplyTiles(const int *first, const int *second, int *result, int inner, int columns, int firstRow,
+                   int lastRow)
+{
+    LOG_TRACE("multiplyTiles");
+#ifdef TILE_KERNELS_X86
+    if (hasAVX2)
+        return multiplyAVX2(first, second, result, inner, columns, firstRow, lastRow);
+#endif
+    multiplyScalar(first, second, result, inner, columns, firstRow, lastRow);
+}
@@ -0,0 +1,28 @@
+#ifndef TILE_KERNELS_H
+#define TILE_KERNELS_H
+#include"logger.h"
+
+/**
+ * @brief Kernels for the transposes and products of matrix tiles, which are
+ * stored row major. Transposes walk the tiles in 8 x 8 micro tiles, so that
+ * both the rows and the columns being swapped stay in the cache: a micro
+ * tile and its mirror image are loaded, transposed in registers and stored
+ * in each other's place. With AVX2 (detected at run time) a micro tile is
+ * eight registers; otherwise, and for the rows and columns left over at the
+ * edges, plain scalar loops are used.
+ *
+ * Square tiles (on the diagonal of a matrix) are processed in place, other
+ * tiles together with their mirror tile: tile is rows x columns and mirror
+ * columns x rows.
+ *
+ * A product of tiles is added to a result tile row by row, a few registers
+ * of result cells at a time.
+ */
+void transposeTile(int *tile, int size);
+void transposeTiles(int *tile, int rows, int columns, int *mirror);
+void subtractTransposeTile(int *tile, int size);
+void subtractTransposeTiles(int *tile, int rows, int columns, int *mirror);
+void multiplyTiles(const int *first, const int *second, int *result, int inner, int columns, int firstRow,
+                   int lastRow);
+
+#endif //TILE_KERNELS_H